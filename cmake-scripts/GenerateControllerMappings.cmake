@@ -0,0 +1,65 @@
+# Generates the built-in game controller mapping table from an SDL_GameControllerDB text file.
+#
+# Usage: cmake -DINPUT=<gamecontrollerdb.txt> -DOUTPUT=<file.c> [-DPLATFORM=<name>] -P GenerateControllerMappings.cmake
+#
+# Only mappings for PLATFORM (as in the "platform:" field, eg. "Linux") are kept. If PLATFORM is empty,
+# all mappings are kept and SDL discards the ones for other platforms when they are loaded.
+# Mappings are sorted by GUID, so that the game can look them up with a binary search.
+
+if(NOT INPUT OR NOT OUTPUT)
+    message(FATAL_ERROR "GenerateControllerMappings: INPUT and OUTPUT are required")
+endif()
+
+file(STRINGS "${INPUT}" lines)
+
+set(index 1000000)
+set(keys)
+set(generic)
+foreach(line IN LISTS lines)
+    if(line MATCHES "^#" OR line STREQUAL "")
+        continue()
+    endif()
+    if(PLATFORM AND NOT line MATCHES "platform:${PLATFORM},")
+        continue()
+    endif()
+    string(REPLACE "\\" "\\\\" line "${line}")
+    string(REPLACE "\"" "\\\"" line "${line}")
+
+    string(FIND "${line}" "," comma)
+    if(comma EQUAL 32 AND line MATCHES "^([0-9a-fA-F]+),(.*)$")
+        # Sort key keeps the file order for equal GUIDs, since later mappings override earlier ones.
+        string(TOLOWER "${CMAKE_MATCH_1}" guid)
+        math(EXPR index "${index} + 1")
+        set(key "${guid}${index}")
+        set(mapping_${key} "${CMAKE_MATCH_2}")
+        list(APPEND keys "${key}")
+    else()
+        # Mappings without a GUID (eg. "xinput") are fallbacks for whole device classes
+        list(APPEND generic "${line}")
+    endif()
+endforeach()
+list(SORT keys)
+list(LENGTH keys count)
+
+set(out "// Generated from ${INPUT} by GenerateControllerMappings.cmake. Do not edit.\n")
+string(APPEND out "#include \"controller/builtin_mappings.h\"\n\n")
+string(APPEND out "const builtin_mapping builtin_controller_mappings[] = {\n")
+foreach(key IN LISTS keys)
+    string(SUBSTRING "${key}" 0 32 guid)
+    string(REGEX REPLACE "(..)" "0x\\1," bytes "${guid}")
+    string(APPEND out "    {{${bytes}}, \"${mapping_${key}}\"},\n")
+endforeach()
+if(count EQUAL 0)
+    string(APPEND out "    {{0}, \"\"},\n")
+endif()
+string(APPEND out "};\n\n")
+string(APPEND out "const unsigned int builtin_controller_mappings_count = ${count};\n\n")
+string(APPEND out "const char *const builtin_controller_generic_mappings[] = {\n")
+foreach(line IN LISTS generic)
+    string(APPEND out "    \"${line}\",\n")
+endforeach()
+string(APPEND out "    0,\n};\n")
+
+file(WRITE "${OUTPUT}.tmp" "${out}")
+configure_file("${OUTPUT}.tmp" "${OUTPUT}" COPYONLY)
+file(REMOVE "${OUTPUT}.tmp")
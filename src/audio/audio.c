@@ -2,17 +2,21 @@
 #include <stdlib.h>
 
 #include <SDL.h>
-#include <SDL_mixer.h>
 #include <xmp.h>
 
 #include "audio/audio.h"
+#include "audio/mixer.h"
+#include "audio/music_stream.h"
 #include "resources/pathmanager.h"
 #include "resources/sounds_loader.h"
 #include "utils/allocator.h"
+#include "utils/compat.h"
 #include "utils/log.h"
 #include "utils/miscmath.h"
 
-#define CHANNEL_MAX 16
+#define SOUND_MAX 300
+#define SOUND_FREQ 8000
+#define BUFFER_FRAMES 1024
 
 const audio_freq output_freqs[] = {
     {11025, 0, "11025Hz"},
@@ -30,17 +34,24 @@ const audio_mod_resampler music_resamplers[] = {
 };
 
 typedef struct audio_system {
+    SDL_AudioDeviceID device;
     int freq;
     Uint16 format;
     int channels;
     int resampler;
     float music_volume;
     resource_id music_id;
+    bool music_playing;
     xmp_context xmp_context;
-    Mix_Chunk *channel_chunks[CHANNEL_MAX];
+    int16_t *music_buffer;
+    unsigned int buffer_frames;
+    music_stream music_stream;
+    mixer mixer;
+    mixer_sample samples[SOUND_MAX];
 } audio_system;
 
 static audio_system *audio = NULL;
+static THREAD_LOCAL bool audio_output = true;
 
 static const char *get_sdl_audio_format_string(SDL_AudioFormat format) {
     switch(format) {
@@ -68,11 +79,17 @@ static const char *get_sdl_audio_format_string(SDL_AudioFormat format) {
     return "UNKNOWN";
 }
 
-static Mix_Chunk *audio_get_chunk(int id, float volume, float pitch) {
+// Converts the 8bit unsigned sample to the signed 16bit format used by the mixer. This is done once
+// per sound on first use, and the result is kept until the audio device is closed.
+static const mixer_sample *audio_get_sample(int id) {
+    mixer_sample *sample = &audio->samples[id];
     char *src_buf;
     int src_len;
-    Uint8 *dst_buf;
-    SDL_AudioCVT cvt;
+    int16_t *dst_buf;
+
+    if(sample->data != NULL) {
+        return sample;
+    }
 
     // Load sample (8000Hz, mono, 8bit)
     if(sounds_loader_get(id, &src_buf, &src_len) != 0) {
@@ -84,41 +101,20 @@ static Mix_Chunk *audio_get_chunk(int id, float volume, float pitch) {
         return NULL;
     }
 
-    // Converter for sound samples.
-    int src_freq = 8000 * pitch;
-    if(SDL_BuildAudioCVT(&cvt, AUDIO_U8, 1, src_freq, audio->format, audio->channels, audio->freq) < 0) {
-        PERROR("Unable to build audio converter: %s", SDL_GetError());
-        return NULL;
-    }
-
-    // Create a buffer that can hold the source data and final converted data.
-    if((dst_buf = SDL_malloc(src_len * cvt.len_mult + 1)) == NULL) {
-        PERROR("Unable to allocate memory for sound buffer");
-        return NULL;
+    // One extra trailing zero sample for the mixer interpolation.
+    dst_buf = omf_calloc(src_len + 1, sizeof(int16_t));
+    for(int i = 0; i < src_len; i++) {
+        dst_buf[i] = ((int16_t)(Uint8)src_buf[i] - 128) << 8;
     }
-    SDL_memcpy((void *)dst_buf, (void *)src_buf, src_len);
-
-    // Convert!
-    cvt.buf = dst_buf;
-    cvt.len = src_len;
-    if(SDL_ConvertAudio(&cvt) != 0) {
-        PERROR("Unable to convert audio sample: %s", SDL_GetError());
-        return NULL;
-    }
-
-    Mix_Chunk *chunk = SDL_malloc(sizeof(Mix_Chunk));
-    chunk->volume = volume * MIX_MAX_VOLUME;
-    chunk->abuf = dst_buf;
-    chunk->alen = cvt.len_cvt;
-    chunk->allocated = 1;
-    return chunk;
+    sample->data = dst_buf;
+    sample->len = src_len;
+    sample->freq = SOUND_FREQ;
+    return sample;
 }
 
-static void audio_sound_finished(int channel) {
-    assert(audio);
-    if(audio->channel_chunks[channel] != NULL) {
-        Mix_FreeChunk(audio->channel_chunks[channel]);
-        audio->channel_chunks[channel] = NULL;
+static void audio_free_samples() {
+    for(int i = 0; i < SOUND_MAX; i++) {
+        omf_free(audio->samples[i].data);
     }
 }
 
@@ -148,7 +144,7 @@ static bool audio_load_module(const char *file) {
         PERROR("Unable to set music resampler");
         goto exit_2;
     }
-    if(xmp_set_player(audio->xmp_context, XMP_PLAYER_VOLUME, audio->music_volume * 100) != 0) {
+    if(xmp_set_player(audio->xmp_context, XMP_PLAYER_VOLUME, 100) != 0) {
         PERROR("Unable to set music volume");
         goto exit_2;
     }
@@ -162,10 +158,28 @@ exit_0:
     return false;
 }
 
-// Callback function for SDL_Mixer
-void audio_xmp_render(void *userdata, Uint8 *stream, int len) {
+// Render callback for the music stream. Runs in the music stream worker thread.
+static void audio_xmp_render(void *userdata, int16_t *buf, unsigned int frames) {
     assert(audio);
-    xmp_play_buffer(audio->xmp_context, stream, len, 0);
+    xmp_play_buffer(audio->xmp_context, buf, frames * audio->channels * sizeof(int16_t), 0);
+}
+
+// Callback function for the SDL audio device. Runs in the audio thread.
+static void audio_render(void *userdata, Uint8 *stream, int len) {
+    assert(audio);
+    int16_t *out = (int16_t *)stream;
+    unsigned int frames = len / (sizeof(int16_t) * audio->channels);
+    while(frames > 0) {
+        unsigned int chunk = min2(frames, audio->buffer_frames);
+        const int16_t *music = NULL;
+        if(audio->music_playing) {
+            music_stream_read(&audio->music_stream, audio->music_buffer, chunk);
+            music = audio->music_buffer;
+        }
+        mixer_render(&audio->mixer, out, music, chunk);
+        out += chunk * audio->channels;
+        frames -= chunk;
+    }
 }
 
 static void audio_close_module() {
@@ -176,7 +190,10 @@ static void audio_close_module() {
     }
 }
 
-bool audio_init(int freq, bool mono, int resampler, float music_volume, float sound_volume) {
+bool audio_init(int freq, bool mono, int resampler, int music_buffer_ms, float music_volume, float sound_volume) {
+    SDL_AudioSpec want, have;
+
+    music_buffer_ms = clamp(music_buffer_ms, MUSIC_BUFFER_MS_MIN, MUSIC_BUFFER_MS_MAX);
     if(!(audio = omf_calloc(1, sizeof(audio_system)))) {
         PERROR("Unable to allocate audio subsystem");
         goto error_0;
@@ -185,13 +202,9 @@ bool audio_init(int freq, bool mono, int resampler, float music_volume, float so
         PERROR("Unable to initialize audio subsystem: %s", SDL_GetError());
         goto error_1;
     }
-    if(Mix_Init(0) != 0) {
-        PERROR("Unable to initialize mixer subsystem: %s", Mix_GetError());
-        goto error_2;
-    }
     if((audio->xmp_context = xmp_create_context()) == NULL) {
         PERROR("Unable to initialize XMP context.");
-        goto error_3;
+        goto error_2;
     }
 
     INFO("Requested audio device with options:");
@@ -199,14 +212,37 @@ bool audio_init(int freq, bool mono, int resampler, float music_volume, float so
     INFO(" * Channels: %d", mono ? 1 : 2);
     INFO(" * Format: %s", get_sdl_audio_format_string(AUDIO_S16SYS));
 
-    // Setup audio. We request for configuration, but we're not sure what we get.
-    if(Mix_OpenAudio(freq, AUDIO_S16SYS, mono ? 1 : 2, 2048) != 0) {
+    // Setup audio. We request for configuration, but we're not sure what we get. Mixer only
+    // handles 16bit output and up to 2 channels, so let SDL convert those if needed.
+    SDL_zero(want);
+    want.freq = freq;
+    want.format = AUDIO_S16SYS;
+    want.channels = mono ? 1 : 2;
+    want.samples = BUFFER_FRAMES;
+    want.callback = audio_render;
+    audio->device = SDL_OpenAudioDevice(NULL, 0, &want, &have, SDL_AUDIO_ALLOW_FREQUENCY_CHANGE);
+    if(audio->device == 0) {
         PERROR("Unable to initialize audio device: %s", SDL_GetError());
-        goto error_4;
+        goto error_3;
     }
 
-    // Make sure we have the correct amount of channels.
-    Mix_AllocateChannels(CHANNEL_MAX);
+    // Get the actual device configuration we got.
+    audio->freq = have.freq;
+    audio->format = have.format;
+    audio->channels = have.channels;
+    audio->buffer_frames = have.samples;
+    audio->music_buffer = omf_calloc(audio->buffer_frames * audio->channels, sizeof(int16_t));
+    mixer_create(&audio->mixer, audio->freq, audio->channels, audio->buffer_frames);
+    if(!music_stream_create(&audio->music_stream, audio->freq, audio->channels, music_buffer_ms, audio_xmp_render,
+                            NULL)) {
+        goto error_4;
+    }
+    INFO("Opened audio device:");
+    INFO(" * Rate: %dHz", audio->freq);
+    INFO(" * Channels: %d", audio->channels);
+    INFO(" * Format: %s", get_sdl_audio_format_string(audio->format));
+    INFO(" * Voices: %d", MIXER_VOICES);
+    INFO(" * Music buffer: %dms", music_buffer_ms);
 
     // Initialize playback parameters.
     audio_set_sound_volume(sound_volume);
@@ -214,20 +250,15 @@ bool audio_init(int freq, bool mono, int resampler, float music_volume, float so
     audio->resampler = resampler;
     audio->music_id = NUMBER_OF_RESOURCES;
 
-    Mix_ChannelFinished(audio_sound_finished);
-
-    // Get the actual device configuration we got.
-    Mix_QuerySpec(&audio->freq, &audio->format, &audio->channels);
-    INFO("Opened audio device:");
-    INFO(" * Rate: %dHz", audio->freq);
-    INFO(" * Channels: %d", audio->channels);
-    INFO(" * Format: %s", get_sdl_audio_format_string(audio->format));
+    SDL_PauseAudioDevice(audio->device, 0);
     return true;
 
 error_4:
-    xmp_free_context(audio->xmp_context);
+    SDL_CloseAudioDevice(audio->device);
+    mixer_free(&audio->mixer);
+    omf_free(audio->music_buffer);
 error_3:
-    Mix_Quit();
+    xmp_free_context(audio->xmp_context);
 error_2:
     SDL_QuitSubSystem(SDL_INIT_AUDIO);
 error_1:
@@ -239,16 +270,13 @@ error_0:
 
 void audio_close() {
     if(audio != NULL) {
-        audio_stop_music();
+        SDL_CloseAudioDevice(audio->device);
+        music_stream_free(&audio->music_stream);
+        audio->music_playing = false;
         audio_close_module();
-        Mix_ChannelFinished(NULL);
-        Mix_CloseAudio();
-        for(int i = 0; i < CHANNEL_MAX; i++) {
-            if(audio->channel_chunks[i] != NULL) {
-                Mix_FreeChunk(audio->channel_chunks[i]);
-                audio->channel_chunks[i] = NULL;
-            }
-        }
+        mixer_free(&audio->mixer);
+        audio_free_samples();
+        omf_free(audio->music_buffer);
         if(audio->xmp_context) {
             xmp_free_context(audio->xmp_context);
             audio->xmp_context = NULL;
@@ -256,49 +284,41 @@ void audio_close() {
         omf_free(audio);
         audio = NULL;
     }
-    Mix_Quit();
     SDL_QuitSubSystem(SDL_INIT_AUDIO);
 }
 
+bool audio_bind_output(bool enabled) {
+    bool old = audio_output;
+    audio_output = enabled;
+    return old;
+}
+
 void audio_play_sound(int id, float volume, float panning, float pitch) {
+    if(!audio_output)
+        return;
     assert(audio);
-    int channel;
-    Mix_Chunk *chunk;
-    float pan_left, pan_right;
+    const mixer_sample *sample;
 
     // Anything beyond these are invalid
-    if(id < 0 || id > 299)
-        goto error_0;
+    if(id < 0 || id >= SOUND_MAX)
+        return;
 
     volume = clampf(volume, VOLUME_MIN, VOLUME_MAX);
     panning = clampf(panning, PANNING_MIN, PANNING_MAX);
     pitch = clampf(pitch, PITCH_MIN, PITCH_MAX);
-    pan_left = (panning > 0) ? 1.0f - panning : 1.0f;
-    pan_right = (panning < 0) ? 1.0f + panning : 1.0f;
 
-    if((channel = Mix_GroupAvailable(-1)) == -1) {
-        // PERROR("Unable to play sound: No free channels");
-        goto error_0;
-    }
-    if((chunk = audio_get_chunk(id, volume, pitch)) == NULL) {
-        PERROR("Unable to play sound: Failed to load chunk");
-        goto error_0;
+    if((sample = audio_get_sample(id)) == NULL) {
+        PERROR("Unable to play sound: Failed to load sample");
+        return;
     }
-    Mix_SetPanning(channel, clamp(pan_left * 255, 0, 255), clamp(pan_right * 255, 0, 255));
-    if(Mix_PlayChannel(channel, chunk, 0) == -1) {
-        PERROR("Unable to play sound: %s", Mix_GetError());
-        goto error_1;
+    if(!mixer_play(&audio->mixer, sample, volume, panning, pitch)) {
+        PERROR("Unable to play sound: Mixer command queue is full");
     }
-    audio->channel_chunks[channel] = chunk;
-    return;
-
-error_1:
-    free(chunk);
-error_0:
-    return;
 }
 
 void audio_play_music(resource_id id) {
+    if(!audio_output)
+        return;
     assert(audio);
     assert(is_music(id));
     if(audio->music_id != id) {
@@ -310,26 +330,51 @@ void audio_play_music(resource_id id) {
             return;
         }
         audio->music_id = id;
-        Mix_HookMusic(audio_xmp_render, NULL);
+
+        // Let the worker start rendering; the audio callback waits until the buffer is filled.
+        music_stream_lock(&audio->music_stream);
+        music_stream_set_active(&audio->music_stream, true);
+        music_stream_unlock(&audio->music_stream);
+        SDL_LockAudioDevice(audio->device);
+        audio->music_playing = true;
+        SDL_UnlockAudioDevice(audio->device);
     }
 }
 
 void audio_stop_music() {
+    if(!audio_output)
+        return;
     assert(audio);
-    Mix_HaltMusic();
-    Mix_HookMusic(NULL, NULL);
+
+    // Stop both the producer and the consumer, so that the stale music can be dropped.
+    music_stream_lock(&audio->music_stream);
+    SDL_LockAudioDevice(audio->device);
+    audio->music_playing = false;
+    music_stream_clear(&audio->music_stream);
+    SDL_UnlockAudioDevice(audio->device);
+    music_stream_set_active(&audio->music_stream, false);
+    music_stream_unlock(&audio->music_stream);
 }
 
 void audio_set_music_volume(float volume) {
     assert(audio);
     audio->music_volume = clampf(volume, VOLUME_MIN, VOLUME_MAX);
-    xmp_set_player(audio->xmp_context, XMP_PLAYER_VOLUME, audio->music_volume * 100);
+    mixer_set_music_volume(&audio->mixer, audio->music_volume);
 }
 
 void audio_set_sound_volume(float volume) {
     assert(audio);
-    volume = clampf(volume, VOLUME_MIN, VOLUME_MAX);
-    Mix_Volume(-1, volume * MIX_MAX_VOLUME);
+    mixer_set_volume(&audio->mixer, clampf(volume, VOLUME_MIN, VOLUME_MAX));
+}
+
+void audio_get_stats(audio_stats *stats) {
+    assert(audio);
+    music_stream_stats ms;
+    music_stream_get_stats(&audio->music_stream, &ms);
+    stats->music_underruns = ms.underruns;
+    stats->music_underrun_ms = (unsigned int)((uint64_t)ms.underrun_frames * 1000 / audio->freq);
+    stats->music_buffered_ms = ms.buffered_frames * 1000 / audio->freq;
+    stats->music_buffer_ms = ms.capacity_frames * 1000 / audio->freq;
 }
 
 const audio_freq *audio_get_freqs() {
@@ -338,4 +383,4 @@ const audio_freq *audio_get_freqs() {
 
 const audio_mod_resampler *audio_get_resamplers() {
     return music_resamplers;
-}
\ No newline at end of file
+}
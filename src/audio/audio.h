@@ -17,12 +17,22 @@
 #define PANNING_MIN -1.0f
 #define PITCH_MIN 0.5f
 
+#define MUSIC_BUFFER_MS_MIN 20
+#define MUSIC_BUFFER_MS_MAX 2000
+
 typedef struct audio_mod_resampler {
     int internal_id;
     int is_default;
     const char *name;
 } audio_mod_resampler;
 
+typedef struct audio_stats {
+    unsigned int music_underruns;   // Times the music stream ran dry
+    unsigned int music_underrun_ms; // Total music time replaced with silence
+    unsigned int music_buffered_ms; // Music currently rendered ahead
+    unsigned int music_buffer_ms;   // Size of the music render-ahead buffer
+} audio_stats;
+
 typedef struct audio_freq {
     int freq;
     int is_default;
@@ -35,17 +45,27 @@ typedef struct audio_freq {
  * @param freq Wanted output frequency (48000 should be fine)
  * @param mono True if 1 channel, False for 2.
  * @param resampler Music module resampler interpolation
+ * @param music_buffer_ms How many milliseconds of music to render ahead, clamped to MUSIC_BUFFER_MS_MIN..MAX
  * @param music_volume Initial music volume
  * @param sound_volume Initial audio volume
  * @return True if initialized, false if not.
  */
-bool audio_init(int freq, bool mono, int resampler, float music_volume, float sound_volume);
+bool audio_init(int freq, bool mono, int resampler, int music_buffer_ms, float music_volume, float sound_volume);
 
 /**
  * Closes the audio subsystem.
  */
 void audio_close();
 
+/**
+ * Enables or disables sound and music output for the calling thread. Simulations that
+ * run without a player, eg. headless replays, turn this off.
+ *
+ * @param enabled True to play sounds (default), false to ignore them.
+ * @return The previous setting of the calling thread.
+ */
+bool audio_bind_output(bool enabled);
+
 /**
  * Plays sound with given parameters.
  *
@@ -80,6 +100,11 @@ void audio_set_music_volume(float volume);
  */
 void audio_set_sound_volume(float volume);
 
+/**
+ * Get playback statistics, eg. for tuning the music buffer size.
+ */
+void audio_get_stats(audio_stats *stats);
+
 /**
  * Get supported audio frequencies list
  */
@@ -0,0 +1,213 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "audio/mixer.h"
+#include "utils/allocator.h"
+#include "utils/miscmath.h"
+
+#define COMMAND_QUEUE_SIZE 256
+
+typedef struct mixer_command {
+    const mixer_sample *sample;
+    uint32_t step;
+    int32_t gain_l;
+    int32_t gain_r;
+} mixer_command;
+
+void mixer_create(mixer *m, int freq, int channels, unsigned int max_frames) {
+    assert(channels == 1 || channels == 2);
+    memset(m, 0, sizeof(mixer));
+    m->freq = freq;
+    m->channels = channels;
+    atomic_init(&m->sound_gain, 256);
+    atomic_init(&m->music_gain, 256);
+    m->accum_frames = max_frames;
+    m->accum = omf_calloc(max_frames * channels, sizeof(int32_t));
+    ringbuffer_create(&m->commands, COMMAND_QUEUE_SIZE, sizeof(mixer_command));
+}
+
+void mixer_free(mixer *m) {
+    ringbuffer_free(&m->commands);
+    omf_free(m->accum);
+}
+
+bool mixer_play(mixer *m, const mixer_sample *sample, float volume, float panning, float pitch) {
+    mixer_command cmd;
+    float pan_left = (panning > 0) ? 1.0f - panning : 1.0f;
+    float pan_right = (panning < 0) ? 1.0f + panning : 1.0f;
+    cmd.sample = sample;
+    cmd.step = (uint32_t)(65536.0 * sample->freq * pitch / m->freq);
+    if(m->channels == 1) {
+        cmd.gain_l = cmd.gain_r = volume * 256;
+    } else {
+        cmd.gain_l = volume * pan_left * 256;
+        cmd.gain_r = volume * pan_right * 256;
+    }
+    return ringbuffer_push(&m->commands, &cmd);
+}
+
+// Volumes are not queued. Only the latest one matters, and the render picks it up from the next buffer on.
+void mixer_set_volume(mixer *m, float volume) {
+    atomic_store_explicit(&m->sound_gain, (int)(volume * 256), memory_order_relaxed);
+}
+
+void mixer_set_music_volume(mixer *m, float volume) {
+    atomic_store_explicit(&m->music_gain, (int)(volume * 256), memory_order_relaxed);
+}
+
+// Picks a free voice, or steals the one that has been playing the longest.
+static mixer_voice *mixer_find_voice(mixer *m) {
+    mixer_voice *oldest = &m->voices[0];
+    for(int i = 0; i < MIXER_VOICES; i++) {
+        mixer_voice *v = &m->voices[i];
+        if(v->sample == NULL) {
+            return v;
+        }
+        if((int32_t)(v->serial - oldest->serial) < 0) {
+            oldest = v;
+        }
+    }
+    return oldest;
+}
+
+static void mixer_handle_commands(mixer *m) {
+    mixer_command cmd;
+    while(ringbuffer_pop(&m->commands, &cmd)) {
+        mixer_voice *v = mixer_find_voice(m);
+        v->sample = cmd.sample;
+        v->pos = 0;
+        v->step = cmd.step;
+        v->gain_l = cmd.gain_l;
+        v->gain_r = cmd.gain_r;
+        v->serial = m->serial++;
+    }
+}
+
+// Resamples one voice with linear interpolation and adds it to the accumulator.
+// Sample data has a trailing zero, so reading idx + 1 at the last sample is fine.
+static void mixer_mix_voice(mixer *m, mixer_voice *v, int32_t sound_gain, unsigned int frames) {
+    const int16_t *data = v->sample->data;
+    const uint64_t end = (uint64_t)v->sample->len << 16;
+    const int32_t gain_l = (v->gain_l * sound_gain) >> 8;
+    const int32_t gain_r = (v->gain_r * sound_gain) >> 8;
+    int32_t *acc = m->accum;
+    uint64_t pos = v->pos;
+    unsigned int i = 0;
+
+#if defined(__SSE2__)
+    // Sample pairs are fetched one frame at a time, straight into registers, and the math is done for 4 frames
+    // at once.
+    // a + (((b - a) * frac) >> 15) equals (a * (32768 - frac) + b * frac) >> 15. The weight 32768 does not fit
+    // 16 bits, so madd computes a * (32767 - frac) + b * frac and a is added separately. Gains are at most 256,
+    // and madd against a gain in the low half of each lane gives sample * gain.
+    const uint64_t step = v->step;
+    const __m128i gains = _mm_set_epi32(gain_r, gain_l, gain_r, gain_l);
+    const __m128i offsets = _mm_set_epi32(3 * v->step, 2 * v->step, v->step, 0);
+    const __m128i frac_mask = _mm_set1_epi32(0xFFFF);
+    const __m128i frac_max = _mm_set1_epi32(32767);
+    for(; i + 4 <= frames && pos + 3 * step < end; i += 4) {
+        int32_t p0, p1, p2, p3;
+        memcpy(&p0, data + (pos >> 16), sizeof(int32_t));
+        memcpy(&p1, data + ((pos + step) >> 16), sizeof(int32_t));
+        memcpy(&p2, data + ((pos + 2 * step) >> 16), sizeof(int32_t));
+        memcpy(&p3, data + ((pos + 3 * step) >> 16), sizeof(int32_t));
+        __m128i frac = _mm_add_epi32(_mm_set1_epi32((uint32_t)pos), offsets);
+        frac = _mm_srli_epi32(_mm_and_si128(frac, frac_mask), 1);
+        __m128i weights = _mm_or_si128(_mm_slli_epi32(frac, 16), _mm_sub_epi32(frac_max, frac));
+        __m128i ab = _mm_unpacklo_epi64(_mm_unpacklo_epi32(_mm_cvtsi32_si128(p0), _mm_cvtsi32_si128(p1)),
+                                        _mm_unpacklo_epi32(_mm_cvtsi32_si128(p2), _mm_cvtsi32_si128(p3)));
+        __m128i a = _mm_srai_epi32(_mm_slli_epi32(ab, 16), 16);
+        __m128i s = _mm_madd_epi16(ab, weights);
+        s = _mm_srai_epi32(_mm_add_epi32(s, a), 15);
+        if(m->channels == 2) {
+            __m128i *dst = (__m128i *)(acc + i * 2);
+            __m128i lo = _mm_srai_epi32(_mm_madd_epi16(_mm_unpacklo_epi32(s, s), gains), 8);
+            __m128i hi = _mm_srai_epi32(_mm_madd_epi16(_mm_unpackhi_epi32(s, s), gains), 8);
+            _mm_storeu_si128(dst, _mm_add_epi32(_mm_loadu_si128(dst), lo));
+            _mm_storeu_si128(dst + 1, _mm_add_epi32(_mm_loadu_si128(dst + 1), hi));
+        } else {
+            __m128i *dst = (__m128i *)(acc + i);
+            __m128i mono = _mm_srai_epi32(_mm_madd_epi16(s, _mm_set1_epi32(gain_l)), 8);
+            _mm_storeu_si128(dst, _mm_add_epi32(_mm_loadu_si128(dst), mono));
+        }
+        pos += 4 * step;
+    }
+#endif
+
+    if(m->channels == 2) {
+        for(; i < frames && pos < end; i++) {
+            uint32_t idx = (uint32_t)(pos >> 16);
+            int32_t frac = (pos & 0xFFFF) >> 1;
+            int32_t s = data[idx] + (((data[idx + 1] - data[idx]) * frac) >> 15);
+            acc[i * 2 + 0] += (s * gain_l) >> 8;
+            acc[i * 2 + 1] += (s * gain_r) >> 8;
+            pos += v->step;
+        }
+    } else {
+        for(; i < frames && pos < end; i++) {
+            uint32_t idx = (uint32_t)(pos >> 16);
+            int32_t frac = (pos & 0xFFFF) >> 1;
+            int32_t s = data[idx] + (((data[idx + 1] - data[idx]) * frac) >> 15);
+            acc[i] += (s * gain_l) >> 8;
+            pos += v->step;
+        }
+    }
+
+    v->pos = pos;
+    if(pos >= end) {
+        v->sample = NULL;
+    }
+}
+
+// Adds music to the accumulated effects and saturates the result to 16 bits.
+static void mixer_write_output(const int32_t *acc, const int16_t *music, int32_t music_gain, int16_t *out,
+                               unsigned int count) {
+    unsigned int i = 0;
+#if defined(__SSE2__)
+    // Music samples are widened to 32 bits by interleaving them with zeroes, so that madd computes
+    // sample * gain for each one. Gain is at most 256, so it fits the low 16 bits of each 32bit lane.
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i gain = _mm_set1_epi32(music_gain);
+    for(; i + 8 <= count; i += 8) {
+        __m128i lo = _mm_loadu_si128((const __m128i *)(acc + i));
+        __m128i hi = _mm_loadu_si128((const __m128i *)(acc + i + 4));
+        if(music != NULL) {
+            __m128i mus = _mm_loadu_si128((const __m128i *)(music + i));
+            lo = _mm_add_epi32(lo, _mm_srai_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(mus, zero), gain), 8));
+            hi = _mm_add_epi32(hi, _mm_srai_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(mus, zero), gain), 8));
+        }
+        _mm_storeu_si128((__m128i *)(out + i), _mm_packs_epi32(lo, hi));
+    }
+#endif
+    for(; i < count; i++) {
+        int32_t s = acc[i] + (music != NULL ? (music[i] * music_gain) >> 8 : 0);
+        out[i] = clamp(s, INT16_MIN, INT16_MAX);
+    }
+}
+
+void mixer_render(mixer *m, int16_t *out, const int16_t *music, unsigned int frames) {
+    const int32_t sound_gain = atomic_load_explicit(&m->sound_gain, memory_order_relaxed);
+    const int32_t music_gain = atomic_load_explicit(&m->music_gain, memory_order_relaxed);
+    mixer_handle_commands(m);
+    while(frames > 0) {
+        unsigned int chunk = min2(frames, m->accum_frames);
+        unsigned int count = chunk * m->channels;
+        memset(m->accum, 0, count * sizeof(int32_t));
+        for(int i = 0; i < MIXER_VOICES; i++) {
+            if(m->voices[i].sample != NULL) {
+                mixer_mix_voice(m, &m->voices[i], sound_gain, chunk);
+            }
+        }
+        mixer_write_output(m->accum, music, music_gain, out, count);
+        out += count;
+        if(music != NULL) {
+            music += count;
+        }
+        frames -= chunk;
+    }
+}
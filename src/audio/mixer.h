@@ -0,0 +1,89 @@
+#ifndef MIXER_H
+#define MIXER_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "utils/ringbuffer.h"
+
+#define MIXER_VOICES 32
+
+/**
+ * Sound effect source data for the mixer: signed 16bit mono samples. Data must have len + 1
+ * entries, with a zero as the last one. The mixer never copies or frees sample data; it must
+ * stay alive while the mixer exists.
+ */
+typedef struct mixer_sample {
+    int16_t *data;
+    uint32_t len;
+    int freq;
+} mixer_sample;
+
+typedef struct mixer_voice {
+    const mixer_sample *sample;
+    uint64_t pos;    // 48.16 fixed point position in the sample
+    uint32_t step;   // 16.16 fixed point position increment per output frame
+    int32_t gain_l;  // Q8 gain for the left (or mono) channel
+    int32_t gain_r;  // Q8 gain for the right channel
+    uint32_t serial; // Start order, used for voice stealing
+} mixer_voice;
+
+typedef struct mixer {
+    int freq;
+    int channels;
+    atomic_int sound_gain; // Q8 master gain for all sound effects. Set directly, so that updates can't be dropped.
+    atomic_int music_gain; // Q8 gain for the music stream
+    uint32_t serial;
+    mixer_voice voices[MIXER_VOICES];
+    ringbuffer commands;
+    int32_t *accum;
+    unsigned int accum_frames;
+} mixer;
+
+/**
+ * Creates a mixer for the given output configuration.
+ *
+ * @param m Mixer to initialize
+ * @param freq Output frequency
+ * @param channels Output channels, 1 or 2
+ * @param max_frames Largest amount of frames rendered at once. Larger requests are split.
+ */
+void mixer_create(mixer *m, int freq, int channels, unsigned int max_frames);
+void mixer_free(mixer *m);
+
+/**
+ * Game thread: Queue a sound effect for playback. Does not block or allocate.
+ * If all voices are busy, the oldest playing voice is replaced.
+ *
+ * @param m Mixer
+ * @param sample Sample to play
+ * @param volume Volume 0.0f ... 1.0f
+ * @param panning Panning -1.0f ... 1.0f
+ * @param pitch Playback speed multiplier
+ * @return True if queued, false if the command queue is full.
+ */
+bool mixer_play(mixer *m, const mixer_sample *sample, float volume, float panning, float pitch);
+
+/**
+ * Game thread: Set master volume for sound effects. Sounds that are already playing follow it
+ * from the next rendered buffer on.
+ */
+void mixer_set_volume(mixer *m, float volume);
+
+/**
+ * Game thread: Set volume for the music stream blended in by mixer_render.
+ */
+void mixer_set_music_volume(mixer *m, float volume);
+
+/**
+ * Audio thread: Render frames into the output buffer.
+ *
+ * @param m Mixer
+ * @param out Output buffer for interleaved signed 16bit samples
+ * @param music Interleaved music samples to blend in, or NULL if no music is playing.
+ * @param frames Amount of frames to render
+ */
+void mixer_render(mixer *m, int16_t *out, const int16_t *music, unsigned int frames);
+
+#endif // MIXER_H
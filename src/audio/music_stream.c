@@ -0,0 +1,128 @@
+#include <assert.h>
+#include <string.h>
+
+#include "audio/music_stream.h"
+#include "utils/allocator.h"
+#include "utils/log.h"
+#include "utils/miscmath.h"
+
+// Frames rendered per source call. The lock is only held for one chunk at a time.
+#define CHUNK_FRAMES 512
+
+// How long the worker sleeps at most if nobody wakes it up.
+#define WORKER_WAIT_MS 10
+
+static int music_stream_worker(void *userdata) {
+    music_stream *stream = userdata;
+    while(atomic_load(&stream->running)) {
+        // Let go of the lock between chunks, so that starting or stopping music does not wait for a full buffer
+        bool filled = false;
+        while(!filled && atomic_load(&stream->running)) {
+            SDL_LockMutex(stream->lock);
+            filled = !stream->active || ringbuffer_space(&stream->ring) < stream->chunk_frames;
+            if(!filled) {
+                stream->render(stream->userdata, stream->chunk, stream->chunk_frames);
+                ringbuffer_write(&stream->ring, stream->chunk, stream->chunk_frames);
+            }
+            SDL_UnlockMutex(stream->lock);
+        }
+        SDL_SemWaitTimeout(stream->wake, WORKER_WAIT_MS);
+    }
+    return 0;
+}
+
+bool music_stream_create(music_stream *stream, int freq, int channels, unsigned int buffer_ms,
+                         music_stream_render_func render, void *userdata) {
+    memset(stream, 0, sizeof(music_stream));
+    unsigned int frames = max2(freq * buffer_ms / 1000, CHUNK_FRAMES * 2);
+    ringbuffer_create(&stream->ring, frames, channels * sizeof(int16_t));
+    stream->channels = channels;
+    stream->render = render;
+    stream->userdata = userdata;
+    stream->chunk_frames = CHUNK_FRAMES;
+    stream->chunk = omf_calloc(CHUNK_FRAMES * channels, sizeof(int16_t));
+    stream->lock = SDL_CreateMutex();
+    stream->wake = SDL_CreateSemaphore(0);
+    atomic_init(&stream->underruns, 0);
+    atomic_init(&stream->underrun_frames, 0);
+    atomic_init(&stream->running, true);
+    if(stream->lock == NULL || stream->wake == NULL) {
+        PERROR("Unable to create music stream synchronization primitives: %s", SDL_GetError());
+        goto error_0;
+    }
+    if((stream->thread = SDL_CreateThread(music_stream_worker, "music_stream", stream)) == NULL) {
+        PERROR("Unable to create music stream thread: %s", SDL_GetError());
+        goto error_0;
+    }
+    DEBUG("Music stream buffer is %u frames (%u ms)", ringbuffer_capacity(&stream->ring),
+          ringbuffer_capacity(&stream->ring) * 1000 / freq);
+    return true;
+
+error_0:
+    atomic_store(&stream->running, false);
+    music_stream_free(stream);
+    return false;
+}
+
+void music_stream_free(music_stream *stream) {
+    if(stream->thread != NULL) {
+        atomic_store(&stream->running, false);
+        SDL_SemPost(stream->wake);
+        SDL_WaitThread(stream->thread, NULL);
+        stream->thread = NULL;
+    }
+    if(stream->wake != NULL) {
+        SDL_DestroySemaphore(stream->wake);
+        stream->wake = NULL;
+    }
+    if(stream->lock != NULL) {
+        SDL_DestroyMutex(stream->lock);
+        stream->lock = NULL;
+    }
+    omf_free(stream->chunk);
+    ringbuffer_free(&stream->ring);
+}
+
+void music_stream_lock(music_stream *stream) {
+    SDL_LockMutex(stream->lock);
+}
+
+void music_stream_unlock(music_stream *stream) {
+    SDL_UnlockMutex(stream->lock);
+    SDL_SemPost(stream->wake);
+}
+
+void music_stream_set_active(music_stream *stream, bool active) {
+    stream->active = active;
+}
+
+void music_stream_clear(music_stream *stream) {
+    ringbuffer_clear(&stream->ring);
+    stream->primed = false;
+}
+
+void music_stream_read(music_stream *stream, int16_t *out, unsigned int frames) {
+    unsigned int got = 0;
+
+    // After a clear, wait for the worker to fill up half of the buffer before starting playback.
+    // This way the start of a track is not counted as an underrun.
+    if(!stream->primed && ringbuffer_size(&stream->ring) >= ringbuffer_capacity(&stream->ring) / 2) {
+        stream->primed = true;
+    }
+    if(stream->primed) {
+        got = ringbuffer_read(&stream->ring, out, frames);
+        if(got < frames) {
+            atomic_fetch_add(&stream->underruns, 1);
+            atomic_fetch_add(&stream->underrun_frames, frames - got);
+        }
+    }
+    memset(out + got * stream->channels, 0, (frames - got) * stream->channels * sizeof(int16_t));
+    SDL_SemPost(stream->wake);
+}
+
+void music_stream_get_stats(music_stream *stream, music_stream_stats *stats) {
+    stats->underruns = atomic_load(&stream->underruns);
+    stats->underrun_frames = atomic_load(&stream->underrun_frames);
+    stats->buffered_frames = ringbuffer_size(&stream->ring);
+    stats->capacity_frames = ringbuffer_capacity(&stream->ring);
+}
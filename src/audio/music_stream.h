@@ -0,0 +1,92 @@
+#ifndef MUSIC_STREAM_H
+#define MUSIC_STREAM_H
+
+#include <SDL.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "utils/ringbuffer.h"
+
+/**
+ * Render callback for the stream source. Called from the stream worker thread.
+ *
+ * @param userdata Userdata given to music_stream_create
+ * @param buf Buffer for interleaved signed 16bit samples
+ * @param frames Amount of frames to render
+ */
+typedef void (*music_stream_render_func)(void *userdata, int16_t *buf, unsigned int frames);
+
+typedef struct music_stream_stats {
+    unsigned int underruns;       // Audio callbacks that did not get enough music data
+    unsigned int underrun_frames; // Total frames replaced with silence due to underruns
+    unsigned int buffered_frames; // Frames currently rendered ahead
+    unsigned int capacity_frames; // Size of the render-ahead buffer
+} music_stream_stats;
+
+/**
+ * Renders music ahead of time on a worker thread into a lock-free ring buffer. The audio callback
+ * only copies from the ring, so slow module rendering does not eat into the callback deadline.
+ */
+typedef struct music_stream {
+    ringbuffer ring; // One element is one interleaved frame
+    int channels;
+    SDL_Thread *thread;
+    SDL_mutex *lock;
+    SDL_sem *wake;
+    atomic_bool running;
+    bool active;
+    bool primed;
+    music_stream_render_func render;
+    void *userdata;
+    int16_t *chunk;
+    unsigned int chunk_frames;
+    atomic_uint underruns;
+    atomic_uint underrun_frames;
+} music_stream;
+
+/**
+ * Creates the stream and starts its worker thread. The stream starts inactive.
+ *
+ * @param stream Stream to initialize
+ * @param freq Output frequency
+ * @param channels Output channels
+ * @param buffer_ms How many milliseconds of audio to render ahead
+ * @param render Source render callback
+ * @param userdata Passed to the render callback
+ * @return True on success, false if the worker thread could not be started.
+ */
+bool music_stream_create(music_stream *stream, int freq, int channels, unsigned int buffer_ms,
+                         music_stream_render_func render, void *userdata);
+void music_stream_free(music_stream *stream);
+
+/**
+ * Game thread: Pauses the worker so that the source may be modified. While locked, the render
+ * callback is guaranteed not to be running.
+ */
+void music_stream_lock(music_stream *stream);
+void music_stream_unlock(music_stream *stream);
+
+/**
+ * Game thread, with the stream locked: Start or stop rendering from the source.
+ */
+void music_stream_set_active(music_stream *stream, bool active);
+
+/**
+ * Drop all rendered-ahead data. The stream must be locked, and the consumer must not be running
+ * (eg. audio device locked).
+ */
+void music_stream_clear(music_stream *stream);
+
+/**
+ * Audio thread: Read frames from the stream. Missing frames are filled with silence and counted
+ * as an underrun, unless the stream has not yet been filled after a clear.
+ */
+void music_stream_read(music_stream *stream, int16_t *out, unsigned int frames);
+
+/**
+ * Get current stream statistics. Safe to call from any thread.
+ */
+void music_stream_get_stats(music_stream *stream, music_stream_stats *stats);
+
+#endif // MUSIC_STREAM_H
@@ -5,6 +5,7 @@
 #include "game/scenes/mechlab.h"
 #include "resources/ids.h"
 #include "utils/allocator.h"
+#include "utils/profiler.h"
 #include <stdio.h>
 
 // utils
@@ -133,8 +134,10 @@ int console_cmd_har(game_state *gs, int argc, char **argv) {
                 // Set HAR for player
                 game_player_set_har(player, obj);
                 game_player_get_ctrl(player)->har = obj;
-                game_player_get_har(player)->animation_state.enemy = game_player_get_har(game_state_get_player(gs, 1));
-                game_player_get_har(game_state_get_player(gs, 1))->animation_state.enemy = game_player_get_har(player);
+                game_player_get_har(player)->animation_state.enemy =
+                    game_player_get_har(game_state_get_player(gs, 1))->handle;
+                game_player_get_har(game_state_get_player(gs, 1))->animation_state.enemy =
+                    game_player_get_har(player)->handle;
 
                 maybe_install_har_hooks(game_state_get_scene(gs));
             } else if(gs->this_id == SCENE_MECHLAB) {
@@ -234,6 +237,45 @@ int console_cmd_music(game_state *gs, int argc, char **argv) {
     return 0;
 }
 
+int console_cmd_audiostats(game_state *gs, int argc, char **argv) {
+    audio_stats stats;
+    char buf[64];
+    audio_get_stats(&stats);
+    snprintf(buf, sizeof(buf), "music buffer: %u/%u ms", stats.music_buffered_ms, stats.music_buffer_ms);
+    console_output_addline(buf);
+    snprintf(buf, sizeof(buf), "music underruns: %u (%u ms)", stats.music_underruns, stats.music_underrun_ms);
+    console_output_addline(buf);
+    return 0;
+}
+
+int console_cmd_profile(game_state *gs, int argc, char **argv) {
+    char buf[64];
+    profile_stats stats;
+    if(argc == 2 && strcmp(argv[1], "reset") == 0) {
+        profiler_reset();
+        return 0;
+    }
+    if(argc == 3 && strcmp(argv[1], "csv") == 0) {
+        if(profiler_write_csv(argv[2])) {
+            return 1;
+        }
+        snprintf(buf, sizeof(buf), "wrote %u frames to %s", profiler_frames(), argv[2]);
+        console_output_addline(buf);
+        return 0;
+    }
+    if(argc != 1) {
+        return 1;
+    }
+    console_output_addline("phase     p50   p99   max  calls");
+    for(int i = 0; i < NUMBER_OF_PROFILE_PHASES; i++) {
+        profiler_get_stats(i, &stats);
+        snprintf(buf, sizeof(buf), "%-8s%6u%6u%6u%7u", profiler_phase_name(i), stats.p50_us, stats.p99_us,
+                 stats.max_us, stats.max_calls);
+        console_output_addline(buf);
+    }
+    return 0;
+}
+
 int console_cmd_money(game_state *gs, int argc, char **argv) {
     // change pilot's money
     if(argc == 2) {
@@ -269,6 +311,33 @@ int console_cmd_rank(game_state *gs, int argc, char **argv) {
     return 1;
 }
 
+int console_cmd_seek(game_state *gs, int argc, char **argv) {
+    int i;
+    if(argc == 2 && strtoint(argv[1], &i) && i >= 0) {
+        return game_state_seek(gs, i);
+    }
+    return 1;
+}
+
+int console_cmd_ff(game_state *gs, int argc, char **argv) {
+    int i;
+    if(argc == 2 && strtoint(argv[1], &i) && i > 0) {
+        game_state_fast_forward(gs, i);
+        return 0;
+    }
+    return 1;
+}
+
+int console_cmd_step(game_state *gs, int argc, char **argv) {
+    int i = 1;
+    if(argc > 2 || (argc == 2 && (!strtoint(argv[1], &i) || i <= 0))) {
+        return 1;
+    }
+    game_state_set_paused(gs, 1);
+    game_state_fast_forward(gs, i);
+    return 0;
+}
+
 void console_init_cmd() {
     // Add console commands
     console_add_cmd("h", &console_cmd_history, "show command history");
@@ -279,6 +348,9 @@ void console_init_cmd() {
     console_add_cmd("help", &console_cmd_help, "show all commands");
     console_add_cmd("scene", &console_cmd_scene, "change scene. usage: scene 1, scene 2, etc");
     console_add_cmd("music", &console_cmd_music, "Play specified song (0-6)");
+    console_add_cmd("audiostats", &console_cmd_audiostats, "Show music streaming statistics");
+    console_add_cmd("profile", &console_cmd_profile,
+                    "Show frame phase timings in us. usage: profile, profile reset, profile csv <file>");
     console_add_cmd("har", &console_cmd_har, "change har. usage: har 1, har 2, etc");
     console_add_cmd("win", &console_cmd_win, "Set the other player's health to 0");
     console_add_cmd("lose", &console_cmd_lose, "Set your health to 0");
@@ -290,4 +362,7 @@ void console_init_cmd() {
     console_add_cmd("warp", &console_toggle_warp, "Toggle warp speed");
     console_add_cmd("money", &console_cmd_money, "Set tournament mode money");
     console_add_cmd("rank", &console_cmd_rank, "Set tournament mode rank");
+    console_add_cmd("seek", &console_cmd_seek, "Seek a recording to a tick. usage: seek 1000");
+    console_add_cmd("ff", &console_cmd_ff, "Fast forward a number of ticks. usage: ff 100");
+    console_add_cmd("step", &console_cmd_step, "Pause and advance one or more ticks. usage: step, step 5");
 }
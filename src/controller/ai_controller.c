@@ -204,7 +204,7 @@ int char_to_act(int ch, int direction) {
  *
  * \return Void.
  */
-void chain_controller_cmd(controller *ctrl, int commands[], size_t n_commands, ctrl_event **ev) {
+void chain_controller_cmd(controller *ctrl, int commands[], size_t n_commands, ctrl_event_queue *ev) {
     for(size_t i = 0; i < n_commands; i++) {
         controller_cmd(ctrl, commands[i], ev);
     }
@@ -1402,6 +1402,26 @@ bool is_valid_move(const af_move *move, const har *h, bool force_allow_projectil
     return false;
 }
 
+/**
+ * \brief Gets the pose of a HAR for looking up playable moves in the move index.
+ *
+ * \param h The HAR instance.
+ *
+ * \return An AF_POSE_* value
+ */
+static int har_pose(const har *h) {
+    switch(h->state) {
+        case STATE_JUMPING:
+            return AF_POSE_AIR;
+        case STATE_VICTORY:
+            return AF_POSE_VICTORY;
+        case STATE_SCRAP:
+            return AF_POSE_SCRAP;
+        default:
+            return AF_POSE_GROUND;
+    }
+}
+
 /**
  * \brief Sets the selected move.
  *
@@ -1445,47 +1465,43 @@ bool assign_move_by_cat(controller *ctrl, int category, bool highest_damage) {
     int top_value = 0;
 
     // Attack
-    for(int i = 0; i < 70; i++) {
-        af_move *move = NULL;
-        if((move = af_get_move(h->af_data, i))) {
-            // category filter
-            if(category != move->category) {
-                continue;
-            }
-
-            move_stat *ms = &a->move_stats[i];
-            if(is_valid_move(move, h, true)) {
-                int value;
-                if(highest_damage) {
-                    // evaluate the move based purely on damage
-                    value = (int)move->damage * 10;
-                } else {
-                    // evaluate the move based on learning reinforcement
-                    value = ms->value + rand_int(10);
-                    if(learning_moment(a) && ms->min_hit_dist != -1) {
-                        if(ms->last_dist < ms->max_hit_dist + 5 && ms->last_dist > ms->min_hit_dist + 5) {
-                            value += 2;
-                        } else if(ms->last_dist > ms->max_hit_dist + 10) {
-                            value -= 3;
-                        }
-                    }
-
-                    // smart AI will slightly favor high damage moves
-                    if(smart_usually(a)) {
-                        value += ((int)move->damage / 3);
+    int count;
+    const uint8_t *ids = af_move_index_category(&h->af_data->index, category, &count);
+    for(int k = 0; k < count; k++) {
+        int i = ids[k];
+        af_move *move = &h->af_data->moves[i];
+        move_stat *ms = &a->move_stats[i];
+        if(is_valid_move(move, h, true)) {
+            int value;
+            if(highest_damage) {
+                // evaluate the move based purely on damage
+                value = (int)move->damage * 10;
+            } else {
+                // evaluate the move based on learning reinforcement
+                value = ms->value + rand_int(10);
+                if(learning_moment(a) && ms->min_hit_dist != -1) {
+                    if(ms->last_dist < ms->max_hit_dist + 5 && ms->last_dist > ms->min_hit_dist + 5) {
+                        value += 2;
+                    } else if(ms->last_dist > ms->max_hit_dist + 10) {
+                        value -= 3;
                     }
-
-                    value -= ms->attempts / 2;
-                    value -= ms->consecutive * 2;
                 }
 
-                if(selected_move == NULL) {
-                    selected_move = move;
-                    top_value = value;
-                } else if(value > top_value) {
-                    selected_move = move;
-                    top_value = value;
+                // smart AI will slightly favor high damage moves
+                if(smart_usually(a)) {
+                    value += ((int)move->damage / 3);
                 }
+
+                value -= ms->attempts / 2;
+                value -= ms->consecutive * 2;
+            }
+
+            if(selected_move == NULL) {
+                selected_move = move;
+                top_value = value;
+            } else if(value > top_value) {
+                selected_move = move;
+                top_value = value;
             }
         }
     }
@@ -1514,20 +1530,14 @@ bool assign_move_by_id(controller *ctrl, int move_id) {
     object *o = ctrl->har;
     har *h = object_get_userdata(o);
 
-    for(int i = 0; i < 70; i++) {
-        af_move *move = NULL;
-        if((move = af_get_move(h->af_data, i))) {
-            if(is_valid_move(move, h, true)) {
-                // move_id filter
-                if(move_id != move->id) {
-                    continue;
-                }
-
-                // DEBUG("=== assign_move_by_id === id %d", move_id);
-                set_selected_move(ctrl, move);
-                return true;
-            }
-        }
+    if(move_id < 0 || move_id >= 70) {
+        return false;
+    }
+    af_move *move = af_get_move(h->af_data, move_id);
+    if(move != NULL && is_valid_move(move, h, true)) {
+        // DEBUG("=== assign_move_by_id === id %d", move_id);
+        set_selected_move(ctrl, move);
+        return true;
     }
 
     return false;
@@ -1541,7 +1551,7 @@ bool assign_move_by_id(controller *ctrl, int move_id) {
  *
  * \return A boolean indicating whether the attack was blocked.
  */
-int ai_block_har(controller *ctrl, ctrl_event **ev) {
+int ai_block_har(controller *ctrl, ctrl_event_queue *ev) {
     ai *a = ctrl->data;
     object *o = ctrl->har;
     har *h = object_get_userdata(o);
@@ -1570,7 +1580,7 @@ int ai_block_har(controller *ctrl, ctrl_event **ev) {
  *
  * \return A boolean indicating whether the projectile was blocked.
  */
-int ai_block_projectile(controller *ctrl, ctrl_event **ev) {
+int ai_block_projectile(controller *ctrl, ctrl_event_queue *ev) {
     ai *a = ctrl->data;
     object *o = ctrl->har;
 
@@ -1609,7 +1619,7 @@ int ai_block_projectile(controller *ctrl, ctrl_event **ev) {
  *
  * \return Void.
  */
-void process_selected_move(controller *ctrl, ctrl_event **ev) {
+void process_selected_move(controller *ctrl, ctrl_event_queue *ev) {
     ai *a = ctrl->data;
     object *o = ctrl->har;
 
@@ -1639,7 +1649,7 @@ void process_selected_move(controller *ctrl, ctrl_event **ev) {
  *
  * \return Void.
  */
-void handle_movement(controller *ctrl, ctrl_event **ev) {
+void handle_movement(controller *ctrl, ctrl_event_queue *ev) {
     ai *a = ctrl->data;
     object *o = ctrl->har;
     har *h = object_get_userdata(o);
@@ -1741,65 +1751,72 @@ bool attempt_attack(controller *ctrl, bool highest_damage) {
     af_move *selected_move = NULL;
     int top_value = 0;
 
-    // Attack
-    for(int i = 0; i < 70; i++) {
-        af_move *move = NULL;
-        if((move = af_get_move(h->af_data, i))) {
-            move_stat *ms = &a->move_stats[i];
-            if(is_valid_move(move, h, false)) {
-                // smart AI will bail out unless close enough to hit
-                if(!in_attempt_range && (move->category == CAT_BASIC || move->category == CAT_LOW ||
-                                         move->category == CAT_MEDIUM || move->category == CAT_HIGH)) {
-                    continue;
-                }
+    // Only visit the moves that can be started right now
+    const af_move_index *idx = &h->af_data->index;
+    uint64_t candidates[AF_MOVE_INDEX_WORDS];
+    for(int w = 0; w < AF_MOVE_INDEX_WORDS; w++) {
+        candidates[w] = idx->playable[har_pose(h)][w];
+        // Only allow handwaving if close or jumping, see is_valid_move()
+        if(!h->close && h->state != STATE_JUMPING) {
+            candidates[w] &= ~idx->close_range[w];
+        }
+        // smart AI will bail out unless close enough to hit
+        if(!in_attempt_range) {
+            candidates[w] &= ~idx->short_reach[w];
+        }
+    }
 
-                int value;
-                if(highest_damage) {
-                    // evaluate the move based purely on damage
-                    value = (int)move->damage * 10;
-                } else {
-                    // evaluate the move based on learning reinforcement
-                    value = ms->value + rand_int(10);
-                    if(learning_moment(a) && ms->min_hit_dist != -1) {
-                        if(ms->last_dist < ms->max_hit_dist + 5 && ms->last_dist > ms->min_hit_dist + 5) {
-                            value += 2;
-                        } else if(ms->last_dist > ms->max_hit_dist + 10) {
-                            value -= 3;
-                        }
+    // Attack
+    for(int i = af_move_index_next(candidates, 0); i >= 0; i = af_move_index_next(candidates, i + 1)) {
+        af_move *move = &h->af_data->moves[i];
+        move_stat *ms = &a->move_stats[i];
+        if(is_valid_move(move, h, false)) {
+            int value;
+            if(highest_damage) {
+                // evaluate the move based purely on damage
+                value = (int)move->damage * 10;
+            } else {
+                // evaluate the move based on learning reinforcement
+                value = ms->value + rand_int(10);
+                if(learning_moment(a) && ms->min_hit_dist != -1) {
+                    if(ms->last_dist < ms->max_hit_dist + 5 && ms->last_dist > ms->min_hit_dist + 5) {
+                        value += 2;
+                    } else if(ms->last_dist > ms->max_hit_dist + 10) {
+                        value -= 3;
                     }
+                }
 
-                    // AI is less likely to use exact same move as last attack
-                    if(a->last_move_id > 0 && a->last_move_id == move->id) {
-                        value -= rand_int(10);
-                    }
+                // AI is less likely to use exact same move as last attack
+                if(a->last_move_id > 0 && a->last_move_id == move->id) {
+                    value -= rand_int(10);
+                }
 
-                    // smart AI will slightly favor high damage moves
-                    if(smart_usually(a)) {
-                        value += ((int)move->damage / 4);
-                    }
+                // smart AI will slightly favor high damage moves
+                if(smart_usually(a)) {
+                    value += ((int)move->damage / 4);
+                }
 
-                    // AI is less likely to use disliked moves
-                    if(dislikes_move(a, move)) {
-                        value -= rand_int(10);
-                    }
+                // AI is less likely to use disliked moves
+                if(dislikes_move(a, move)) {
+                    value -= rand_int(10);
+                }
 
-                    value -= ms->attempts / 2;
-                    value -= ms->consecutive * 2;
+                value -= ms->attempts / 2;
+                value -= ms->consecutive * 2;
 
-                    // sometimes skip move if it is too powerful for difficulty
-                    if(move_too_powerful(a, move)) {
-                        DEBUG("skipping move %s because of difficulty", str_c(&move->move_string));
-                        continue;
-                    }
+                // sometimes skip move if it is too powerful for difficulty
+                if(move_too_powerful(a, move)) {
+                    DEBUG("skipping move %s because of difficulty", str_c(&move->move_string));
+                    continue;
                 }
+            }
 
-                if(selected_move == NULL) {
-                    selected_move = move;
-                    top_value = value;
-                } else if(value > top_value) {
-                    selected_move = move;
-                    top_value = value;
-                }
+            if(selected_move == NULL) {
+                selected_move = move;
+                top_value = value;
+            } else if(value > top_value) {
+                selected_move = move;
+                top_value = value;
             }
         }
     }
@@ -1825,7 +1842,7 @@ bool attempt_attack(controller *ctrl, bool highest_damage) {
  *
  * \return Boolean indicating whether an attack was initiated.
  */
-bool attempt_charge_attack(controller *ctrl, ctrl_event **ev) {
+bool attempt_charge_attack(controller *ctrl, ctrl_event_queue *ev) {
     ai *a = ctrl->data;
     object *o = ctrl->har;
     har *h = object_get_userdata(o);
@@ -2029,7 +2046,7 @@ bool attempt_charge_attack(controller *ctrl, ctrl_event **ev) {
  *
  * \return Boolean indicating whether an attack was initiated.
  */
-bool attempt_push_attack(controller *ctrl, ctrl_event **ev) {
+bool attempt_push_attack(controller *ctrl, ctrl_event_queue *ev) {
     ai *a = ctrl->data;
     object *o = ctrl->har;
     har *h = object_get_userdata(o);
@@ -2141,7 +2158,7 @@ bool attempt_push_attack(controller *ctrl, ctrl_event **ev) {
  *
  * \return Boolean indicating whether an attack was initiated.
  */
-bool attempt_trip_attack(controller *ctrl, ctrl_event **ev) {
+bool attempt_trip_attack(controller *ctrl, ctrl_event_queue *ev) {
     object *o = ctrl->har;
     har *h = object_get_userdata(o);
 
@@ -2175,7 +2192,7 @@ bool attempt_trip_attack(controller *ctrl, ctrl_event **ev) {
  *
  * \return Boolean indicating whether an attack was initiated.
  */
-bool attempt_projectile_attack(controller *ctrl, ctrl_event **ev) {
+bool attempt_projectile_attack(controller *ctrl, ctrl_event_queue *ev) {
     object *o = ctrl->har;
     har *h = object_get_userdata(o);
 
@@ -2246,7 +2263,7 @@ bool attempt_projectile_attack(controller *ctrl, ctrl_event **ev) {
  *
  * \return Boolean indicating whether AI moved or attacked.
  */
-bool handle_queued_tactic(controller *ctrl, ctrl_event **ev) {
+bool handle_queued_tactic(controller *ctrl, ctrl_event_queue *ev) {
     ai *a = ctrl->data;
     object *o = ctrl->har;
     har *h = object_get_userdata(o);
@@ -2570,7 +2587,7 @@ bool handle_queued_tactic(controller *ctrl, ctrl_event **ev) {
     return acted;
 }
 
-int ai_controller_poll(controller *ctrl, ctrl_event **ev) {
+int ai_controller_poll(controller *ctrl, ctrl_event_queue *ev) {
     ai *a = ctrl->data;
     object *o = ctrl->har;
     if(!o) {
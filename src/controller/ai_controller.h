@@ -2,10 +2,23 @@
 #define AI_CONTROLLER_H
 
 #include "formats/pilot.h"
+#include "game/objects/har.h"
+#include "resources/af_move.h"
+#include <stdbool.h>
 
 typedef struct controller_t controller;
 
 void ai_controller_free(controller *ctrl);
 void ai_controller_create(controller *ctrl, int difficulty, sd_pilot *pilot, int pilot_id);
 
+/**
+ * Converts a move string character to a controller action for a HAR facing the given direction.
+ */
+int char_to_act(int ch, int direction);
+
+/**
+ * Tells whether the AI may try the move in the current state of the HAR.
+ */
+bool is_valid_move(const af_move *move, const har *h, bool force_allow_projectile);
+
 #endif // AI_CONTROLLER_H
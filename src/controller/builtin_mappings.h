@@ -1,6 +1,21 @@
 #ifndef BUILTIN_MAPPINGS_H
 #define BUILTIN_MAPPINGS_H
 
-extern const char builtin_controller_mappings[];
+#include <stdint.h>
+
+// The tables are generated at build time from resources/gamecontrollerdb.txt,
+// see cmake-scripts/GenerateControllerMappings.cmake.
+
+typedef struct {
+    uint8_t guid[16];
+    const char *mapping; // Mapping without the GUID, ie. "name,bindings...,platform:X,"
+} builtin_mapping;
+
+// Mappings for the target platform, sorted by GUID. Equal GUIDs are in file order.
+extern const builtin_mapping builtin_controller_mappings[];
+extern const unsigned int builtin_controller_mappings_count;
+
+// Complete mappings that are not tied to a GUID, NULL terminated.
+extern const char *const builtin_controller_generic_mappings[];
 
 #endif // BUILTIN_MAPPINGS_H
@@ -1,15 +1,48 @@
 #include "controller/controller.h"
 #include "utils/allocator.h"
+#include "utils/log.h"
 #include <stdlib.h>
+#include <string.h>
 
 typedef struct {
     void (*fp)(controller *ctrl, int act_type);
     controller *source;
 } hook_function;
 
+void ctrl_event_queue_init(ctrl_event_queue *q) {
+    q->first = 0;
+    q->count = 0;
+    memset(&q->snapshot, 0, sizeof(serial));
+}
+
+void ctrl_event_queue_free(ctrl_event_queue *q) {
+    if(q->snapshot.data != NULL) {
+        serial_free(&q->snapshot);
+    }
+    q->first = 0;
+    q->count = 0;
+}
+
+void ctrl_event_queue_clear(ctrl_event_queue *q) {
+    q->first = 0;
+    q->count = 0;
+}
+
+// Returns a slot for a new event, or NULL if the queue is full. Sync and close events clear the queue before
+// they are pushed, so only actions can be dropped and events in the queue are never overwritten.
+static ctrl_event *ctrl_event_queue_push(ctrl_event_queue *q, int type) {
+    if(q->count == CTRL_EVENT_QUEUE_SIZE) {
+        INFO("Controller event queue is full, dropping event of type %d", type);
+        return NULL;
+    }
+    ctrl_event *new = &q->events[(q->first + q->count++) & (CTRL_EVENT_QUEUE_SIZE - 1)];
+    new->type = type;
+    return new;
+}
+
 void controller_init(controller *ctrl) {
     list_create(&ctrl->hooks);
-    ctrl->extra_events = NULL;
+    ctrl_event_queue_init(&ctrl->extra_events);
     ctrl->har = NULL;
     ctrl->poll_fun = NULL;
     ctrl->tick_fun = NULL;
@@ -17,10 +50,18 @@ void controller_init(controller *ctrl) {
     ctrl->update_fun = NULL;
     ctrl->har_hook = NULL;
     ctrl->rumble_fun = NULL;
+    ctrl->free_fun = NULL;
     ctrl->rtt = 0;
     ctrl->repeat = 0;
 }
 
+void controller_free(controller *ctrl) {
+    if(ctrl->free_fun != NULL) {
+        ctrl->free_fun(ctrl);
+    }
+    ctrl_event_queue_free(&ctrl->extra_events);
+}
+
 void controller_add_hook(controller *ctrl, controller *source, void (*fp)(controller *ctrl, int act_type)) {
     hook_function *h = omf_calloc(1, sizeof(hook_function));
     h->fp = fp;
@@ -38,72 +79,52 @@ void controller_clear_hooks(controller *ctrl) {
     }
 }
 
-void controller_free_chain(ctrl_event *ev) {
-    ctrl_event *now = ev;
-    ctrl_event *tmp;
-    while(now != NULL) {
-        if(now->type == EVENT_TYPE_SYNC) {
-            serial_free(now->event_data.ser);
-            omf_free(now->event_data.ser);
-        }
-        tmp = now->next;
-        omf_free(now);
-        now = tmp;
-    }
-}
-
-void controller_cmd(controller *ctrl, int action, ctrl_event **ev) {
+void controller_cmd(controller *ctrl, int action, ctrl_event_queue *ev) {
     // fire any installed hooks
     iterator it;
     hook_function **p = 0;
-    ctrl_event *i;
-    ctrl_event *new;
 
     list_iter_begin(&ctrl->hooks, &it);
     while((p = iter_next(&it)) != NULL) {
         ((*p)->fp)((*p)->source, action);
     }
 
-    new = omf_calloc(1, sizeof(ctrl_event));
-    new->type = EVENT_TYPE_ACTION;
-    new->event_data.action = action;
-
-    if(*ev == NULL) {
-        *ev = new;
-    } else {
-        i = *ev;
-        while(i->next) {
-            i = i->next;
-        }
-        i->next = new;
+    ctrl_event *new = ctrl_event_queue_push(ev, EVENT_TYPE_ACTION);
+    if(new != NULL) {
+        new->event_data.action = action;
     }
 }
 
-void controller_sync(controller *ctrl, const serial *ser, ctrl_event **ev) {
+void controller_sync(controller *ctrl, const serial *ser, ctrl_event_queue *ev) {
     // a sync event obsoletes all previous events
-    controller_free_chain(*ev);
-    *ev = omf_calloc(1, sizeof(ctrl_event));
-    (*ev)->type = EVENT_TYPE_SYNC;
-    (*ev)->event_data.ser = serial_calloc_copy(ser);
-    (*ev)->next = NULL;
+    ctrl_event_queue_clear(ev);
+
+    // Copy the snapshot to the reusable buffer, keeping the read position.
+    if(ev->snapshot.data == NULL) {
+        serial_create(&ev->snapshot);
+    }
+    ev->snapshot.wpos = 0;
+    serial_write(&ev->snapshot, ser->data, ser->wpos);
+    ev->snapshot.rpos = ser->rpos;
+
+    ctrl_event *new = ctrl_event_queue_push(ev, EVENT_TYPE_SYNC);
+    new->event_data.ser = &ev->snapshot;
 }
 
-void controller_close(controller *ctrl, ctrl_event **ev) {
+void controller_close(controller *ctrl, ctrl_event_queue *ev) {
     // a close event obsoletes all previous events
-    controller_free_chain(*ev);
-    *ev = omf_calloc(1, sizeof(ctrl_event));
-    (*ev)->type = EVENT_TYPE_CLOSE;
-    (*ev)->next = NULL;
+    ctrl_event_queue_clear(ev);
+    ctrl_event_queue_push(ev, EVENT_TYPE_CLOSE);
 }
 
-int controller_tick(controller *ctrl, int ticks, ctrl_event **ev) {
+int controller_tick(controller *ctrl, int ticks, ctrl_event_queue *ev) {
     if(ctrl->tick_fun != NULL) {
         return ctrl->tick_fun(ctrl, ticks, ev);
     }
     return 0;
 }
 
-int controller_dyntick(controller *ctrl, int ticks, ctrl_event **ev) {
+int controller_dyntick(controller *ctrl, int ticks, ctrl_event_queue *ev) {
     if(ctrl->dyntick_fun != NULL) {
         return ctrl->dyntick_fun(ctrl, ticks, ev);
     }
@@ -117,7 +138,7 @@ int controller_update(controller *ctrl, serial *state) {
     return 0;
 }
 
-int controller_poll(controller *ctrl, ctrl_event **ev) {
+int controller_poll(controller *ctrl, ctrl_event_queue *ev) {
     if(ctrl->poll_fun != NULL) {
         return ctrl->poll_fun(ctrl, ev);
     }
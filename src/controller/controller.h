@@ -36,26 +36,37 @@ enum
     EVENT_TYPE_CLOSE
 };
 
-typedef struct ctrl_event_t ctrl_event;
+#define CTRL_EVENT_QUEUE_SIZE 32 // Must be a power of two
 
-struct ctrl_event_t {
+typedef struct ctrl_event_t {
     int type;
     union {
         int action;
-        serial *ser;
+        serial *ser; // Points to the snapshot buffer of the queue the event is in
     } event_data;
-    ctrl_event *next;
-};
+} ctrl_event;
+
+/**
+ * Fixed size ring of controller events. Adding and reading events never allocates; the snapshot
+ * of a sync event is copied to a buffer owned by the queue, which is reused for later syncs.
+ * If the queue is full, new actions are dropped; sync and close events clear the queue, so they are never dropped.
+ */
+typedef struct ctrl_event_queue_t {
+    ctrl_event events[CTRL_EVENT_QUEUE_SIZE];
+    unsigned int first;
+    unsigned int count;
+    serial snapshot;
+} ctrl_event_queue;
 
 typedef struct controller_t controller;
 
 struct controller_t {
     object *har;
     list hooks;
-    ctrl_event *extra_events;
-    int (*tick_fun)(controller *ctrl, int ticks, ctrl_event **ev);
-    int (*dyntick_fun)(controller *ctrl, int ticks, ctrl_event **ev);
-    int (*poll_fun)(controller *ctrl, ctrl_event **ev);
+    ctrl_event_queue extra_events;
+    int (*tick_fun)(controller *ctrl, int ticks, ctrl_event_queue *ev);
+    int (*dyntick_fun)(controller *ctrl, int ticks, ctrl_event_queue *ev);
+    int (*poll_fun)(controller *ctrl, ctrl_event_queue *ev);
     int (*update_fun)(controller *ctrl, serial *state);
     int (*rumble_fun)(controller *ctrl, float magnitude, int duration);
     int (*har_hook)(controller *ctrl, har_event event);
@@ -67,18 +78,36 @@ struct controller_t {
     int repeat;
 };
 
+void ctrl_event_queue_init(ctrl_event_queue *q);
+void ctrl_event_queue_free(ctrl_event_queue *q);
+
+/**
+ * Removes all events from the queue. The snapshot buffer is kept for reuse.
+ */
+void ctrl_event_queue_clear(ctrl_event_queue *q);
+
+/**
+ * Returns the n'th event in the queue, oldest first, or NULL if there are not that many events.
+ */
+static inline ctrl_event *ctrl_event_queue_get(ctrl_event_queue *q, unsigned int n) {
+    if(n >= q->count) {
+        return NULL;
+    }
+    return &q->events[(q->first + n) & (CTRL_EVENT_QUEUE_SIZE - 1)];
+}
+
 void controller_init(controller *ctrl);
-void controller_cmd(controller *ctrl, int action, ctrl_event **ev);
-void controller_sync(controller *ctrl, const serial *ser, ctrl_event **ev);
-void controller_close(controller *ctrl, ctrl_event **ev);
-int controller_poll(controller *ctrl, ctrl_event **ev);
-int controller_tick(controller *ctrl, int ticks, ctrl_event **ev);
-int controller_dyntick(controller *ctrl, int ticks, ctrl_event **ev);
+void controller_free(controller *ctrl);
+void controller_cmd(controller *ctrl, int action, ctrl_event_queue *ev);
+void controller_sync(controller *ctrl, const serial *ser, ctrl_event_queue *ev);
+void controller_close(controller *ctrl, ctrl_event_queue *ev);
+int controller_poll(controller *ctrl, ctrl_event_queue *ev);
+int controller_tick(controller *ctrl, int ticks, ctrl_event_queue *ev);
+int controller_dyntick(controller *ctrl, int ticks, ctrl_event_queue *ev);
 int controller_update(controller *ctrl, serial *state);
 int controller_har_hook(controller *ctrl, har_event event);
 void controller_add_hook(controller *ctrl, controller *source, void (*fp)(controller *ctrl, int act_type));
 void controller_clear_hooks(controller *ctrl);
-void controller_free_chain(ctrl_event *ev);
 void controller_set_repeat(controller *ctrl, int repeat);
 int controller_rumble(controller *ctrl, float magnitude, int duration);
 
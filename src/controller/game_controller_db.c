@@ -1,24 +1,113 @@
+#include <SDL.h>
 #include <SDL_gamecontroller.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "controller/builtin_mappings.h"
 #include "controller/game_controller_db.h"
 #include "resources/pathmanager.h"
+#include "utils/allocator.h"
 #include "utils/log.h"
 #include "utils/str.h"
 
+// GUIDs that have a mapping in the external mappings file, sorted. These win over the built-in mappings.
+static SDL_JoystickGUID *external_guids = NULL;
+static size_t external_guid_count = 0;
+
+static int guid_compare(const void *a, const void *b) {
+    return memcmp(a, b, sizeof(SDL_JoystickGUID));
+}
+
+// Adds all built-in mappings for the GUID. SDL skips the ones for other platforms. Returns the number added.
+static int add_builtin_mappings(SDL_JoystickGUID guid) {
+    char guid_str[33];
+    str mapping;
+    int added = 0;
+
+    // Find the first mapping for the GUID
+    size_t lo = 0;
+    size_t hi = builtin_controller_mappings_count;
+    while(lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if(memcmp(builtin_controller_mappings[mid].guid, guid.data, sizeof(guid.data)) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    SDL_JoystickGetGUIDString(guid, guid_str, sizeof(guid_str));
+    for(size_t i = lo; i < builtin_controller_mappings_count; i++) {
+        if(memcmp(builtin_controller_mappings[i].guid, guid.data, sizeof(guid.data)) != 0) {
+            break;
+        }
+        str_from_format(&mapping, "%s,%s", guid_str, builtin_controller_mappings[i].mapping);
+        if(SDL_GameControllerAddMapping(str_c(&mapping)) >= 0) {
+            added++;
+        }
+        str_free(&mapping);
+    }
+    return added;
+}
+
+void joystick_load_builtin_mapping(int device_index) {
+    SDL_JoystickGUID guid = SDL_JoystickGetDeviceGUID(device_index);
+    if(external_guid_count > 0 &&
+       bsearch(&guid, external_guids, external_guid_count, sizeof(SDL_JoystickGUID), guid_compare) != NULL) {
+        return;
+    }
+
+    int added = add_builtin_mappings(guid);
+    if(added == 0) {
+        // Newer SDL versions store a CRC of the device name in bytes 2-3, the database does not.
+        guid.data[2] = 0;
+        guid.data[3] = 0;
+        added = add_builtin_mappings(guid);
+    }
+    if(added > 0) {
+        INFO("Loaded built-in controller mapping for %s", SDL_JoystickNameForIndex(device_index));
+    }
+}
+
 void joystick_load_builtin_mappings() {
-    SDL_RWops *rw = SDL_RWFromConstMem(builtin_controller_mappings, strlen(builtin_controller_mappings));
-    SDL_GameControllerAddMappingsFromRW(rw, 1);
-    INFO("Loaded built-in controller mappings");
+    for(int i = 0; builtin_controller_generic_mappings[i] != NULL; i++) {
+        SDL_GameControllerAddMapping(builtin_controller_generic_mappings[i]);
+    }
+    for(int i = 0; i < SDL_NumJoysticks(); i++) {
+        joystick_load_builtin_mapping(i);
+    }
+    INFO("Built-in controller mappings available for %u devices", builtin_controller_mappings_count);
     INFO("We currently have %d known game controller mappings", SDL_GameControllerNumMappings());
 }
 
+// Remembers which GUIDs the external file maps, so that hot-plugging does not override them.
+static void read_external_guids(const char *filename) {
+    char line[1024];
+    FILE *fp = fopen(filename, "r");
+    if(fp == NULL) {
+        return;
+    }
+    while(fgets(line, sizeof(line), fp) != NULL) {
+        if(strcspn(line, ",") != 32) {
+            continue;
+        }
+        line[32] = 0;
+        external_guids = omf_realloc(external_guids, (external_guid_count + 1) * sizeof(SDL_JoystickGUID));
+        external_guids[external_guid_count++] = SDL_JoystickGetGUIDFromString(line);
+    }
+    fclose(fp);
+    if(external_guid_count > 0) {
+        qsort(external_guids, external_guid_count, sizeof(SDL_JoystickGUID), guid_compare);
+    }
+}
+
 void joystick_load_external_mappings() {
     str controller_db_path;
     const char *resource_path = pm_get_local_path(RESOURCE_PATH);
     str_from_format(&controller_db_path, "%sgamecontrollerdb.txt", resource_path);
     if(SDL_GameControllerAddMappingsFromFile(str_c(&controller_db_path)) > 0) {
+        read_external_guids(str_c(&controller_db_path));
         INFO("Loaded external game controller mappings from %s", str_c(&controller_db_path));
         INFO("We have %d known game controller mappings", SDL_GameControllerNumMappings());
     } else {
@@ -26,3 +115,8 @@ void joystick_load_external_mappings() {
     }
     str_free(&controller_db_path);
 }
+
+void joystick_free_mappings() {
+    omf_free(external_guids);
+    external_guid_count = 0;
+}
@@ -1,7 +1,21 @@
 #ifndef GAME_CONTROLLER_DB_H
 #define GAME_CONTROLLER_DB_H
 
+/**
+ * Adds the built-in mappings for all connected joysticks. Mappings for joysticks
+ * connected later are added by joystick_load_builtin_mapping().
+ */
 void joystick_load_builtin_mappings();
+
+/**
+ * Adds the built-in mapping for a joystick, unless the external mappings file has one.
+ * Called when a joystick is connected (SDL_JOYDEVICEADDED).
+ *
+ * \param device_index SDL joystick device index
+ */
+void joystick_load_builtin_mapping(int device_index);
+
 void joystick_load_external_mappings();
+void joystick_free_mappings();
 
 #endif // GAME_CONTROLLER_DB_H
@@ -19,7 +19,7 @@ void joystick_free(controller *ctrl) {
     omf_free(k);
 }
 
-void joystick_cmd(controller *ctrl, int action, ctrl_event **ev) {
+void joystick_cmd(controller *ctrl, int action, ctrl_event_queue *ev) {
     joystick *k = ctrl->data;
     if(ctrl->repeat && action != ACT_KICK && action != ACT_PUNCH && action != ACT_ESC) {
         controller_cmd(ctrl, action, ev);
@@ -84,7 +84,7 @@ int joystick_name_to_id(const char *name, int offset) {
     return -1;
 }
 
-int joystick_poll(controller *ctrl, ctrl_event **ev) {
+int joystick_poll(controller *ctrl, ctrl_event_queue *ev) {
     joystick *k = ctrl->data;
 
     k->current = 0;
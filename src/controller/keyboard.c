@@ -8,7 +8,7 @@ void keyboard_free(controller *ctrl) {
     omf_free(k);
 }
 
-void keyboard_cmd(controller *ctrl, int action, ctrl_event **ev) {
+void keyboard_cmd(controller *ctrl, int action, ctrl_event_queue *ev) {
     keyboard *k = ctrl->data;
     if(ctrl->repeat && action != ACT_KICK && action != ACT_PUNCH && action != ACT_ESC) {
         controller_cmd(ctrl, action, ev);
@@ -18,7 +18,7 @@ void keyboard_cmd(controller *ctrl, int action, ctrl_event **ev) {
     k->current |= action;
 }
 
-int keyboard_poll(controller *ctrl, ctrl_event **ev) {
+int keyboard_poll(controller *ctrl, ctrl_event_queue *ev) {
     keyboard *k = ctrl->data;
     k->current = 0;
     const unsigned char *state = SDL_GetKeyboardState(NULL);
@@ -0,0 +1,306 @@
+#include "controller/lookahead_controller.h"
+#include "controller/ai_controller.h"
+#include "formats/af.h"
+#include "game/game_state.h"
+#include "game/objects/arena_constraints.h"
+#include "game/objects/har.h"
+#include "game/scenes/arena.h"
+#include "resources/ids.h"
+#include "utils/allocator.h"
+#include "utils/log.h"
+#include "utils/miscmath.h"
+#include "utils/work_pool.h"
+#include <SDL.h>
+#include <math.h>
+
+/* most plans tried in one search */
+#define MAX_PLANS 80
+/* longest plan, in ticks */
+#define MAX_PLAN_TICKS 16
+/* ticks a movement is held for */
+#define MOVEMENT_TICKS 8
+/* ticks simulated per rollout, and the extra ticks per difficulty level */
+#define BASE_DEPTH 20
+#define DEPTH_PER_DIFFICULTY 6
+/* time a search may take per tick. A search that needs more carries on in the next ticks. */
+#define SEARCH_SLICE_MS 2
+/* ticks a search may take. After that the best plan found so far is performed. */
+#define SEARCH_MAX_TICKS 6
+
+typedef struct {
+    int actions[MAX_PLAN_TICKS]; // ACT_* input for each tick
+    int length;
+    int score;
+    int evaluated; // 1 if the rollout has finished
+} plan;
+
+// A fork and the rollout running on it. Rollouts that don't finish in one slice carry on in the next one.
+typedef struct {
+    game_state *fork;
+    int plan; // Plan being rolled out, or -1
+    int tick; // Ticks of the rollout simulated so far
+    int my_health;
+    int enemy_health;
+} rollout;
+
+typedef struct {
+    int depth; // Ticks simulated per rollout
+
+    // Plan being performed, or -1 if a new one is needed
+    int current;
+    int current_tick;
+
+    // The current search. Workers only use the serialized state and their own rollout.
+    int searching;
+    int search_ticks; // Ticks the search has been running for
+    plan plans[MAX_PLANS];
+    int plan_count;
+    serial state; // Game state the search started from
+    int player_id;
+    SDL_atomic_t next_plan; // First plan that no rollout has started yet
+    uint64_t deadline;      // End of the current slice
+
+    // The forks are kept from one search to the next, and only reset in between
+    rollout rollouts[WORK_POOL_MAX_THREADS + 1];
+    int rollout_count;
+
+    work_pool pool;
+} lookahead;
+
+static int har_can_act(har *h) {
+    return h->state == STATE_STANDING || har_is_walking(h) || har_is_crouching(h) || h->state == STATE_JUMPING;
+}
+
+// Adds a plan that plays the inputs of a move string (newest input first) and then holds the last one
+static void add_plan(lookahead *l, const char *inputs, int len, int hold, int direction) {
+    if(l->plan_count >= MAX_PLANS || len + hold > MAX_PLAN_TICKS || len == 0) {
+        return;
+    }
+    plan *p = &l->plans[l->plan_count++];
+    p->length = 0;
+    for(int k = len - 1; k >= 0; k--) {
+        p->actions[p->length++] = char_to_act(inputs[k], direction);
+    }
+    for(int k = 0; k < hold; k++) {
+        p->actions[p->length++] = char_to_act(inputs[0], direction);
+    }
+    p->score = 0;
+    p->evaluated = 0;
+}
+
+static void build_plans(lookahead *l, object *o) {
+    har *h = object_get_userdata(o);
+    int dir = object_get_direction(o);
+    l->plan_count = 0;
+
+    // Standing still comes first, so that it wins ties
+    add_plan(l, "5", 1, MOVEMENT_TICKS - 1, dir);
+    if(h->state != STATE_JUMPING) {
+        add_plan(l, "6", 1, MOVEMENT_TICKS - 1, dir); // walk forwards
+        add_plan(l, "4", 1, MOVEMENT_TICKS - 1, dir); // walk backwards, blocks
+        add_plan(l, "1", 1, MOVEMENT_TICKS - 1, dir); // crouch block
+        add_plan(l, "9", 1, 0, dir);
+        add_plan(l, "8", 1, 0, dir);
+        add_plan(l, "7", 1, 0, dir);
+    }
+
+    for(int i = 0; i < MAX_AF_MOVES; i++) {
+        af_move *move = af_get_move(h->af_data, i);
+        if(move != NULL && is_valid_move(move, h, false)) {
+            add_plan(l, str_c(&move->move_string), str_size(&move->move_string), 0, dir);
+        }
+    }
+}
+
+// Higher is better: damage dealt, damage avoided, staying close and keeping off the walls
+static int score_rollout(object *me, object *enemy, int my_health, int enemy_health) {
+    har *h = object_get_userdata(me);
+    har *e = object_get_userdata(enemy);
+    int dealt = enemy_health - e->health;
+    int taken = my_health - h->health;
+    int distance = fabsf(me->pos.x - enemy->pos.x);
+    int wall = min2(me->pos.x - ARENA_LEFT_WALL, ARENA_RIGHT_WALL - me->pos.x);
+    return dealt * 16 - taken * 20 - distance / 8 + min2(wall, 60) / 4;
+}
+
+// Puts the fork back to the start of the search, and starts rolling out a plan on it
+static void start_rollout(lookahead *l, rollout *r, int plan_index) {
+    game_state_fork_reset(r->fork, &l->state);
+    r->plan = plan_index;
+    r->tick = 0;
+    r->my_health = ((har *)object_get_userdata(game_state_get_player(r->fork, l->player_id)->har))->health;
+    r->enemy_health = ((har *)object_get_userdata(game_state_get_player(r->fork, !l->player_id)->har))->health;
+}
+
+// Simulates one more tick of the rollout, and scores the plan when the rollout is done
+static void step_rollout(lookahead *l, rollout *r) {
+    plan *p = &l->plans[r->plan];
+
+    // The enemy is left to carry on with whatever it is doing
+    int actions[2] = {0, 0};
+    actions[l->player_id] = (r->tick < p->length) ? p->actions[r->tick] : ACT_STOP;
+    game_state_fork_tick(r->fork, actions);
+    if(++r->tick < l->depth) {
+        return;
+    }
+    object *me = game_state_get_player(r->fork, l->player_id)->har;
+    object *enemy = game_state_get_player(r->fork, !l->player_id)->har;
+    p->score = score_rollout(me, enemy, r->my_health, r->enemy_health);
+    p->evaluated = 1;
+    r->plan = -1;
+}
+
+// Runs the rollouts of one fork until the slice is over or no plans are left
+static void run_rollouts(void *userdata, int worker, int job) {
+    lookahead *l = userdata;
+    rollout *r = &l->rollouts[job];
+    if(r->fork == NULL) {
+        return;
+    }
+    while(SDL_GetPerformanceCounter() < l->deadline) {
+        if(r->plan < 0) {
+            int next = SDL_AtomicAdd(&l->next_plan, 1);
+            if(next >= l->plan_count) {
+                return;
+            }
+            start_rollout(l, r, next);
+        }
+        step_rollout(l, r);
+    }
+}
+
+static void free_forks(lookahead *l) {
+    for(int i = 0; i < l->rollout_count; i++) {
+        if(l->rollouts[i].fork != NULL) {
+            game_state_free(&l->rollouts[i].fork);
+        }
+    }
+    l->rollout_count = 0;
+}
+
+static void start_search(lookahead *l, object *o) {
+    har *h = object_get_userdata(o);
+    build_plans(l, o);
+    l->player_id = h->player_id;
+
+    // Only this thread reads the live game state. The workers start each rollout from this copy of it.
+    l->state.wpos = 0;
+    l->state.rpos = 0;
+    game_state_serialize(o->gs, &l->state);
+    if(l->rollout_count == 0) {
+        l->rollout_count = work_pool_workers(&l->pool);
+        for(int i = 0; i < l->rollout_count; i++) {
+            l->rollouts[i].fork = game_state_fork(o->gs, &l->state);
+        }
+    }
+    for(int i = 0; i < l->rollout_count; i++) {
+        l->rollouts[i].plan = -1;
+    }
+    SDL_AtomicSet(&l->next_plan, 0);
+    l->search_ticks = 0;
+    l->searching = 1;
+}
+
+// Runs the search for one slice. Returns 1 when the search is over.
+static int continue_search(lookahead *l) {
+    l->deadline = SDL_GetPerformanceCounter() + SDL_GetPerformanceFrequency() * SEARCH_SLICE_MS / 1000;
+    work_pool_run(&l->pool, l->rollout_count, run_rollouts, l);
+    l->search_ticks++;
+
+    int busy = SDL_AtomicGet(&l->next_plan) < l->plan_count;
+    for(int i = 0; i < l->rollout_count; i++) {
+        busy |= l->rollouts[i].plan >= 0;
+    }
+    if(busy && l->search_ticks < SEARCH_MAX_TICKS) {
+        return 0;
+    }
+    l->searching = 0;
+    return 1;
+}
+
+// Returns the index of the best plan that has been rolled out. Ties go to the earlier plan.
+static int best_plan(lookahead *l) {
+    int best = 0;
+    int evaluated = 0;
+    for(int i = 0; i < l->plan_count; i++) {
+        if(l->plans[i].evaluated && (!l->plans[best].evaluated || l->plans[i].score > l->plans[best].score)) {
+            best = i;
+        }
+        evaluated += l->plans[i].evaluated;
+    }
+    if(evaluated < l->plan_count) {
+        DEBUG("lookahead: only %d of %d plans evaluated in %d ticks", evaluated, l->plan_count, SEARCH_MAX_TICKS);
+    }
+    return best;
+}
+
+int lookahead_controller_poll(controller *ctrl, ctrl_event_queue *ev) {
+    lookahead *l = ctrl->data;
+    object *o = ctrl->har;
+    if(!o) {
+        return 1;
+    }
+    har *h = object_get_userdata(o);
+
+    // Do not run AI while the game is paused, or the match is starting or ending
+    if(game_state_is_paused(o->gs)) {
+        return 0;
+    }
+    // The forks borrow the data of the fight, so they are let go of between rounds
+    if(is_arena(game_state_get_scene(o->gs)->id) &&
+       arena_get_state(game_state_get_scene(o->gs)) != ARENA_STATE_FIGHTING) {
+        l->current = -1;
+        l->searching = 0;
+        free_forks(l);
+        return 0;
+    }
+
+    if(l->current < 0) {
+        if(!l->searching) {
+            if(!har_can_act(h)) {
+                return 0;
+            }
+            start_search(l, o);
+        }
+        if(!continue_search(l)) {
+            return 0;
+        }
+
+        // The fight went on during the search. If the HAR can't act any more, the plans are of no use.
+        if(!har_can_act(h)) {
+            return 0;
+        }
+        l->current = best_plan(l);
+        l->current_tick = 0;
+    }
+
+    plan *p = &l->plans[l->current];
+    controller_cmd(ctrl, p->actions[l->current_tick], ev);
+    if(++l->current_tick >= p->length) {
+        l->current = -1;
+    }
+    return 0;
+}
+
+void lookahead_controller_free(controller *ctrl) {
+    lookahead *l = ctrl->data;
+    free_forks(l);
+    work_pool_free(&l->pool);
+    serial_free(&l->state);
+    omf_free(l);
+}
+
+void lookahead_controller_create(controller *ctrl, int difficulty, sd_pilot *pilot, int pilot_id) {
+    lookahead *l = omf_calloc(1, sizeof(lookahead));
+    l->depth = BASE_DEPTH + difficulty * DEPTH_PER_DIFFICULTY;
+    l->current = -1;
+    serial_create(&l->state);
+    pilot->pilot_id = pilot_id;
+    work_pool_create(&l->pool, clamp(SDL_GetCPUCount() - 1, 0, WORK_POOL_MAX_THREADS));
+    DEBUG("Lookahead AI searching %d ticks ahead with %d workers", l->depth, work_pool_workers(&l->pool));
+
+    ctrl->data = l;
+    ctrl->type = CTRL_TYPE_AI;
+    ctrl->poll_fun = &lookahead_controller_poll;
+    ctrl->free_fun = &lookahead_controller_free;
+}
@@ -0,0 +1,24 @@
+#ifndef LOOKAHEAD_CONTROLLER_H
+#define LOOKAHEAD_CONTROLLER_H
+
+#include "controller/controller.h"
+#include "formats/pilot.h"
+
+/**
+ * Creates an AI controller that picks its actions by trying them out.
+ *
+ * Whenever the HAR is free to act, every valid move and a few basic movements are played out in forks of the
+ * game (see game_state_fork()) for a few dozen ticks. The one with the best outcome in damage and position is
+ * then performed for real. Rollouts run on worker threads, and always start from the same state. A search gets
+ * a couple of milliseconds per tick, and carries on over the next ticks if it needs more. If it is still not done
+ * after a few ticks, the best plan rolled out so far is performed. The forks are kept from one search to the next.
+ *
+ * \param ctrl Controller to set up, must have been initialized with controller_init()
+ * \param difficulty AI_DIFFICULTY_* value, higher difficulties look further ahead
+ * \param pilot Pilot of the HAR
+ * \param pilot_id Pilot ID
+ */
+void lookahead_controller_create(controller *ctrl, int difficulty, sd_pilot *pilot, int pilot_id);
+void lookahead_controller_free(controller *ctrl);
+
+#endif // LOOKAHEAD_CONTROLLER_H
@@ -95,7 +95,7 @@ done:
     }
 }
 
-int net_controller_tick(controller *ctrl, int ticks, ctrl_event **ev) {
+int net_controller_tick(controller *ctrl, int ticks, ctrl_event_queue *ev) {
     ENetEvent event;
     wtf *data = ctrl->data;
     ENetHost *host = data->host;
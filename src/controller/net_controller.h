@@ -5,6 +5,10 @@
 #include <SDL.h>
 #include <enet/enet.h>
 
+// Sent as the connect data, the server refuses clients of other versions. Bump this when the packets or the
+// game_state_serialize() format change. Version 1 fixed the length of the serialized projectiles.
+#define NET_PROTOCOL_VERSION 1
+
 void net_controller_create(controller *ctrl, ENetHost *host, ENetPeer *peer, int id);
 void net_controller_free(controller *ctrl);
 int net_controller_get_rtt(controller *ctrl);
@@ -2,27 +2,87 @@
 #include "formats/rec.h"
 #include "utils/allocator.h"
 #include "utils/log.h"
+#include <stdlib.h>
+
+typedef struct {
+    unsigned int tick;
+    unsigned int order; // Position in the REC file, keeps sorting stable
+    sd_action action;
+} rec_input;
 
 typedef struct {
     int id;
     int last_tick;
     int last_action;
     int max_tick;
-    hashmap tick_lookup;
+    rec_input *inputs; // Inputs of this player, sorted by tick, one per tick at most
+    unsigned int input_count;
+    unsigned int cursor; // Index of the first input that has not been played yet
 } wtf;
 
 void rec_controller_free(controller *ctrl) {
     wtf *data = ctrl->data;
     if(data) {
-        hashmap_free(&data->tick_lookup);
+        omf_free(data->inputs);
         omf_free(data);
     }
 }
 
-int rec_controller_tick(controller *ctrl, int ticks, ctrl_event **ev) {
+// Directional part of a recorded action, which is repeated on ticks that have no input.
+static int rec_direction(sd_action action) {
+    int result = 0;
+    if(action & SD_ACT_UP) {
+        result |= ACT_UP;
+    }
+    if(action & SD_ACT_DOWN) {
+        result |= ACT_DOWN;
+    }
+    if(action & SD_ACT_LEFT) {
+        result |= ACT_LEFT;
+    }
+    if(action & SD_ACT_RIGHT) {
+        result |= ACT_RIGHT;
+    }
+    return (result != 0) ? result : ACT_STOP;
+}
+
+static void rec_play_input(controller *ctrl, const rec_input *input, ctrl_event_queue *ev) {
+    wtf *data = ctrl->data;
+    if(input->action == SD_ACT_NONE) {
+        controller_cmd(ctrl, ACT_STOP, ev);
+        data->last_action = ACT_STOP;
+        return;
+    }
+
+    if(input->action & SD_ACT_PUNCH) {
+        controller_cmd(ctrl, ACT_PUNCH, ev);
+    } else if(input->action & SD_ACT_KICK) {
+        controller_cmd(ctrl, ACT_KICK, ev);
+    }
+
+    data->last_action = rec_direction(input->action);
+    if(data->last_action != ACT_STOP) {
+        controller_cmd(ctrl, data->last_action, ev);
+    }
+}
+
+// Binary search for the first input at or after the given tick
+static unsigned int rec_find_input(const wtf *data, int tick) {
+    unsigned int lo = 0;
+    unsigned int hi = data->input_count;
+    while(lo < hi) {
+        unsigned int mid = lo + (hi - lo) / 2;
+        if(data->inputs[mid].tick < (unsigned int)tick) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+int rec_controller_tick(controller *ctrl, int ticks, ctrl_event_queue *ev) {
     wtf *data = ctrl->data;
-    sd_rec_move *move;
-    unsigned int len;
     if(ticks > data->max_tick) {
         DEBUG("closing controller");
         controller_close(ctrl, ev);
@@ -30,40 +90,15 @@ int rec_controller_tick(controller *ctrl, int ticks, ctrl_event **ev) {
     }
 
     if(data->last_tick != ticks) {
-        if(hashmap_iget(&data->tick_lookup, ticks, (void **)(&move), &len) == 0) {
-            if(move->action == SD_ACT_NONE) {
-                controller_cmd(ctrl, ACT_STOP, ev);
-                data->last_action = ACT_STOP;
-            } else {
-                if(move->action & SD_ACT_PUNCH) {
-                    controller_cmd(ctrl, ACT_PUNCH, ev);
-                } else if(move->action & SD_ACT_KICK) {
-                    controller_cmd(ctrl, ACT_KICK, ev);
-                }
-
-                int action = 0;
-                if(move->action & SD_ACT_UP) {
-                    action |= ACT_UP;
-                }
-
-                if(move->action & SD_ACT_DOWN) {
-                    action |= ACT_DOWN;
-                }
-
-                if(move->action & SD_ACT_LEFT) {
-                    action |= ACT_LEFT;
-                }
-
-                if(move->action & SD_ACT_RIGHT) {
-                    action |= ACT_RIGHT;
-                }
-                if(action != 0) {
-                    controller_cmd(ctrl, action, ev);
-                    data->last_action = action;
-                } else {
-                    data->last_action = ACT_STOP;
-                }
-            }
+        // Ticks normally advance by one. If the game tick was reset, look up the position again.
+        if(ticks < data->last_tick) {
+            data->cursor = rec_find_input(data, ticks);
+        }
+        while(data->cursor < data->input_count && data->inputs[data->cursor].tick < (unsigned int)ticks) {
+            data->cursor++;
+        }
+        if(data->cursor < data->input_count && data->inputs[data->cursor].tick == (unsigned int)ticks) {
+            rec_play_input(ctrl, &data->inputs[data->cursor++], ev);
         } else {
             controller_cmd(ctrl, data->last_action, ev);
         }
@@ -72,18 +107,66 @@ int rec_controller_tick(controller *ctrl, int ticks, ctrl_event **ev) {
     return 0;
 }
 
+int rec_controller_seek(controller *ctrl, int tick) {
+    wtf *data = ctrl->data;
+    if(ctrl->type != CTRL_TYPE_REC || tick < 0) {
+        return 1;
+    }
+
+    unsigned int lo = rec_find_input(data, tick);
+    data->cursor = lo;
+
+    // Held direction is whatever the previous input left it at
+    data->last_action = (lo > 0) ? rec_direction(data->inputs[lo - 1].action) : ACT_STOP;
+    data->last_tick = tick - 1;
+    return 0;
+}
+
+static int rec_input_compare(const void *a, const void *b) {
+    const rec_input *ia = a;
+    const rec_input *ib = b;
+    if(ia->tick != ib->tick) {
+        return (ia->tick < ib->tick) ? -1 : 1;
+    }
+    return (ia->order < ib->order) ? -1 : (ia->order > ib->order);
+}
+
 void rec_controller_create(controller *ctrl, int player, sd_rec_file *rec) {
     wtf *data = omf_calloc(1, sizeof(wtf));
     data->last_action = ACT_STOP;
     data->last_tick = 0;
-    hashmap_create(&data->tick_lookup, 9);
+    data->inputs = omf_calloc(rec->move_count > 0 ? rec->move_count : 1, sizeof(rec_input));
+
+    // Take the inputs of this player. REC files are in tick order already, but sort anyway
+    // in case a file isn't; the input stream must never skip backwards.
+    int sorted = 1;
     for(unsigned int i = 0; i < rec->move_count; i++) {
         if(rec->moves[i].player_id == player && rec->moves[i].lookup_id == 2) {
-            hashmap_iput(&data->tick_lookup, rec->moves[i].tick, &rec->moves[i], sizeof(sd_rec_move));
+            rec_input *input = &data->inputs[data->input_count++];
+            input->tick = rec->moves[i].tick;
+            input->order = i;
+            input->action = rec->moves[i].action;
+            if(data->input_count > 1 && input->tick < data->inputs[data->input_count - 2].tick) {
+                sorted = 0;
+            }
         }
     }
+    if(!sorted) {
+        qsort(data->inputs, data->input_count, sizeof(rec_input), rec_input_compare);
+    }
+
+    // If several inputs share a tick, the last one wins
+    unsigned int count = 0;
+    for(unsigned int i = 0; i < data->input_count; i++) {
+        if(count > 0 && data->inputs[count - 1].tick == data->inputs[i].tick) {
+            count--;
+        }
+        data->inputs[count++] = data->inputs[i];
+    }
+    data->input_count = count;
+
     data->max_tick = rec->moves[rec->move_count - 1].tick;
-    DEBUG("max tick is %d", data->last_tick);
+    DEBUG("max tick is %d", data->max_tick);
     ctrl->data = data;
     ctrl->type = CTRL_TYPE_REC;
     ctrl->dyntick_fun = &rec_controller_tick;
@@ -3,9 +3,16 @@
 
 #include "controller/controller.h"
 #include "formats/rec.h"
-#include "utils/hashmap.h"
 
 void rec_controller_create(controller *ctrl, int player, sd_rec_file *rec);
 void rec_controller_free(controller *ctrl);
 
+/**
+ * Moves the playback cursor so that the next tick played is the given tick.
+ * The game state itself must be brought to the same tick separately.
+ *
+ * \return 0 on success, 1 if the controller is not a REC controller.
+ */
+int rec_controller_seek(controller *ctrl, int tick);
+
 #endif // REC_CONTROLLER_H
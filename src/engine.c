@@ -1,6 +1,7 @@
 #include "engine.h"
 #include "audio/audio.h"
 #include "console/console.h"
+#include "controller/game_controller_db.h"
 #include "formats/altpal.h"
 #include "game/game_state.h"
 #include "game/gui/text_render.h"
@@ -9,6 +10,7 @@
 #include "resources/sounds_loader.h"
 #include "utils/allocator.h"
 #include "utils/log.h"
+#include "utils/profiler.h"
 #include "video/surface.h"
 #include "video/video.h"
 #include <SDL.h>
@@ -31,6 +33,7 @@ int engine_init() {
     char *scaler = setting->video.scaler;
     int frequency = setting->sound.music_frequency;
     int resampler = setting->sound.music_resampler;
+    int music_buffer_ms = setting->sound.music_buffer_ms;
     bool mono = setting->sound.music_mono;
     float music_volume = setting->sound.music_vol / 10.0;
     float sound_volume = setting->sound.sound_vol / 10.0;
@@ -38,7 +41,7 @@ int engine_init() {
     // Initialize everything.
     if(video_init(w, h, fs, vsync, scaler, scale_factor))
         goto exit_0;
-    if(!audio_init(frequency, mono, resampler, music_volume, sound_volume))
+    if(!audio_init(frequency, mono, resampler, music_buffer_ms, music_volume, sound_volume))
         goto exit_1;
     if(sounds_loader_init())
         goto exit_2;
@@ -118,6 +121,7 @@ void engine_run(engine_init_flags *init_flags) {
     while(run && game_state_is_running(gs)) {
         // Handle events
         int check_fs;
+        profiler_begin(PROFILE_EVENTS);
         while(SDL_PollEvent(&e)) {
             // Handle other events
             switch(e.type) {
@@ -138,6 +142,10 @@ void engine_run(engine_init_flags *init_flags) {
                         debugger_render = !debugger_render;
                     }
                     break;
+                case SDL_JOYDEVICEADDED:
+                    // Once there is a mapping, SDL follows up with SDL_CONTROLLERDEVICEADDED
+                    joystick_load_builtin_mapping(e.jdevice.which);
+                    break;
                 case SDL_MOUSEMOTION:
                     mouse_visible_ticks = 1000;
                     SDL_ShowCursor(1);
@@ -194,6 +202,7 @@ void engine_run(engine_init_flags *init_flags) {
                 game_state_handle_event(gs, &e);
             }
         }
+        profiler_end(PROFILE_EVENTS);
 
         // hide mouse after n ticks
         if(mouse_visible_ticks > 0) {
@@ -204,7 +213,9 @@ void engine_run(engine_init_flags *init_flags) {
         }
 
         // Tick controllers
+        profiler_begin(PROFILE_CONTROLLERS);
         game_state_tick_controllers(gs);
+        profiler_end(PROFILE_CONTROLLERS);
 
         // Render scene
         int dt = (SDL_GetTicks() - frame_start);
@@ -221,7 +232,9 @@ void engine_run(engine_init_flags *init_flags) {
         int limit_dynamic = 100;
         while(static_wait > 10 && limit_static--) {
             // Static tick for gamestate
+            profiler_begin(PROFILE_STATIC_TICK);
             game_state_static_tick(gs);
+            profiler_end(PROFILE_STATIC_TICK);
 
             // Tick console
             console_tick();
@@ -233,7 +246,9 @@ void engine_run(engine_init_flags *init_flags) {
         }
         while(dynamic_wait > game_state_ms_per_dyntick(gs) && limit_dynamic--) {
             // Tick scene
+            profiler_begin(PROFILE_DYNAMIC_TICK);
             game_state_dynamic_tick(gs);
+            profiler_end(PROFILE_DYNAMIC_TICK);
 
             // Handle waiting period leftover time
             dynamic_wait -= game_state_ms_per_dyntick(gs);
@@ -243,12 +258,16 @@ void engine_run(engine_init_flags *init_flags) {
         if(enable_screen_updates) {
 
             video_render_prepare();
+            profiler_begin(PROFILE_RENDER);
             game_state_render(gs);
+            profiler_end(PROFILE_RENDER);
             if(debugger_render) {
                 game_state_debug(gs);
             }
             console_render();
+            profiler_begin(PROFILE_RENDER_FINISH);
             video_render_finish();
+            profiler_end(PROFILE_RENDER_FINISH);
 
             // If screenshot requested, do it here.
             if(take_screenshot) {
@@ -271,6 +290,8 @@ void engine_run(engine_init_flags *init_flags) {
             // If screen updates are disabled, then wait
             SDL_Delay(1);
         }
+
+        profiler_frame_end();
     }
 
     // Free scene object
@@ -4,6 +4,7 @@
 typedef struct engine_init_flags_t {
     unsigned int net_mode;
     unsigned int record;
+    unsigned int headless; // Run without sound or screen effects
     char rec_file[255];
 } engine_init_flags;
 
@@ -175,6 +175,7 @@ int sd_rec_load(sd_rec_file *rec, const char *file) {
     // Okay, not reduce the allocated memory to match what we actually need
     // Realloc should keep our old data intact
     rec->moves = omf_realloc(rec->moves, rec->move_count * sizeof(sd_rec_move));
+    rec->move_capacity = rec->move_count;
 
     // Close & return
     sd_reader_close(r);
@@ -185,17 +186,7 @@ error_0:
     return ret;
 }
 
-int sd_rec_save(sd_rec_file *rec, const char *file) {
-    sd_writer *w;
-
-    if(rec == NULL || file == NULL) {
-        return SD_INVALID_INPUT;
-    }
-
-    if(!(w = sd_writer_open(file))) {
-        return SD_FILE_OPEN_ERROR;
-    }
-
+static void sd_rec_write_header(sd_writer *w, const sd_rec_file *rec) {
     // Write pilots, palettes, etc.
     for(int i = 0; i < 2; i++) {
         sd_pilot_save(w, &rec->pilots[i].info);
@@ -237,61 +228,115 @@ int sd_rec_save(sd_rec_file *rec, const char *file) {
     out |= (rec->hyper_mode & 0x1) << 24;
     sd_write_udword(w, out);
     sd_write_byte(w, rec->unknown_m);
+}
 
-    // Move records
-    for(int i = 0; i < rec->move_count; i++) {
-        sd_write_udword(w, rec->moves[i].tick);
-        sd_write_ubyte(w, rec->moves[i].lookup_id);
-        sd_write_ubyte(w, rec->moves[i].player_id);
+static void sd_rec_write_move(sd_writer *w, const sd_rec_move *move) {
+    sd_write_udword(w, move->tick);
+    sd_write_ubyte(w, move->lookup_id);
+    sd_write_ubyte(w, move->player_id);
+
+    int extra_length = sd_rec_extra_len(move->lookup_id);
+    if(extra_length > 0) {
+        // Write action information
+        uint8_t raw_action = 0;
+        switch(move->action & SD_MOVE_MASK) {
+            case(SD_ACT_UP):
+                raw_action = 16;
+                break;
+            case(SD_ACT_UP | SD_ACT_RIGHT):
+                raw_action = 32;
+                break;
+            case(SD_ACT_RIGHT):
+                raw_action = 48;
+                break;
+            case(SD_ACT_DOWN | SD_ACT_RIGHT):
+                raw_action = 64;
+                break;
+            case(SD_ACT_DOWN):
+                raw_action = 80;
+                break;
+            case(SD_ACT_DOWN | SD_ACT_LEFT):
+                raw_action = 96;
+                break;
+            case(SD_ACT_LEFT):
+                raw_action = 112;
+                break;
+            case(SD_ACT_UP | SD_ACT_LEFT):
+                raw_action = 128;
+                break;
+        }
+        if(move->action & SD_ACT_PUNCH)
+            raw_action |= 1;
+        if(move->action & SD_ACT_KICK)
+            raw_action |= 2;
+        sd_write_ubyte(w, raw_action);
+
+        // If there is more extra data, write it
+        int unknown_len = extra_length - 1;
+        if(unknown_len > 0) {
+            sd_write_buf(w, move->extra_data, unknown_len);
+        }
+    }
+}
 
-        int extra_length = sd_rec_extra_len(rec->moves[i].lookup_id);
-        if(extra_length > 0) {
-            // Write action information
-            uint8_t raw_action = 0;
-            switch(rec->moves[i].action & SD_MOVE_MASK) {
-                case(SD_ACT_UP):
-                    raw_action = 16;
-                    break;
-                case(SD_ACT_UP | SD_ACT_RIGHT):
-                    raw_action = 32;
-                    break;
-                case(SD_ACT_RIGHT):
-                    raw_action = 48;
-                    break;
-                case(SD_ACT_DOWN | SD_ACT_RIGHT):
-                    raw_action = 64;
-                    break;
-                case(SD_ACT_DOWN):
-                    raw_action = 80;
-                    break;
-                case(SD_ACT_DOWN | SD_ACT_LEFT):
-                    raw_action = 96;
-                    break;
-                case(SD_ACT_LEFT):
-                    raw_action = 112;
-                    break;
-                case(SD_ACT_UP | SD_ACT_LEFT):
-                    raw_action = 128;
-                    break;
-            }
-            if(rec->moves[i].action & SD_ACT_PUNCH)
-                raw_action |= 1;
-            if(rec->moves[i].action & SD_ACT_KICK)
-                raw_action |= 2;
-            sd_write_ubyte(w, raw_action);
+int sd_rec_save(sd_rec_file *rec, const char *file) {
+    sd_writer *w;
 
-            // If there is more extra data, write it
-            int unknown_len = extra_length - 1;
-            if(unknown_len > 0) {
-                sd_write_buf(w, rec->moves[i].extra_data, unknown_len);
-            }
-        }
+    if(rec == NULL || file == NULL) {
+        return SD_INVALID_INPUT;
+    }
+
+    if(!(w = sd_writer_open(file))) {
+        return SD_FILE_OPEN_ERROR;
+    }
+
+    sd_rec_write_header(w, rec);
+    for(int i = 0; i < rec->move_count; i++) {
+        sd_rec_write_move(w, &rec->moves[i]);
     }
 
     sd_writer_close(w);
     return SD_SUCCESS;
 }
 
+struct sd_rec_stream_t {
+    sd_writer *w;
+};
+
+sd_rec_stream *sd_rec_stream_open(const sd_rec_file *rec, const char *file) {
+    if(rec == NULL || file == NULL) {
+        return NULL;
+    }
+    sd_writer *w = sd_writer_open(file);
+    if(w == NULL) {
+        return NULL;
+    }
+    sd_rec_stream *stream = omf_calloc(1, sizeof(sd_rec_stream));
+    stream->w = w;
+    sd_rec_write_header(w, rec);
+    sd_writer_flush(w);
+    return stream;
+}
+
+int sd_rec_stream_write(sd_rec_stream *stream, const sd_rec_move *moves, unsigned int count) {
+    if(stream == NULL || (moves == NULL && count > 0)) {
+        return SD_INVALID_INPUT;
+    }
+    for(unsigned int i = 0; i < count; i++) {
+        sd_rec_write_move(stream->w, &moves[i]);
+    }
+    sd_writer_flush(stream->w);
+    return (sd_writer_errno(stream->w) == 0) ? SD_SUCCESS : SD_FILE_WRITE_ERROR;
+}
+
+void sd_rec_stream_close(sd_rec_stream *stream) {
+    if(stream == NULL) {
+        return;
+    }
+    sd_writer_close(stream->w);
+    omf_free(stream);
+}
+
 int sd_rec_delete_action(sd_rec_file *rec, unsigned int number) {
     if(rec == NULL || number >= rec->move_count) {
         return SD_INVALID_INPUT;
@@ -302,9 +347,8 @@ int sd_rec_delete_action(sd_rec_file *rec, unsigned int number) {
         memmove(rec->moves + number, rec->moves + number + 1, (rec->move_count - number - 1) * sizeof(sd_rec_move));
     }
 
-    // Resize to save memory
+    // Capacity is kept, it will be reused by following inserts
     rec->move_count--;
-    rec->moves = omf_realloc(rec->moves, rec->move_count * sizeof(sd_rec_move));
     return SD_SUCCESS;
 }
 
@@ -316,8 +360,11 @@ int sd_rec_insert_action(sd_rec_file *rec, unsigned int number, const sd_rec_mov
         return SD_INVALID_INPUT;
     }
 
-    // Resize
-    rec->moves = omf_realloc(rec->moves, (rec->move_count + 1) * sizeof(sd_rec_move));
+    // Grow geometrically, so that appending a long recording one move at a time stays cheap
+    if(rec->move_count >= rec->move_capacity) {
+        rec->move_capacity = (rec->move_capacity < 64) ? 64 : rec->move_capacity * 2;
+        rec->moves = omf_realloc(rec->moves, rec->move_capacity * sizeof(sd_rec_move));
+    }
 
     // Only move if we are inserting, not appending
     // when number == move_count-1, we are pushing the last entry forwards by one
@@ -84,10 +84,19 @@ typedef struct {
 
     int8_t unknown_m; ///< Unknown \todo: Find out
 
-    unsigned int move_count; ///< How many REC event records
-    sd_rec_move *moves;      ///< REC event records list
+    unsigned int move_count;    ///< How many REC event records
+    unsigned int move_capacity; ///< How many REC event records fit in the moves list
+    sd_rec_move *moves;         ///< REC event records list
 } sd_rec_file;
 
+/*! \brief REC file being written incrementally
+ *
+ * Writes the REC header once and then appends event records as they come in.
+ * Since the REC format has no record count in the header, the file is valid
+ * after every write, even if the program stops before closing the stream.
+ */
+typedef struct sd_rec_stream_t sd_rec_stream;
+
 /*! \brief Initialize REC file structure
  *
  * Initializes the REC file structure with empty values.
@@ -168,6 +177,38 @@ int sd_rec_extra_len(int key);
  */
 int sd_rec_insert_action(sd_rec_file *rec, unsigned int number, const sd_rec_move *move);
 
+/*! \brief Start writing a REC file incrementally
+ *
+ * Creates the file and writes the REC header from the given structure. Event records
+ * in the structure are not written; use sd_rec_stream_write() for those.
+ *
+ * \return Stream handle, or NULL if the file could not be opened.
+ *
+ * \param rec REC struct pointer with the header information.
+ * \param filename Name of the REC file to write into.
+ */
+sd_rec_stream *sd_rec_stream_open(const sd_rec_file *rec, const char *filename);
+
+/*! \brief Append REC event records to a stream
+ *
+ * Writes the given records to the end of the file and flushes them to disk.
+ *
+ * \retval SD_INVALID_INPUT Stream was NULL.
+ * \retval SD_FILE_WRITE_ERROR Writing failed.
+ * \retval SD_SUCCESS Success.
+ *
+ * \param stream Stream handle
+ * \param moves Records to write
+ * \param count Number of records
+ */
+int sd_rec_stream_write(sd_rec_stream *stream, const sd_rec_move *moves, unsigned int count);
+
+/*! \brief Close a REC stream
+ *
+ * \param stream Stream handle. May be NULL.
+ */
+void sd_rec_stream_close(sd_rec_stream *stream);
+
 #ifdef __cplusplus
 }
 #endif
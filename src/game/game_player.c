@@ -35,7 +35,7 @@ object *game_player_get_har(game_player *gp) {
 
 void game_player_set_ctrl(game_player *gp, controller *ctrl) {
     if(gp->ctrl != NULL) {
-        gp->ctrl->free_fun(gp->ctrl);
+        controller_free(gp->ctrl);
         omf_free(gp->ctrl);
     }
     gp->ctrl = ctrl;
@@ -1,12 +1,15 @@
 #include "game/game_state.h"
+#include "audio/audio.h"
 #include "console/console.h"
 #include "controller/joystick.h"
 #include "controller/keyboard.h"
+#include "controller/lookahead_controller.h"
 #include "controller/rec_controller.h"
 #include "formats/error.h"
 #include "formats/pilot.h"
 #include "formats/rec.h"
 #include "game/common_defines.h"
+#include "game/gui/text_render.h"
 #include "game/protos/object.h"
 #include "game/protos/scene.h"
 #include "game/scenes/arena.h"
@@ -20,17 +23,22 @@
 #include "game/scenes/openomf.h"
 #include "game/scenes/scoreboard.h"
 #include "game/scenes/vs.h"
+#include "game/utils/keyframes.h"
+#include "game/utils/kinematics.h"
 #include "game/utils/serial.h"
 #include "game/utils/settings.h"
 #include "game/utils/ticktimer.h"
+#include "resources/ids.h"
 #include "resources/pilots.h"
 #include "utils/allocator.h"
 #include "utils/log.h"
 #include "utils/miscmath.h"
+#include "utils/profiler.h"
 #include "video/tcache.h"
 #include "video/video.h"
 #include <SDL.h>
 #include <math.h>
+#include <stdio.h>
 #include <stdlib.h>
 
 #define MS_PER_OMF_TICK 10
@@ -43,6 +51,7 @@ enum
 };
 
 static void _setup_rec_controller(game_state *gs, int player_id, sd_rec_file *rec);
+static void game_state_restore(game_state *gs, serial *ser, int reuse_hars);
 
 // How long the scene waits after order to move to another scene
 // Used for crossfades
@@ -52,20 +61,82 @@ typedef struct {
     int layer;      ///< Object rendering layer
     int persistent; ///< 1 if the object should keep alive across scene boundaries
     int singleton;  ///< 1 if object should be the only representative of its animation ID
-    object *obj;
+    object *obj;    ///< NULL if the object has been removed, but not yet swept
 } render_obj;
 
+typedef struct {
+    object *obj;            ///< NULL if the slot is free
+    unsigned int next_free; ///< Next free slot + 1, if this slot is free
+    uint16_t generation;    ///< Bumped when the slot is freed, invalidating old handles
+} object_slot;
+
+// Returns the n'th entry of the object list. The pointer is only valid until the next object is added.
+static inline render_obj *robj_at(game_state *gs, unsigned int n) {
+    return (render_obj *)gs->objects.data + n;
+}
+
+// Iterates the live objects in insertion order. Objects added while iterating are visited too,
+// so robj is fetched again on every step.
+#define FOREACH_OBJECT(gs, n, robj)                                                                                    \
+    for(unsigned int n = 0; n < (gs)->objects.blocks; n++)                                                             \
+        if(((robj) = robj_at((gs), n))->obj != NULL)
+
+// Thread bindings that were replaced by game_state_bind_saved()
+typedef struct {
+    struct random_t *rand;
+    settings *settings;
+    bool audio;
+    bool video;
+    bool profiling;
+} saved_bindings;
+
+void game_state_bind(game_state *gs) {
+    rand_bind(&gs->rand);
+    settings_bind(gs->settings);
+    audio_bind_output(!gs->headless);
+    video_bind_output(!gs->headless);
+    profiler_bind(!gs->is_fork);
+}
+
+// Like game_state_bind(), but remembers the old bindings for game_state_unbind_saved()
+static void game_state_bind_saved(game_state *gs, saved_bindings *saved) {
+    saved->rand = rand_bind(&gs->rand);
+    saved->settings = settings_bind(gs->settings);
+    saved->audio = audio_bind_output(!gs->headless);
+    saved->video = video_bind_output(!gs->headless);
+    saved->profiling = profiler_bind(!gs->is_fork);
+}
+
+static void game_state_unbind_saved(const saved_bindings *saved) {
+    rand_bind(saved->rand);
+    settings_bind(saved->settings);
+    audio_bind_output(saved->audio);
+    video_bind_output(saved->video);
+    profiler_bind(saved->profiling);
+}
+
 int game_state_create(game_state *gs, engine_init_flags *init_flags) {
     gs->run = 1;
     gs->paused = 0;
     gs->tick = 0;
     gs->int_tick = 0;
     gs->role = ROLE_CLIENT;
-    gs->next_requires_refresh = 0;
     gs->net_mode = init_flags->net_mode;
     gs->speed = settings_get()->gameplay.speed + 5;
     gs->init_flags = init_flags;
+    // Headless games get a snapshot of the settings. The game on screen follows the global settings, which the
+    // menus change while it runs.
+    gs->settings = init_flags->headless ? settings_copy(settings_get()) : NULL;
+    gs->headless = init_flags->headless;
+    gs->is_fork = 0;
+    random_seed(&gs->rand, rand_get_seed());
+    game_state_bind(gs);
     vector_create(&gs->objects, sizeof(render_obj));
+    vector_create(&gs->object_slots, sizeof(object_slot));
+    gs->dead_objects = 0;
+    gs->free_slot = 0;
+    kinematics_create(&gs->particles);
+    gs->keyframes = NULL;
 
     // For screen shake
     gs->screen_shake_horizontal = 0;
@@ -102,6 +173,19 @@ int game_state_create(game_state *gs, engine_init_flags *init_flags) {
 
         nscene = SCENE_ARENA0 + rec.arena_id;
         DEBUG("playing recording file %s", init_flags->rec_file);
+
+        // Keyframes from an earlier playback make seeking fast. Missing ones are created while playing.
+        // Headless playbacks can't seek, and must not write next to the recordings they verify.
+        if(!init_flags->headless) {
+            char kf_file[sizeof(init_flags->rec_file) + 4];
+            snprintf(kf_file, sizeof(kf_file), "%s.kf", init_flags->rec_file);
+            gs->keyframes = omf_calloc(1, sizeof(keyframes));
+            keyframes_create(gs->keyframes, KEYFRAME_INTERVAL, keyframes_hash_file(init_flags->rec_file),
+                             rec.move_count);
+            if(keyframes_load(gs->keyframes, kf_file) == 0) {
+                DEBUG("loaded %u keyframes from %s", vector_size(&gs->keyframes->frames), kf_file);
+            }
+        }
         if(scene_create(gs->sc, gs, nscene)) {
             PERROR("Error while loading scene %d.", nscene);
             goto error_0;
@@ -157,9 +241,97 @@ error_1:
 error_0:
     omf_free(gs->sc);
     vector_free(&gs->objects);
+    vector_free(&gs->object_slots);
+    if(gs->keyframes) {
+        keyframes_free(gs->keyframes);
+        omf_free(gs->keyframes);
+    }
     return 1;
 }
 
+static object_handle game_state_alloc_handle(game_state *gs, object *obj) {
+    object_slot *slot;
+    unsigned int n;
+    if(gs->free_slot != 0) {
+        n = gs->free_slot - 1;
+        slot = vector_get(&gs->object_slots, n);
+        gs->free_slot = slot->next_free;
+    } else {
+        n = vector_size(&gs->object_slots);
+        if(n >= 0xFFFF) {
+            PERROR("Out of object handles!");
+            return OBJECT_HANDLE_NONE;
+        }
+        object_slot new_slot = {NULL, 0, 0};
+        vector_append(&gs->object_slots, &new_slot);
+        slot = vector_get(&gs->object_slots, n);
+    }
+    slot->obj = obj;
+    return ((object_handle)slot->generation << 16) | (n + 1);
+}
+
+static void game_state_release_handle(game_state *gs, object_handle handle) {
+    if(handle == OBJECT_HANDLE_NONE) {
+        return;
+    }
+    unsigned int n = (handle & 0xFFFF) - 1;
+    object_slot *slot = vector_get(&gs->object_slots, n);
+    slot->obj = NULL;
+    slot->generation++;
+    slot->next_free = gs->free_slot;
+    gs->free_slot = n + 1;
+}
+
+/*
+ * Returns the object the handle refers to, or NULL if the object has been removed from the game state.
+ */
+object *game_state_find_object(game_state *gs, object_handle handle) {
+    if(handle == OBJECT_HANDLE_NONE) {
+        return NULL;
+    }
+    unsigned int n = (handle & 0xFFFF) - 1;
+    if(n >= gs->object_slots.blocks) {
+        return NULL;
+    }
+    object_slot *slot = (object_slot *)gs->object_slots.data + n;
+    if(slot->generation != (handle >> 16)) {
+        return NULL;
+    }
+    return slot->obj;
+}
+
+// Frees the object, and leaves its entry empty for game_state_sweep_objects() to remove.
+// This is safe to do while iterating the object list.
+static void game_state_remove_object(game_state *gs, render_obj *robj) {
+    object *obj = robj->obj;
+    robj->obj = NULL;
+    gs->dead_objects++;
+    game_state_release_handle(gs, obj->handle);
+    object_free(obj);
+    omf_free(obj);
+}
+
+// Compacts the object list in a single pass, keeping the order of the remaining objects.
+// Must not be called while iterating the object list.
+static void game_state_sweep_objects(game_state *gs) {
+    if(gs->dead_objects == 0) {
+        return;
+    }
+    unsigned int size = vector_size(&gs->objects);
+    unsigned int live = 0;
+    for(unsigned int n = 0; n < size; n++) {
+        render_obj *robj = robj_at(gs, n);
+        if(robj->obj != NULL) {
+            if(live != n) {
+                *robj_at(gs, live) = *robj;
+            }
+            live++;
+        }
+    }
+    vector_truncate(&gs->objects, live);
+    gs->dead_objects = 0;
+}
+
 /*
  * \param game_state gs Game state object
  * \param obj Object to add
@@ -175,16 +347,15 @@ int game_state_add_object(game_state *gs, object *obj, int layer, int singleton,
     o.persistent = persistent;
     animation *new_ani = object_get_animation(obj);
     if(singleton) {
-        iterator it;
         render_obj *robj;
-        vector_iter_begin(&gs->objects, &it);
-        while((robj = iter_next(&it)) != NULL) {
+        FOREACH_OBJECT(gs, n, robj) {
             animation *ani = object_get_animation(robj->obj);
             if(ani != NULL && ani->id == new_ani->id && robj->singleton) {
                 return 1;
             }
         }
     }
+    obj->handle = game_state_alloc_handle(gs, obj);
     vector_append(&gs->objects, &o);
 
 #ifdef DEBUGMODE_STFU
@@ -215,15 +386,11 @@ unsigned int game_state_get_speed(game_state *gs) {
 }
 
 void game_state_del_animation(game_state *gs, int anim_id) {
-    iterator it;
     render_obj *robj;
-    vector_iter_begin(&gs->objects, &it);
-    while((robj = iter_next(&it)) != NULL) {
+    FOREACH_OBJECT(gs, n, robj) {
         animation *ani = object_get_animation(robj->obj);
         if(ani != NULL && ani->id == anim_id) {
-            object_free(robj->obj);
-            omf_free(robj->obj);
-            vector_delete(&gs->objects, &it);
+            game_state_remove_object(gs, robj);
             DEBUG("Deleted animation %i from game_state.", anim_id);
             return;
         }
@@ -232,24 +399,18 @@ void game_state_del_animation(game_state *gs, int anim_id) {
 }
 
 void game_state_del_object(game_state *gs, object *target) {
-    iterator it;
     render_obj *robj;
-    vector_iter_begin(&gs->objects, &it);
-    while((robj = iter_next(&it)) != NULL) {
+    FOREACH_OBJECT(gs, n, robj) {
         if(target == robj->obj) {
-            object_free(robj->obj);
-            omf_free(robj->obj);
-            vector_delete(&gs->objects, &it);
+            game_state_remove_object(gs, robj);
             return;
         }
     }
 }
 
 void game_state_get_projectiles(game_state *gs, vector *obj_proj) {
-    iterator it;
     render_obj *robj;
-    vector_iter_begin(&gs->objects, &it);
-    while((robj = iter_next(&it)) != NULL) {
+    FOREACH_OBJECT(gs, n, robj) {
         if(object_get_layers(robj->obj) & LAYER_PROJECTILE) {
             vector_append(obj_proj, &robj->obj);
         }
@@ -257,14 +418,10 @@ void game_state_get_projectiles(game_state *gs, vector *obj_proj) {
 }
 
 void game_state_clear_hazards_projectiles(game_state *gs) {
-    iterator it;
     render_obj *robj;
-    vector_iter_begin(&gs->objects, &it);
-    while((robj = iter_next(&it)) != NULL) {
+    FOREACH_OBJECT(gs, n, robj) {
         if(object_get_group(robj->obj) == GROUP_PROJECTILE) {
-            object_free(robj->obj);
-            omf_free(robj->obj);
-            vector_delete(&gs->objects, &it);
+            game_state_remove_object(gs, robj);
         }
     }
 }
@@ -295,6 +452,7 @@ void game_state_set_paused(game_state *gs, unsigned int paused) {
 
 // Return 0 if event was handled here
 int game_state_handle_event(game_state *gs, SDL_Event *event) {
+    game_state_bind(gs);
     if(scene_event(gs->sc, event) == 0) {
         return 0;
     }
@@ -302,30 +460,13 @@ int game_state_handle_event(game_state *gs, SDL_Event *event) {
 }
 
 void game_state_render(game_state *gs) {
-    iterator it;
     render_obj *robj;
+    game_state_bind(gs);
 
-    // Do palette transformations
+    // Do palette transformations. The texture cache picks up the changed palette ranges by itself.
     screen_palette *scr_pal = video_get_pal_ref();
-    int pal_changed = 0;
-    vector_iter_begin(&gs->objects, &it);
-    while((robj = iter_next(&it)) != NULL) {
-        if(object_palette_transform(robj->obj, scr_pal) == 1) {
-            pal_changed = 1;
-            gs->next_requires_refresh = 1;
-        }
-    }
-
-    // If changes were made to palette, then
-    // all resources that depend on it must be redrawn.
-    // This will take care of it.
-    if(pal_changed) {
-        scr_pal->version++;
-    } else if(gs->next_requires_refresh) {
-        // Because of caching, we might sometimes get stuck to
-        // a bad/old frame. This will fix it.
-        scr_pal->version++;
-        gs->next_requires_refresh = 0;
+    FOREACH_OBJECT(gs, n, robj) {
+        object_palette_transform(robj->obj, scr_pal);
     }
 
     // Render scene background
@@ -337,8 +478,7 @@ void game_state_render(game_state *gs) {
     har[1] = game_state_get_player(gs, 1)->har;
 
     // Render BOTTOM layer
-    vector_iter_begin(&gs->objects, &it);
-    while((robj = iter_next(&it)) != NULL) {
+    FOREACH_OBJECT(gs, n, robj) {
         if(robj->layer == RENDER_LAYER_BOTTOM) {
             if(robj->obj == har[0] || robj->obj == har[1])
                 continue;
@@ -347,8 +487,7 @@ void game_state_render(game_state *gs) {
     }
 
     // cast object shadows (scrap, projectiles, etc)
-    vector_iter_begin(&gs->objects, &it);
-    while((robj = iter_next(&it)) != NULL) {
+    FOREACH_OBJECT(gs, n, robj) {
         object_render_shadow(robj->obj);
     }
 
@@ -360,8 +499,7 @@ void game_state_render(game_state *gs) {
     }
 
     // Render MIDDLE layer
-    vector_iter_begin(&gs->objects, &it);
-    while((robj = iter_next(&it)) != NULL) {
+    FOREACH_OBJECT(gs, n, robj) {
         if(robj->layer == RENDER_LAYER_MIDDLE) {
             if(robj->obj == har[0] || robj->obj == har[1])
                 continue;
@@ -377,8 +515,7 @@ void game_state_render(game_state *gs) {
     }
 
     // Render TOP layer
-    vector_iter_begin(&gs->objects, &it);
-    while((robj = iter_next(&it)) != NULL) {
+    FOREACH_OBJECT(gs, n, robj) {
         if(robj->layer == RENDER_LAYER_TOP) {
             if(robj->obj == har[0] || robj->obj == har[1])
                 continue;
@@ -400,6 +537,18 @@ void game_state_debug(game_state *gs) {
         }
     }
 #endif
+
+    // Frame profiler overlay. Times are in microseconds.
+    char buf[64];
+    profile_stats stats;
+    font_render_shadowed(&font_small, "phase     p50   p99   max", 2, 2, COLOR_YELLOW,
+                         TEXT_SHADOW_RIGHT | TEXT_SHADOW_BOTTOM);
+    for(int i = 0; i < NUMBER_OF_PROFILE_PHASES; i++) {
+        profiler_get_stats(i, &stats);
+        snprintf(buf, sizeof(buf), "%-8s%6u%6u%6u", profiler_phase_name(i), stats.p50_us, stats.p99_us,
+                 stats.max_us);
+        font_render_shadowed(&font_small, buf, 2, 10 + i * 8, COLOR_WHITE, TEXT_SHADOW_RIGHT | TEXT_SHADOW_BOTTOM);
+    }
 }
 
 int game_load_new(game_state *gs, int scene_id) {
@@ -412,15 +561,12 @@ int game_load_new(game_state *gs, int scene_id) {
 
     // Remove old objects
     render_obj *robj;
-    iterator it;
-    vector_iter_begin(&gs->objects, &it);
-    while((robj = iter_next(&it)) != NULL) {
+    FOREACH_OBJECT(gs, n, robj) {
         if(!robj->persistent) {
-            object_free(robj->obj);
-            omf_free(robj->obj);
-            vector_delete(&gs->objects, &it);
+            game_state_remove_object(gs, robj);
         }
     }
+    game_state_sweep_objects(gs);
 
     // Initialize new scene with BK data etc.
     gs->sc = omf_calloc(1, sizeof(scene));
@@ -522,10 +668,16 @@ error_0:
 void game_state_call_collide(game_state *gs) {
     object *a, *b;
     unsigned int size = vector_size(&gs->objects);
-    for(int i = 0; i < size; i++) {
-        a = ((render_obj *)vector_get(&gs->objects, i))->obj;
-        for(int k = i + 1; k < size; k++) {
-            b = ((render_obj *)vector_get(&gs->objects, k))->obj;
+    profiler_begin(PROFILE_COLLIDE);
+    for(unsigned int i = 0; i < size; i++) {
+        for(unsigned int k = i + 1; k < size; k++) {
+            // Either object may have been removed by an earlier collision
+            if((a = robj_at(gs, i)->obj) == NULL) {
+                break;
+            }
+            if((b = robj_at(gs, k)->obj) == NULL) {
+                continue;
+            }
             if(a->group != b->group || a->group == OBJECT_NO_GROUP || b->group == OBJECT_NO_GROUP) {
                 if(a->layers & b->layers) {
                     object_collide(a, b);
@@ -533,32 +685,44 @@ void game_state_call_collide(game_state *gs) {
             }
         }
     }
+    profiler_end(PROFILE_COLLIDE);
 }
 
 void game_state_cleanup(game_state *gs) {
     render_obj *robj;
-    iterator it;
-    vector_iter_begin(&gs->objects, &it);
-    while((robj = iter_next(&it)) != NULL) {
+    profiler_begin(PROFILE_CLEANUP);
+    FOREACH_OBJECT(gs, n, robj) {
         if(object_finished(robj->obj)) {
             /*DEBUG("Animation object %d is finished, removing.", robj->obj->cur_animation->id);*/
-            object_free(robj->obj);
-            omf_free(robj->obj);
-            vector_delete(&gs->objects, &it);
+            game_state_remove_object(gs, robj);
         }
     }
+    game_state_sweep_objects(gs);
+    profiler_end(PROFILE_CLEANUP);
 }
 
 void game_state_call_move(game_state *gs) {
     render_obj *robj;
-    iterator it;
-    vector_iter_begin(&gs->objects, &it);
-    while((robj = iter_next(&it)) != NULL) {
-        object_move(robj->obj);
+    profiler_begin(PROFILE_MOVE);
+
+    // Particles (scrap, oil) are moved in one batch after the objects with callbacks.
+    // They never interact with each other or anything else while moving, so the order is irrelevant.
+    kinematics_clear(&gs->particles);
+    FOREACH_OBJECT(gs, n, robj) {
+        if(object_is_particle(robj->obj)) {
+            kinematics_add(&gs->particles, robj->obj);
+        } else {
+            object_move(robj->obj);
+        }
     }
+    kinematics_integrate(&gs->particles);
+    kinematics_store(&gs->particles);
+
+    profiler_end(PROFILE_MOVE);
 }
 
 void game_state_tick_controllers(game_state *gs) {
+    game_state_bind(gs);
     for(int i = 0; i < game_state_num_players(gs); i++) {
         game_player *gp = game_state_get_player(gs, i);
         controller *c = game_player_get_ctrl(gp);
@@ -583,8 +747,7 @@ void game_state_ctrl_events_free(game_state *gs) {
         game_player *gp = game_state_get_player(gs, i);
         controller *c = game_player_get_ctrl(gp);
         if(c) {
-            controller_free_chain(c->extra_events);
-            c->extra_events = NULL;
+            ctrl_event_queue_clear(&c->extra_events);
         }
     }
 }
@@ -592,15 +755,15 @@ void game_state_ctrl_events_free(game_state *gs) {
 // This function is called with changing interval, depending on the value of game speed
 void game_state_call_tick(game_state *gs, int mode) {
     render_obj *robj;
-    iterator it;
-    vector_iter_begin(&gs->objects, &it);
-    while((robj = iter_next(&it)) != NULL) {
+    profiler_begin(PROFILE_TICK);
+    FOREACH_OBJECT(gs, n, robj) {
         if(mode == TICK_DYNAMIC) {
             object_dynamic_tick(robj->obj);
         } else {
             object_static_tick(robj->obj);
         }
     }
+    profiler_end(PROFILE_TICK);
 
     // Speed back up
     if(gs->speed_slowdown_time == 0) {
@@ -614,6 +777,8 @@ void game_state_call_tick(game_state *gs, int mode) {
 
 // This function is always called with the same interval, and game speed does not affect it
 void game_state_static_tick(game_state *gs) {
+    game_state_bind(gs);
+
     // Set scene crossfade values
     if(gs->next_wait_ticks > 0) {
         gs->next_wait_ticks--;
@@ -633,6 +798,8 @@ void game_state_static_tick(game_state *gs) {
 
 // This function is called when the game speed requires it
 void game_state_dynamic_tick(game_state *gs) {
+    game_state_bind(gs);
+
     // We want to load another scene
     if(gs->this_id != gs->next_id && (gs->next_wait_ticks <= 1 || !settings_get()->video.crossfade_on)) {
         // If this is the end, set run to 0 so that engine knows to close here
@@ -694,6 +861,11 @@ void game_state_dynamic_tick(game_state *gs) {
     }
 
     if(!game_state_is_paused(gs)) {
+        // Snapshot the state at the start of the tick for replay seeking
+        if(gs->keyframes && is_arena(gs->this_id)) {
+            keyframes_record(gs->keyframes, gs);
+        }
+
         // Clean up objects
         game_state_cleanup(gs);
 
@@ -778,7 +950,11 @@ void _setup_ai(game_state *gs, int player_id) {
     controller_init(ctrl);
 
     sd_pilot *pilot = game_player_get_pilot(player);
-    ai_controller_create(ctrl, settings_get()->gameplay.difficulty, pilot, player->pilot->pilot_id);
+    if(settings_get()->gameplay.ai_lookahead) {
+        lookahead_controller_create(ctrl, settings_get()->gameplay.difficulty, pilot, player->pilot->pilot_id);
+    } else {
+        ai_controller_create(ctrl, settings_get()->gameplay.difficulty, pilot, player->pilot->pilot_id);
+    }
 
     game_player_set_ctrl(player, ctrl);
     game_player_set_selectable(player, 0);
@@ -848,28 +1024,65 @@ void game_state_init_demo(game_state *gs) {
 void game_state_free(game_state **_gs) {
     game_state *gs = *_gs;
     *_gs = NULL;
+    saved_bindings saved;
+    game_state_bind_saved(gs, &saved);
 
     // Free objects
     render_obj *robj;
-    iterator it;
-    vector_iter_begin(&gs->objects, &it);
-    while((robj = iter_next(&it)) != NULL) {
-        object_free(robj->obj);
-        omf_free(robj->obj);
-        vector_delete(&gs->objects, &it);
+    FOREACH_OBJECT(gs, n, robj) {
+        game_state_remove_object(gs, robj);
     }
     vector_free(&gs->objects);
+    vector_free(&gs->object_slots);
+    kinematics_free(&gs->particles);
+
+    // Keep the keyframes for the next playback of the same recording
+    if(gs->keyframes) {
+        if(keyframes_is_dirty(gs->keyframes)) {
+            char kf_file[sizeof(gs->init_flags->rec_file) + 4];
+            snprintf(kf_file, sizeof(kf_file), "%s.kf", gs->init_flags->rec_file);
+            keyframes_save(gs->keyframes, kf_file);
+        }
+        keyframes_free(gs->keyframes);
+        omf_free(gs->keyframes);
+    }
 
-    // Free scene
-    scene_free(gs->sc);
+    // Free scene. A fork only owns the copy of the scene struct.
+    if(!gs->is_fork) {
+        scene_free(gs->sc);
+    }
     omf_free(gs->sc);
 
     // Free players
     for(int i = 0; i < 2; i++) {
         game_player_set_ctrl(gs->players[i], NULL);
-        game_player_free(gs->players[i]);
+        if(gs->is_fork) {
+            chr_score_free(&gs->players[i]->score);
+            har_screencaps_free(&gs->players[i]->screencaps);
+        } else {
+            game_player_free(gs->players[i]);
+        }
         omf_free(gs->players[i]);
     }
+
+    // The thread goes back to the game state that made the fork
+    if(gs->is_fork) {
+        game_state_unbind_saved(&saved);
+        settings_free_copy(gs->settings);
+        omf_free(gs);
+        return;
+    }
+
+    // Back to the process-wide defaults. The RNG continues from where this game left it.
+    rand_bind(NULL);
+    rand_seed(random_get_seed(&gs->rand));
+    settings_bind(NULL);
+    audio_bind_output(true);
+    video_bind_output(true);
+    profiler_bind(true);
+    if(gs->settings != NULL) {
+        settings_free_copy(gs->settings);
+    }
     omf_free(gs);
 }
 
@@ -909,11 +1122,9 @@ int game_state_serialize(game_state *gs, serial *ser) {
     serial_create(&objects);
 
     // serialize any HAZARD or PROJECTILE objects
-    iterator it;
-    vector_iter_begin(&gs->objects, &it);
     render_obj *robj;
     uint8_t count = 0;
-    while((robj = iter_next(&it)) != NULL) {
+    FOREACH_OBJECT(gs, n, robj) {
         if(robj->obj->group == GROUP_PROJECTILE) {
             serial_write_int8(&objects, robj->layer);
             object_serialize(robj->obj, &objects);
@@ -922,7 +1133,7 @@ int game_state_serialize(game_state *gs, serial *ser) {
     }
     serial_write_int8(ser, count);
 
-    serial_write(ser, objects.data, objects.len);
+    serial_write(ser, objects.data, serial_len(&objects));
     serial_free(&objects);
 
     chr_score_serialize(game_player_get_score(game_state_get_player(gs, 0)), ser);
@@ -931,23 +1142,29 @@ int game_state_serialize(game_state *gs, serial *ser) {
     return 0;
 }
 
-int game_state_unserialize(game_state *gs, serial *ser, int rtt) {
-    int old_tick = gs->tick;
+// Replaces the HARs, projectiles and scores with a serialized state, without advancing time.
+// With reuse_hars, the HAR objects of the players have been taken out of the object list already, and are
+// unserialized into again instead of being freed and allocated anew.
+static void game_state_restore(game_state *gs, serial *ser, int reuse_hars) {
     gs->tick = serial_read_int32(ser);
-    int end_tick = gs->tick + ceilf(rtt / 2.0f);
     rand_seed(serial_read_int32(ser));
     game_state_set_paused(gs, serial_read_int32(ser));
 
     for(int i = 0; i < 2; i++) {
         // Declare some vars
         game_player *player = game_state_get_player(gs, i);
-        game_state_del_object(gs, player->har);
-        object *obj = omf_calloc(1, sizeof(object));
+        object *obj;
+        if(reuse_hars) {
+            obj = player->har;
+            object_reset(obj);
+        } else {
+            game_state_del_object(gs, player->har);
+            obj = omf_calloc(1, sizeof(object));
+            object_create(obj, gs, vec2i_create(0, 0), vec2f_create(0, 0));
+        }
 
-        // Create object and specialize it as HAR.
+        // Specialize the object as HAR.
         // Errors are unlikely here, but check anyway.
-
-        object_create(obj, gs, vec2i_create(0, 0), vec2f_create(0, 0));
         object_unserialize(obj, ser, gs);
 
         // Set HAR to controller and game_player
@@ -963,20 +1180,17 @@ int game_state_unserialize(game_state *gs, serial *ser, int rtt) {
     obj_har1 = game_player_get_har(game_state_get_player(gs, 0));
     obj_har2 = game_player_get_har(game_state_get_player(gs, 1));
 
-    obj_har1->animation_state.enemy = obj_har2;
-    obj_har2->animation_state.enemy = obj_har1;
+    obj_har1->animation_state.enemy = obj_har2->handle;
+    obj_har2->animation_state.enemy = obj_har1->handle;
 
     // clean out any current projectiles/hazards
-    iterator it;
-    vector_iter_begin(&gs->objects, &it);
     render_obj *robj;
-    while((robj = iter_next(&it)) != NULL) {
+    FOREACH_OBJECT(gs, n, robj) {
         if(robj->obj->group == GROUP_PROJECTILE) {
-            object_free(robj->obj);
-            omf_free(robj->obj);
-            vector_delete(&gs->objects, &it);
+            game_state_remove_object(gs, robj);
         }
     }
+    game_state_sweep_objects(gs);
 
     uint8_t count = serial_read_int8(ser);
 
@@ -992,18 +1206,195 @@ int game_state_unserialize(game_state *gs, serial *ser, int rtt) {
 
     chr_score_unserialize(game_player_get_score(game_state_get_player(gs, 0)), ser);
     chr_score_unserialize(game_player_get_score(game_state_get_player(gs, 1)), ser);
+}
+
+// Runs the objects of an unpaused dynamic tick, without the scene, controllers or screen effects
+static void game_state_simulate_tick(game_state *gs) {
+    game_state_cleanup(gs);
+    game_state_call_move(gs);
+    game_state_call_collide(gs);
+    game_state_call_tick(gs, TICK_DYNAMIC);
+    gs->tick++;
+}
+
+int game_state_unserialize(game_state *gs, serial *ser, int rtt) {
+    int old_tick = gs->tick;
+    game_state_restore(gs, ser, 0);
+    int end_tick = gs->tick + ceilf(rtt / 2.0f);
 
     // tick things back to the current time
     DEBUG("replaying %d ticks", end_tick - gs->tick);
     DEBUG("adjusting clock from %d to %d (%d)", old_tick, end_tick, ceilf(rtt / 2.0f));
     while(gs->tick <= end_tick) {
-        game_state_cleanup(gs);
-        game_state_call_move(gs);
-        game_state_call_collide(gs);
-        game_state_call_tick(gs, TICK_DYNAMIC);
-        gs->tick++;
+        game_state_simulate_tick(gs);
     }
     DEBUG("replay done");
 
     return 0;
 }
+
+unsigned int game_state_fast_forward(game_state *gs, unsigned int ticks) {
+    unsigned int scene_id = gs->this_id;
+    unsigned int paused = gs->paused;
+    unsigned int done = 0;
+
+    // Run even if paused, this is also used for stepping frame by frame
+    gs->paused = 0;
+    while(done < ticks && gs->run && gs->this_id == scene_id && gs->next_id == scene_id) {
+        game_state_dynamic_tick(gs);
+        done++;
+    }
+    gs->paused = paused;
+    return done;
+}
+
+game_state *game_state_fork(game_state *gs, const serial *state) {
+    if(!is_arena(gs->this_id) || gs->players[0]->har == NULL || gs->players[1]->har == NULL) {
+        return NULL;
+    }
+
+    saved_bindings saved;
+    game_state_bind_saved(gs, &saved);
+
+    game_state *fork = omf_calloc(1, sizeof(game_state));
+    fork->run = 1;
+    fork->this_id = gs->this_id;
+    fork->next_id = gs->next_id;
+    fork->next_next_id = gs->next_next_id;
+    fork->int_tick = gs->int_tick;
+    fork->role = gs->role;
+    fork->speed = gs->speed;
+    fork->init_flags = gs->init_flags;
+    fork->speed_slowdown_previous = gs->speed_slowdown_previous;
+    fork->speed_slowdown_time = gs->speed_slowdown_time;
+    fork->net_mode = NET_MODE_NONE;
+    fork->settings = settings_copy(settings_get());
+    fork->headless = 1;
+    fork->is_fork = 1;
+    vector_create(&fork->objects, sizeof(render_obj));
+    vector_create(&fork->object_slots, sizeof(object_slot));
+    kinematics_create(&fork->particles);
+
+    // The scene is only needed for its resources and for reading the arena state, so it is not ticked.
+    fork->sc = omf_calloc(1, sizeof(scene));
+    fork->sc->gs = fork;
+    fork->sc->id = gs->sc->id;
+    fork->sc->bk_data = gs->sc->bk_data;
+    fork->sc->af_data[0] = gs->sc->af_data[0];
+    fork->sc->af_data[1] = gs->sc->af_data[1];
+    fork->sc->userdata = gs->sc->userdata;
+
+    // Players borrow the pilots, and get a controller that only holds the HAR
+    for(int i = 0; i < 2; i++) {
+        game_player *src = gs->players[i];
+        game_player *dst = omf_calloc(1, sizeof(game_player));
+        dst->pilot = src->pilot;
+        dst->chr = src->chr;
+        dst->selectable = src->selectable;
+        dst->score = src->score;
+        list_create(&dst->score.texts);
+        dst->god = src->god;
+        dst->ez_destruct = src->ez_destruct;
+        dst->sp_wins = src->sp_wins;
+        har_screencaps_create(&dst->screencaps);
+        dst->ctrl = omf_calloc(1, sizeof(controller));
+        controller_init(dst->ctrl);
+        fork->players[i] = dst;
+    }
+
+    game_state_unbind_saved(&saved);
+    game_state_fork_reset(fork, state);
+    return fork;
+}
+
+void game_state_fork_reset(game_state *fork, const serial *state) {
+    saved_bindings saved;
+    game_state_bind_saved(fork, &saved);
+
+    // Start from an empty object table, so that the objects and their handles come out the same every time.
+    // The HARs are only taken out of it, the restore below unserializes into them again.
+    object *hars[2] = {fork->players[0]->har, fork->players[1]->har};
+    int reuse_hars = hars[0] != NULL && hars[1] != NULL;
+    render_obj *robj;
+    FOREACH_OBJECT(fork, n, robj) {
+        if(reuse_hars && (robj->obj == hars[0] || robj->obj == hars[1])) {
+            robj->obj = NULL;
+            fork->dead_objects++;
+        } else {
+            game_state_remove_object(fork, robj);
+        }
+    }
+    game_state_sweep_objects(fork);
+    vector_clear(&fork->object_slots);
+    fork->free_slot = 0;
+    for(int i = 0; i < 2; i++) {
+        chr_score *score = &fork->players[i]->score;
+
+        // Combo counters are not part of the serialized state, every reset starts them over
+        score->consecutive_hits = 0;
+        score->consecutive_hit_score = 0;
+        score->combo_hits = 0;
+        score->combo_hit_score = 0;
+    }
+
+    // The state is only read, so several forks can be reset from it at the same time
+    serial ser = *state;
+    ser.rpos = 0;
+    game_state_restore(fork, &ser, reuse_hars);
+    maybe_install_har_hooks(fork->sc);
+
+    game_state_unbind_saved(&saved);
+}
+
+void game_state_fork_tick(game_state *fork, const int actions[2]) {
+    saved_bindings saved;
+    game_state_bind_saved(fork, &saved);
+    for(int i = 0; i < 2; i++) {
+        if(actions[i] != 0) {
+            object_act(fork->players[i]->har, actions[i]);
+        }
+    }
+    if(!game_state_is_paused(fork)) {
+        game_state_simulate_tick(fork);
+    }
+    fork->int_tick++;
+    game_state_unbind_saved(&saved);
+}
+
+int game_state_seek(game_state *gs, unsigned int tick) {
+    if(gs->keyframes == NULL || !is_arena(gs->this_id)) {
+        return 1;
+    }
+    game_state_bind(gs);
+
+    // Jump if going backwards, or if there is a keyframe between here and the target
+    keyframe *frame = keyframes_find(gs->keyframes, tick);
+    if(tick < gs->tick || (frame != NULL && frame->tick > gs->tick)) {
+        if(frame == NULL) {
+            return 1;
+        }
+        DEBUG("seek: restoring keyframe at tick %u", frame->tick);
+
+        // Keyframes taken after this would carry any difference between the restored and the played state
+        keyframes_stop_recording(gs->keyframes);
+
+        // The keyframe is read through a copy, so that it can be restored again later
+        serial ser;
+        serial_create_from(&ser, frame->state.data, serial_len(&frame->state));
+        game_state_restore(gs, &ser, 0);
+        arena_unserialize(gs->sc, &ser);
+        serial_free(&ser);
+        maybe_install_har_hooks(gs->sc);
+
+        for(int i = 0; i < game_state_num_players(gs); i++) {
+            controller *ctrl = game_player_get_ctrl(game_state_get_player(gs, i));
+            if(ctrl) {
+                rec_controller_seek(ctrl, gs->tick);
+            }
+        }
+    }
+
+    DEBUG("seek: fast forwarding from tick %u to %u", gs->tick, tick);
+    game_state_fast_forward(gs, tick - gs->tick);
+    return gs->tick == tick ? 0 : 1;
+}
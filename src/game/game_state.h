@@ -2,17 +2,29 @@
 #define GAME_STATE_H
 
 #include "game/game_state_type.h"
+#include "game/protos/player.h"
 #include "game/utils/serial.h"
 #include "utils/random.h"
 #include "utils/vector.h"
 #include <SDL.h>
 
+// Version of the game_state_serialize() format. Keyframe files of other versions are ignored, and
+// NET_PROTOCOL_VERSION must be bumped with it.
+#define GAME_STATE_FORMAT_VERSION 2
+
 typedef struct scene_t scene;
 typedef struct game_player_t game_player;
 typedef struct object_t object;
 
 int game_state_create(game_state *gs, engine_init_flags *init_flags);
 void game_state_free(game_state **gs);
+
+/**
+ * Makes the calling thread use the RNG, settings and output switches of this game state.
+ * Every game_state entry point does this, so several game states can run in one process,
+ * one per thread or interleaved on the same thread.
+ */
+void game_state_bind(game_state *gs);
 int game_state_handle_event(game_state *gs, SDL_Event *event);
 void game_state_render(game_state *gs);
 void game_state_debug(game_state *gs);
@@ -33,6 +45,56 @@ ticktimer *game_state_get_ticktimer(game_state *gs);
 int game_state_serialize(game_state *gs, serial *ser);
 int game_state_unserialize(game_state *gs, serial *ser, int rtt);
 
+/**
+ * Moves a recording playback to the given tick. Jumps to the closest keyframe before the tick
+ * if needed, and simulates the rest of the way.
+ *
+ * \return 0 on success, 1 if not playing a recording or there is no keyframe to start from.
+ */
+int game_state_seek(game_state *gs, unsigned int tick);
+
+/**
+ * Runs the given number of dynamic ticks immediately, without rendering. Stops early if
+ * the scene changes or the game is closing.
+ *
+ * \return Number of ticks that were run.
+ */
+unsigned int game_state_fast_forward(game_state *gs, unsigned int ticks);
+
+/**
+ * Makes a scratch copy of a running fight for trying things out, eg. for AI lookahead.
+ *
+ * The copy gets its own HARs, projectiles, scores and RNG, and makes no sounds or screen effects.
+ * The BK and AF data, the arena state and the pilots are shared read-only with the original, so the
+ * copy must be freed with game_state_free() before the original is. The fork leaves the calling
+ * thread bound to the original game state.
+ *
+ * \param gs Game state to copy
+ * \param state State of gs from game_state_serialize(), the fork starts from it
+ * \return The copy, or NULL if gs is not in a fight.
+ */
+game_state *game_state_fork(game_state *gs, const serial *state);
+
+/**
+ * Puts a fork back to a serialized state of its original, eg. to try something else from the same
+ * starting point. The fork ends up the same as a new one made from the state. The state is not
+ * modified, so it can be shared by forks running on several threads. The HAR objects of the fork and
+ * their data are reused, so a fork can be reset over and over without allocating them again.
+ *
+ * \param fork Game state made by game_state_fork()
+ * \param state State of the original from game_state_serialize()
+ */
+void game_state_fork_reset(game_state *fork, const serial *state);
+
+/**
+ * Runs one dynamic tick of a fork: gives the HARs their input, then moves, collides and ticks the objects.
+ * The scene and the controllers are not ticked.
+ *
+ * \param fork Game state made by game_state_fork()
+ * \param actions ACT_* input for each player, 0 for no input
+ */
+void game_state_fork_tick(game_state *fork, const int actions[2]);
+
 void _setup_keyboard(game_state *gs, int player_id);
 void _setup_ai(game_state *gs, int player_id);
 int _setup_joystick(game_state *gs, int player_id, const char *joyname, int offset);
@@ -49,6 +111,7 @@ unsigned int game_state_get_speed(game_state *gs);
 int game_state_add_object(game_state *gs, object *obj, int layer, int singleton, int persistent);
 void game_state_del_object(game_state *gs, object *obj);
 void game_state_del_animation(game_state *gs, int anim_id);
+object *game_state_find_object(game_state *gs, object_handle handle);
 void game_state_get_projectiles(game_state *gs, vector *obj_proj);
 void game_state_clear_hazards_projectiles(game_state *gs);
 
@@ -2,6 +2,9 @@
 #define GAME_STATE_TYPE_H
 
 #include "engine.h"
+#include "game/utils/kinematics.h"
+#include "game/utils/settings.h"
+#include "utils/random.h"
 #include "utils/vector.h"
 
 enum
@@ -27,6 +30,7 @@ enum
 typedef struct scene_t scene;
 typedef struct game_player_t game_player;
 typedef struct ticktimer_t ticktimer;
+typedef struct keyframes_t keyframes;
 
 typedef struct game_state_t {
     unsigned int run;
@@ -55,10 +59,18 @@ typedef struct game_state_t {
     // For debugging, sets fastest possible mode :)
     int warp_speed;
 
-    int next_requires_refresh; // If next frame requires a texture refresh, this should be set to 1
     int net_mode;              // NET_MODE_NONE, NET_MODE_CLIENT, NET_MODE_SERVER
     scene *sc;
-    vector objects;
+    vector objects;            // Live objects in insertion order; removed ones are NULL until swept
+    unsigned int dead_objects; // Number of removed objects waiting for the sweep
+    vector object_slots;       // Handle table, see game_state_find_object()
+    unsigned int free_slot;    // First free handle slot + 1, or 0 if none
+    kinematics particles;      // Scratch store for the batched particle move pass
+    keyframes *keyframes;      // Replay snapshots for seeking, NULL if not playing a recording on screen
+    struct random_t rand;      // RNG of this simulation, used by rand_*() while bound
+    settings *settings;        // Settings of this simulation, NULL to use the global settings
+    int headless;              // 1 if sound and screen effects are disabled
+    int is_fork;               // 1 if made by game_state_fork(), the scene and pilots belong to the original
     game_player *players[2];
 } game_state;
 
@@ -20,6 +20,7 @@
 #include "resources/animation.h"
 #include "resources/pilots.h"
 #include "utils/allocator.h"
+#include "utils/flatmap.h"
 #include "utils/log.h"
 #include "utils/miscmath.h"
 #include "utils/random.h"
@@ -31,10 +32,12 @@
 void har_finished(object *obj);
 int har_act(object *obj, int act_type);
 void har_spawn_scrap(object *obj, vec2i pos, int amount);
+static void har_recreate(object *obj, af *af_data, int dir, int har_id, int pilot_id, int player_id);
 
 void har_free(object *obj) {
     har *h = object_get_userdata(obj);
     list_free(&h->har_hooks);
+    flatmap_free(&h->pal_cache);
 #ifdef DEBUGMODE
     surface_free(&h->cd_debug);
 #endif
@@ -931,10 +934,9 @@ void har_debug(object *obj) {
     if(obj->cur_sprite == NULL) {
         return;
     }
-    // Make sure there are hitpoints to check.
-    if(vector_size(&obj->cur_animation->collision_coords) == 0) {
-        return;
-    }
+    // Hitpoints of the current frame
+    int coord_count;
+    collision_coord *coords = animation_get_frame_coords(obj->cur_animation, obj->cur_sprite->id, &coord_count);
 
     // Some useful variables
     vec2i pos_a = object_get_pos(obj); //, obj->cur_sprite->pos);
@@ -947,28 +949,15 @@ void har_debug(object *obj) {
         flip = -1;
     }
 
-    // Iterate through hitpoints
-    iterator it;
-    collision_coord *cc;
-    vector_iter_begin(&obj->cur_animation->collision_coords, &it);
-
-    int found = 0;
-    while((cc = iter_next(&it)) != NULL) {
-        if(cc->frame_index != obj->cur_sprite->id)
-            continue;
-        found = 1;
-    }
-
     image_clear(&img, blank);
 
-    if(!found) {
+    if(coords == NULL) {
         return;
     }
 
-    vector_iter_begin(&obj->cur_animation->collision_coords, &it);
-    while((cc = iter_next(&it)) != NULL) {
-        if(cc->frame_index != obj->cur_sprite->id)
-            continue;
+    // Iterate through hitpoints
+    for(int i = 0; i < coord_count; i++) {
+        collision_coord *cc = &coords[i];
         image_set_pixel(&img, pos_a.x + (cc->pos.x * flip), pos_a.y + cc->pos.y, c);
         // DEBUG("%d drawing hit point at %d %d ->%d %d", obj->cur_sprite->id, pos_a.x, pos_a.y, pos_a.x + (cc->pos.x *
         // flip), pos_a.y + cc->pos.y);
@@ -1250,6 +1239,26 @@ void har_collide(object *obj_a, object *obj_b) {
     har_collide_with_har(obj_b, obj_a, 0);
 }
 
+// Flashes are short and repeat with the same parameters, so the transformed colors are kept around.
+// The colors the transform started from are part of the value, as other palette transforms may run first.
+typedef struct har_pal_cache_key_t {
+    int ticks_left;
+    unsigned int ticks_length;
+    uint8_t pal_ref;
+    uint8_t color_ref;
+    uint8_t color_fn;
+    uint8_t pal_start;
+    uint8_t pal_length;
+} har_pal_cache_key;
+
+typedef struct har_pal_cache_value_t {
+    uint8_t ref[3];
+    uint8_t input[48][3];
+    uint8_t output[48][3];
+} har_pal_cache_value;
+
+#define HAR_PAL_CACHE_MAX_ENTRIES 256
+
 int har_palette_transform(object *obj, screen_palette *pal) {
     har *h = object_get_userdata(obj);
 
@@ -1264,31 +1273,44 @@ int har_palette_transform(object *obj, screen_palette *pal) {
     int pal_start = 48 * (h->player_id ^ h->p_har_switch);
     int pal_length = 47 + h->player_id;
 
-    // Handle palette transformation
-    int r, g, b, m, c;
-    int _r = pal->data[h->p_pal_ref][0];
-    int _g = pal->data[h->p_pal_ref][1];
-    int _b = pal->data[h->p_pal_ref][2];
-    c = (h->p_color_ref * 4) * ((float)h->p_ticks_left / (float)h->p_ticks_length);
-    for(int i = pal_start; i < pal_start + pal_length; i++) {
-        if(h->p_color_fn) {
-            m = max3(pal->data[i][0], pal->data[i][1], pal->data[i][2]);
-            r = (m * (c * (_r * pal->data[i][0]) / 255.0f) / 255.0f) * pal->data[i][0];
-            g = (m * (c * (_g * pal->data[i][1]) / 255.0f) / 255.0f) * pal->data[i][1];
-            b = (m * (c * (_b * pal->data[i][2]) / 255.0f) / 255.0f) * pal->data[i][2];
-        } else {
-            r = (c * _r) / 255.0f + (255 - c) * (pal->data[i][0] / 255.0f);
-            g = (c * _g) / 255.0f + (255 - c) * (pal->data[i][1] / 255.0f);
-            b = (c * _b) / 255.0f + (255 - c) * (pal->data[i][2] / 255.0f);
-        }
+    har_pal_cache_key key;
+    memset(&key, 0, sizeof(har_pal_cache_key));
+    key.ticks_left = h->p_ticks_left;
+    key.ticks_length = h->p_ticks_length;
+    key.pal_ref = h->p_pal_ref;
+    key.color_ref = h->p_color_ref;
+    key.color_fn = h->p_color_fn;
+    key.pal_start = pal_start;
+    key.pal_length = pal_length;
+    const uint8_t *ref = pal->data[h->p_pal_ref];
+    h->p_ticks_left--;
 
-        pal->data[i][0] = min2(max2(r, 0), 255);
-        pal->data[i][1] = min2(max2(g, 0), 255);
-        pal->data[i][2] = min2(max2(b, 0), 255);
+    har_pal_cache_value *val = NULL;
+    unsigned int tmp_size;
+    flatmap_get(&h->pal_cache, &key, sizeof(har_pal_cache_key), (void **)&val, &tmp_size);
+    if(val != NULL && memcmp(val->ref, ref, 3) == 0 && memcmp(val->input, pal->data[pal_start], pal_length * 3) == 0) {
+        return screen_palette_set_range(pal, pal_start, pal_length, val->output);
     }
 
-    h->p_ticks_left--;
-    return 1;
+    har_pal_cache_value entry;
+    memcpy(entry.ref, ref, 3);
+    memcpy(entry.input, pal->data[pal_start], pal_length * 3);
+
+    // Handle palette transformation
+    int changed;
+    int c = (h->p_color_ref * 4) * key.ticks_left / (int)h->p_ticks_length;
+    if(h->p_color_fn) {
+        changed = screen_palette_light(pal, pal_start, pal_length, entry.ref, c);
+    } else {
+        changed = screen_palette_blend(pal, pal_start, pal_length, entry.ref, c * 256);
+    }
+
+    memcpy(entry.output, pal->data[pal_start], pal_length * 3);
+    if(flatmap_size(&h->pal_cache) >= HAR_PAL_CACHE_MAX_ENTRIES) {
+        flatmap_clear(&h->pal_cache);
+    }
+    flatmap_put(&h->pal_cache, &key, sizeof(har_pal_cache_key), &entry, sizeof(har_pal_cache_value));
+    return changed;
 }
 
 void har_tick(object *obj) {
@@ -1524,98 +1546,80 @@ void add_input(char *buf, int act_type, int direction) {
 af_move *match_move(object *obj, char *inputs) {
     har *h = object_get_userdata(obj);
     af_move *move = NULL;
-    size_t len;
-    for(int i = 0; i < 70; i++) {
-        if((move = af_get_move(h->af_data, i))) {
-            len = move->move_string.len;
-            if(!strncmp(str_c(&move->move_string), inputs, len)) {
-                if(move->category == CAT_CLOSE && h->close != 1) {
-                    // not standing close enough
-                    continue;
-                }
-                if(move->category == CAT_JUMPING && h->state != STATE_JUMPING) {
-                    // not jumping
-                    continue;
-                }
-                if(move->category != CAT_JUMPING && h->state == STATE_JUMPING) {
-                    // jumping but this move is not a jumping move
-                    continue;
-                }
-                if(move->category == CAT_SCRAP && h->state != STATE_VICTORY) {
-                    continue;
-                }
-
-                if(move->category == CAT_DESTRUCTION && h->state != STATE_SCRAP) {
-                    continue;
-                }
+    int count;
+    // Only moves whose string is a prefix of the inputs and which are allowed in the air (or on the ground)
+    const uint8_t *candidates = af_matcher_find(&h->af_data->matcher, inputs, h->state == STATE_JUMPING, &count);
+    for(int c = 0; c < count; c++) {
+        int i = candidates[c];
+        move = af_get_move(h->af_data, i);
+        if(move->category == CAT_CLOSE && h->close != 1) {
+            // not standing close enough
+            continue;
+        }
+        if(move->category == CAT_SCRAP && h->state != STATE_VICTORY) {
+            continue;
+        }
 
-                if(move->category == CAT_FIRE_ICE) {
-                    continue;
-                }
+        if(move->category == CAT_DESTRUCTION && h->state != STATE_SCRAP) {
+            continue;
+        }
 
-                if(h->state != STATE_JUMPING && move->pos_constraints & 0x2) {
-                    DEBUG("Position contraint prevents move when not jumping!");
-                    // required to be jumping
-                    continue;
-                }
-                if(h->is_wallhugging != 1 && move->pos_constraints & 0x1) {
-                    DEBUG("Position contraint prevents move when not wallhugging!");
-                    // required to be wall hugging
-                    continue;
-                }
+        if(h->is_wallhugging != 1 && move->pos_constraints & 0x1) {
+            DEBUG("Position contraint prevents move when not wallhugging!");
+            // required to be wall hugging
+            continue;
+        }
 
-                if(h->executing_move && !h->enqueued) {
-                    // check if the current frame allows chaining
-                    int allowed = 0;
-                    if(player_frame_isset(obj, "jn") && i == player_frame_get(obj, "jn")) {
-                        allowed = 1;
-                    } else {
-                        switch(move->category) {
-                            case CAT_LOW:
-                                if(player_frame_isset(obj, "jl")) {
-                                    allowed = 1;
-                                }
-                                break;
-                            case CAT_MEDIUM:
-                                if(player_frame_isset(obj, "jm")) {
-                                    allowed = 1;
-                                }
-                                break;
-                            case CAT_HIGH:
-                                if(player_frame_isset(obj, "jh")) {
-                                    allowed = 1;
-                                }
-                                break;
-                            case CAT_SCRAP:
-                                if(player_frame_isset(obj, "jf")) {
-                                    allowed = 1;
-                                }
-                                break;
-                            case CAT_DESTRUCTION:
-                                if(player_frame_isset(obj, "jf2")) {
-                                    allowed = 1;
-                                }
-                                break;
+        if(h->executing_move && !h->enqueued) {
+            // check if the current frame allows chaining
+            int allowed = 0;
+            if(player_frame_isset(obj, "jn") && i == player_frame_get(obj, "jn")) {
+                allowed = 1;
+            } else {
+                switch(move->category) {
+                    case CAT_LOW:
+                        if(player_frame_isset(obj, "jl")) {
+                            allowed = 1;
                         }
-                    }
-                    if(player_get_current_tick(obj) >= player_get_len_ticks(obj)) {
-                        DEBUG("enqueueing %d %s", i, str_c(&move->move_string));
-                        h->enqueued = i;
-                        return NULL;
-                    }
-
-                    if(!allowed) {
-                        // not allowed
-                        continue;
-                    }
-                    DEBUG("CHAINING");
+                        break;
+                    case CAT_MEDIUM:
+                        if(player_frame_isset(obj, "jm")) {
+                            allowed = 1;
+                        }
+                        break;
+                    case CAT_HIGH:
+                        if(player_frame_isset(obj, "jh")) {
+                            allowed = 1;
+                        }
+                        break;
+                    case CAT_SCRAP:
+                        if(player_frame_isset(obj, "jf")) {
+                            allowed = 1;
+                        }
+                        break;
+                    case CAT_DESTRUCTION:
+                        if(player_frame_isset(obj, "jf2")) {
+                            allowed = 1;
+                        }
+                        break;
                 }
+            }
+            if(player_get_current_tick(obj) >= player_get_len_ticks(obj)) {
+                DEBUG("enqueueing %d %s", i, str_c(&move->move_string));
+                h->enqueued = i;
+                return NULL;
+            }
 
-                DEBUG("matched move %d with string %s", i, str_c(&move->move_string));
-                /*DEBUG("input was %s", h->inputs);*/
-                return move;
+            if(!allowed) {
+                // not allowed
+                continue;
             }
+            DEBUG("CHAINING");
         }
+
+        DEBUG("matched move %d with string %s", i, str_c(&move->move_string));
+        /*DEBUG("input was %s", h->inputs);*/
+        return move;
     }
     return NULL;
 }
@@ -2081,7 +2085,11 @@ int har_unserialize(object *obj, serial *ser, int animation_id, game_state *gs)
         return 1;
     }
 
-    har_create(obj, af_data, obj->direction, har_id, pilot_id, player_id);
+    if(obj->free == har_free) {
+        har_recreate(obj, af_data, obj->direction, har_id, pilot_id, player_id);
+    } else {
+        har_create(obj, af_data, obj->direction, har_id, pilot_id, player_id);
+    }
 
     har *h = object_get_userdata(obj);
     // we are unserializing a state update for a HAR, we expect it to have the AF data already loaded into RAM, we're
@@ -2140,9 +2148,87 @@ void har_copy_actions(object *new, object *old) {
     memcpy(h_new->act_buf, h_old->act_buf, sizeof(action_buffer) * OBJECT_EVENT_BUFFER_SIZE);
 }
 
-int har_create(object *obj, af *af_data, int dir, int har_id, int pilot_id, int player_id) {
-    // Create local data
-    har *local = omf_calloc(1, sizeof(har));
+// Scales the move damage and stun, and picks the move speed strings, by the pilot stats.
+// This modifies the AF data, so it must be done exactly once after loading it.
+void har_apply_pilot_stats(af *af_data, const sd_pilot *pilot) {
+    bool is_tournament = false;
+    float leg_power = 0.0f;
+    float arm_power = 0.0f;
+    // cheap way to check if we're in tournament mode
+    if(pilot->photo != NULL) {
+        is_tournament = true;
+        // (Limb Power + 3) * .192
+        leg_power = (pilot->leg_power + 3) * 0.192f;
+        arm_power = (pilot->arm_power + 3) * 0.192f;
+    }
+
+    af_move *move;
+    // apply pilot stats and HAR upgrades/enhancements to the HAR
+    for(int i = 0; i < MAX_AF_MOVES; i++) {
+        move = af_get_move(af_data, i);
+        if(move != NULL) {
+            if(!is_tournament) {
+                // Single Player
+                // Damage = Base Damage * (20 + Power) / 30 + 1
+                //  Stun = (Base Damage + 6) * 512
+                move->stun = (move->damage + 6) * 512;
+                move->damage = move->damage * (20 + pilot->power) / 30 + 1;
+            } else {
+                // Tournament Mode
+                // Damage = (Base Damage * (25 + Power) / 35 + 1) * leg/arm power / armor
+                // Stun = ((Base Damage * (35 + Power) / 45) * 2 + 12) * 256
+                move->stun = ((move->damage * (35 + pilot->power) / 45) * 2 + 12) * 256;
+                switch(move->extra_string_selector) {
+                    case 0:
+                        break;
+                    case 1:
+                        // arm speed and power
+                        move->damage = (move->damage * (25 + pilot->power) / 35 + 1) * arm_power;
+                        if(move->ani.extra_string_count > 0) {
+                            str_free(&move->ani.animation_string);
+                            // sometimes there's not enough extra strings, so take the last available
+                            str_from(&move->ani.animation_string,
+                                     vector_get(&move->ani.extra_strings,
+                                                min2(pilot->arm_speed, move->ani.extra_string_count - 1)));
+                        }
+                        break;
+                    case 2:
+                        // leg speed and power
+                        move->damage = (move->damage * (25 + pilot->power) / 35 + 1) * leg_power;
+                        if(move->ani.extra_string_count > 0) {
+                            str_free(&move->ani.animation_string);
+                            // sometimes there's not enough extra strings, so take the last available
+                            str_from(&move->ani.animation_string,
+                                     vector_get(&move->ani.extra_strings,
+                                                min2(pilot->leg_speed, move->ani.extra_string_count - 1)));
+                        }
+                        break;
+                    case 3:
+                        // check if you have the enhancement(s) (and apply arm power for damage)
+                        move->damage = (move->damage * (25 + pilot->power) / 35 + 1) * arm_power;
+                        // TODO if you have 1 enhancement choose extra string 2
+                        // if you have 2 enhancements choose extra string 3
+                        break;
+                    case 4:
+                        // check if you have the enhancement(s) (and apply leg power for damage)
+                        move->damage = (move->damage * (25 + pilot->power) / 35 + 1) * leg_power;
+                        // TODO if you have 1 enhancement choose extra string 2
+                        // if you have 2 enhancements choose extra string 3
+                        break;
+                    case 5:
+                        // check if you have the enhancement(s) (and apply leg and arm power for damage)
+                        move->damage = (move->damage * (25 + pilot->power) / 35 + 1) * leg_power * leg_power;
+                        // TODO if you have 1 enhancement choose extra string 2
+                        // if you have 2 enhancements choose extra string 3
+                        break;
+                }
+            }
+        }
+    }
+}
+
+// Sets up the HAR data for a fresh HAR. The hook list and the palette cache must exist already.
+static void har_setup(object *obj, har *local, af *af_data, int dir, int har_id, int pilot_id, int player_id) {
     object_set_userdata(obj, local);
     har_bootstrap(obj);
 
@@ -2216,8 +2302,6 @@ int har_create(object *obj, af *af_data, int dir, int har_id, int pilot_id, int
     /*local->hook_cb = NULL;*/
     /*local->hook_cb_data = NULL;*/
 
-    list_create(&local->har_hooks);
-
     local->stun_timer = 0;
 
     // Set palette offset 0 for player1, 48 for player2
@@ -2254,96 +2338,50 @@ int har_create(object *obj, af *af_data, int dir, int har_id, int pilot_id, int
 
 #ifdef DEBUGMODE
     object_set_debug_cb(obj, har_debug);
-    surface_create(&local->cd_debug, SURFACE_TYPE_RGBA, 320, 200);
-    surface_clear(&local->cd_debug);
 #endif
 
     for(int i = 0; i < OBJECT_EVENT_BUFFER_SIZE; i++) {
         local->act_buf[i].count = 0;
         local->act_buf[i].age = 0;
     }
+}
 
-    // fixup a bunch of stuff based on player stats
-
-    bool is_tournament = false;
-    float leg_power = 0.0f;
-    float arm_power = 0.0f;
-    // cheap way to check if we're in tournament mode
-    if(pilot->photo != NULL) {
-        is_tournament = true;
-        // (Limb Power + 3) * .192
-        leg_power = (pilot->leg_power + 3) * 0.192f;
-        arm_power = (pilot->arm_power + 3) * 0.192f;
-    }
-
-    af_move *move;
-    // apply pilot stats and HAR upgrades/enhancements to the HAR
-    for(int i = 0; i < MAX_AF_MOVES; i++) {
-        move = af_get_move(af_data, i);
-        if(move != NULL) {
-            if(!is_tournament) {
-                // Single Player
-                // Damage = Base Damage * (20 + Power) / 30 + 1
-                //  Stun = (Base Damage + 6) * 512
-                move->stun = (move->damage + 6) * 512;
-                move->damage = move->damage * (20 + pilot->power) / 30 + 1;
-            } else {
-                // Tournament Mode
-                // Damage = (Base Damage * (25 + Power) / 35 + 1) * leg/arm power / armor
-                // Stun = ((Base Damage * (35 + Power) / 45) * 2 + 12) * 256
-                move->stun = ((move->damage * (35 + pilot->power) / 45) * 2 + 12) * 256;
-                switch(move->extra_string_selector) {
-                    case 0:
-                        break;
-                    case 1:
-                        // arm speed and power
-                        move->damage = (move->damage * (25 + pilot->power) / 35 + 1) * arm_power;
-                        if(move->ani.extra_string_count > 0) {
-                            str_free(&move->ani.animation_string);
-                            // sometimes there's not enough extra strings, so take the last available
-                            str_from(&move->ani.animation_string,
-                                     vector_get(&move->ani.extra_strings,
-                                                min2(pilot->arm_speed, move->ani.extra_string_count - 1)));
-                        }
-                        break;
-                    case 2:
-                        // leg speed and power
-                        move->damage = (move->damage * (25 + pilot->power) / 35 + 1) * leg_power;
-                        if(move->ani.extra_string_count > 0) {
-                            str_free(&move->ani.animation_string);
-                            // sometimes there's not enough extra strings, so take the last available
-                            str_from(&move->ani.animation_string,
-                                     vector_get(&move->ani.extra_strings,
-                                                min2(pilot->leg_speed, move->ani.extra_string_count - 1)));
-                        }
-                        break;
-                    case 3:
-                        // check if you have the enhancement(s) (and apply arm power for damage)
-                        move->damage = (move->damage * (25 + pilot->power) / 35 + 1) * arm_power;
-                        // TODO if you have 1 enhancement choose extra string 2
-                        // if you have 2 enhancements choose extra string 3
-                        break;
-                    case 4:
-                        // check if you have the enhancement(s) (and apply leg power for damage)
-                        move->damage = (move->damage * (25 + pilot->power) / 35 + 1) * leg_power;
-                        // TODO if you have 1 enhancement choose extra string 2
-                        // if you have 2 enhancements choose extra string 3
-                        break;
-                    case 5:
-                        // check if you have the enhancement(s) (and apply leg and arm power for damage)
-                        move->damage = (move->damage * (25 + pilot->power) / 35 + 1) * leg_power * leg_power;
-                        // TODO if you have 1 enhancement choose extra string 2
-                        // if you have 2 enhancements choose extra string 3
-                        break;
-                }
-            }
-        }
-    }
+int har_create(object *obj, af *af_data, int dir, int har_id, int pilot_id, int player_id) {
+    // Create local data
+    har *local = omf_calloc(1, sizeof(har));
+    list_create(&local->har_hooks);
+    flatmap_create(&local->pal_cache, 4, sizeof(har_pal_cache_key), sizeof(har_pal_cache_value));
+#ifdef DEBUGMODE
+    surface_create(&local->cd_debug, SURFACE_TYPE_RGBA, 320, 200);
+    surface_clear(&local->cd_debug);
+#endif
+    har_setup(obj, local, af_data, dir, har_id, pilot_id, player_id);
 
     // All done
     return 0;
 }
 
+// Sets up the HAR data that an object kept through object_reset() as if it was new, keeping its memory
+static void har_recreate(object *obj, af *af_data, int dir, int har_id, int pilot_id, int player_id) {
+    har *local = object_get_userdata(obj);
+    list hooks = local->har_hooks;
+    flatmap pal_cache = local->pal_cache;
+#ifdef DEBUGMODE
+    surface cd_debug = local->cd_debug;
+#endif
+
+    // Hooks are installed again by whoever restores the HAR. The cached palettes stay valid.
+    list_free(&hooks);
+    list_create(&hooks);
+    memset(local, 0, sizeof(har));
+    local->har_hooks = hooks;
+    local->pal_cache = pal_cache;
+#ifdef DEBUGMODE
+    local->cd_debug = cd_debug;
+#endif
+    har_setup(obj, local, af_data, dir, har_id, pilot_id, player_id);
+}
+
 void har_reset(object *obj) {
     har *h = object_get_userdata(obj);
     object_set_gravity(obj, h->fall_speed);
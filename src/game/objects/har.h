@@ -1,11 +1,13 @@
 #ifndef HAR_H
 #define HAR_H
 
+#include "formats/pilot.h"
 #include "game/objects/arena_constraints.h"
 #include "game/protos/object.h"
 #include "resources/af.h"
 #include "resources/animation.h"
 #include "resources/bk.h"
+#include "utils/flatmap.h"
 #include "utils/list.h"
 
 // For debug texture stuff
@@ -23,22 +25,6 @@
 
 #define GROUP_PROJECTILE 2
 
-enum
-{
-    CAT_MISC = 0,
-    CAT_CLOSE = 2,
-    CAT_LOW = 4,
-    CAT_MEDIUM = 5,
-    CAT_HIGH,
-    CAT_JUMPING,
-    CAT_PROJECTILE,
-    CAT_BASIC,
-    CAT_VICTORY, // or defeat
-    CAT_FIRE_ICE,
-    CAT_SCRAP,
-    CAT_DESTRUCTION
-};
-
 enum
 {
     STATE_STANDING = 1,
@@ -162,6 +148,7 @@ typedef struct har_t {
     int p_ticks_left;
     unsigned int p_ticks_length;
     uint8_t p_color_fn;
+    flatmap pal_cache; // Palettes of earlier flashes
 
     list har_hooks;
 
@@ -178,6 +165,7 @@ typedef struct har_t {
 void har_install_action_hook(har *h, har_action_hook_cb hook, void *data);
 void har_install_hook(har *h, har_hook_cb hook, void *data);
 void har_bootstrap(object *obj);
+void har_apply_pilot_stats(af *af_data, const sd_pilot *pilot);
 int har_create(object *obj, af *af_data, int dir, int har_id, int pilot_id, int player_id);
 void har_set_ani(object *obj, int animation_id, int repeat);
 int har_is_active(object *obj);
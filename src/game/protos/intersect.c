@@ -62,7 +62,9 @@ int intersect_sprite_hitpoint(object *obj, object *target, int level, vec2i *poi
         return 0;
     }
     // Make sure there are hitpoints to check.
-    if(vector_size(&obj->cur_animation->collision_coords) == 0) {
+    int coord_count;
+    collision_coord *coords = animation_get_frame_coords(obj->cur_animation, obj->cur_sprite->id, &coord_count);
+    if(coords == NULL) {
         return 0;
     }
 
@@ -75,14 +77,13 @@ int intersect_sprite_hitpoint(object *obj, object *target, int level, vec2i *poi
     vec2i size_a = object_get_size(obj);
     vec2i size_b = object_get_size(target);
 
-    if((object_get_direction(obj) == OBJECT_FACE_LEFT && !player_frame_isset(obj, "r")) ||
-       (object_get_direction(obj) == OBJECT_FACE_RIGHT && player_frame_isset(obj, "r"))) {
+    // The r tag flips the sprite
+    if((object_get_direction(obj) == OBJECT_FACE_LEFT) != (player_frame_isset(obj, "r") != 0)) {
         object_dir = OBJECT_FACE_LEFT;
         pos_a.x = object_get_pos(obj).x + ((obj->cur_sprite->pos.x * -1) - size_a.x);
     }
 
-    if((object_get_direction(target) == OBJECT_FACE_LEFT && !player_frame_isset(target, "r")) ||
-       (object_get_direction(target) == OBJECT_FACE_RIGHT && player_frame_isset(target, "r"))) {
+    if((object_get_direction(target) == OBJECT_FACE_LEFT) != (player_frame_isset(target, "r") != 0)) {
         target_dir = OBJECT_FACE_LEFT;
         pos_b.x = object_get_pos(target).x + ((target->cur_sprite->pos.x * -1) - size_b.x);
     }
@@ -90,13 +91,8 @@ int intersect_sprite_hitpoint(object *obj, object *target, int level, vec2i *poi
     // Iterate through hitpoints
     vec2i hcoords[level];
     int found = 0;
-    iterator it;
-    collision_coord *cc;
-    vector_iter_begin(&obj->cur_animation->collision_coords, &it);
-    while((cc = iter_next(&it)) != NULL) {
-        // Skip coords that don't belong to the frame we are checking
-        if(cc->frame_index != obj->cur_sprite->id)
-            continue;
+    for(int i = 0; i < coord_count; i++) {
+        const collision_coord *cc = &coords[i];
 
         // Convert coords to target sprite local space
         int t = (object_dir == OBJECT_FACE_RIGHT) ? (pos_a.x + cc->pos.x - obj->cur_sprite->pos.x)
@@ -116,12 +112,7 @@ int intersect_sprite_hitpoint(object *obj, object *target, int level, vec2i *poi
             continue;
 
         // Get hitpixel
-        surface *sfc = target->cur_sprite->data;
-        int hitpoint = (ycoord * sfc->w) + xcoord;
-        if(target_dir == OBJECT_FACE_LEFT) {
-            hitpoint = (ycoord * sfc->w) + (sfc->w - xcoord);
-        }
-        if(sfc->stencil[hitpoint] > 0) {
+        if(sprite_is_solid(target->cur_sprite, xcoord, ycoord, target_dir == OBJECT_FACE_LEFT)) {
             hcoords[found++] = vec2i_create(xcoord, ycoord);
             if(found >= level) {
                 vec2f sum = vec2f_create(0, 0);
@@ -1,8 +1,9 @@
 #include "game/protos/object.h"
 #include "formats/sprite.h"
-#include "game/game_state_type.h"
+#include "game/game_state.h"
 #include "game/objects/arena_constraints.h"
 #include "game/protos/object_specializer.h"
+#include "game/utils/settings.h"
 #include "utils/allocator.h"
 #include "utils/compat.h"
 #include "utils/log.h"
@@ -22,6 +23,7 @@
 void object_create(object *obj, game_state *gs, vec2i pos, vec2f vel) {
     // State
     obj->gs = gs;
+    obj->handle = OBJECT_HANDLE_NONE;
 
     // Position related
     obj->pos = vec2i_to_f(pos);
@@ -42,7 +44,7 @@ void object_create(object *obj, game_state *gs, vec2i pos, vec2f vel) {
     obj->video_effects = 0;
 
     // Attachment stuff
-    obj->attached_to = NULL;
+    obj->attached_to = OBJECT_HANDLE_NONE;
 
     // Fire orb wandering
     obj->orbit = 0;
@@ -64,6 +66,7 @@ void object_create(object *obj, game_state *gs, vec2i pos, vec2f vel) {
     obj->halt_ticks = 0;
     obj->stride = 1;
     obj->cast_shadow = 0;
+    obj->particle = 0;
     obj->age = 0;
     player_create(obj);
 
@@ -187,6 +190,7 @@ int object_unserialize(object *obj, serial *ser, game_state *gs) {
     obj->halt = 0;
     obj->halt_ticks = 0;
     obj->cast_shadow = 0;
+    obj->particle = 0;
     player_create(obj);
 
     // Read animation state
@@ -267,9 +271,10 @@ void object_set_playback_direction(object *obj, int dir) {
 void object_dynamic_tick(object *obj) {
     obj->age++;
 
-    if(obj->attached_to != NULL) {
-        object_set_pos(obj, object_get_pos(obj->attached_to));
-        object_set_direction(obj, object_get_direction(obj->attached_to));
+    const object *attached_to = game_state_find_object(obj->gs, obj->attached_to);
+    if(attached_to != NULL) {
+        object_set_pos(obj, object_get_pos(attached_to));
+        object_set_direction(obj, object_get_direction(attached_to));
     }
 
     // Check if object still needs to be halted
@@ -347,44 +352,50 @@ void object_del_effects(object *obj, int effects) {
     obj->video_effects &= ~effects;
 }
 
-void object_render(object *obj) {
-    // Stop here if cur_sprite is NULL
-    if(obj->cur_sprite == NULL)
-        return;
-
-    // Set current surface
-    obj->cur_surface = obj->cur_sprite->data;
-
-    // Something to ease the pain ...
-    player_sprite_state *rstate = &obj->sprite_state;
-
-    // Position
-    int x;
-    int y;
+void object_get_render_pos(const object *obj, int *x, int *y, int *flipmode) {
+    const player_sprite_state *rstate = &obj->sprite_state;
 
     // Set Y coord, take into account sprite flipping
     if(rstate->flipmode & FLIP_VERTICAL) {
-        y = obj->pos.y - obj->cur_sprite->pos.y + rstate->o_correction.y - object_get_size(obj).y;
+        *y = obj->pos.y - obj->cur_sprite->pos.y + rstate->o_correction.y - object_get_size(obj).y;
 
         if(obj->cur_animation->id == ANIM_JUMPING) {
-            y -= 100;
+            *y -= 100;
         }
     } else {
-        y = obj->pos.y + obj->cur_sprite->pos.y + rstate->o_correction.y;
+        *y = obj->pos.y + obj->cur_sprite->pos.y + rstate->o_correction.y;
     }
 
     // Set X coord, take into account the HAR facing.
     if(object_get_direction(obj) == OBJECT_FACE_LEFT) {
-        x = obj->pos.x - obj->cur_sprite->pos.x + rstate->o_correction.x - object_get_size(obj).x;
+        *x = obj->pos.x - obj->cur_sprite->pos.x + rstate->o_correction.x - object_get_size(obj).x;
     } else {
-        x = obj->pos.x + obj->cur_sprite->pos.x + rstate->o_correction.x;
+        *x = obj->pos.x + obj->cur_sprite->pos.x + rstate->o_correction.x;
     }
 
     // Flip to face the right direction
-    int flipmode = rstate->flipmode;
+    *flipmode = rstate->flipmode;
     if(object_get_direction(obj) == OBJECT_FACE_LEFT) {
-        flipmode ^= FLIP_HORIZONTAL;
+        *flipmode ^= FLIP_HORIZONTAL;
     }
+}
+
+void object_render(object *obj) {
+    // Stop here if cur_sprite is NULL
+    if(obj->cur_sprite == NULL)
+        return;
+
+    // Set current surface
+    obj->cur_surface = obj->cur_sprite->data;
+
+    // Something to ease the pain ...
+    player_sprite_state *rstate = &obj->sprite_state;
+
+    // Position
+    int x;
+    int y;
+    int flipmode;
+    object_get_render_pos(obj, &x, &y, &flipmode);
 
     // Blend start / blend finish
     uint8_t opacity = rstate->blend_finish;
@@ -428,6 +439,10 @@ void object_render_shadow(object *obj) {
     if(obj->cur_sprite == NULL || !obj->cast_shadow) {
         return;
     }
+    int mode = settings_get()->video.shadows;
+    if(mode == SHADOWS_OFF) {
+        return;
+    }
 
     // Scale of the sprite on Y axis should be less than the
     // height of the sprite because of light position
@@ -445,12 +460,9 @@ void object_render_shadow(object *obj) {
     float temp = object_h(obj) * scale_y;
     int y = 190 - temp - (object_h(obj) - temp) / 2;
 
-    // Render shadow object twice with different offsets, so that
-    // the shadows seem a bit blobbier and shadow-y
-    for(int i = 0; i < 2; i++) {
-        video_render_sprite_flip_scale_opacity_tint(obj->cur_sprite->data, x + i, y + i, BLEND_ALPHA, obj->pal_offset,
-                                                    flipmode, 1.0, scale_y, 65, color_create(0, 0, 0, 255));
-    }
+    // The cached shadow is the sprite drawn twice with different offsets,
+    // so that the shadows seem a bit blobbier and shadow-y
+    video_render_shadow(obj->cur_sprite->data, x, y, flipmode, scale_y, mode == SHADOWS_FADE);
 }
 
 int object_act(object *obj, int action) {
@@ -475,31 +487,16 @@ void object_move(object *obj) {
 int object_scenewide_palette_transform(object *obj, screen_palette *pal) {
     player_sprite_state *rstate = &obj->sprite_state;
     if(rstate->pal_entry_count > 0 && rstate->duration > 0) {
-        float bp = ((float)rstate->pal_begin) + ((float)rstate->pal_end - (float)rstate->pal_begin) *
-                                                    ((float)rstate->timer / (float)rstate->duration);
-
-        color b;
-        b.r = pal->data[rstate->pal_ref_index][0];
-        b.g = pal->data[rstate->pal_ref_index][1];
-        b.b = pal->data[rstate->pal_ref_index][2];
-
-        uint8_t m;
-        float u;
-        float k = bp / 255.0f;
-        for(int i = rstate->pal_start_index; i < rstate->pal_start_index + rstate->pal_entry_count; i++) {
-            if(rstate->pal_tint) {
-                m = max3(pal->data[i][0], pal->data[i][1], pal->data[i][2]);
-                u = m / 255.0f;
-                pal->data[i][0] = max2(0, min2(255, pal->data[i][0] + u * k * (b.r - pal->data[i][0])));
-                pal->data[i][1] = max2(0, min2(255, pal->data[i][1] + u * k * (b.g - pal->data[i][1])));
-                pal->data[i][2] = max2(0, min2(255, pal->data[i][2] + u * k * (b.b - pal->data[i][2])));
-            } else {
-                pal->data[i][0] = max2(0, min2(255, pal->data[i][0] * (1 - k) + (b.r * k)));
-                pal->data[i][1] = max2(0, min2(255, pal->data[i][1] * (1 - k) + (b.g * k)));
-                pal->data[i][2] = max2(0, min2(255, pal->data[i][2] * (1 - k) + (b.b * k)));
-            }
+        // Blend weight goes from bpb to bpd over the duration, in 1/256 steps
+        int weight = rstate->pal_begin * 256 +
+                     (rstate->pal_end - rstate->pal_begin) * 256 * rstate->timer / rstate->duration;
+
+        uint8_t ref[3];
+        memcpy(ref, pal->data[rstate->pal_ref_index], 3);
+        if(rstate->pal_tint) {
+            return screen_palette_tint(pal, rstate->pal_start_index, rstate->pal_entry_count, ref, weight);
         }
-        return 1;
+        return screen_palette_blend(pal, rstate->pal_start_index, rstate->pal_entry_count, ref, weight);
     }
     return 0;
 }
@@ -534,6 +531,20 @@ void object_free(object *obj) {
     obj->cur_animation = NULL;
 }
 
+/** Returns the object to the state object_create() leaves it in, but keeps the specialized data and its free
+ * callback. Unserializing the same kind of object into it can then reuse that memory instead of allocating it again.
+ * \param obj Object handle
+ */
+void object_reset(object *obj) {
+    void *userdata = obj->userdata;
+    object_free_cb free_cb = obj->free;
+    obj->free = NULL;
+    object_free(obj);
+    object_create(obj, obj->gs, vec2i_create(0, 0), vec2f_create(0, 0));
+    obj->userdata = userdata;
+    obj->free = free_cb;
+}
+
 /** Sets a pointer to a sound translation table. Note! Does NOT copy!
  * \param obj Object handle
  * \param ptr Pointer to the STL (30 byte char array)
@@ -789,6 +800,14 @@ vec2i object_get_size(const object *obj) {
     return vec2i_create(0, 0);
 }
 
+void object_set_particle(object *obj, int particle) {
+    obj->particle = particle;
+}
+
+int object_is_particle(const object *obj) {
+    return obj->particle;
+}
+
 void object_disable_rewind_tag(object *obj, int disable_d) {
     obj->animation_state.disable_d = disable_d;
 }
@@ -815,7 +834,8 @@ int object_is_airborne(const object *obj) {
     return obj->pos.y < ARENA_FLOOR;
 }
 
-/* Attaches one object to another. Positions are synced to this from the attached. */
+/* Attaches one object to another. Positions are synced to this from the attached.
+ * The object attached to must already be added to the game state. */
 void object_attach_to(object *obj, const object *attach_to) {
-    obj->attached_to = attach_to;
+    obj->attached_to = attach_to->handle;
 }
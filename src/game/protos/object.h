@@ -55,10 +55,12 @@ typedef void (*object_finish_cb)(object *obj);
 typedef int (*object_serialize_cb)(object *obj, serial *ser);
 typedef int (*object_unserialize_cb)(object *obj, serial *ser, int animation_id, game_state *gs);
 typedef void (*object_debug_cb)(object *obj);
+// Returns 1 if palette entries got new colors. The changed entries are marked in the palette.
 typedef int (*object_palette_transform_cb)(object *obj, screen_palette *pal);
 
 struct object_t {
     game_state *gs;
+    object_handle handle; // Set when the object is added to the game state
 
     vec2f start;
     vec2f pos;
@@ -96,9 +98,9 @@ struct object_t {
     char *sound_translation_table;
     uint8_t sprite_override; //< Tells whether cur_sprite should be kept constant regardless of anim string.
 
-    // NULL if this object is not attached to any other objects
-    // Object pointer if it is. In this case, velocity and direction will be matched.
-    const object *attached_to;
+    // OBJECT_HANDLE_NONE if this object is not attached to any other objects
+    // Object handle if it is. In this case, velocity and direction will be matched.
+    object_handle attached_to;
 
     uint8_t pal_offset;
     uint8_t cur_remap;
@@ -106,6 +108,7 @@ struct object_t {
     int16_t halt_ticks;
     uint8_t stride;
     uint8_t cast_shadow;
+    uint8_t particle; // Moved by the batched particle pass instead of the move callback
     surface *cur_surface;
 
     player_sprite_state sprite_state;
@@ -135,6 +138,7 @@ struct object_t {
 void object_create(object *obj, game_state *gs, vec2i pos, vec2f vel);
 void object_render(object *obj);
 void object_render_shadow(object *obj);
+void object_get_render_pos(const object *obj, int *x, int *y, int *flipmode);
 void object_debug(object *obj);
 void object_static_tick(object *obj);
 void object_dynamic_tick(object *obj);
@@ -146,6 +150,7 @@ void object_collide(object *a, object *b);
 int object_act(object *obj, int action);
 int object_finished(object *obj);
 void object_free(object *obj);
+void object_reset(object *obj);
 
 int object_serialize(object *obj, serial *ser);
 int object_unserialize(object *obj, serial *ser, game_state *gs);
@@ -211,6 +216,9 @@ int object_is_airborne(const object *obj);
 void object_set_shadow(object *obj, int enable);
 int object_get_shadow(const object *obj);
 
+void object_set_particle(object *obj, int particle);
+int object_is_particle(const object *obj);
+
 void object_disable_rewind_tag(object *obj, int disable_d);
 int object_is_rewind_tag_disabled(const object *obj);
 
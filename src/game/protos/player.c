@@ -96,7 +96,7 @@ void player_create(object *obj) {
     obj->animation_state.destroy = NULL;
     obj->animation_state.destroy_userdata = NULL;
     obj->animation_state.disable_d = 0;
-    obj->animation_state.enemy = NULL;
+    obj->animation_state.enemy = OBJECT_HANDLE_NONE;
     obj->animation_state.shadow_corner_hack = 0;
     obj->slide_state.timer = 0;
     obj->slide_state.vel = vec2f_create(0, 0);
@@ -273,6 +273,9 @@ void player_run(object *obj) {
     // This should really never happen, but just make sure anyway.
     assert(frame != NULL);
 
+    // The enemy may have been removed from the game; don't follow it around then.
+    object *enemy = game_state_find_object(obj->gs, state->enemy);
+
     // Get MP flag content, set to 0 if not set.
     uint8_t mp = sd_script_isset(frame, "mp") ? sd_script_get(frame, "mp") & 0xFF : 0;
 
@@ -358,15 +361,15 @@ void player_run(object *obj) {
         state->current_tick = sd_script_get(frame, "d");
     }
 
-    if(sd_script_isset(frame, "e")) {
+    if(sd_script_isset(frame, "e") && enemy != NULL) {
         // Set speed to 0, since we're being controlled by animation tag system
         obj->vel.x = 0;
         obj->vel.y = 0;
 
         // Reset position to enemy coordinates and make sure facing is set correctly
-        obj->pos.x = state->enemy->pos.x;
-        obj->pos.y = state->enemy->pos.y;
-        object_set_direction(obj, object_get_direction(state->enemy) * -1);
+        obj->pos.x = enemy->pos.x;
+        obj->pos.y = enemy->pos.y;
+        object_set_direction(obj, object_get_direction(enemy) * -1);
         // DEBUG("E: pos.x = %f, pos.y = %f", obj->pos.x, obj->pos.y);
     }
 
@@ -382,12 +385,12 @@ void player_run(object *obj) {
         obj->vel.y = 0;
     }
 
-    if(sd_script_isset(frame, "at")) {
+    if(sd_script_isset(frame, "at") && enemy != NULL) {
         // set the object's X position to be behind the opponent
-        if(obj->pos.x > state->enemy->pos.x) { // From right to left
-            obj->pos.x = state->enemy->pos.x - object_get_size(obj).x / 2;
+        if(obj->pos.x > enemy->pos.x) { // From right to left
+            obj->pos.x = enemy->pos.x - object_get_size(obj).x / 2;
         } else { // From left to right
-            obj->pos.x = state->enemy->pos.x + object_get_size(state->enemy).x / 2;
+            obj->pos.x = enemy->pos.x + object_get_size(enemy).x / 2;
         }
         object_set_direction(obj, object_get_direction(obj) * -1);
     }
@@ -413,10 +416,10 @@ void player_run(object *obj) {
     }
 
     // Handle slide in relation to enemy
-    if(obj->enemy_slide_state.timer > 0) {
+    if(obj->enemy_slide_state.timer > 0 && enemy != NULL) {
         obj->enemy_slide_state.duration++;
-        obj->pos.x = state->enemy->pos.x + obj->enemy_slide_state.dest.x;
-        obj->pos.y = state->enemy->pos.y + obj->enemy_slide_state.dest.y;
+        obj->pos.x = enemy->pos.x + obj->enemy_slide_state.dest.x;
+        obj->pos.y = enemy->pos.y + obj->enemy_slide_state.dest.y;
         obj->enemy_slide_state.timer--;
     }
 
@@ -429,9 +432,9 @@ void player_run(object *obj) {
             float vx = 0;
             float vy = 0;
 
-            if(obj->animation_state.shadow_corner_hack && sd_script_get(frame, "m") == 65) {
-                mx = state->enemy->pos.x;
-                my = state->enemy->pos.y;
+            if(obj->animation_state.shadow_corner_hack && sd_script_get(frame, "m") == 65 && enemy != NULL) {
+                mx = enemy->pos.x;
+                my = enemy->pos.y;
             }
 
             // Staring X coordinate for new animation
@@ -579,8 +582,8 @@ void player_run(object *obj) {
         }
 
         // If UA is set, force other HAR to damage animation
-        if(sd_script_isset(frame, "ua") && state->enemy->cur_animation->id != 9) {
-            har_set_ani(state->enemy, 9, 0);
+        if(sd_script_isset(frame, "ua") && enemy != NULL && enemy->cur_animation->id != 9) {
+            har_set_ani(enemy, 9, 0);
         }
 
         // BJ sets new animation for our HAR
@@ -7,6 +7,11 @@
 
 typedef struct object_t object;
 
+// Generation stamped reference to an object owned by the game state. Unlike a plain pointer,
+// a handle to a removed object resolves to NULL in game_state_find_object().
+typedef uint32_t object_handle;
+#define OBJECT_HANDLE_NONE 0
+
 typedef void (*object_state_add_cb)(object *parent, int id, vec2i pos, vec2f vel, uint8_t flags, int s, int g,
                                     void *userdata);
 typedef void (*object_state_del_cb)(object *parent, int id, void *userdata);
@@ -60,7 +65,7 @@ typedef struct player_animation_state_t {
 
     void *spawn_userdata;
     void *destroy_userdata;
-    object *enemy;
+    object_handle enemy;
     object_state_add_cb spawn;
     object_state_del_cb destroy;
 } player_animation_state;
@@ -3,6 +3,7 @@
 #include "formats/move.h"
 #include "game/game_player.h"
 #include "game/game_state_type.h"
+#include "game/objects/har.h"
 #include "resources/af_loader.h"
 #include "resources/bk_loader.h"
 #include "resources/ids.h"
@@ -88,6 +89,9 @@ int scene_load_har(scene *scene, int player_id) {
     // Fix some coordinates on jump sprites
     har_fix_sprite_coords(&af_get_move(scene->af_data[player_id], ANIM_JUMPING)->ani, 0, -50);
 
+    // Done here rather than in har_create(), so that HARs restored from a saved state do not scale the moves again
+    har_apply_pilot_stats(scene->af_data[player_id], player->pilot);
+
     DEBUG("Loaded HAR %s (%s).", har_get_name(player->pilot->har_id), get_resource_name(resource_id));
     return 0;
 }
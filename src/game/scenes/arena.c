@@ -25,6 +25,7 @@
 #include "game/objects/scrap.h"
 #include "game/protos/object.h"
 #include "game/scenes/arena.h"
+#include "game/utils/rec_writer.h"
 #include "game/utils/score.h"
 #include "game/utils/settings.h"
 #include "game/utils/ticktimer.h"
@@ -63,7 +64,8 @@ typedef struct arena_local_t {
 
     int rein_enabled;
 
-    sd_rec_file *rec;
+    sd_rec_file *rec; // Header of the recording, moves are streamed to rec_writer
+    rec_writer *rec_writer;
     int rec_last[2];
 } arena_local;
 
@@ -649,6 +651,10 @@ void arena_har_hook(har_event event, void *data) {
             }
             break;
         case HAR_EVENT_DEFEAT:
+            if(scene->gs->is_fork) {
+                // Rounds and pilot records belong to the real game
+                break;
+            }
             arena_har_defeat_hook(event.player_id, scene);
             if(arena->state != ARENA_STATE_ENDING) {
                 arena->ending_ticks = 0;
@@ -703,7 +709,7 @@ void arena_free(scene *scene) {
 
     if(local->rec) {
         write_rec_move(scene, game_state_get_player(scene->gs, 0), ACT_STOP);
-        sd_rec_save(local->rec, scene->gs->init_flags->rec_file);
+        rec_writer_close(local->rec_writer);
         sd_rec_free(local->rec);
         omf_free(local->rec);
     }
@@ -784,68 +790,64 @@ void write_rec_move(scene *scene, game_player *player, int action) {
     }
     local->rec_last[move.player_id] = move.action;
 
-    int ret;
-
-    if((ret = sd_rec_insert_action(local->rec, local->rec->move_count, &move)) != SD_SUCCESS) {
-        DEBUG("recoding move failed %d", ret);
+    if(local->rec_writer) {
+        rec_writer_append(local->rec_writer, &move);
     }
 }
 
-int arena_handle_events(scene *scene, game_player *player, ctrl_event *i) {
+int arena_handle_events(scene *scene, game_player *player, ctrl_event_queue *events) {
     int need_sync = 0;
     arena_local *local = scene_get_userdata(scene);
-    if(i) {
-        do {
-            if(i->type == EVENT_TYPE_ACTION && i->event_data.action == ACT_ESC &&
-               player == game_state_get_player(scene->gs, 0)) {
-                // toggle menu
-                local->menu_visible = !local->menu_visible;
-                game_state_set_paused(scene->gs, local->menu_visible);
-                need_sync = 1;
-                controller_set_repeat(game_player_get_ctrl(player), !local->menu_visible);
-                controller_set_repeat(game_player_get_ctrl(game_state_get_player(scene->gs, 1)), !local->menu_visible);
-                DEBUG("local menu %d, controller repeat %d", local->menu_visible, game_player_get_ctrl(player)->repeat);
-            } else if(i->type == EVENT_TYPE_ACTION && local->menu_visible &&
-                      (player->ctrl->type == CTRL_TYPE_KEYBOARD || player->ctrl->type == CTRL_TYPE_GAMEPAD) &&
-                      i->event_data.action != ACT_ESC && /* take AST_ESC only from player 1 */
-                      !is_demoplay(scene)) {
-                DEBUG("menu event %d", i->event_data.action);
-                // menu events
-                guiframe_action(local->game_menu, i->event_data.action);
-            } else if(i->type == EVENT_TYPE_ACTION) {
-                if(player->ctrl->type == CTRL_TYPE_NETWORK) {
-                    do {
-                        object_act(game_player_get_har(player), i->event_data.action);
-                        write_rec_move(scene, player, i->event_data.action);
-                        // Rewritten this way, we possible skipped some events
-                        // before. We check if there is a next event, then
-                        // check if it is EVENT_TYPE_ACTION and only then we
-                        // move the event iterator. If conditions fail then we
-                        // move to the next element at the end of the loop as
-                        // usual.
-                        if(i->next == NULL || i->next->type != EVENT_TYPE_ACTION)
-                            break;
-                    } while((i = i->next) != NULL);
-                    // always trigger a synchronization, since if the client's move did not actually happen, we want to
-                    // rewind them ASAP
-                    need_sync = 1;
-                } else {
-                    need_sync += object_act(game_player_get_har(player), i->event_data.action);
+    ctrl_event *i;
+    for(unsigned int n = 0; (i = ctrl_event_queue_get(events, n)) != NULL; n++) {
+        if(i->type == EVENT_TYPE_ACTION && i->event_data.action == ACT_ESC &&
+           player == game_state_get_player(scene->gs, 0)) {
+            // toggle menu
+            local->menu_visible = !local->menu_visible;
+            game_state_set_paused(scene->gs, local->menu_visible);
+            need_sync = 1;
+            controller_set_repeat(game_player_get_ctrl(player), !local->menu_visible);
+            controller_set_repeat(game_player_get_ctrl(game_state_get_player(scene->gs, 1)), !local->menu_visible);
+            DEBUG("local menu %d, controller repeat %d", local->menu_visible, game_player_get_ctrl(player)->repeat);
+        } else if(i->type == EVENT_TYPE_ACTION && local->menu_visible &&
+                  (player->ctrl->type == CTRL_TYPE_KEYBOARD || player->ctrl->type == CTRL_TYPE_GAMEPAD) &&
+                  i->event_data.action != ACT_ESC && /* take AST_ESC only from player 1 */
+                  !is_demoplay(scene)) {
+            DEBUG("menu event %d", i->event_data.action);
+            // menu events
+            guiframe_action(local->game_menu, i->event_data.action);
+        } else if(i->type == EVENT_TYPE_ACTION) {
+            if(player->ctrl->type == CTRL_TYPE_NETWORK) {
+                // Consecutive network actions are all applied here
+                ctrl_event *next;
+                do {
+                    object_act(game_player_get_har(player), i->event_data.action);
                     write_rec_move(scene, player, i->event_data.action);
-                }
-            } else if(i->type == EVENT_TYPE_SYNC) {
-                DEBUG("sync");
-                game_state_unserialize(scene->gs, i->event_data.ser, player->ctrl->rtt);
-                maybe_install_har_hooks(scene);
-            } else if(i->type == EVENT_TYPE_CLOSE) {
-                if(player->ctrl->type == CTRL_TYPE_REC) {
-                    game_state_set_next(scene->gs, SCENE_NONE);
-                } else {
-                    game_state_set_next(scene->gs, SCENE_MENU);
-                }
-                return 0;
+                    next = ctrl_event_queue_get(events, n + 1);
+                    if(next == NULL || next->type != EVENT_TYPE_ACTION)
+                        break;
+                    i = next;
+                    n++;
+                } while(1);
+                // always trigger a synchronization, since if the client's move did not actually happen, we want to
+                // rewind them ASAP
+                need_sync = 1;
+            } else {
+                need_sync += object_act(game_player_get_har(player), i->event_data.action);
+                write_rec_move(scene, player, i->event_data.action);
+            }
+        } else if(i->type == EVENT_TYPE_SYNC) {
+            DEBUG("sync");
+            game_state_unserialize(scene->gs, i->event_data.ser, player->ctrl->rtt);
+            maybe_install_har_hooks(scene);
+        } else if(i->type == EVENT_TYPE_CLOSE) {
+            if(player->ctrl->type == CTRL_TYPE_REC) {
+                game_state_set_next(scene->gs, SCENE_NONE);
+            } else {
+                game_state_set_next(scene->gs, SCENE_MENU);
             }
-        } while((i = i->next));
+            return 0;
+        }
     }
     return need_sync;
 }
@@ -917,6 +919,10 @@ void arena_dynamic_tick(scene *scene, int paused) {
     game_player *player1 = game_state_get_player(gs, 0);
     game_player *player2 = game_state_get_player(gs, 1);
 
+    if(local->rec_writer) {
+        rec_writer_tick(local->rec_writer, gs->tick);
+    }
+
     if(!paused) {
         object *obj_har[2];
         har *hars[2];
@@ -1007,8 +1013,8 @@ void arena_dynamic_tick(scene *scene, int paused) {
 
     int need_sync = 0;
     // allow enemy HARs to move during a network game
-    need_sync += arena_handle_events(scene, player1, player1->ctrl->extra_events);
-    need_sync += arena_handle_events(scene, player2, player2->ctrl->extra_events);
+    need_sync += arena_handle_events(scene, player1, &player1->ctrl->extra_events);
+    need_sync += arena_handle_events(scene, player2, &player2->ctrl->extra_events);
     arena_maybe_sync(scene, need_sync);
 }
 
@@ -1021,15 +1027,17 @@ void arena_input_tick(scene *scene) {
     game_player *player1 = game_state_get_player(scene->gs, 0);
     game_player *player2 = game_state_get_player(scene->gs, 1);
 
-    ctrl_event *p1 = NULL, *p2 = NULL;
+    ctrl_event_queue p1, p2;
+    ctrl_event_queue_init(&p1);
+    ctrl_event_queue_init(&p2);
     controller_poll(player1->ctrl, &p1);
     controller_poll(player2->ctrl, &p2);
 
     int need_sync = 0;
-    need_sync += arena_handle_events(scene, player1, p1);
-    need_sync += arena_handle_events(scene, player2, p2);
-    controller_free_chain(p1);
-    controller_free_chain(p2);
+    need_sync += arena_handle_events(scene, player1, &p1);
+    need_sync += arena_handle_events(scene, player2, &p2);
+    ctrl_event_queue_free(&p1);
+    ctrl_event_queue_free(&p2);
     arena_maybe_sync(scene, need_sync);
 }
 
@@ -1145,6 +1153,36 @@ void arena_set_state(scene *scene, int state) {
     local->state = state;
 }
 
+void arena_serialize(scene *scene, serial *ser) {
+    arena_local *local = scene_get_userdata(scene);
+    serial_write_int8(ser, local->round);
+    serial_write_int8(ser, local->state);
+    serial_write_int8(ser, local->over);
+    serial_write_int32(ser, local->ending_ticks);
+    for(int i = 0; i < 2; i++) {
+        serial_write_int8(ser, game_player_get_score(game_state_get_player(scene->gs, i))->rounds);
+    }
+}
+
+void arena_unserialize(scene *scene, serial *ser) {
+    arena_local *local = scene_get_userdata(scene);
+    local->round = serial_read_int8(ser);
+    local->state = serial_read_int8(ser);
+    local->over = serial_read_int8(ser);
+    local->ending_ticks = serial_read_int32(ser);
+    for(int i = 0; i < 2; i++) {
+        chr_score *score = game_player_get_score(game_state_get_player(scene->gs, i));
+        score->rounds = serial_read_int8(ser);
+
+        // Round tokens show the rounds won
+        for(int j = 0; j < 4; j++) {
+            if(local->player_rounds[i][j]) {
+                object_select_sprite(local->player_rounds[i][j], j < score->rounds ? 0 : 1);
+            }
+        }
+    }
+}
+
 void arena_toggle_rein(scene *scene) {
     arena_local *local = scene_get_userdata(scene);
     local->rein_enabled = !local->rein_enabled;
@@ -1327,8 +1365,8 @@ int arena_create(scene *scene) {
     controller_set_repeat(game_player_get_ctrl(_player[0]), 1);
     controller_set_repeat(game_player_get_ctrl(_player[1]), 1);
 
-    game_player_get_har(_player[0])->animation_state.enemy = game_player_get_har(_player[1]);
-    game_player_get_har(_player[1])->animation_state.enemy = game_player_get_har(_player[0]);
+    game_player_get_har(_player[0])->animation_state.enemy = game_player_get_har(_player[1])->handle;
+    game_player_get_har(_player[1])->animation_state.enemy = game_player_get_har(_player[0])->handle;
 
     maybe_install_har_hooks(scene);
 
@@ -1466,6 +1504,7 @@ int arena_create(scene *scene) {
             memcpy(local->rec->pilots[i].info.name, lang_get(player->pilot->pilot_id + 20), 18);
         }
         local->rec->arena_id = scene->id - SCENE_ARENA0;
+        local->rec_writer = rec_writer_open(local->rec, scene->gs->init_flags->rec_file);
     } else {
         local->rec = NULL;
     }
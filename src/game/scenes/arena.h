@@ -2,6 +2,7 @@
 #define ARENA_H
 
 #include "game/protos/scene.h"
+#include "game/utils/serial.h"
 
 enum
 {
@@ -17,4 +18,15 @@ palette *arena_get_player_palette(scene *scene, int player);
 void arena_toggle_rein(scene *scene);
 void maybe_install_har_hooks(scene *scene);
 
+/**
+ * Writes the round state of the arena: round number, state, ending timer and the rounds won.
+ * Together with game_state_serialize(), this is enough to continue a fight from a keyframe.
+ */
+void arena_serialize(scene *scene, serial *ser);
+
+/**
+ * Restores a round state written by arena_serialize().
+ */
+void arena_unserialize(scene *scene, serial *ser);
+
 #endif // ARENA_H
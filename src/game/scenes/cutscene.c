@@ -44,35 +44,34 @@ int cutscene_next_scene(scene *scene) {
 void cutscene_input_tick(scene *scene) {
     cutscene_local *local = scene_get_userdata(scene);
     game_player *player1 = game_state_get_player(scene->gs, 0);
-    ctrl_event *p1 = NULL, *i;
+    ctrl_event_queue p1;
+    ctrl_event *i;
+    ctrl_event_queue_init(&p1);
 
     controller_poll(player1->ctrl, &p1);
 
-    i = p1;
-    if(i) {
-        do {
-            if(i->type == EVENT_TYPE_ACTION) {
-                if(i->event_data.action == ACT_KICK || i->event_data.action == ACT_PUNCH) {
-
-                    if(player1->chr && player1->chr->cutscene_text[local->pos + 1]) {
-                        local->pos++;
-                        local->current = player1->chr->cutscene_text[local->pos];
-                    } else if(!player1->chr && strlen(local->current) + local->pos < local->len) {
-                        local->pos += strlen(local->current) + 1;
-                        local->current += strlen(local->current) + 1;
-                        char *p;
-                        if((p = strchr(local->current, '\n'))) {
-                            // null out the byte
-                            *p = '\0';
-                        }
-                    } else {
-                        game_state_set_next(scene->gs, cutscene_next_scene(scene));
+    for(unsigned int n = 0; (i = ctrl_event_queue_get(&p1, n)) != NULL; n++) {
+        if(i->type == EVENT_TYPE_ACTION) {
+            if(i->event_data.action == ACT_KICK || i->event_data.action == ACT_PUNCH) {
+
+                if(player1->chr && player1->chr->cutscene_text[local->pos + 1]) {
+                    local->pos++;
+                    local->current = player1->chr->cutscene_text[local->pos];
+                } else if(!player1->chr && strlen(local->current) + local->pos < local->len) {
+                    local->pos += strlen(local->current) + 1;
+                    local->current += strlen(local->current) + 1;
+                    char *p;
+                    if((p = strchr(local->current, '\n'))) {
+                        // null out the byte
+                        *p = '\0';
                     }
+                } else {
+                    game_state_set_next(scene->gs, cutscene_next_scene(scene));
                 }
             }
-        } while((i = i->next));
+        }
     }
-    controller_free_chain(p1);
+    ctrl_event_queue_free(&p1);
 }
 
 void cutscene_render_overlay(scene *scene) {
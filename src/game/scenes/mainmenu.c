@@ -35,24 +35,24 @@ void mainmenu_input_tick(scene *scene) {
         game_player *player = game_state_get_player(scene->gs, i);
 
         // Poll the controller
-        ctrl_event *p = NULL;
-        controller_poll(player->ctrl, &p);
-        if(p) {
-            do {
-                if(p->type == EVENT_TYPE_ACTION) {
-                    // Skip repeated keys
-                    if(local->prev_key[i] == p->event_data.action) {
-                        continue;
-                    }
-
-                    local->prev_key[i] = p->event_data.action;
-
-                    // Pass on the event
-                    guiframe_action(local->frame, p->event_data.action);
+        ctrl_event_queue events;
+        ctrl_event *p;
+        ctrl_event_queue_init(&events);
+        controller_poll(player->ctrl, &events);
+        for(unsigned int n = 0; (p = ctrl_event_queue_get(&events, n)) != NULL; n++) {
+            if(p->type == EVENT_TYPE_ACTION) {
+                // Skip repeated keys
+                if(local->prev_key[i] == p->event_data.action) {
+                    continue;
                 }
-            } while((p = p->next));
+
+                local->prev_key[i] = p->event_data.action;
+
+                // Pass on the event
+                guiframe_action(local->frame, p->event_data.action);
+            }
         }
-        controller_free_chain(p);
+        ctrl_event_queue_free(&events);
     }
 }
 
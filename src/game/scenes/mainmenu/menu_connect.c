@@ -4,6 +4,7 @@
 #include "game/scenes/mainmenu/menu_connect.h"
 #include "game/scenes/mainmenu/menu_widget_ids.h"
 
+#include "controller/net_controller.h"
 #include "game/game_state.h"
 #include "game/gui/gui.h"
 #include "game/protos/scene.h"
@@ -60,7 +61,7 @@ void menu_connect_start(component *c, void *userdata) {
     enet_address_set_host(&address, addr);
     address.port = settings_get()->net.net_connect_port;
 
-    ENetPeer *peer = enet_host_connect(local->host, &address, 2, 0);
+    ENetPeer *peer = enet_host_connect(local->host, &address, 2, NET_PROTOCOL_VERSION);
     if(peer == NULL) {
         DEBUG("Unable to connect to %s", addr);
         enet_host_destroy(local->host);
@@ -17,6 +17,7 @@ void menu_gameplay_speed_slide(component *c, void *userdata, int pos) {
 component *menu_gameplay_create(scene *s) {
     const char *fightmode_opts[] = {"NORMAL", "HYPER"};
     const char *hazard_opts[] = {"OFF", "ON"};
+    const char *cpu_style_opts[] = {"CLASSIC", "LOOKAHEAD"};
 
     // Text config
     text_settings tconf;
@@ -38,6 +39,8 @@ component *menu_gameplay_create(scene *s) {
                                                     hazard_opts, 2));
     menu_attach(menu, textselector_create_bind_opts(&tconf, "CPU:", NULL, NULL, &settings_get()->gameplay.difficulty,
                                                     ai_difficulty_names, NUMBER_OF_AI_DIFFICULTY_TYPES));
+    menu_attach(menu, textselector_create_bind_opts(&tconf, "CPU STYLE", NULL, NULL,
+                                                    &settings_get()->gameplay.ai_lookahead, cpu_style_opts, 2));
     menu_attach(menu, textselector_create_bind_opts(&tconf, "", NULL, NULL, &settings_get()->gameplay.rounds,
                                                     round_type_names, NUMBER_OF_ROUND_TYPES));
     menu_attach(menu, textbutton_create(&tconf, "DONE", COM_ENABLED, menu_gameplay_done, NULL));
@@ -3,6 +3,7 @@
 
 #include "game/scenes/mainmenu/menu_listen.h"
 
+#include "controller/net_controller.h"
 #include "game/game_state.h"
 #include "game/gui/gui.h"
 #include "game/protos/scene.h"
@@ -37,6 +38,12 @@ void menu_listen_tick(component *c) {
             if(event.type != ENET_EVENT_TYPE_CONNECT) {
                 continue;
             }
+            if(event.data != NET_PROTOCOL_VERSION) {
+                PERROR("Refusing client with network protocol version %u, expected %u", event.data,
+                       NET_PROTOCOL_VERSION);
+                enet_peer_disconnect_now(event.peer, 0);
+                continue;
+            }
 
             ENetPacket *packet = enet_packet_create("0", 2, ENET_PACKET_FLAG_RELIABLE);
             enet_peer_send(event.peer, 0, packet);
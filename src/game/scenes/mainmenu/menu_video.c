@@ -268,6 +268,11 @@ component *menu_video_create(scene *s) {
         textselector_set_pos(factor, pindex);
     }
 
+    // Shadows
+    const char *shadow_opts[] = {"OFF", "ON", "FADE"};
+    menu_attach(menu,
+                textselector_create_bind_opts(&tconf, "SHADOWS", NULL, NULL, &setting->video.shadows, shadow_opts, 3));
+
     // Done button
     menu_attach(menu, textbutton_create(&tconf, "DONE", COM_ENABLED, menu_video_done, s));
 
@@ -377,58 +377,57 @@ void mechlab_input_tick(scene *scene) {
     game_player *player1 = game_state_get_player(scene->gs, 0);
 
     // Poll the controller
-    ctrl_event *p1 = NULL, *i;
+    ctrl_event_queue p1;
+    ctrl_event *i;
+    ctrl_event_queue_init(&p1);
     controller_poll(player1->ctrl, &p1);
-    i = p1;
-    if(i) {
-        do {
-            if(i->type == EVENT_TYPE_ACTION) {
-                // If view is new dashboard view, pass all input to it
-                if(local->dashtype == DASHBOARD_NEW) {
-                    // If inputting text for new player name is done, switch to next view.
-                    // If ESC, exit view.
-                    // Otherwise handle text input
-                    if(i->event_data.action == ACT_ESC) {
-                        mechlab_find_last_player(scene);
-                        mechlab_select_dashboard(scene, DASHBOARD_STATS);
-                    } else if(i->event_data.action == ACT_KICK || i->event_data.action == ACT_PUNCH) {
-                        strncpy(player1->pilot->name, textinput_value(local->nw.input), 17);
-                        // mechlab_select_dashboard(scene, DASHBOARD_SELECT_NEW_PIC);
-                        trnmenu_finish(
-                            guiframe_get_root(local->frame)); // This will trigger exception case in mechlab_tick
-                    } else {
-                        guiframe_action(local->dashboard, i->event_data.action);
-                    }
-
-                } else if(local->dashtype == DASHBOARD_SELECT_NEW_PIC && i->event_data.action == ACT_ESC) {
-                    bool found = mechlab_find_last_player(scene);
+    for(unsigned int n = 0; (i = ctrl_event_queue_get(&p1, n)) != NULL; n++) {
+        if(i->type == EVENT_TYPE_ACTION) {
+            // If view is new dashboard view, pass all input to it
+            if(local->dashtype == DASHBOARD_NEW) {
+                // If inputting text for new player name is done, switch to next view.
+                // If ESC, exit view.
+                // Otherwise handle text input
+                if(i->event_data.action == ACT_ESC) {
+                    mechlab_find_last_player(scene);
                     mechlab_select_dashboard(scene, DASHBOARD_STATS);
-                    guiframe_set_root(local->frame, lab_menu_main_create(scene, found));
-                    guiframe_layout(local->frame);
-                } else if(local->dashtype == DASHBOARD_SELECT_DIFFICULTY && i->event_data.action == ACT_ESC) {
-                    bool found = mechlab_find_last_player(scene);
-                    mechlab_select_dashboard(scene, DASHBOARD_STATS);
-                    guiframe_set_root(local->frame, lab_menu_main_create(scene, found));
-                    guiframe_layout(local->frame);
-                } else if(local->dashtype == DASHBOARD_SELECT_TOURNAMENT && i->event_data.action == ACT_ESC) {
-                    bool found = mechlab_find_last_player(scene);
-                    mechlab_select_dashboard(scene, DASHBOARD_STATS);
-                    guiframe_set_root(local->frame, lab_menu_main_create(scene, found));
-                    guiframe_layout(local->frame);
-
-                    // } else if (local->dashtype == DASHBOARD_SELECT_NEW_PIC && (i->event_data.action == ACT_KICK ||
-                    // i->event_data.action == ACT_PUNCH)) {
-                    //         mechlab_select_dashboard(scene, DASHBOARD_SELECT_DIFFICULTY);
-                    //         trnmenu_finish(
-                    //             guiframe_get_root(local->frame)); // This will trigger exception case in mechlab_tick
-                    // If view is any other, just pass input to the bottom menu
+                } else if(i->event_data.action == ACT_KICK || i->event_data.action == ACT_PUNCH) {
+                    strncpy(player1->pilot->name, textinput_value(local->nw.input), 17);
+                    // mechlab_select_dashboard(scene, DASHBOARD_SELECT_NEW_PIC);
+                    trnmenu_finish(
+                        guiframe_get_root(local->frame)); // This will trigger exception case in mechlab_tick
                 } else {
-                    guiframe_action(local->frame, i->event_data.action);
+                    guiframe_action(local->dashboard, i->event_data.action);
                 }
+
+            } else if(local->dashtype == DASHBOARD_SELECT_NEW_PIC && i->event_data.action == ACT_ESC) {
+                bool found = mechlab_find_last_player(scene);
+                mechlab_select_dashboard(scene, DASHBOARD_STATS);
+                guiframe_set_root(local->frame, lab_menu_main_create(scene, found));
+                guiframe_layout(local->frame);
+            } else if(local->dashtype == DASHBOARD_SELECT_DIFFICULTY && i->event_data.action == ACT_ESC) {
+                bool found = mechlab_find_last_player(scene);
+                mechlab_select_dashboard(scene, DASHBOARD_STATS);
+                guiframe_set_root(local->frame, lab_menu_main_create(scene, found));
+                guiframe_layout(local->frame);
+            } else if(local->dashtype == DASHBOARD_SELECT_TOURNAMENT && i->event_data.action == ACT_ESC) {
+                bool found = mechlab_find_last_player(scene);
+                mechlab_select_dashboard(scene, DASHBOARD_STATS);
+                guiframe_set_root(local->frame, lab_menu_main_create(scene, found));
+                guiframe_layout(local->frame);
+
+                // } else if (local->dashtype == DASHBOARD_SELECT_NEW_PIC && (i->event_data.action == ACT_KICK ||
+                // i->event_data.action == ACT_PUNCH)) {
+                //         mechlab_select_dashboard(scene, DASHBOARD_SELECT_DIFFICULTY);
+                //         trnmenu_finish(
+                //             guiframe_get_root(local->frame)); // This will trigger exception case in mechlab_tick
+                // If view is any other, just pass input to the bottom menu
+            } else {
+                guiframe_action(local->frame, i->event_data.action);
             }
-        } while((i = i->next));
+        }
     }
-    controller_free_chain(p1);
+    ctrl_event_queue_free(&p1);
 }
 
 // Init mechlab
@@ -69,14 +69,10 @@ void mask_sprite(surface *vga, int x, int y, int w, int h) {
         for(int j = 0; j < vga->w; j++) {
             int offset = (i * vga->w) + j;
             if((i < y || i > y + h) || (j < x || j > x + w)) {
-                vga->stencil[offset] = 0;
+                surface_stencil_set(vga, offset, 0);
             } else {
-                if(vga->data[offset] == -48) {
-                    // strip out the black pixels
-                    vga->stencil[offset] = 0;
-                } else {
-                    vga->stencil[offset] = 1;
-                }
+                // strip out the black pixels
+                surface_stencil_set(vga, offset, vga->data[offset] != -48);
             }
         }
     }
@@ -119,30 +115,24 @@ void melee_tick(scene *scene, int paused) {
     melee_local *local = scene_get_userdata(scene);
     game_player *player1 = game_state_get_player(scene->gs, 0);
     game_player *player2 = game_state_get_player(scene->gs, 1);
-    ctrl_event *i = NULL;
+    ctrl_event *i;
 
     // Handle extra controller inputs
-    i = player1->ctrl->extra_events;
-    if(i) {
-        do {
-            if(i->type == EVENT_TYPE_ACTION) {
-                handle_action(scene, 1, i->event_data.action);
-            } else if(i->type == EVENT_TYPE_CLOSE) {
-                game_state_set_next(scene->gs, SCENE_MENU);
-                return;
-            }
-        } while((i = i->next));
+    for(unsigned int n = 0; (i = ctrl_event_queue_get(&player1->ctrl->extra_events, n)) != NULL; n++) {
+        if(i->type == EVENT_TYPE_ACTION) {
+            handle_action(scene, 1, i->event_data.action);
+        } else if(i->type == EVENT_TYPE_CLOSE) {
+            game_state_set_next(scene->gs, SCENE_MENU);
+            return;
+        }
     }
-    i = player2->ctrl->extra_events;
-    if(i) {
-        do {
-            if(i->type == EVENT_TYPE_ACTION) {
-                handle_action(scene, 2, i->event_data.action);
-            } else if(i->type == EVENT_TYPE_CLOSE) {
-                game_state_set_next(scene->gs, SCENE_MENU);
-                return;
-            }
-        } while((i = i->next));
+    for(unsigned int n = 0; (i = ctrl_event_queue_get(&player2->ctrl->extra_events, n)) != NULL; n++) {
+        if(i->type == EVENT_TYPE_ACTION) {
+            handle_action(scene, 2, i->event_data.action);
+        } else if(i->type == EVENT_TYPE_CLOSE) {
+            game_state_set_next(scene->gs, SCENE_MENU);
+            return;
+        }
     }
 
     if(!local->pulsedir) {
@@ -356,48 +346,45 @@ void melee_input_tick(scene *scene) {
     melee_local *local = scene_get_userdata(scene);
     game_player *player1 = game_state_get_player(scene->gs, 0);
     game_player *player2 = game_state_get_player(scene->gs, 1);
-    ctrl_event *p1 = NULL, *p2 = NULL, *i;
+    ctrl_event_queue p1, p2;
+    ctrl_event *i;
+    ctrl_event_queue_init(&p1);
+    ctrl_event_queue_init(&p2);
     controller_poll(player1->ctrl, &p1);
     controller_poll(player2->ctrl, &p2);
-    i = p1;
-    if(i) {
-        do {
-            if(i->type == EVENT_TYPE_ACTION) {
-                if(i->event_data.action == ACT_ESC) {
-                    audio_play_sound(20, 0.5f, 0.0f, 2.0f);
-                    if(local->selection == 1) {
-                        // restore the player selection
-                        local->column_a = local->pilot_id_a % 5;
-                        local->row_a = local->pilot_id_a / 5;
-                        local->column_b = local->pilot_id_b % 5;
-                        local->row_b = local->pilot_id_b / 5;
-
-                        local->selection = 0;
-                        local->done_a = 0;
-                        local->done_b = 0;
-                    } else {
-                        game_state_set_next(scene->gs, SCENE_MENU);
-                    }
+    for(unsigned int n = 0; (i = ctrl_event_queue_get(&p1, n)) != NULL; n++) {
+        if(i->type == EVENT_TYPE_ACTION) {
+            if(i->event_data.action == ACT_ESC) {
+                audio_play_sound(20, 0.5f, 0.0f, 2.0f);
+                if(local->selection == 1) {
+                    // restore the player selection
+                    local->column_a = local->pilot_id_a % 5;
+                    local->row_a = local->pilot_id_a / 5;
+                    local->column_b = local->pilot_id_b % 5;
+                    local->row_b = local->pilot_id_b / 5;
+
+                    local->selection = 0;
+                    local->done_a = 0;
+                    local->done_b = 0;
                 } else {
-                    handle_action(scene, 1, i->event_data.action);
+                    game_state_set_next(scene->gs, SCENE_MENU);
                 }
-            } else if(i->type == EVENT_TYPE_CLOSE) {
-                game_state_set_next(scene->gs, SCENE_MENU);
+            } else {
+                handle_action(scene, 1, i->event_data.action);
             }
-        } while((i = i->next));
+        } else if(i->type == EVENT_TYPE_CLOSE) {
+            game_state_set_next(scene->gs, SCENE_MENU);
+        }
     }
-    controller_free_chain(p1);
-    i = p2;
-    if(i) {
-        do {
-            if(i->type == EVENT_TYPE_ACTION) {
-                handle_action(scene, 2, i->event_data.action);
-            } else if(i->type == EVENT_TYPE_CLOSE) {
-                game_state_set_next(scene->gs, SCENE_MENU);
-            }
-        } while((i = i->next));
+    ctrl_event_queue_free(&p1);
+    for(unsigned int n = 0; (i = ctrl_event_queue_get(&p2, n)) != NULL; n++) {
+        if(i->type == EVENT_TYPE_ACTION) {
+            handle_action(scene, 2, i->event_data.action);
+        } else if(i->type == EVENT_TYPE_CLOSE) {
+            game_state_set_next(scene->gs, SCENE_MENU);
+        }
     }
-    controller_free_chain(p2);
+    ctrl_event_queue_free(&p2);
 }
 
 void render_highlights(scene *scene) {
@@ -169,81 +169,80 @@ void newsroom_input_tick(scene *scene) {
     newsroom_local *local = scene_get_userdata(scene);
 
     game_player *player1 = game_state_get_player(scene->gs, 0);
-    ctrl_event *p1 = NULL, *i;
+    ctrl_event_queue p1;
+    ctrl_event *i;
+    ctrl_event_queue_init(&p1);
     controller_poll(player1->ctrl, &p1);
-    i = p1;
-    if(i) {
-        do {
-            if(i->type == EVENT_TYPE_ACTION) {
-                if(dialog_is_visible(&local->continue_dialog)) {
-                    dialog_event(&local->continue_dialog, i->event_data.action);
-                } else if(i->event_data.action == ACT_ESC || i->event_data.action == ACT_KICK ||
-                          i->event_data.action == ACT_PUNCH) {
-                    local->screen++;
-                    newsroom_fixup_str(local);
-
-                    if((local->screen >= 2 && !local->champion) || local->screen >= 3) {
-                        if(local->won || player1->chr) {
-                            // pick a new player
-                            game_player *p1 = game_state_get_player(scene->gs, 0);
-                            game_player *p2 = game_state_get_player(scene->gs, 1);
-                            if(p1->chr) {
-                                // clear the opponent as a signal to display plug on the VS
-                                p2->pilot = NULL;
-                                // also zero out the p2 wins so the game doesn't think
-                                // we keep losing
-                                p2->sp_wins = 0;
+    for(unsigned int n = 0; (i = ctrl_event_queue_get(&p1, n)) != NULL; n++) {
+        if(i->type == EVENT_TYPE_ACTION) {
+            if(dialog_is_visible(&local->continue_dialog)) {
+                dialog_event(&local->continue_dialog, i->event_data.action);
+            } else if(i->event_data.action == ACT_ESC || i->event_data.action == ACT_KICK ||
+                      i->event_data.action == ACT_PUNCH) {
+                local->screen++;
+                newsroom_fixup_str(local);
+
+                if((local->screen >= 2 && !local->champion) || local->screen >= 3) {
+                    if(local->won || player1->chr) {
+                        // pick a new player
+                        game_player *p1 = game_state_get_player(scene->gs, 0);
+                        game_player *p2 = game_state_get_player(scene->gs, 1);
+                        if(p1->chr) {
+                            // clear the opponent as a signal to display plug on the VS
+                            p2->pilot = NULL;
+                            // also zero out the p2 wins so the game doesn't think
+                            // we keep losing
+                            p2->sp_wins = 0;
+                        } else {
+                            DEBUG("wins are %d", p1->sp_wins);
+                            if(p1->sp_wins == (4094 ^ (2 << p1->pilot->pilot_id))) {
+                                // won the game
+                                game_state_set_next(scene->gs, SCENE_END);
                             } else {
-                                DEBUG("wins are %d", p1->sp_wins);
-                                if(p1->sp_wins == (4094 ^ (2 << p1->pilot->pilot_id))) {
-                                    // won the game
-                                    game_state_set_next(scene->gs, SCENE_END);
+                                if(p1->sp_wins == (2046 ^ (2 << p1->pilot->pilot_id))) {
+                                    // everyone but kreissack
+                                    p2->pilot->pilot_id = PILOT_KREISSACK;
+                                    p2->pilot->har_id = HAR_NOVA;
                                 } else {
-                                    if(p1->sp_wins == (2046 ^ (2 << p1->pilot->pilot_id))) {
-                                        // everyone but kreissack
-                                        p2->pilot->pilot_id = PILOT_KREISSACK;
-                                        p2->pilot->har_id = HAR_NOVA;
-                                    } else {
-                                        // pick an opponent we have not yet beaten
-                                        while(1) {
-                                            int i = rand_int(10);
-                                            if((2 << i) & p1->sp_wins || i == p1->pilot->pilot_id) {
-                                                continue;
-                                            }
-                                            p2->pilot->pilot_id = i;
-                                            p2->pilot->har_id = rand_int(10);
-                                            break;
+                                    // pick an opponent we have not yet beaten
+                                    while(1) {
+                                        int i = rand_int(10);
+                                        if((2 << i) & p1->sp_wins || i == p1->pilot->pilot_id) {
+                                            continue;
                                         }
+                                        p2->pilot->pilot_id = i;
+                                        p2->pilot->har_id = rand_int(10);
+                                        break;
                                     }
-                                    pilot p;
-                                    pilot_get_info(&p, p2->pilot->pilot_id);
-                                    sd_pilot_set_player_color(p2->pilot, TERTIARY, p.colors[0]);
-                                    sd_pilot_set_player_color(p2->pilot, SECONDARY, p.colors[1]);
-                                    sd_pilot_set_player_color(p2->pilot, PRIMARY, p.colors[2]);
-
-                                    // make a new AI controller
-                                    controller *ctrl = omf_calloc(1, sizeof(controller));
-                                    controller_init(ctrl);
-                                    sd_pilot *pilot = game_player_get_pilot(p2);
-                                    ai_controller_create(ctrl, settings_get()->gameplay.difficulty, pilot,
-                                                         p2->pilot->pilot_id);
-                                    game_player_set_ctrl(p2, ctrl);
                                 }
+                                pilot p;
+                                pilot_get_info(&p, p2->pilot->pilot_id);
+                                sd_pilot_set_player_color(p2->pilot, TERTIARY, p.colors[0]);
+                                sd_pilot_set_player_color(p2->pilot, SECONDARY, p.colors[1]);
+                                sd_pilot_set_player_color(p2->pilot, PRIMARY, p.colors[2]);
+
+                                // make a new AI controller
+                                controller *ctrl = omf_calloc(1, sizeof(controller));
+                                controller_init(ctrl);
+                                sd_pilot *pilot = game_player_get_pilot(p2);
+                                ai_controller_create(ctrl, settings_get()->gameplay.difficulty, pilot,
+                                                     p2->pilot->pilot_id);
+                                game_player_set_ctrl(p2, ctrl);
                             }
-                            if(p1->chr && local->champion) {
-                                game_state_set_next(scene->gs, p1->chr->cutscene);
-                            } else {
-                                game_state_set_next(scene->gs, SCENE_VS);
-                            }
+                        }
+                        if(p1->chr && local->champion) {
+                            game_state_set_next(scene->gs, p1->chr->cutscene);
                         } else {
-                            dialog_show(&local->continue_dialog, 1);
+                            game_state_set_next(scene->gs, SCENE_VS);
                         }
+                    } else {
+                        dialog_show(&local->continue_dialog, 1);
                     }
                 }
             }
-        } while((i = i->next));
+        }
     }
-    controller_free_chain(p1);
+    ctrl_event_queue_free(&p1);
 }
 
 int pilot_sex(int pilot_id) {
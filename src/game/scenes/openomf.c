@@ -12,22 +12,21 @@ typedef struct openomf_local_t {
 void openomf_input_tick(scene *scene) {
     game_player *player1 = game_state_get_player(scene->gs, 0);
 
-    ctrl_event *p1 = NULL, *i;
+    ctrl_event_queue p1;
+    ctrl_event *i;
+    ctrl_event_queue_init(&p1);
     controller_poll(player1->ctrl, &p1);
 
-    i = p1;
-    if(i) {
-        do {
-            if(i->type == EVENT_TYPE_ACTION) {
-                if(i->event_data.action == ACT_ESC || i->event_data.action == ACT_KICK ||
-                   i->event_data.action == ACT_PUNCH) {
+    for(unsigned int n = 0; (i = ctrl_event_queue_get(&p1, n)) != NULL; n++) {
+        if(i->type == EVENT_TYPE_ACTION) {
+            if(i->event_data.action == ACT_ESC || i->event_data.action == ACT_KICK ||
+               i->event_data.action == ACT_PUNCH) {
 
-                    game_state_set_next(scene->gs, SCENE_MENU);
-                }
+                game_state_set_next(scene->gs, SCENE_MENU);
             }
-        } while((i = i->next));
+        }
     }
-    controller_free_chain(p1);
+    ctrl_event_queue_free(&p1);
 }
 
 void openomf_tick(scene *scene, int paused) {
@@ -81,44 +81,43 @@ int scoreboard_event(scene *scene, SDL_Event *event) {
 void scoreboard_input_tick(scene *scene) {
     scoreboard_local *local = scene_get_userdata(scene);
     game_player *player1 = game_state_get_player(scene->gs, 0);
-    ctrl_event *p1 = NULL, *i;
+    ctrl_event_queue p1;
+    ctrl_event *i;
+    ctrl_event_queue_init(&p1);
     controller_poll(player1->ctrl, &p1);
-    i = p1;
-    if(i) {
-        do {
-            if(i->type == EVENT_TYPE_ACTION) {
-                // If there is pending data, and name has been given, save
-                if(local->has_pending_data && strlen(local->pending_data.name) > 0 &&
-                   (i->event_data.action == ACT_KICK || i->event_data.action == ACT_PUNCH)) {
-
-                    handle_scoreboard_save(local);
-                    local->has_pending_data = 0;
-
-                    // If there is no data, and confirm is clicked, don't save
-                } else if(local->has_pending_data == 1 && strlen(local->pending_data.name) == 0 &&
-                          (i->event_data.action == ACT_KICK || i->event_data.action == ACT_PUNCH)) {
-
-                    local->has_pending_data = 0;
-
-                    // Normal exit routine
-                    // Only allow if there is no pending data.
-                } else if(!local->has_pending_data &&
-                          (i->event_data.action == ACT_ESC || i->event_data.action == ACT_KICK ||
-                           i->event_data.action == ACT_PUNCH)) {
-
-                    game_state_set_next(scene->gs, scene->gs->next_next_id);
-
-                    // If left or right button is pressed, change page
-                    // but only if we are not in input mode.
-                } else if(!local->has_pending_data && i->event_data.action == ACT_LEFT) {
-                    local->page = (local->page > 0) ? local->page - 1 : 0;
-                } else if(!local->has_pending_data && i->event_data.action == ACT_RIGHT) {
-                    local->page = (local->page < MAX_PAGES) ? local->page + 1 : MAX_PAGES;
-                }
+    for(unsigned int n = 0; (i = ctrl_event_queue_get(&p1, n)) != NULL; n++) {
+        if(i->type == EVENT_TYPE_ACTION) {
+            // If there is pending data, and name has been given, save
+            if(local->has_pending_data && strlen(local->pending_data.name) > 0 &&
+               (i->event_data.action == ACT_KICK || i->event_data.action == ACT_PUNCH)) {
+
+                handle_scoreboard_save(local);
+                local->has_pending_data = 0;
+
+                // If there is no data, and confirm is clicked, don't save
+            } else if(local->has_pending_data == 1 && strlen(local->pending_data.name) == 0 &&
+                      (i->event_data.action == ACT_KICK || i->event_data.action == ACT_PUNCH)) {
+
+                local->has_pending_data = 0;
+
+                // Normal exit routine
+                // Only allow if there is no pending data.
+            } else if(!local->has_pending_data &&
+                      (i->event_data.action == ACT_ESC || i->event_data.action == ACT_KICK ||
+                       i->event_data.action == ACT_PUNCH)) {
+
+                game_state_set_next(scene->gs, scene->gs->next_next_id);
+
+                // If left or right button is pressed, change page
+                // but only if we are not in input mode.
+            } else if(!local->has_pending_data && i->event_data.action == ACT_LEFT) {
+                local->page = (local->page > 0) ? local->page - 1 : 0;
+            } else if(!local->has_pending_data && i->event_data.action == ACT_RIGHT) {
+                local->page = (local->page < MAX_PAGES) ? local->page + 1 : MAX_PAGES;
             }
-        } while((i = i->next));
+        }
     }
-    controller_free_chain(p1);
+    ctrl_event_queue_free(&p1);
 }
 
 void scoreboard_render_overlay(scene *scene) {
@@ -185,18 +185,15 @@ void vs_handle_action(scene *scene, int action) {
 
 void vs_dynamic_tick(scene *scene, int paused) {
     game_player *player1 = game_state_get_player(scene->gs, 0);
-    ctrl_event *i = NULL;
+    ctrl_event *i;
     // Handle extra controller inputs
-    i = player1->ctrl->extra_events;
-    if(i) {
-        do {
-            if(i->type == EVENT_TYPE_ACTION) {
-                vs_handle_action(scene, i->event_data.action);
-            } else if(i->type == EVENT_TYPE_CLOSE) {
-                game_state_set_next(scene->gs, SCENE_MENU);
-                return;
-            }
-        } while((i = i->next));
+    for(unsigned int n = 0; (i = ctrl_event_queue_get(&player1->ctrl->extra_events, n)) != NULL; n++) {
+        if(i->type == EVENT_TYPE_ACTION) {
+            vs_handle_action(scene, i->event_data.action);
+        } else if(i->type == EVENT_TYPE_CLOSE) {
+            game_state_set_next(scene->gs, SCENE_MENU);
+            return;
+        }
     }
 }
 
@@ -211,37 +208,36 @@ void vs_static_tick(scene *scene, int paused) {
 
 void vs_input_tick(scene *scene) {
     vs_local *local = scene->userdata;
-    ctrl_event *p1 = NULL, *i;
+    ctrl_event_queue p1;
+    ctrl_event *i;
+    ctrl_event_queue_init(&p1);
     game_player *player1 = game_state_get_player(scene->gs, 0);
     controller_poll(player1->ctrl, &p1);
-    i = p1;
-    if(i) {
-        do {
-            if(i->type == EVENT_TYPE_ACTION) {
-                if(i->event_data.action == ACT_ESC) {
-                    if(dialog_is_visible(&local->too_pathetic_dialog)) {
-                        dialog_event(&local->too_pathetic_dialog, i->event_data.action);
-                    } else if(dialog_is_visible(&local->quit_dialog)) {
-                        dialog_event(&local->quit_dialog, i->event_data.action);
-                    } else if(vs_is_singleplayer(scene) && player1->sp_wins != 0 && !player1->chr) {
-                        // there's an active singleplayer campaign, confirm quitting
-                        dialog_show(&local->quit_dialog, 1);
+    for(unsigned int n = 0; (i = ctrl_event_queue_get(&p1, n)) != NULL; n++) {
+        if(i->type == EVENT_TYPE_ACTION) {
+            if(i->event_data.action == ACT_ESC) {
+                if(dialog_is_visible(&local->too_pathetic_dialog)) {
+                    dialog_event(&local->too_pathetic_dialog, i->event_data.action);
+                } else if(dialog_is_visible(&local->quit_dialog)) {
+                    dialog_event(&local->quit_dialog, i->event_data.action);
+                } else if(vs_is_singleplayer(scene) && player1->sp_wins != 0 && !player1->chr) {
+                    // there's an active singleplayer campaign, confirm quitting
+                    dialog_show(&local->quit_dialog, 1);
+                } else {
+                    if(player1->chr) {
+                        game_state_set_next(scene->gs, SCENE_MECHLAB);
                     } else {
-                        if(player1->chr) {
-                            game_state_set_next(scene->gs, SCENE_MECHLAB);
-                        } else {
-                            game_state_set_next(scene->gs, SCENE_MELEE);
-                        }
+                        game_state_set_next(scene->gs, SCENE_MELEE);
                     }
-                } else {
-                    vs_handle_action(scene, i->event_data.action);
                 }
-            } else if(i->type == EVENT_TYPE_CLOSE) {
-                game_state_set_next(scene->gs, SCENE_MENU);
+            } else {
+                vs_handle_action(scene, i->event_data.action);
             }
-        } while((i = i->next));
+        } else if(i->type == EVENT_TYPE_CLOSE) {
+            game_state_set_next(scene->gs, SCENE_MENU);
+        }
     }
-    controller_free_chain(p1);
+    ctrl_event_queue_free(&p1);
 }
 
 void vs_render(scene *scene) {
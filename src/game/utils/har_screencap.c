@@ -1,6 +1,44 @@
 #include "game/utils/har_screencap.h"
+#include "game/game_player.h"
+#include "game/game_state.h"
+#include "game/protos/scene.h"
 #include "video/video.h"
 
+// Writes a palette color to an RGBA pixel. Player 2 HAR colors are shifted by pal_offset, like in surface_to_rgba.
+static void put_color(char *dst, const screen_palette *pal, uint8_t idx, uint8_t pal_offset) {
+    if(idx < 48) {
+        idx += pal_offset;
+    }
+    dst[0] = pal->data[idx][0];
+    dst[1] = pal->data[idx][1];
+    dst[2] = pal->data[idx][2];
+    dst[3] = 0xFF;
+}
+
+// Draws the current sprite of a HAR on the capture, cap_x and cap_y being the capture position on screen
+static void draw_har(surface *cap, const screen_palette *pal, const object *obj, int cap_x, int cap_y) {
+    if(obj == NULL || obj->cur_sprite == NULL || obj->cur_sprite->data->type != SURFACE_TYPE_PALETTE) {
+        return;
+    }
+    const surface *sur = obj->cur_sprite->data;
+    int x, y, flipmode;
+    object_get_render_pos(obj, &x, &y, &flipmode);
+    for(int sy = 0; sy < sur->h; sy++) {
+        int dy = y - cap_y + ((flipmode & FLIP_VERTICAL) ? sur->h - 1 - sy : sy);
+        if(dy < 0 || dy >= cap->h) {
+            continue;
+        }
+        for(int sx = 0; sx < sur->w; sx++) {
+            int dx = x - cap_x + ((flipmode & FLIP_HORIZONTAL) ? sur->w - 1 - sx : sx);
+            int offset = sy * sur->w + sx;
+            if(dx < 0 || dx >= cap->w || !surface_stencil_get(sur, offset)) {
+                continue;
+            }
+            put_color(cap->data + (dy * cap->w + dx) * 4, pal, sur->data[offset], obj->pal_offset);
+        }
+    }
+}
+
 void har_screencaps_create(har_screencaps *caps) {
     for(int i = 0; i < 2; i++) {
         caps->ok[i] = 0;
@@ -26,6 +64,11 @@ void har_screencaps_capture(har_screencaps *caps, object *obj, int id) {
         caps->ok[id] = 0;
     }
 
+    // Nobody looks at the captures of simulated games, so don't spend time on them
+    if(obj->gs->headless || !video_output_enabled()) {
+        return;
+    }
+
     // Position
     int x = (object_px(obj) - object_w(obj) / 2) - (SCREENCAP_W - object_w(obj)) / 2;
     int y = (object_py(obj) - object_h(obj)) - (SCREENCAP_H - object_h(obj)) / 2;
@@ -38,9 +81,30 @@ void har_screencaps_capture(har_screencaps *caps, object *obj, int id) {
     if(y + SCREENCAP_H >= NATIVE_H)
         y = NATIVE_H - SCREENCAP_H;
 
-    // Capture
-    int ret = video_area_capture(&caps->cap[id], x, y, SCREENCAP_W, SCREENCAP_H);
-    if(ret == 0) {
-        caps->ok[id] = 1;
+    // Rebuild the area from the arena background and the HARs instead of reading it back from the renderer,
+    // which would stall rendering in the middle of the fight.
+    const screen_palette *pal = video_get_pal_ref();
+    if(pal == NULL) {
+        return;
+    }
+    surface *cap = &caps->cap[id];
+    surface_create(cap, SURFACE_TYPE_RGBA, SCREENCAP_W, SCREENCAP_H);
+    const surface *bg = &game_state_get_scene(obj->gs)->bk_data.background;
+    if(bg->type == SURFACE_TYPE_PALETTE && bg->data != NULL) {
+        for(int cy = 0; cy < SCREENCAP_H && y + cy < bg->h; cy++) {
+            for(int cx = 0; cx < SCREENCAP_W && x + cx < bg->w; cx++) {
+                put_color(cap->data + (cy * SCREENCAP_W + cx) * 4, pal, bg->data[(y + cy) * bg->w + x + cx], 0);
+            }
+        }
+    }
+
+    // The captured HAR goes on top of the other one
+    for(int i = 0; i < 2; i++) {
+        object *har = game_state_get_player(obj->gs, i)->har;
+        if(har != obj) {
+            draw_har(cap, pal, har, x, y);
+        }
     }
+    draw_har(cap, pal, obj, x, y);
+    caps->ok[id] = 1;
 }
@@ -0,0 +1,223 @@
+#include "game/utils/keyframes.h"
+#include "game/game_state.h"
+#include "game/scenes/arena.h"
+#include "utils/allocator.h"
+#include "utils/log.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define KEYFRAMES_MAGIC "OMFKEYS"
+#define KEYFRAMES_VERSION 2
+
+// Upper limit for a single serialized game state in a keyframe file
+#define KEYFRAMES_MAX_STATE_LEN (1024 * 1024)
+
+// Keyframes hold raw game state, so files from other builds can't be trusted even if the format matches
+#define KEYFRAMES_ENGINE_VERSION ((V_MAJOR << 16) | (V_MINOR << 8) | V_PATCH)
+
+void keyframes_create(keyframes *kf, unsigned int interval, uint32_t rec_hash, uint32_t rec_moves) {
+    vector_create(&kf->frames, sizeof(keyframe));
+    kf->interval = (interval > 0) ? interval : KEYFRAME_INTERVAL;
+    kf->stored = 0;
+    kf->rec_hash = rec_hash;
+    kf->rec_moves = rec_moves;
+    kf->recording = 1;
+}
+
+void keyframes_free(keyframes *kf) {
+    iterator it;
+    keyframe *frame;
+    vector_iter_begin(&kf->frames, &it);
+    while((frame = iter_next(&it)) != NULL) {
+        serial_free(&frame->state);
+    }
+    vector_free(&kf->frames);
+}
+
+void keyframes_record(keyframes *kf, game_state *gs) {
+    unsigned int tick = game_state_get_tick(gs);
+    if(!kf->recording || tick % kf->interval != 0) {
+        return;
+    }
+
+    // Keyframes are only ever appended. When replaying a part that already has them, keep the old ones.
+    unsigned int count = vector_size(&kf->frames);
+    if(count > 0 && ((keyframe *)vector_get(&kf->frames, count - 1))->tick >= tick) {
+        return;
+    }
+
+    serial state;
+    serial_create(&state);
+    game_state_serialize(gs, &state);
+    arena_serialize(game_state_get_scene(gs), &state);
+    keyframes_add(kf, tick, &state);
+}
+
+void keyframes_stop_recording(keyframes *kf) {
+    kf->recording = 0;
+}
+
+void keyframes_add(keyframes *kf, unsigned int tick, serial *state) {
+    keyframe frame;
+    frame.tick = tick;
+    frame.state = *state;
+    vector_append(&kf->frames, &frame);
+}
+
+int keyframes_is_dirty(const keyframes *kf) {
+    return vector_size(&kf->frames) != kf->stored;
+}
+
+keyframe *keyframes_find(const keyframes *kf, unsigned int tick) {
+    unsigned int lo = 0;
+    unsigned int hi = vector_size(&kf->frames);
+    while(lo < hi) {
+        unsigned int mid = lo + (hi - lo) / 2;
+        if(((keyframe *)vector_get(&kf->frames, mid))->tick <= tick) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return (lo > 0) ? vector_get(&kf->frames, lo - 1) : NULL;
+}
+
+static void write_u32(FILE *fp, uint32_t value) {
+    for(int i = 0; i < 4; i++) {
+        fputc((value >> (i * 8)) & 0xFF, fp);
+    }
+}
+
+static int read_u32(FILE *fp, uint32_t *value) {
+    *value = 0;
+    for(int i = 0; i < 4; i++) {
+        int c = fgetc(fp);
+        if(c == EOF) {
+            return 1;
+        }
+        *value |= (uint32_t)c << (i * 8);
+    }
+    return 0;
+}
+
+int keyframes_save(keyframes *kf, const char *filename) {
+    FILE *fp = fopen(filename, "wb");
+    if(fp == NULL) {
+        PERROR("Unable to open keyframe file %s for writing", filename);
+        return 1;
+    }
+    fwrite(KEYFRAMES_MAGIC, 1, strlen(KEYFRAMES_MAGIC), fp);
+    write_u32(fp, KEYFRAMES_VERSION);
+    write_u32(fp, KEYFRAMES_ENGINE_VERSION);
+    write_u32(fp, GAME_STATE_FORMAT_VERSION);
+    write_u32(fp, kf->rec_hash);
+    write_u32(fp, kf->rec_moves);
+    write_u32(fp, kf->interval);
+    write_u32(fp, vector_size(&kf->frames));
+
+    iterator it;
+    keyframe *frame;
+    vector_iter_begin(&kf->frames, &it);
+    while((frame = iter_next(&it)) != NULL) {
+        write_u32(fp, frame->tick);
+        write_u32(fp, serial_len(&frame->state));
+        fwrite(frame->state.data, 1, serial_len(&frame->state), fp);
+    }
+
+    kf->stored = vector_size(&kf->frames);
+    if(ferror(fp)) {
+        PERROR("Unable to write keyframe file %s", filename);
+        fclose(fp);
+        return 1;
+    }
+    fclose(fp);
+    return 0;
+}
+
+int keyframes_load(keyframes *kf, const char *filename) {
+    char magic[sizeof(KEYFRAMES_MAGIC)];
+    uint32_t version, engine_version, format_version, rec_hash, rec_moves, interval, count, tick, len;
+    char *buf = NULL;
+    keyframe frame;
+    long file_size;
+
+    FILE *fp = fopen(filename, "rb");
+    if(fp == NULL) {
+        return 1;
+    }
+    if(fseek(fp, 0, SEEK_END) != 0 || (file_size = ftell(fp)) < 0 || fseek(fp, 0, SEEK_SET) != 0) {
+        PERROR("Unable to read keyframe file %s", filename);
+        goto error_0;
+    }
+    if(fread(magic, 1, strlen(KEYFRAMES_MAGIC), fp) != strlen(KEYFRAMES_MAGIC) ||
+       memcmp(magic, KEYFRAMES_MAGIC, strlen(KEYFRAMES_MAGIC)) != 0) {
+        PERROR("%s is not a keyframe file", filename);
+        goto error_0;
+    }
+    if(read_u32(fp, &version) || version != KEYFRAMES_VERSION || read_u32(fp, &engine_version) ||
+       read_u32(fp, &format_version) || read_u32(fp, &rec_hash) || read_u32(fp, &rec_moves) ||
+       read_u32(fp, &interval) || interval == 0 || read_u32(fp, &count)) {
+        PERROR("Unsupported keyframe file %s", filename);
+        goto error_0;
+    }
+    if(engine_version != KEYFRAMES_ENGINE_VERSION || format_version != GAME_STATE_FORMAT_VERSION) {
+        INFO("Ignoring keyframe file %s, it was made by another version of the game", filename);
+        goto error_0;
+    }
+    if(rec_hash != kf->rec_hash || rec_moves != kf->rec_moves) {
+        INFO("Ignoring keyframe file %s, it was made for another recording", filename);
+        goto error_0;
+    }
+
+    // Loading replaces the keyframes, but not the decision whether to record more of them
+    int recording = kf->recording;
+    keyframes_free(kf);
+    keyframes_create(kf, interval, rec_hash, rec_moves);
+    kf->recording = recording;
+    for(uint32_t i = 0; i < count; i++) {
+        if(read_u32(fp, &tick) || read_u32(fp, &len)) {
+            goto error_1;
+        }
+        // A corrupt length must not turn into a huge allocation
+        if(len > KEYFRAMES_MAX_STATE_LEN || (long)len > file_size - ftell(fp)) {
+            goto error_1;
+        }
+        buf = omf_realloc(buf, len > 0 ? len : 1);
+        if(fread(buf, 1, len, fp) != len) {
+            goto error_1;
+        }
+        frame.tick = tick;
+        serial_create_from(&frame.state, buf, len);
+        vector_append(&kf->frames, &frame);
+    }
+    omf_free(buf);
+    kf->stored = vector_size(&kf->frames);
+    fclose(fp);
+    return 0;
+
+error_1:
+    // Keep what was read correctly, a damaged file is still useful.
+    PERROR("Keyframe file %s is truncated or corrupt, using %u keyframes", filename, vector_size(&kf->frames));
+    omf_free(buf);
+    fclose(fp);
+    return 0;
+
+error_0:
+    fclose(fp);
+    return 1;
+}
+
+uint32_t keyframes_hash_file(const char *filename) {
+    FILE *fp = fopen(filename, "rb");
+    if(fp == NULL) {
+        return 0;
+    }
+    uint32_t hash = 2166136261u;
+    int c;
+    while((c = fgetc(fp)) != EOF) {
+        hash = (hash ^ (uint8_t)c) * 16777619u;
+    }
+    fclose(fp);
+    return hash;
+}
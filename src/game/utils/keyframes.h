@@ -0,0 +1,89 @@
+#ifndef KEYFRAMES_H
+#define KEYFRAMES_H
+
+#include "game/utils/serial.h"
+#include "utils/vector.h"
+#include <stdint.h>
+
+// Default number of game ticks between keyframes
+#define KEYFRAME_INTERVAL 250
+
+typedef struct game_state_t game_state;
+
+typedef struct keyframe_t {
+    unsigned int tick;
+    serial state; // From game_state_serialize(), followed by arena_serialize()
+} keyframe;
+
+/**
+ * Periodic game state snapshots for a replay. Used to seek in a recording without
+ * re-simulating it from the start.
+ */
+typedef struct keyframes_t {
+    vector frames; // keyframe, in ascending tick order
+    unsigned int interval;
+    unsigned int stored; // Number of keyframes that are already in the sidecar file
+    uint32_t rec_hash;   // Recording the keyframes belong to, see keyframes_hash_file()
+    uint32_t rec_moves;  // Number of moves in the recording
+    int recording;       // Cleared once a keyframe is restored, see keyframes_stop_recording()
+} keyframes;
+
+/**
+ * Creates an empty set of keyframes for a recording. The hash and the move count are stored in the
+ * sidecar file, and keyframes_load() only accepts files made for the same recording.
+ */
+void keyframes_create(keyframes *kf, unsigned int interval, uint32_t rec_hash, uint32_t rec_moves);
+void keyframes_free(keyframes *kf);
+
+/**
+ * Takes a snapshot of the game state if the current tick is on the keyframe interval
+ * and no keyframe exists for it yet. Does nothing once recording has been stopped.
+ */
+void keyframes_record(keyframes *kf, game_state *gs);
+
+/**
+ * Stops recording new keyframes. A restored keyframe does not bring back everything in the game state,
+ * so keyframes are only taken while a recording is played straight through from the start.
+ */
+void keyframes_stop_recording(keyframes *kf);
+
+/**
+ * Adds a keyframe after the last one. The keyframes take ownership of the state.
+ */
+void keyframes_add(keyframes *kf, unsigned int tick, serial *state);
+
+/**
+ * Tells whether there are keyframes that have not been saved or loaded from a file.
+ */
+int keyframes_is_dirty(const keyframes *kf);
+
+/**
+ * Finds the last keyframe at or before the given tick.
+ *
+ * \return Keyframe, or NULL if there is none.
+ */
+keyframe *keyframes_find(const keyframes *kf, unsigned int tick);
+
+/**
+ * Writes all keyframes to a sidecar file next to the recording.
+ *
+ * \return 0 on success, 1 on error.
+ */
+int keyframes_save(keyframes *kf, const char *filename);
+
+/**
+ * Reads keyframes from a sidecar file written by keyframes_save(). Existing keyframes are replaced.
+ * Files made for another recording, engine version or game state format are ignored.
+ *
+ * \return 0 on success, 1 on error or if the file was ignored.
+ */
+int keyframes_load(keyframes *kf, const char *filename);
+
+/**
+ * Hashes the contents of a file, to tell which recording a sidecar file was made for.
+ *
+ * \return FNV-1a hash of the file, or 0 if it could not be read.
+ */
+uint32_t keyframes_hash_file(const char *filename);
+
+#endif // KEYFRAMES_H
@@ -0,0 +1,132 @@
+#include "game/utils/kinematics.h"
+#include "game/objects/arena_constraints.h"
+#include "game/protos/object.h"
+#include "utils/allocator.h"
+
+#define KINEMATICS_INITIAL_CAPACITY 64
+#define KINEMATICS_DAMPEN 0.4f
+#define IS_ZERO(n) (n < 0.1 && n > -0.1)
+
+void kinematics_create(kinematics *k) {
+    k->count = 0;
+    k->capacity = 0;
+    k->objs = NULL;
+    k->pos_x = NULL;
+    k->pos_y = NULL;
+    k->vel_x = NULL;
+    k->vel_y = NULL;
+    k->gravity = NULL;
+    k->resting = NULL;
+    k->settled = NULL;
+}
+
+void kinematics_free(kinematics *k) {
+    omf_free(k->objs);
+    omf_free(k->pos_x);
+    omf_free(k->pos_y);
+    omf_free(k->vel_x);
+    omf_free(k->vel_y);
+    omf_free(k->gravity);
+    omf_free(k->resting);
+    omf_free(k->settled);
+    k->count = 0;
+    k->capacity = 0;
+}
+
+void kinematics_clear(kinematics *k) {
+    k->count = 0;
+}
+
+static void kinematics_grow(kinematics *k) {
+    unsigned int capacity = (k->capacity == 0) ? KINEMATICS_INITIAL_CAPACITY : k->capacity * 2;
+    k->objs = omf_realloc(k->objs, capacity * sizeof(object *));
+    k->pos_x = omf_realloc(k->pos_x, capacity * sizeof(int32_t));
+    k->pos_y = omf_realloc(k->pos_y, capacity * sizeof(int32_t));
+    k->vel_x = omf_realloc(k->vel_x, capacity * sizeof(float));
+    k->vel_y = omf_realloc(k->vel_y, capacity * sizeof(float));
+    k->gravity = omf_realloc(k->gravity, capacity * sizeof(float));
+    k->resting = omf_realloc(k->resting, capacity * sizeof(uint8_t));
+    k->settled = omf_realloc(k->settled, capacity * sizeof(uint8_t));
+    k->capacity = capacity;
+}
+
+void kinematics_add(kinematics *k, object *obj) {
+    if(k->count >= k->capacity) {
+        kinematics_grow(k);
+    }
+    // Same as object_move(); animation may ask for the object to be held in place.
+    if(obj->sprite_state.disable_gravity) {
+        object_set_vel(obj, vec2f_create(0, 0));
+    }
+    vec2i pos = object_get_pos(obj);
+    unsigned int i = k->count++;
+    k->objs[i] = obj;
+    k->pos_x[i] = pos.x;
+    k->pos_y[i] = pos.y;
+    k->vel_x[i] = obj->vel.x;
+    k->vel_y[i] = obj->vel.y;
+    k->gravity[i] = obj->gravity;
+    k->resting[i] = object_is_rewind_tag_disabled(obj) > 0;
+    k->settled[i] = 0;
+}
+
+void kinematics_integrate(kinematics *k) {
+    int32_t *restrict pos_x = k->pos_x;
+    int32_t *restrict pos_y = k->pos_y;
+    float *restrict vel_x = k->vel_x;
+    float *restrict vel_y = k->vel_y;
+    const float *restrict gravity = k->gravity;
+    const uint8_t *restrict resting = k->resting;
+    uint8_t *restrict settled = k->settled;
+    unsigned int count = k->count;
+
+    // Everything is computed for every entry and then selected, so that the loop
+    // has no early exits and the compiler is free to vectorize it.
+    for(unsigned int i = 0; i < count; i++) {
+        float g = gravity[i];
+        float vx = vel_x[i];
+        float vy = vel_y[i] + g;
+        int32_t px = pos_x[i] + vx;
+        int32_t py = pos_y[i] + vy;
+
+        if(px < ARENA_LEFT_WALL) {
+            px = ARENA_LEFT_WALL;
+            vx = -vx * KINEMATICS_DAMPEN;
+        }
+        if(px > ARENA_RIGHT_WALL) {
+            px = ARENA_RIGHT_WALL;
+            vx = -vx * KINEMATICS_DAMPEN;
+        }
+        if(py > ARENA_FLOOR) {
+            py = ARENA_FLOOR;
+            vy = -vy * KINEMATICS_DAMPEN;
+            vx = vx * KINEMATICS_DAMPEN;
+        }
+        if(IS_ZERO(vx)) {
+            vx = 0;
+        }
+
+        int moving = !resting[i];
+        pos_x[i] = moving ? px : pos_x[i];
+        pos_y[i] = moving ? py : pos_y[i];
+        vel_x[i] = moving ? vx : vel_x[i];
+        vel_y[i] = moving ? vy : vel_y[i];
+        settled[i] = moving && py >= (ARENA_FLOOR - 5) && IS_ZERO(vx) && vy < g * 1.1 && vy > g * -1.1;
+    }
+}
+
+void kinematics_store(kinematics *k) {
+    for(unsigned int i = 0; i < k->count; i++) {
+        if(k->resting[i]) {
+            continue;
+        }
+        object *obj = k->objs[i];
+        object_set_pos(obj, vec2i_create(k->pos_x[i], k->pos_y[i]));
+        object_set_vel(obj, vec2f_create(k->vel_x[i], k->vel_y[i]));
+
+        // If object is at rest, just halt animation
+        if(k->settled[i]) {
+            object_disable_rewind_tag(obj, 1);
+        }
+    }
+}
@@ -0,0 +1,52 @@
+#ifndef KINEMATICS_H
+#define KINEMATICS_H
+
+#include <stdint.h>
+
+typedef struct object_t object;
+
+/**
+ * Structure-of-arrays store for passive, particle-like objects (scrap, oil drops).
+ *
+ * Particles have no move callback. Instead the move pass gathers their state here,
+ * integrates everything in one loop and writes the results back to the objects.
+ * The integration matches the old per-object scrap move exactly, including the
+ * integer truncation of positions, so replays and netplay stay deterministic.
+ */
+typedef struct kinematics_t {
+    unsigned int count;
+    unsigned int capacity;
+    object **objs;
+    int32_t *pos_x;
+    int32_t *pos_y;
+    float *vel_x;
+    float *vel_y;
+    float *gravity;
+    uint8_t *resting; // Was at rest before this tick, not moved
+    uint8_t *settled; // Came to rest during this tick
+} kinematics;
+
+void kinematics_create(kinematics *k);
+void kinematics_free(kinematics *k);
+
+/**
+ * Forget all gathered objects. Allocated memory is kept for the next tick.
+ */
+void kinematics_clear(kinematics *k);
+
+/**
+ * Gather the position, velocity and gravity of an object into the store.
+ */
+void kinematics_add(kinematics *k, object *obj);
+
+/**
+ * Move all gathered objects by one tick, bouncing them off the arena walls and floor.
+ */
+void kinematics_integrate(kinematics *k);
+
+/**
+ * Write the integrated state back to the gathered objects.
+ */
+void kinematics_store(kinematics *k);
+
+#endif // KINEMATICS_H
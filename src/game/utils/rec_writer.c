@@ -0,0 +1,144 @@
+#include "game/utils/rec_writer.h"
+#include "formats/error.h"
+#include "utils/allocator.h"
+#include "utils/log.h"
+#include "utils/ringbuffer.h"
+#include "utils/vector.h"
+#include <SDL.h>
+#include <stdatomic.h>
+
+// Chunks waiting for the writer thread. When full, chunks wait on the game thread instead.
+#define REC_WRITER_QUEUE_SIZE 64
+
+// How long the writer thread sleeps at most if nobody wakes it up.
+#define REC_WRITER_WAIT_MS 500
+
+typedef struct rec_chunk_t {
+    unsigned int count;
+    unsigned int first_tick;
+    sd_rec_move moves[REC_WRITER_CHUNK_SIZE];
+} rec_chunk;
+
+struct rec_writer_t {
+    sd_rec_stream *stream;
+    rec_chunk *current; // Being filled by the game thread
+    vector backlog;     // Full chunks that did not fit into the queue yet (game thread only)
+    unsigned int backlog_first;
+    ringbuffer queue;   // Full chunks for the writer thread
+    atomic_bool running;
+    SDL_Thread *thread;
+    SDL_sem *wake;
+};
+
+static void rec_writer_drain(rec_writer *writer) {
+    rec_chunk *chunk;
+    while(ringbuffer_pop(&writer->queue, &chunk)) {
+        if(sd_rec_stream_write(writer->stream, chunk->moves, chunk->count) != SD_SUCCESS) {
+            PERROR("Unable to write recording");
+        }
+        omf_free(chunk);
+    }
+}
+
+static int rec_writer_thread(void *userdata) {
+    rec_writer *writer = userdata;
+    while(atomic_load(&writer->running)) {
+        rec_writer_drain(writer);
+        SDL_SemWaitTimeout(writer->wake, REC_WRITER_WAIT_MS);
+    }
+    return 0;
+}
+
+// Moves any waiting chunks to the writer thread, in order.
+static void rec_writer_submit_backlog(rec_writer *writer) {
+    rec_chunk **chunk;
+    while((chunk = vector_get(&writer->backlog, writer->backlog_first)) != NULL &&
+          ringbuffer_push(&writer->queue, chunk)) {
+        writer->backlog_first++;
+    }
+    if(writer->backlog_first == vector_size(&writer->backlog)) {
+        vector_clear(&writer->backlog);
+        writer->backlog_first = 0;
+    }
+    SDL_SemPost(writer->wake);
+}
+
+rec_writer *rec_writer_open(const sd_rec_file *rec, const char *filename) {
+    sd_rec_stream *stream = sd_rec_stream_open(rec, filename);
+    if(stream == NULL) {
+        PERROR("Unable to open %s for recording", filename);
+        return NULL;
+    }
+    rec_writer *writer = omf_calloc(1, sizeof(rec_writer));
+    writer->stream = stream;
+    vector_create(&writer->backlog, sizeof(rec_chunk *));
+    ringbuffer_create(&writer->queue, REC_WRITER_QUEUE_SIZE, sizeof(rec_chunk *));
+    atomic_init(&writer->running, true);
+
+    // If the thread cannot be started, chunks are kept until the recording is closed.
+    writer->wake = SDL_CreateSemaphore(0);
+    writer->thread = SDL_CreateThread(rec_writer_thread, "rec_writer", writer);
+    if(writer->thread == NULL) {
+        PERROR("Unable to start recording writer thread: %s", SDL_GetError());
+    }
+    return writer;
+}
+
+void rec_writer_flush(rec_writer *writer) {
+    if(writer->current == NULL) {
+        return;
+    }
+    vector_append(&writer->backlog, &writer->current);
+    writer->current = NULL;
+    if(writer->thread != NULL) {
+        rec_writer_submit_backlog(writer);
+    }
+}
+
+void rec_writer_tick(rec_writer *writer, unsigned int tick) {
+    if(writer->current != NULL && tick - writer->current->first_tick >= REC_WRITER_FLUSH_TICKS) {
+        rec_writer_flush(writer);
+    }
+}
+
+void rec_writer_append(rec_writer *writer, const sd_rec_move *move) {
+    if(writer->current == NULL) {
+        writer->current = omf_calloc(1, sizeof(rec_chunk));
+        writer->current->first_tick = move->tick;
+    }
+    writer->current->moves[writer->current->count++] = *move;
+    if(writer->current->count == REC_WRITER_CHUNK_SIZE) {
+        rec_writer_flush(writer);
+    } else {
+        rec_writer_tick(writer, move->tick);
+    }
+}
+
+void rec_writer_close(rec_writer *writer) {
+    if(writer == NULL) {
+        return;
+    }
+    if(writer->thread != NULL) {
+        atomic_store(&writer->running, false);
+        SDL_SemPost(writer->wake);
+        SDL_WaitThread(writer->thread, NULL);
+        writer->thread = NULL;
+    }
+
+    // The writer thread is gone; write the rest from here, in order.
+    rec_writer_drain(writer);
+    rec_writer_flush(writer);
+    rec_chunk **chunk;
+    for(unsigned int i = writer->backlog_first; (chunk = vector_get(&writer->backlog, i)) != NULL; i++) {
+        if(sd_rec_stream_write(writer->stream, (*chunk)->moves, (*chunk)->count) != SD_SUCCESS) {
+            PERROR("Unable to write recording");
+        }
+        omf_free(*chunk);
+    }
+
+    sd_rec_stream_close(writer->stream);
+    SDL_DestroySemaphore(writer->wake);
+    ringbuffer_free(&writer->queue);
+    vector_free(&writer->backlog);
+    omf_free(writer);
+}
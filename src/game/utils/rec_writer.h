@@ -0,0 +1,48 @@
+#ifndef REC_WRITER_H
+#define REC_WRITER_H
+
+#include "formats/rec.h"
+
+// Moves per chunk handed to the writer thread
+#define REC_WRITER_CHUNK_SIZE 256
+
+// A partially filled chunk is handed over after this many ticks, so that
+// a crash loses at most this much of the recording.
+#define REC_WRITER_FLUSH_TICKS 200
+
+typedef struct rec_writer_t rec_writer;
+
+/**
+ * Opens a REC file for recording and starts its writer thread. The header is taken
+ * from rec and written immediately.
+ *
+ * Moves are collected into fixed size chunks on the game thread; full chunks are
+ * written and flushed to disk by the writer thread. The game thread never waits
+ * for the disk.
+ *
+ * \return Writer, or NULL if the file could not be opened.
+ */
+rec_writer *rec_writer_open(const sd_rec_file *rec, const char *filename);
+
+/**
+ * Appends a move to the recording. Amortized O(1), never blocks.
+ */
+void rec_writer_append(rec_writer *writer, const sd_rec_move *move);
+
+/**
+ * Hands over the current chunk if it has been waiting for REC_WRITER_FLUSH_TICKS.
+ * Call once per game tick, so that quiet periods still reach the disk.
+ */
+void rec_writer_tick(rec_writer *writer, unsigned int tick);
+
+/**
+ * Hands over the moves collected so far, even if the current chunk is not full.
+ */
+void rec_writer_flush(rec_writer *writer);
+
+/**
+ * Writes out everything that is left, stops the writer thread and closes the file.
+ */
+void rec_writer_close(rec_writer *writer);
+
+#endif // REC_WRITER_H
@@ -1,6 +1,7 @@
 #include "game/utils/settings.h"
 #include "controller/controller.h"
 #include "utils/allocator.h"
+#include "utils/compat.h"
 #include "utils/config.h"
 #include "utils/log.h"
 #include <stddef.h> //offsetof
@@ -23,6 +24,7 @@
 
 static settings _settings;
 static const char *settings_path;
+static THREAD_LOCAL settings *bound_settings = NULL;
 
 typedef enum
 {
@@ -57,17 +59,17 @@ const field f_video[] = {
     F_BOOL(settings_video, vsync, 0),        F_BOOL(settings_video, fullscreen, 0),
     F_INT(settings_video, scaling, 0),       F_BOOL(settings_video, instant_console, 0),
     F_BOOL(settings_video, crossfade_on, 1), F_STRING(settings_video, scaler, "Nearest"),
-    F_INT(settings_video, scale_factor, 1),
+    F_INT(settings_video, scale_factor, 1),  F_INT(settings_video, shadows, SHADOWS_ON),
 };
 
 const field f_sound[] = {F_BOOL(settings_sound, music_mono, 0), F_INT(settings_sound, sound_vol, 5),
                          F_INT(settings_sound, music_vol, 5), F_INT(settings_sound, music_frequency, 48000),
-                         F_INT(settings_sound, music_resampler, 1)};
+                         F_INT(settings_sound, music_resampler, 1), F_INT(settings_sound, music_buffer_ms, 100)};
 
 const field f_gameplay[] = {F_INT(settings_gameplay, speed, 5),       F_INT(settings_gameplay, fight_mode, 0),
                             F_INT(settings_gameplay, power1, 5),      F_INT(settings_gameplay, power2, 5),
                             F_BOOL(settings_gameplay, hazards_on, 1), F_INT(settings_gameplay, difficulty, 1),
-                            F_INT(settings_gameplay, rounds, 1)};
+                            F_INT(settings_gameplay, rounds, 1),      F_BOOL(settings_gameplay, ai_lookahead, 0)};
 
 const field f_tournament[] = {
     F_STRING(settings_tournament, last_name, ""),
@@ -258,5 +260,36 @@ void settings_free() {
 }
 
 settings *settings_get() {
-    return &_settings;
+    return (bound_settings != NULL) ? bound_settings : &_settings;
+}
+
+settings *settings_bind(settings *s) {
+    settings *old = bound_settings;
+    bound_settings = s;
+    return old;
+}
+
+settings *settings_copy(const settings *src) {
+    settings *dst = omf_calloc(1, sizeof(settings));
+    memcpy(dst, src, sizeof(settings));
+    // The field tables point into the global settings, use them for the offsets of the copy
+    for(int i = 0; i < sizeof(struct_to_fields) / sizeof(struct_to_field); i++) {
+        const struct_to_field *s2f = &struct_to_fields[i];
+        void *st = (char *)dst + ((char *)s2f->_struct - (char *)&_settings);
+        for(int k = 0; k < s2f->num_fields; k++) {
+            if(s2f->fields[k].type == TYPE_STRING && *fieldstr(st, s2f->fields[k].offset) != NULL) {
+                char **str = fieldstr(st, s2f->fields[k].offset);
+                *str = strdup(*str);
+            }
+        }
+    }
+    return dst;
+}
+
+void settings_free_copy(settings *s) {
+    for(int i = 0; i < sizeof(struct_to_fields) / sizeof(struct_to_field); i++) {
+        const struct_to_field *s2f = &struct_to_fields[i];
+        settings_free_strings((char *)s + ((char *)s2f->_struct - (char *)&_settings), s2f->fields, s2f->num_fields);
+    }
+    omf_free(s);
 }
@@ -15,6 +15,13 @@ typedef enum
     KNOCK_DOWN_BOTH
 } knock_down_mode;
 
+typedef enum
+{
+    SHADOWS_OFF = 0,
+    SHADOWS_ON,
+    SHADOWS_FADE
+} shadow_mode;
+
 typedef enum
 {
     PUNCHING_BAG,
@@ -30,6 +37,7 @@ typedef struct {
     int music_mono;
     int music_frequency;
     int music_resampler;
+    int music_buffer_ms;
     int sound_vol;
     int music_vol;
 } settings_sound;
@@ -44,6 +52,7 @@ typedef struct {
     int crossfade_on;
     char *scaler;
     int scale_factor;
+    int shadows;
 } settings_video;
 
 typedef struct {
@@ -54,6 +63,7 @@ typedef struct {
     int hazards_on;
     int difficulty;
     int rounds;
+    int ai_lookahead; // 1 to use the lookahead AI for the CPU opponent
 } settings_gameplay;
 
 typedef struct {
@@ -130,4 +140,22 @@ void settings_save();
 
 settings *settings_get();
 
+/**
+ * Makes settings_get() on the calling thread return the given settings, e.g. a snapshot
+ * owned by a simulation. NULL selects the global settings again.
+ *
+ * \return Previously bound settings, or NULL if the global settings were in use.
+ */
+settings *settings_bind(settings *s);
+
+/**
+ * Makes a snapshot of settings, with copies of all the strings. Free with settings_free_copy().
+ */
+settings *settings_copy(const settings *src);
+
+/**
+ * Frees a snapshot made by settings_copy().
+ */
+void settings_free_copy(settings *s);
+
 #endif // SETTINGS_H
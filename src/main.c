@@ -60,6 +60,7 @@ int main(int argc, char *argv[]) {
     engine_init_flags init_flags;
     init_flags.net_mode = NET_MODE_NONE;
     init_flags.record = 0;
+    init_flags.headless = 0;
     memset(init_flags.rec_file, 0, 255);
     int ret = 0;
 
@@ -77,8 +78,9 @@ int main(int argc, char *argv[]) {
     struct arg_int *port = arg_int0("p", "port", "<port>", "Port to connect or listen (default: 2097)");
     struct arg_file *play = arg_file0("P", "play", "<file>", "Play an existing recfile");
     struct arg_file *rec = arg_file0("R", "rec", "<file>", "Record a new recfile");
+    struct arg_file *trace = arg_file0("T", "trace", "<file>", "Write log as a compact binary trace to file");
     struct arg_end *end = arg_end(30);
-    void *argtable[] = {help, vers, listen, connect, port, play, rec, end};
+    void *argtable[] = {help, vers, listen, connect, port, play, rec, trace, end};
     const char *progname = "openomf";
 
     // Make sure everything got allocated
@@ -134,20 +136,21 @@ int main(int argc, char *argv[]) {
         strncpy(init_flags.rec_file, rec->filename[0], 254);
     }
 
-    // Init log
-#if defined(DEBUGMODE)
-    if(log_init(0)) {
-        err_msgbox("Error while initializing log!");
-        printf("Error while initializing log!\n");
-        goto exit_0;
+    // Init log. A binary trace replaces the normal text log, if requested.
+    const char *log_file = NULL;
+    log_format log_fmt = LOG_FORMAT_TEXT;
+#if !defined(DEBUGMODE)
+    log_file = pm_get_local_path(LOG_PATH);
+#endif
+    if(trace->count > 0) {
+        log_file = trace->filename[0];
+        log_fmt = LOG_FORMAT_TRACE;
     }
-#else
-    if(log_init(pm_get_local_path(LOG_PATH))) {
-        err_msgbox("Error while initializing log '%s'!", pm_get_local_path(LOG_PATH));
-        printf("Error while initializing log '%s'!", pm_get_local_path(LOG_PATH));
+    if(log_init(log_file, log_fmt)) {
+        err_msgbox("Error while initializing log '%s'!", log_file ? log_file : "stdout");
+        printf("Error while initializing log '%s'!\n", log_file ? log_file : "stdout");
         goto exit_0;
     }
-#endif
 
     // Simple header
     INFO("Starting OpenOMF v%d.%d.%d", V_MAJOR, V_MINOR, V_PATCH);
@@ -230,6 +233,7 @@ int main(int argc, char *argv[]) {
 exit_4:
     enet_deinitialize();
 exit_3:
+    joystick_free_mappings();
     SDL_Quit();
 exit_2:
     settings_save();
@@ -31,6 +31,8 @@ void af_create(af *a, void *src) {
             a->moves[i].id = -1;
         }
     }
+    af_matcher_create(&a->matcher, a->moves, 70);
+    af_move_index_create(&a->index, a->moves, 70);
 }
 
 af_move *af_get_move(af *a, int id) {
@@ -46,4 +48,5 @@ void af_free(af *a) {
             af_move_free(&a->moves[i]);
         }
     }
+    af_matcher_free(&a->matcher);
 }
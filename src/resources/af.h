@@ -1,6 +1,8 @@
 #ifndef AF_H
 #define AF_H
 
+#include "resources/af_matcher.h"
+#include "resources/af_move_index.h"
 #include "resources/af_move.h"
 
 typedef struct af_t {
@@ -12,6 +14,8 @@ typedef struct af_t {
     float jump_speed;
     float fall_speed;
     af_move moves[70];
+    af_matcher matcher;  // Looks up moves by the HAR input buffer
+    af_move_index index; // Looks up moves by category, range and pose
     char sound_translation_table[30];
 } af;
 
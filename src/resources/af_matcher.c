@@ -0,0 +1,152 @@
+#include "resources/af_matcher.h"
+#include "utils/allocator.h"
+#include <assert.h>
+#include <string.h>
+
+#define MAX_MOVES 128
+
+// Moves that match at a node, as bitmasks by move id
+typedef struct {
+    uint64_t ground[MAX_MOVES / 64];
+    uint64_t air[MAX_MOVES / 64];
+} move_mask;
+
+static int symbol_index(char c) {
+    if(c >= '1' && c <= '9') {
+        return c - '1';
+    }
+    if(c == 'K') {
+        return 9;
+    }
+    if(c == 'P') {
+        return 10;
+    }
+    return -1;
+}
+
+static void mask_set(uint64_t *mask, int id) {
+    mask[id / 64] |= (uint64_t)1 << (id % 64);
+}
+
+static int mask_isset(const uint64_t *mask, int id) {
+    return (mask[id / 64] >> (id % 64)) & 1;
+}
+
+// Writes the ids in the mask to out in ascending order, returns how many there were
+static int mask_expand(const uint64_t *mask, int count, uint8_t *out) {
+    int n = 0;
+    for(int id = 0; id < count; id++) {
+        if(mask_isset(mask, id)) {
+            if(out != NULL) {
+                out[n] = id;
+            }
+            n++;
+        }
+    }
+    return n;
+}
+
+// Returns the length of the move string, or -1 if the input buffer can never match it
+static int matchable_length(const af_move *move) {
+    const char *s = str_c(&move->move_string);
+    if(move->move_string.len > AF_MATCHER_MAX_INPUT) {
+        return -1;
+    }
+    for(size_t i = 0; i < move->move_string.len; i++) {
+        if(symbol_index(s[i]) < 0) {
+            return -1;
+        }
+    }
+    return move->move_string.len;
+}
+
+void af_matcher_create(af_matcher *m, const af_move *moves, int count) {
+    assert(count <= MAX_MOVES);
+
+    // Every move string adds at most one node per input
+    unsigned int max_nodes = 1 + count * AF_MATCHER_MAX_INPUT;
+    uint16_t *parents = omf_calloc(max_nodes, sizeof(uint16_t));
+    move_mask *masks = omf_calloc(max_nodes, sizeof(move_mask));
+    m->nodes = omf_calloc(max_nodes, sizeof(af_matcher_node));
+    m->node_count = 1;
+
+    for(int i = 0; i < count; i++) {
+        const af_move *move = &moves[i];
+        if(move->id == -1 || move->category == CAT_FIRE_ICE) {
+            continue;
+        }
+        int jumping = move->category == CAT_JUMPING;
+        if(!jumping && move->pos_constraints & 0x2) {
+            // Requires jumping, but only jumping moves are allowed in the air
+            continue;
+        }
+        int len = matchable_length(move);
+        if(len < 0) {
+            continue;
+        }
+
+        const char *s = str_c(&move->move_string);
+        unsigned int node = 0;
+        for(int k = 0; k < len; k++) {
+            int sym = symbol_index(s[k]);
+            if(m->nodes[node].next[sym] == 0) {
+                parents[m->node_count] = node;
+                m->nodes[node].next[sym] = m->node_count++;
+            }
+            node = m->nodes[node].next[sym];
+        }
+        mask_set(jumping ? masks[node].air : masks[node].ground, i);
+    }
+
+    // Children are always created after their parents, so the parent masks are complete when we get to a child.
+    uint32_t total = 0;
+    for(unsigned int n = 0; n < m->node_count; n++) {
+        if(n > 0) {
+            for(int w = 0; w < MAX_MOVES / 64; w++) {
+                masks[n].ground[w] |= masks[parents[n]].ground[w];
+                masks[n].air[w] |= masks[parents[n]].air[w];
+            }
+        }
+        m->nodes[n].ground_count = mask_expand(masks[n].ground, count, NULL);
+        m->nodes[n].air_count = mask_expand(masks[n].air, count, NULL);
+        m->nodes[n].ground = total;
+        m->nodes[n].air = total + m->nodes[n].ground_count;
+        total += m->nodes[n].ground_count + m->nodes[n].air_count;
+    }
+
+    m->moves = omf_calloc(total > 0 ? total : 1, sizeof(uint8_t));
+    for(unsigned int n = 0; n < m->node_count; n++) {
+        mask_expand(masks[n].ground, count, m->moves + m->nodes[n].ground);
+        mask_expand(masks[n].air, count, m->moves + m->nodes[n].air);
+    }
+
+    m->nodes = omf_realloc(m->nodes, m->node_count * sizeof(af_matcher_node));
+    omf_free(parents);
+    omf_free(masks);
+}
+
+const uint8_t *af_matcher_find(const af_matcher *m, const char *inputs, int airborne, int *count) {
+    // Follow the inputs for as long as some move string continues with them
+    unsigned int node = 0;
+    for(int k = 0; k < AF_MATCHER_MAX_INPUT && inputs[k] != '\0'; k++) {
+        int sym = symbol_index(inputs[k]);
+        if(sym < 0 || m->nodes[node].next[sym] == 0) {
+            break;
+        }
+        node = m->nodes[node].next[sym];
+    }
+
+    const af_matcher_node *n = &m->nodes[node];
+    if(airborne) {
+        *count = n->air_count;
+        return m->moves + n->air;
+    }
+    *count = n->ground_count;
+    return m->moves + n->ground;
+}
+
+void af_matcher_free(af_matcher *m) {
+    omf_free(m->nodes);
+    omf_free(m->moves);
+    m->node_count = 0;
+}
@@ -0,0 +1,51 @@
+#ifndef AF_MATCHER_H
+#define AF_MATCHER_H
+
+#include <stdint.h>
+
+#include "resources/af_move.h"
+
+#define AF_MATCHER_SYMBOLS 11   // Numpad directions 1-9, K and P
+#define AF_MATCHER_MAX_INPUT 10 // Length of the HAR input buffer
+
+typedef struct af_matcher_node_t {
+    uint16_t next[AF_MATCHER_SYMBOLS]; // Child node for each input symbol, or 0 if there is none
+    uint16_t ground_count;
+    uint16_t air_count;
+    uint32_t ground; // Offset of the ground candidates in af_matcher.moves
+    uint32_t air;    // Offset of the airborne candidates in af_matcher.moves
+} af_matcher_node;
+
+/**
+ * Trie of the AF move strings, walked with the input buffer (newest input first).
+ *
+ * Each node lists, in ascending move id order, every move whose string is a prefix of the path to the node.
+ * The lists are split by whether the HAR is jumping, and moves that can never match (fire/ice moves,
+ * moves too long for the input buffer or with position constraints that contradict their category)
+ * are left out.
+ */
+typedef struct af_matcher_t {
+    af_matcher_node *nodes;
+    uint8_t *moves;
+    unsigned int node_count;
+} af_matcher;
+
+/**
+ * Builds the matcher from the given moves. Moves with id -1 are unused slots.
+ */
+void af_matcher_create(af_matcher *m, const af_move *moves, int count);
+
+/**
+ * Finds the candidate moves for the input buffer.
+ *
+ * \param m Matcher
+ * \param inputs Input buffer, newest input first and NUL terminated
+ * \param airborne 1 if the HAR is jumping
+ * \param count Set to the number of candidates
+ * \return Candidate move ids in ascending order
+ */
+const uint8_t *af_matcher_find(const af_matcher *m, const char *inputs, int airborne, int *count);
+
+void af_matcher_free(af_matcher *m);
+
+#endif // AF_MATCHER_H
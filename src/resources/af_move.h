@@ -4,6 +4,22 @@
 #include "resources/animation.h"
 #include "utils/str.h"
 
+enum
+{
+    CAT_MISC = 0,
+    CAT_CLOSE = 2,
+    CAT_LOW = 4,
+    CAT_MEDIUM = 5,
+    CAT_HIGH,
+    CAT_JUMPING,
+    CAT_PROJECTILE,
+    CAT_BASIC,
+    CAT_VICTORY, // or defeat
+    CAT_FIRE_ICE,
+    CAT_SCRAP,
+    CAT_DESTRUCTION
+};
+
 typedef struct af_move_t {
     int id;
     animation ani;
@@ -0,0 +1,110 @@
+#include "resources/af_move_index.h"
+#include <assert.h>
+#include <string.h>
+
+static void mask_set(uint64_t *mask, int id) {
+    mask[id / 64] |= (uint64_t)1 << (id % 64);
+}
+
+static int has_plain_inputs(const af_move *move) {
+    const char *s = str_c(&move->move_string);
+    if(move->move_string.len == 0) {
+        return 0;
+    }
+    for(size_t i = 0; i < move->move_string.len; i++) {
+        if(!((s[i] >= '1' && s[i] <= '9') || s[i] == 'K' || s[i] == 'P')) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int pose_allows(int pose, int category) {
+    switch(category) {
+        case CAT_FIRE_ICE:
+            return 0;
+        case CAT_JUMPING:
+            return pose == AF_POSE_AIR;
+        case CAT_SCRAP:
+            return pose == AF_POSE_VICTORY;
+        case CAT_DESTRUCTION:
+            return pose == AF_POSE_SCRAP;
+        default:
+            return pose != AF_POSE_AIR;
+    }
+}
+
+void af_move_index_create(af_move_index *idx, const af_move *moves, int count) {
+    assert(count <= AF_MOVE_INDEX_MAX_MOVES);
+    memset(idx, 0, sizeof(af_move_index));
+
+    // Counting sort by category keeps the ids ascending within each category
+    int sizes[AF_MOVE_INDEX_CATEGORIES] = {0};
+    for(int i = 0; i < count; i++) {
+        if(moves[i].id != -1 && moves[i].category < AF_MOVE_INDEX_CATEGORIES) {
+            sizes[moves[i].category]++;
+        }
+    }
+    int fill[AF_MOVE_INDEX_CATEGORIES];
+    for(int c = 0; c < AF_MOVE_INDEX_CATEGORIES; c++) {
+        fill[c] = idx->category_start[c];
+        idx->category_start[c + 1] = idx->category_start[c] + sizes[c];
+    }
+
+    for(int i = 0; i < count; i++) {
+        const af_move *move = &moves[i];
+        if(move->id == -1) {
+            continue;
+        }
+        if(move->category < AF_MOVE_INDEX_CATEGORIES) {
+            idx->by_category[fill[move->category]++] = i;
+        }
+        switch(move->category) {
+            case CAT_CLOSE:
+                mask_set(idx->close_range, i);
+                break;
+            case CAT_BASIC:
+                mask_set(idx->short_reach, i);
+                break;
+            case CAT_LOW:
+            case CAT_MEDIUM:
+            case CAT_HIGH:
+                mask_set(idx->close_range, i);
+                mask_set(idx->short_reach, i);
+                break;
+        }
+        if(has_plain_inputs(move)) {
+            for(int pose = 0; pose < NUMBER_OF_AF_POSES; pose++) {
+                if(pose_allows(pose, move->category)) {
+                    mask_set(idx->playable[pose], i);
+                }
+            }
+        }
+    }
+}
+
+const uint8_t *af_move_index_category(const af_move_index *idx, int category, int *count) {
+    if(category < 0 || category >= AF_MOVE_INDEX_CATEGORIES) {
+        *count = 0;
+        return idx->by_category;
+    }
+    *count = idx->category_start[category + 1] - idx->category_start[category];
+    return idx->by_category + idx->category_start[category];
+}
+
+int af_move_index_next(const uint64_t *mask, int from) {
+    for(int w = from / 64; w < AF_MOVE_INDEX_WORDS; w++) {
+        uint64_t bits = mask[w];
+        if(w == from / 64) {
+            bits &= ~(uint64_t)0 << (from % 64);
+        }
+        if(bits != 0) {
+            int bit = 0;
+            while(!((bits >> bit) & 1)) {
+                bit++;
+            }
+            return w * 64 + bit;
+        }
+    }
+    return -1;
+}
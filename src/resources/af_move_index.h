@@ -0,0 +1,60 @@
+#ifndef AF_MOVE_INDEX_H
+#define AF_MOVE_INDEX_H
+
+#include <stdint.h>
+
+#include "resources/af_move.h"
+
+#define AF_MOVE_INDEX_MAX_MOVES 128
+#define AF_MOVE_INDEX_CATEGORIES (CAT_DESTRUCTION + 1)
+#define AF_MOVE_INDEX_WORDS (AF_MOVE_INDEX_MAX_MOVES / 64)
+
+// What the HAR is doing when a move would be started
+enum
+{
+    AF_POSE_GROUND = 0,
+    AF_POSE_AIR,
+    AF_POSE_VICTORY, // Enemy is defeated, scrap moves are allowed
+    AF_POSE_SCRAP,   // Enemy is scrapped, destruction moves are allowed
+    NUMBER_OF_AF_POSES
+};
+
+/**
+ * Move lookups for picking moves by category, range or pose without scanning every move slot.
+ *
+ * Masks are bitmasks by move id. Lists are in ascending move id order, so that walking a list or the set bits of
+ * a mask visits moves in the same order as a scan of the move slots would.
+ */
+typedef struct af_move_index_t {
+    uint8_t by_category[AF_MOVE_INDEX_MAX_MOVES];         // Move ids grouped by category
+    uint8_t category_start[AF_MOVE_INDEX_CATEGORIES + 1]; // Offset of each category in by_category
+
+    // Moves with a non-empty move string of plain inputs (1-9, K, P) that can be started in each pose
+    uint64_t playable[NUMBER_OF_AF_POSES][AF_MOVE_INDEX_WORDS];
+    uint64_t close_range[AF_MOVE_INDEX_WORDS]; // Close, low, medium and high moves
+    uint64_t short_reach[AF_MOVE_INDEX_WORDS]; // Basic, low, medium and high moves
+} af_move_index;
+
+/**
+ * Builds the index from the given moves. Moves with id -1 are unused slots.
+ */
+void af_move_index_create(af_move_index *idx, const af_move *moves, int count);
+
+/**
+ * Gets the moves of a category.
+ *
+ * \param idx Move index
+ * \param category CAT_* value
+ * \param count Set to the number of moves
+ * \return Move ids in ascending order
+ */
+const uint8_t *af_move_index_category(const af_move_index *idx, int category, int *count);
+
+/**
+ * Gets the next move id in a mask, starting from the given id.
+ *
+ * \return Move id, or -1 if there are no more moves in the mask
+ */
+int af_move_index_next(const uint64_t *mask, int from);
+
+#endif // AF_MOVE_INDEX_H
@@ -11,14 +11,29 @@ void animation_create(animation *ani, void *src, int id) {
     ani->start_pos = vec2i_create(sdani->start_x, sdani->start_y);
     str_from_c(&ani->animation_string, sdani->anim_string);
 
-    // Copy collision coordinates
+    // Copy collision coordinates, bucketed by frame so that hit tests only look at the current frame.
+    // The order within a frame is kept, since hit detection uses the first matching coordinates.
     vector_create(&ani->collision_coords, sizeof(collision_coord));
-    collision_coord tmp_coord;
+    ani->frame_count = 0;
     for(int i = 0; i < sdani->coord_count; i++) {
-        tmp_coord.pos = vec2i_create(sdani->coord_table[i].x, sdani->coord_table[i].y);
-        tmp_coord.frame_index = sdani->coord_table[i].frame_id;
-        vector_append(&ani->collision_coords, &tmp_coord);
+        if(sdani->coord_table[i].frame_id >= ani->frame_count) {
+            ani->frame_count = sdani->coord_table[i].frame_id + 1;
+        }
+    }
+    ani->frame_coords = omf_calloc(ani->frame_count + 1, sizeof(int));
+    collision_coord tmp_coord;
+    for(int frame = 0; frame < ani->frame_count; frame++) {
+        ani->frame_coords[frame] = vector_size(&ani->collision_coords);
+        for(int i = 0; i < sdani->coord_count; i++) {
+            if(sdani->coord_table[i].frame_id != frame) {
+                continue;
+            }
+            tmp_coord.pos = vec2i_create(sdani->coord_table[i].x, sdani->coord_table[i].y);
+            tmp_coord.frame_index = frame;
+            vector_append(&ani->collision_coords, &tmp_coord);
+        }
     }
+    ani->frame_coords[ani->frame_count] = vector_size(&ani->collision_coords);
 
     ani->extra_string_count = sdani->extra_string_count;
     // Copy extra strings
@@ -46,6 +61,8 @@ animation *create_animation_from_single(sprite *sp, vec2i pos) {
     a->id = -1;
     str_from_c(&a->animation_string, "A9999999999");
     vector_create(&a->collision_coords, sizeof(collision_coord));
+    a->frame_coords = omf_calloc(1, sizeof(int));
+    a->frame_count = 0;
     vector_create(&a->extra_strings, sizeof(str));
     vector_create(&a->sprites, sizeof(sprite));
     vector_append(&a->sprites, sp);
@@ -61,6 +78,18 @@ int animation_get_sprite_count(animation *ani) {
     return vector_size(&ani->sprites);
 }
 
+collision_coord *animation_get_frame_coords(animation *ani, int frame_index, int *count) {
+    if(frame_index < 0 || frame_index >= ani->frame_count) {
+        *count = 0;
+        return NULL;
+    }
+    *count = ani->frame_coords[frame_index + 1] - ani->frame_coords[frame_index];
+    if(*count == 0) {
+        return NULL;
+    }
+    return vector_get(&ani->collision_coords, ani->frame_coords[frame_index]);
+}
+
 void animation_free(animation *ani) {
     iterator it;
 
@@ -69,6 +98,7 @@ void animation_free(animation *ani) {
 
     // Free collision coordinates
     vector_free(&ani->collision_coords);
+    omf_free(ani->frame_coords);
 
     // Free extra strings
     vector_iter_begin(&ani->extra_strings, &it);
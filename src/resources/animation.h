@@ -38,7 +38,9 @@ typedef struct collision_coord_t {
 typedef struct animation_t {
     int id;
     vec2i start_pos;
-    vector collision_coords;
+    vector collision_coords; // Sorted by frame index, in file order within a frame
+    int *frame_coords;       // First collision coord of each frame, plus the end of the last frame
+    int frame_count;         // Frames in frame_coords
     str animation_string;
     uint8_t extra_string_count;
     vector extra_strings;
@@ -51,6 +53,16 @@ void animation_free(animation *ani);
 
 int animation_get_sprite_count(animation *ani);
 
+/**
+ * Gets the collision coordinates of a single frame.
+ *
+ * \param ani Animation to look in
+ * \param frame_index Sprite id of the frame
+ * \param count Set to the number of coordinates returned
+ * \return The first coordinate of the frame, or NULL if there are none.
+ */
+collision_coord *animation_get_frame_coords(animation *ani, int frame_index, int *count);
+
 animation *create_animation_from_single(sprite *sp, vec2i pos);
 
 #endif // ANIMATION_H
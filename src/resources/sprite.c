@@ -4,10 +4,43 @@
 #include <stdlib.h>
 #include <string.h>
 
+// Index of the stencil byte that a mirrored lookup reads. This is off by one (w - x instead of w - 1 - x),
+// but hit detection has always worked like this, and changing it would change the outcome of recorded fights.
+static int mirrored_index(const surface *sur, int x, int y) {
+    return (y * sur->w) + (sur->w - x);
+}
+
+static int mask_bytes(const surface *sur) {
+    return (sur->w * sur->h + 7) / 8;
+}
+
+// Unmirrored hit checks read the stencil directly. Mirrored ones get a table of their own, so that the
+// off by one lookup does not have to be worked out for every pixel.
+static void sprite_create_mirrored_mask(sprite *sp) {
+    sp->mirrored_mask = NULL;
+    if(sp->data == NULL || sp->data->stencil == NULL || sp->data->w * sp->data->h == 0) {
+        return;
+    }
+    const surface *sur = sp->data;
+    int len = sur->w * sur->h;
+    uint8_t *mask = omf_calloc(1, mask_bytes(sur));
+    for(int y = 0; y < sur->h; y++) {
+        for(int x = 0; x < sur->w; x++) {
+            int bit = y * sur->w + x;
+            int m = mirrored_index(sur, x, y);
+            if(m < len && surface_stencil_get(sur, m)) {
+                mask[bit / 8] |= 1 << (bit % 8);
+            }
+        }
+    }
+    sp->mirrored_mask = mask;
+}
+
 void sprite_create_custom(sprite *sp, vec2i pos, surface *data) {
     sp->id = -1;
     sp->pos = pos;
     sp->data = data;
+    sprite_create_mirrored_mask(sp);
 }
 
 void sprite_create(sprite *sp, void *src, int id) {
@@ -20,13 +53,15 @@ void sprite_create(sprite *sp, void *src, int id) {
     sd_vga_image raw;
     sd_sprite_vga_decode(&raw, sdsprite);
     surface_create_from_data(sp->data, SURFACE_TYPE_PALETTE, raw.w, raw.h, raw.data);
-    memcpy(sp->data->stencil, raw.stencil, raw.w * raw.h);
+    surface_set_stencil(sp->data, raw.stencil);
     sd_vga_image_free(&raw);
+    sprite_create_mirrored_mask(sp);
 }
 
 void sprite_free(sprite *sp) {
     surface_free(sp->data);
     omf_free(sp->data);
+    omf_free(sp->mirrored_mask);
 }
 
 vec2i sprite_get_size(sprite *sp) {
@@ -47,5 +82,26 @@ sprite *sprite_copy(sprite *src) {
     // Copy surface
     new->data = omf_calloc(1, sizeof(surface));
     surface_copy(new->data, src->data);
+    if(src->mirrored_mask != NULL) {
+        new->mirrored_mask = omf_calloc(1, mask_bytes(src->data));
+        memcpy(new->mirrored_mask, src->mirrored_mask, mask_bytes(src->data));
+    }
     return new;
 }
+
+int sprite_is_solid(const sprite *sp, int x, int y, int mirrored) {
+    const surface *sur = sp->data;
+    if(sur->stencil == NULL) {
+        return 0;
+    }
+    int bit = (y * sur->w) + x;
+    if(!mirrored) {
+        return surface_stencil_get(sur, bit);
+    }
+    if(sp->mirrored_mask == NULL) {
+        // Sprites that were not created from game data have no table; do the mirrored lookup here.
+        int index = mirrored_index(sur, x, y);
+        return index < sur->w * sur->h && surface_stencil_get(sur, index);
+    }
+    return (sp->mirrored_mask[bit / 8] >> (bit % 8)) & 1;
+}
@@ -8,6 +8,7 @@ typedef struct sprite_t {
     int id;
     vec2i pos;
     surface *data;
+    uint8_t *mirrored_mask; // 1 bit per pixel, the stencil as a mirrored hit check reads it
 } sprite;
 
 void sprite_create(sprite *sp, void *src, int id);
@@ -15,6 +16,17 @@ void sprite_create_custom(sprite *sp, vec2i pos, surface *sur);
 void sprite_free(sprite *sp);
 
 vec2i sprite_get_size(sprite *s);
+
+/**
+ * Tells whether a pixel of the sprite can be hit. Coordinates must be within the sprite.
+ *
+ * \param sp Sprite to check
+ * \param x X coordinate, counted from the right edge if the sprite is mirrored
+ * \param y Y coordinate
+ * \param mirrored 1 if the sprite is drawn mirrored
+ * \return 1 if the pixel is solid, 0 if not.
+ */
+int sprite_is_solid(const sprite *sp, int x, int y, int mirrored);
 sprite *sprite_copy(sprite *src);
 
 #endif // SPRITE_H
@@ -4,6 +4,13 @@
 #include "platform.h"
 #include <string.h>
 
+// Storage class for per-thread variables
+#if defined(_MSC_VER) && !defined(__clang__)
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL _Thread_local
+#endif
+
 #ifndef HAVE_STD_STRDUP
 char *strdup(const char *s1);
 #endif
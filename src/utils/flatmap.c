@@ -0,0 +1,353 @@
+#include "utils/flatmap.h"
+#include "utils/allocator.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define HASH_USED_BIT 0x80000000u
+#define ALIGN8(x) (((x) + 7) & ~7u)
+
+// Grow when the map would become more than 7/8 full. Robin Hood probing keeps
+// probe sequences short even at high load.
+#define NEEDS_GROW(fm) (((fm)->reserved + 1) * 8 > (fm)->capacity * 7)
+
+static inline uint32_t hash_u32(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352d;
+    x ^= x >> 15;
+    x *= 0x846ca68b;
+    x ^= x >> 16;
+    return x | HASH_USED_BIT;
+}
+
+static uint32_t hash_bytes(const void *key, unsigned int len) {
+    const unsigned char *p = key;
+    uint32_t word;
+    if(len == sizeof(uint32_t)) {
+        memcpy(&word, p, sizeof(uint32_t));
+        return hash_u32(word);
+    }
+
+    // Mix a word at a time instead of byte by byte.
+    uint32_t h = len * 0x9e3779b9;
+    while(len >= sizeof(uint32_t)) {
+        memcpy(&word, p, sizeof(uint32_t));
+        word *= 0xcc9e2d51;
+        word = (word << 15) | (word >> 17);
+        word *= 0x1b873593;
+        h ^= word;
+        h = (h << 13) | (h >> 19);
+        h = h * 5 + 0xe6546b64;
+        p += sizeof(uint32_t);
+        len -= sizeof(uint32_t);
+    }
+    word = 0;
+    memcpy(&word, p, len);
+    return hash_u32(h ^ word);
+}
+
+static inline flatmap_pair *slot_at(const char *slots, unsigned int slot_size, unsigned int index) {
+    return (flatmap_pair *)(slots + (size_t)index * slot_size);
+}
+
+static inline unsigned int probe_distance(const flatmap *fm, uint32_t hash, unsigned int index) {
+    return (index - hash) & (fm->capacity - 1);
+}
+
+// Point the key and value fields of every slot to its own inline storage.
+// These never change afterwards, moving an entry only copies the contents.
+static void init_slots(char *slots, unsigned int count, unsigned int slot_size, unsigned int key_size) {
+    for(unsigned int i = 0; i < count; i++) {
+        flatmap_pair *pair = slot_at(slots, slot_size, i);
+        pair->keylen = 0;
+        pair->vallen = 0;
+        pair->key = (char *)pair + sizeof(flatmap_pair);
+        pair->val = (char *)pair->key + ALIGN8(key_size);
+    }
+}
+
+static inline void copy_entry(flatmap_pair *dst, const flatmap_pair *src) {
+    dst->keylen = src->keylen;
+    dst->vallen = src->vallen;
+    memcpy(dst->key, src->key, src->keylen);
+    memcpy(dst->val, src->val, src->vallen);
+}
+
+static void alloc_slots(flatmap *fm, unsigned int capacity) {
+    fm->capacity = capacity;
+    fm->hashes = omf_calloc(capacity, sizeof(uint32_t));
+    fm->slots = omf_calloc(capacity, fm->slot_size);
+    init_slots(fm->slots, capacity, fm->slot_size, fm->key_size);
+}
+
+// Inserts an entry that is known not to be in the map yet. Returns the slot it ended up in.
+static flatmap_pair *insert_new(flatmap *fm, uint32_t hash, const flatmap_pair *entry) {
+    unsigned int mask = fm->capacity - 1;
+    unsigned int index = hash & mask;
+    unsigned int dist = 0;
+    flatmap_pair *carry = slot_at(fm->swap, fm->slot_size, 0);
+    flatmap_pair *tmp = slot_at(fm->swap, fm->slot_size, 1);
+    flatmap_pair *result = NULL;
+    copy_entry(carry, entry);
+
+    while(1) {
+        flatmap_pair *slot = slot_at(fm->slots, fm->slot_size, index);
+        if(fm->hashes[index] == 0) {
+            fm->hashes[index] = hash;
+            copy_entry(slot, carry);
+            fm->reserved++;
+            return (result != NULL) ? result : slot;
+        }
+
+        // Robin Hood: Take the slot from an entry that is closer to its home than we are,
+        // and continue looking for a place for the displaced entry instead.
+        unsigned int existing = probe_distance(fm, fm->hashes[index], index);
+        if(existing < dist) {
+            uint32_t tmp_hash = fm->hashes[index];
+            fm->hashes[index] = hash;
+            hash = tmp_hash;
+            copy_entry(tmp, slot);
+            copy_entry(slot, carry);
+            flatmap_pair *swap = carry;
+            carry = tmp;
+            tmp = swap;
+            if(result == NULL) {
+                result = slot;
+            }
+            dist = existing;
+        }
+        index = (index + 1) & mask;
+        dist++;
+    }
+}
+
+static void grow(flatmap *fm) {
+    uint32_t *old_hashes = fm->hashes;
+    char *old_slots = fm->slots;
+    unsigned int old_capacity = fm->capacity;
+
+    alloc_slots(fm, old_capacity * 2);
+    fm->reserved = 0;
+    for(unsigned int i = 0; i < old_capacity; i++) {
+        if(old_hashes[i] != 0) {
+            insert_new(fm, old_hashes[i], slot_at(old_slots, fm->slot_size, i));
+        }
+    }
+    omf_free(old_hashes);
+    omf_free(old_slots);
+}
+
+static int find(const flatmap *fm, uint32_t hash, const void *key, unsigned int keylen) {
+    unsigned int mask = fm->capacity - 1;
+    unsigned int index = hash & mask;
+    for(unsigned int dist = 0;; dist++) {
+        uint32_t slot_hash = fm->hashes[index];
+        // Entries are ordered by probe distance, so we can stop at the first one that is closer to home.
+        if(slot_hash == 0 || probe_distance(fm, slot_hash, index) < dist) {
+            return -1;
+        }
+        if(slot_hash == hash) {
+            const flatmap_pair *pair = slot_at(fm->slots, fm->slot_size, index);
+            if(pair->keylen == keylen && memcmp(pair->key, key, keylen) == 0) {
+                return index;
+            }
+        }
+        index = (index + 1) & mask;
+    }
+}
+
+static int ifind(const flatmap *fm, uint32_t hash, uint32_t key) {
+    unsigned int mask = fm->capacity - 1;
+    unsigned int index = hash & mask;
+    for(unsigned int dist = 0;; dist++) {
+        uint32_t slot_hash = fm->hashes[index];
+        if(slot_hash == 0 || probe_distance(fm, slot_hash, index) < dist) {
+            return -1;
+        }
+        if(slot_hash == hash) {
+            const flatmap_pair *pair = slot_at(fm->slots, fm->slot_size, index);
+            uint32_t slot_key;
+            memcpy(&slot_key, pair->key, sizeof(uint32_t));
+            if(pair->keylen == sizeof(uint32_t) && slot_key == key) {
+                return index;
+            }
+        }
+        index = (index + 1) & mask;
+    }
+}
+
+// Removes the entry at index by shifting the rest of its probe sequence one step back.
+static void remove_at(flatmap *fm, unsigned int index) {
+    unsigned int mask = fm->capacity - 1;
+    unsigned int next = (index + 1) & mask;
+    while(fm->hashes[next] != 0 && probe_distance(fm, fm->hashes[next], next) > 0) {
+        fm->hashes[index] = fm->hashes[next];
+        copy_entry(slot_at(fm->slots, fm->slot_size, index), slot_at(fm->slots, fm->slot_size, next));
+        index = next;
+        next = (next + 1) & mask;
+    }
+    fm->hashes[index] = 0;
+    fm->reserved--;
+}
+
+static void *put(flatmap *fm, uint32_t hash, int index, const void *key, unsigned int keylen, const void *val,
+                 unsigned int vallen) {
+    if(keylen > fm->key_size || vallen > fm->val_size) {
+        return NULL;
+    }
+
+    // Key already exists, just replace the value.
+    if(index >= 0) {
+        flatmap_pair *pair = slot_at(fm->slots, fm->slot_size, index);
+        memcpy(pair->val, val, vallen);
+        pair->vallen = vallen;
+        return pair->val;
+    }
+
+    if(NEEDS_GROW(fm)) {
+        grow(fm);
+    }
+    flatmap_pair entry;
+    entry.keylen = keylen;
+    entry.vallen = vallen;
+    entry.key = (void *)key;
+    entry.val = (void *)val;
+    return insert_new(fm, hash, &entry)->val;
+}
+
+void flatmap_create(flatmap *fm, int n_size, unsigned int key_size, unsigned int val_size) {
+    fm->key_size = key_size;
+    fm->val_size = val_size;
+    fm->slot_size = sizeof(flatmap_pair) + ALIGN8(key_size) + ALIGN8(val_size);
+    fm->reserved = 0;
+    fm->swap = omf_calloc(2, fm->slot_size);
+    init_slots(fm->swap, 2, fm->slot_size, key_size);
+    alloc_slots(fm, 1u << (n_size > 0 ? n_size : 1));
+}
+
+void flatmap_free(flatmap *fm) {
+    omf_free(fm->hashes);
+    omf_free(fm->slots);
+    omf_free(fm->swap);
+    fm->capacity = 0;
+    fm->reserved = 0;
+}
+
+void flatmap_clear(flatmap *fm) {
+    memset(fm->hashes, 0, fm->capacity * sizeof(uint32_t));
+    fm->reserved = 0;
+}
+
+unsigned int flatmap_size(const flatmap *fm) {
+    return fm->capacity;
+}
+
+unsigned int flatmap_reserved(const flatmap *fm) {
+    return fm->reserved;
+}
+
+void *flatmap_put(flatmap *fm, const void *key, unsigned int keylen, const void *val, unsigned int vallen) {
+    uint32_t hash = hash_bytes(key, keylen);
+    return put(fm, hash, find(fm, hash, key, keylen), key, keylen, val, vallen);
+}
+
+int flatmap_get(const flatmap *fm, const void *key, unsigned int keylen, void **val, unsigned int *vallen) {
+    int index = find(fm, hash_bytes(key, keylen), key, keylen);
+    if(index < 0) {
+        *val = NULL;
+        *vallen = 0;
+        return 1;
+    }
+    flatmap_pair *pair = slot_at(fm->slots, fm->slot_size, index);
+    *val = pair->val;
+    *vallen = pair->vallen;
+    return 0;
+}
+
+int flatmap_del(flatmap *fm, const void *key, unsigned int keylen) {
+    int index = find(fm, hash_bytes(key, keylen), key, keylen);
+    if(index < 0) {
+        return 1;
+    }
+    remove_at(fm, index);
+    return 0;
+}
+
+void *flatmap_iput(flatmap *fm, uint32_t key, const void *val, unsigned int vallen) {
+    uint32_t hash = hash_u32(key);
+    return put(fm, hash, ifind(fm, hash, key), &key, sizeof(uint32_t), val, vallen);
+}
+
+int flatmap_iget(const flatmap *fm, uint32_t key, void **val, unsigned int *vallen) {
+    int index = ifind(fm, hash_u32(key), key);
+    if(index < 0) {
+        *val = NULL;
+        *vallen = 0;
+        return 1;
+    }
+    flatmap_pair *pair = slot_at(fm->slots, fm->slot_size, index);
+    *val = pair->val;
+    *vallen = pair->vallen;
+    return 0;
+}
+
+int flatmap_idel(flatmap *fm, uint32_t key) {
+    int index = ifind(fm, hash_u32(key), key);
+    if(index < 0) {
+        return 1;
+    }
+    remove_at(fm, index);
+    return 0;
+}
+
+// The iterator keeps the last returned slot in vnow and the number of slots left to visit in inow.
+// Iteration starts from a slot that begins a probe sequence, so that deleting entries during
+// iteration only ever shifts not-yet-visited entries backwards.
+static unsigned int iter_slot_index(const flatmap *fm, const void *vnow) {
+    return ((const char *)vnow - fm->slots) / fm->slot_size;
+}
+
+static void *flatmap_iter_next(iterator *iter) {
+    const flatmap *fm = iter->data;
+    unsigned int mask = fm->capacity - 1;
+    unsigned int index = iter_slot_index(fm, iter->vnow);
+    while(iter->inow > 0) {
+        index = (index + 1) & mask;
+        iter->inow--;
+        if(fm->hashes[index] != 0) {
+            iter->vnow = slot_at(fm->slots, fm->slot_size, index);
+            return iter->vnow;
+        }
+    }
+    iter->ended = 1;
+    return NULL;
+}
+
+void flatmap_iter_begin(const flatmap *fm, iterator *iter) {
+    unsigned int start = 0;
+    while(start < fm->capacity && fm->hashes[start] != 0 && probe_distance(fm, fm->hashes[start], start) > 0) {
+        start++;
+    }
+    iter->data = fm;
+    iter->vnow = slot_at(fm->slots, fm->slot_size, (start - 1) & (fm->capacity - 1));
+    iter->inow = fm->capacity;
+    iter->next = flatmap_iter_next;
+    iter->prev = NULL;
+    iter->ended = (fm->reserved == 0);
+}
+
+int flatmap_delete(flatmap *fm, iterator *iter) {
+    // Nothing has been returned by the iterator yet
+    if(iter->ended || (unsigned int)iter->inow >= fm->capacity) {
+        return 1;
+    }
+    unsigned int index = iter_slot_index(fm, iter->vnow);
+    if(fm->hashes[index] == 0) {
+        return 1;
+    }
+    remove_at(fm, index);
+
+    // The next entry may have been shifted into this slot, so look at it again.
+    iter->vnow = slot_at(fm->slots, fm->slot_size, (index - 1) & (fm->capacity - 1));
+    iter->inow++;
+    return 0;
+}
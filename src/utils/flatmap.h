@@ -0,0 +1,92 @@
+#ifndef FLATMAP_H
+#define FLATMAP_H
+
+#include "utils/iterator.h"
+#include <stdint.h>
+
+typedef struct flatmap_pair_t flatmap_pair;
+typedef struct flatmap_t flatmap;
+
+/**
+ * Key-value pair as stored in a flatmap slot. Key and value point to inline storage
+ * inside the slot and are only valid until the next put or delete on the map.
+ */
+struct flatmap_pair_t {
+    unsigned int keylen, vallen;
+    void *key, *val;
+};
+
+/**
+ * Open addressing hashmap with Robin Hood probing.
+ *
+ * Keys and values are stored inline in one flat slot array, so there are no per-item
+ * allocations. The maximum key and value sizes are fixed at creation. Deletion
+ * shifts the following entries back instead of leaving tombstones, so lookups stay
+ * fast no matter how many items have been removed.
+ *
+ * Unlike hashmap, pointers returned by the map are invalidated by any put or delete.
+ */
+struct flatmap_t {
+    uint32_t *hashes; // 0 for an empty slot
+    char *slots;
+    unsigned int capacity; // Always a power of two
+    unsigned int reserved;
+    unsigned int key_size;
+    unsigned int val_size;
+    unsigned int slot_size;
+    char *swap; // Scratch space for two slots, used when displacing entries
+};
+
+/**
+ * Create a flatmap with room for 2^n_size slots. The map grows automatically.
+ *
+ * \param fm Allocated flatmap pointer
+ * \param n_size Initial size of the map. Slot count will be pow(2, n_size)
+ * \param key_size Largest key length in bytes that will be stored
+ * \param val_size Largest value length in bytes that will be stored
+ */
+void flatmap_create(flatmap *fm, int n_size, unsigned int key_size, unsigned int val_size);
+void flatmap_free(flatmap *fm);
+void flatmap_clear(flatmap *fm);
+unsigned int flatmap_size(const flatmap *fm);
+unsigned int flatmap_reserved(const flatmap *fm);
+
+/**
+ * Puts an item to the map, replacing any previous value with the same key.
+ *
+ * \return Pointer to the stored value, or NULL if key or value is larger than the map allows.
+ */
+void *flatmap_put(flatmap *fm, const void *key, unsigned int keylen, const void *val, unsigned int vallen);
+
+/**
+ * Gets an item from the map.
+ *
+ * \return 0 on success, 1 if the key was not found.
+ */
+int flatmap_get(const flatmap *fm, const void *key, unsigned int keylen, void **val, unsigned int *vallen);
+
+/**
+ * Deletes an item from the map.
+ *
+ * \return 0 on success, 1 if the key was not found.
+ */
+int flatmap_del(flatmap *fm, const void *key, unsigned int keylen);
+
+// Integer key variants. These are interchangeable with using a 4 byte key with the functions above.
+void *flatmap_iput(flatmap *fm, uint32_t key, const void *val, unsigned int vallen);
+int flatmap_iget(const flatmap *fm, uint32_t key, void **val, unsigned int *vallen);
+int flatmap_idel(flatmap *fm, uint32_t key);
+
+/**
+ * Iterate the map. The iterator returns flatmap_pair pointers. Iteration order is unspecified.
+ */
+void flatmap_iter_begin(const flatmap *fm, iterator *iter);
+
+/**
+ * Deletes the item last returned by the iterator. Iteration may continue after this.
+ *
+ * \return 0 on success, 1 on error.
+ */
+int flatmap_delete(flatmap *fm, iterator *iter);
+
+#endif // FLATMAP_H
@@ -1,46 +1,463 @@
 #include "utils/log.h"
+#include "utils/compat.h"
+#include "utils/hashmap.h"
+#include <SDL.h>
+#include <ctype.h>
+#include <signal.h>
 #include <stdarg.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 
-FILE *handle = 0;
+// Queue must be a power of two.
+#define LOG_QUEUE_SIZE 1024
+#define LOG_MSG_SIZE 480
+
+// How often the writer thread wakes up to write out queued messages. Errors are written out right away.
+#define LOG_FLUSH_MS 20
+
+// How long the crash handler waits for another thread to finish writing before writing anyway
+#define LOG_CRASH_WAIT_MS 100
+
+// One queued message. For text logs, data holds the formatted message. For traces, data holds the
+// encoded printf arguments. The seq field is used to hand the entry over between threads.
+typedef struct log_entry {
+    atomic_uint seq;
+    unsigned int tick;
+    char mode;
+    const char *fn;
+    const char *fmt;
+    unsigned int len;
+    char data[LOG_MSG_SIZE];
+} log_entry;
+
+typedef struct log_callsite_key {
+    const char *fn;
+    const char *fmt;
+} log_callsite_key;
+
+typedef struct log_state {
+    FILE *handle;
+    log_format format;
+    log_entry *queue;
+    atomic_uint head;
+    atomic_uint tail;
+    atomic_uint dropped;
+    atomic_bool running;
+    SDL_Thread *thread;
+    SDL_sem *wake;
+    atomic_flag drain_lock; // Held while writing out queued messages
+    hashmap callsites;
+    unsigned int next_callsite;
+} log_state;
+
+static log_state state;
+static THREAD_LOCAL bool log_draining = false; // Set while this thread holds the drain lock
 unsigned int _log_tick = 0;
 
-int log_init(const char *filename) {
-    if(handle)
+// ------------------------ Trace encoding ------------------------
+
+static void put_le(char *buf, unsigned int *pos, unsigned int size, uint64_t value, unsigned int bytes) {
+    if(*pos + bytes > size) {
+        *pos = size;
+        return;
+    }
+    for(unsigned int i = 0; i < bytes; i++) {
+        buf[(*pos)++] = (value >> (i * 8)) & 0xFF;
+    }
+}
+
+static void put_arg(char *buf, unsigned int *pos, unsigned int size, char type, uint64_t value, unsigned int bytes) {
+    if(*pos + 1 + bytes > size) {
+        *pos = size;
+        return;
+    }
+    buf[(*pos)++] = type;
+    put_le(buf, pos, size, value, bytes);
+}
+
+static void put_string_arg(char *buf, unsigned int *pos, unsigned int size, const char *str) {
+    if(str == NULL) {
+        str = "(null)";
+    }
+    unsigned int len = strlen(str);
+    if(*pos + 3 >= size) {
+        *pos = size;
+        return;
+    }
+    if(len > size - *pos - 3) {
+        len = size - *pos - 3;
+    }
+    buf[(*pos)++] = LOG_TRACE_ARG_STRING;
+    put_le(buf, pos, size, len, 2);
+    memcpy(buf + *pos, str, len);
+    *pos += len;
+}
+
+// Walks the printf conversions in fmt and stores each argument with its type. This is much cheaper than
+// formatting, and the trace decoder can apply the same format string afterwards.
+static unsigned int log_encode_args(char *buf, unsigned int size, const char *fmt, va_list args) {
+    unsigned int pos = 0;
+    for(const char *p = fmt; *p != '\0' && pos < size; p++) {
+        if(*p != '%')
+            continue;
+        p++;
+        if(*p == '%')
+            continue;
+
+        // Flags, field width and precision. Star width or precision are passed as int arguments.
+        while(*p != '\0' && strchr("-+ #0'", *p))
+            p++;
+        for(int field = 0; field < 2; field++) {
+            if(field == 1) {
+                if(*p != '.')
+                    break;
+                p++;
+            }
+            if(*p == '*') {
+                put_arg(buf, &pos, size, LOG_TRACE_ARG_INT, (uint32_t)va_arg(args, int), 4);
+                p++;
+            }
+            while(isdigit((unsigned char)*p))
+                p++;
+        }
+
+        // Length modifiers
+        char length = 0;
+        while(*p != '\0' && strchr("hlLqjzt", *p)) {
+            if(*p != 'h')
+                length = *p;
+            p++;
+        }
+
+        switch(*p) {
+            case 'd':
+            case 'i':
+            case 'u':
+            case 'x':
+            case 'X':
+            case 'o':
+            case 'c':
+                switch(length) {
+                    case 0:
+                        put_arg(buf, &pos, size, LOG_TRACE_ARG_INT, (uint32_t)va_arg(args, int), 4);
+                        break;
+                    case 'l':
+                        put_arg(buf, &pos, size, LOG_TRACE_ARG_LONG, (uint64_t)va_arg(args, long), 8);
+                        break;
+                    case 'z':
+                        put_arg(buf, &pos, size, LOG_TRACE_ARG_LONG, (uint64_t)va_arg(args, size_t), 8);
+                        break;
+                    default:
+                        put_arg(buf, &pos, size, LOG_TRACE_ARG_LONG, (uint64_t)va_arg(args, long long), 8);
+                        break;
+                }
+                break;
+            case 'f':
+            case 'F':
+            case 'e':
+            case 'E':
+            case 'g':
+            case 'G':
+            case 'a':
+            case 'A': {
+                double value = (length == 'L') ? (double)va_arg(args, long double) : va_arg(args, double);
+                uint64_t bits;
+                memcpy(&bits, &value, sizeof(bits));
+                put_arg(buf, &pos, size, LOG_TRACE_ARG_DOUBLE, bits, 8);
+            } break;
+            case 's':
+                put_string_arg(buf, &pos, size, va_arg(args, const char *));
+                break;
+            case 'p':
+                put_arg(buf, &pos, size, LOG_TRACE_ARG_POINTER, (uintptr_t)va_arg(args, void *), 8);
+                break;
+            case 'n':
+                va_arg(args, void *);
+                break;
+            case '\0':
+                return pos;
+        }
+    }
+    return pos;
+}
+
+// ------------------------ Writer side ------------------------
+
+static void write_le(uint64_t value, unsigned int bytes) {
+    for(unsigned int i = 0; i < bytes; i++) {
+        fputc((value >> (i * 8)) & 0xFF, state.handle);
+    }
+}
+
+static void write_trace_string(const char *str) {
+    unsigned int len = (str != NULL) ? strlen(str) : 0;
+    write_le(len, 2);
+    fwrite(str, 1, len, state.handle);
+}
+
+static uint32_t log_get_callsite(const log_entry *entry) {
+    log_callsite_key key = {entry->fn, entry->fmt};
+    uint32_t *id;
+    unsigned int len;
+    if(hashmap_get(&state.callsites, &key, sizeof(key), (void **)&id, &len) == 0) {
+        return *id;
+    }
+    uint32_t new_id = state.next_callsite++;
+    hashmap_put(&state.callsites, &key, sizeof(key), &new_id, sizeof(new_id));
+    write_le(LOG_TRACE_CALLSITE, 1);
+    write_le(new_id, 4);
+    write_trace_string(entry->fn);
+    write_trace_string(entry->fmt);
+    return new_id;
+}
+
+static void log_write_entry(const log_entry *entry) {
+    if(state.format == LOG_FORMAT_TRACE) {
+        uint32_t callsite = log_get_callsite(entry);
+        write_le(LOG_TRACE_EVENT, 1);
+        write_le(entry->tick, 4);
+        write_le(entry->mode, 1);
+        write_le(callsite, 4);
+        write_le(entry->len, 2);
+        fwrite(entry->data, 1, entry->len, state.handle);
+    } else if(entry->fn != NULL) {
+        fprintf(state.handle, "[%7u][%c] %s(): %.*s\n", entry->tick, entry->mode, entry->fn, (int)entry->len,
+                entry->data);
+    } else {
+        fprintf(state.handle, "[%7u][%c] %.*s\n", entry->tick, entry->mode, (int)entry->len, entry->data);
+    }
+}
+
+static void log_write_dropped() {
+    unsigned int dropped = atomic_exchange(&state.dropped, 0);
+    if(dropped == 0) {
+        return;
+    }
+    if(state.format == LOG_FORMAT_TRACE) {
+        write_le(LOG_TRACE_DROPPED, 1);
+        write_le(dropped, 4);
+    } else {
+        fprintf(state.handle, "[%7u][E] Log queue full, %u messages dropped\n", _log_tick, dropped);
+    }
+}
+
+// Writes out everything that is currently queued. Only one thread may do this at a time.
+static bool log_drain() {
+    bool wrote = false;
+    unsigned int tail = atomic_load_explicit(&state.tail, memory_order_relaxed);
+    for(;;) {
+        log_entry *entry = &state.queue[tail & (LOG_QUEUE_SIZE - 1)];
+        unsigned int seq = atomic_load_explicit(&entry->seq, memory_order_acquire);
+        if((int)(seq - (tail + 1)) < 0) {
+            break;
+        }
+        log_write_entry(entry);
+        atomic_store_explicit(&entry->seq, tail + LOG_QUEUE_SIZE, memory_order_release);
+        tail++;
+        atomic_store_explicit(&state.tail, tail, memory_order_release);
+        wrote = true;
+    }
+    log_write_dropped();
+    return wrote;
+}
+
+// Writes out and flushes everything that is currently queued. If wait is false and another thread is
+// already writing, nothing is done and false is returned.
+static bool log_flush(bool wait) {
+    if(wait) {
+        while(atomic_flag_test_and_set(&state.drain_lock))
+            ;
+    } else if(atomic_flag_test_and_set(&state.drain_lock)) {
+        return false;
+    }
+    log_draining = true;
+    if(log_drain()) {
+        fflush(state.handle);
+    }
+    log_draining = false;
+    atomic_flag_clear(&state.drain_lock);
+    return true;
+}
+
+static int log_writer(void *userdata) {
+    while(atomic_load(&state.running)) {
+        log_flush(true);
+        SDL_SemWaitTimeout(state.wake, LOG_FLUSH_MS);
+    }
+    return 0;
+}
+
+// The last messages before a crash are the most interesting ones, so try to get them written out.
+// Stdio is not async signal safe, but this only runs when the process is going down anyway. If another
+// thread is writing the log, give it a moment and then write the rest without the lock. If the crashing
+// thread was itself writing the log, nothing more can be done.
+static void log_crash_handler(int sig) {
+    signal(sig, SIG_DFL);
+    if(state.handle != 0 && !log_draining) {
+        Uint32 start = SDL_GetTicks();
+        while(!log_flush(false)) {
+            if(SDL_GetTicks() - start > LOG_CRASH_WAIT_MS) {
+                if(log_drain()) {
+                    fflush(state.handle);
+                }
+                break;
+            }
+        }
+    }
+    raise(sig);
+}
+
+static void log_exit_handler() {
+    if(state.handle != 0) {
+        log_flush(false);
+    }
+}
+
+static void log_install_handlers() {
+    static bool installed = false;
+    if(installed) {
+        return;
+    }
+    installed = true;
+    atexit(log_exit_handler);
+    signal(SIGSEGV, log_crash_handler);
+    signal(SIGABRT, log_crash_handler);
+    signal(SIGFPE, log_crash_handler);
+    signal(SIGILL, log_crash_handler);
+}
+
+// ------------------------ Public API ------------------------
+
+int log_init(const char *filename, log_format format) {
+    if(state.handle)
         return 1;
 
     if(filename == 0) {
-        handle = stdout;
+        state.handle = stdout;
     } else {
-        handle = fopen(filename, "w");
-        if(handle == NULL) {
+        state.handle = fopen(filename, (format == LOG_FORMAT_TRACE) ? "wb" : "w");
+        if(state.handle == NULL) {
             return 1;
         }
     }
+    state.format = format;
+    if(format == LOG_FORMAT_TRACE) {
+        fwrite(LOG_TRACE_MAGIC, 1, strlen(LOG_TRACE_MAGIC), state.handle);
+        write_le(LOG_TRACE_VERSION, 4);
+        hashmap_create(&state.callsites, 8);
+        state.next_callsite = 0;
+    }
+
+    state.queue = calloc(LOG_QUEUE_SIZE, sizeof(log_entry));
+    for(unsigned int i = 0; i < LOG_QUEUE_SIZE; i++) {
+        atomic_init(&state.queue[i].seq, i);
+    }
+    atomic_init(&state.head, 0);
+    atomic_init(&state.tail, 0);
+    atomic_init(&state.dropped, 0);
+    atomic_init(&state.running, true);
+    atomic_flag_clear(&state.drain_lock);
+    log_install_handlers();
+
+    // If the writer thread cannot be started, messages are written out directly from log_print.
+    state.wake = SDL_CreateSemaphore(0);
+    state.thread = SDL_CreateThread(log_writer, "log_writer", NULL);
+    if(state.thread == NULL) {
+        fprintf(state.handle, "Unable to start log writer thread: %s\n", SDL_GetError());
+    }
     return 0;
 }
 
 void log_close() {
-    if(handle != stdout && handle != 0) {
-        fclose(handle);
+    if(state.handle == 0)
+        return;
+    if(state.thread != NULL) {
+        atomic_store(&state.running, false);
+        SDL_SemPost(state.wake);
+        SDL_WaitThread(state.thread, NULL);
+        state.thread = NULL;
     }
+    log_flush(true);
+    if(state.wake != NULL) {
+        SDL_DestroySemaphore(state.wake);
+        state.wake = NULL;
+    }
+    if(state.format == LOG_FORMAT_TRACE) {
+        hashmap_free(&state.callsites);
+    }
+    if(state.handle != stdout) {
+        fclose(state.handle);
+    } else {
+        fflush(state.handle);
+    }
+    free(state.queue);
+    state.queue = NULL;
+    state.handle = 0;
 }
 
 void log_hide(char mode, const char *fn, const char *fmt, ...) {
 } // Do nothing here. This is a no-op logger.
 
+// Reserves a queue entry. Any thread may call this.
+static log_entry *log_reserve(unsigned int *pos_out) {
+    unsigned int pos = atomic_load_explicit(&state.head, memory_order_relaxed);
+    for(;;) {
+        log_entry *entry = &state.queue[pos & (LOG_QUEUE_SIZE - 1)];
+        unsigned int seq = atomic_load_explicit(&entry->seq, memory_order_acquire);
+        int diff = (int)(seq - pos);
+        if(diff == 0) {
+            if(atomic_compare_exchange_weak_explicit(&state.head, &pos, pos + 1, memory_order_relaxed,
+                                                     memory_order_relaxed)) {
+                *pos_out = pos;
+                return entry;
+            }
+        } else if(diff < 0) {
+            return NULL; // Queue is full
+        } else {
+            pos = atomic_load_explicit(&state.head, memory_order_relaxed);
+        }
+    }
+}
+
 void log_print(char mode, const char *fn, const char *fmt, ...) {
-    if(handle == 0)
+    unsigned int pos;
+    log_entry *entry;
+    va_list args;
+
+    if(state.handle == 0)
+        return;
+    if((entry = log_reserve(&pos)) == NULL) {
+        atomic_fetch_add(&state.dropped, 1);
+        SDL_SemPost(state.wake);
         return;
-    if(fn != NULL) {
-        fprintf(handle, "[%7u][%c] %s(): ", _log_tick, mode, fn);
-    } else {
-        fprintf(handle, "[%7u][%c] ", _log_tick, mode);
     }
-    va_list args;
+
+    entry->tick = _log_tick;
+    entry->mode = mode;
+    entry->fn = fn;
+    entry->fmt = fmt;
     va_start(args, fmt);
-    vfprintf(handle, fmt, args);
+    if(state.format == LOG_FORMAT_TRACE) {
+        entry->len = log_encode_args(entry->data, LOG_MSG_SIZE, fmt, args);
+    } else {
+        int len = vsnprintf(entry->data, LOG_MSG_SIZE, fmt, args);
+        entry->len = (len < 0) ? 0 : ((len >= LOG_MSG_SIZE) ? LOG_MSG_SIZE - 1 : len);
+    }
     va_end(args);
-    fprintf(handle, "\n");
-    fflush(handle);
+    atomic_store_explicit(&entry->seq, pos + 1, memory_order_release);
+
+    // Errors are written out before returning, in case they are followed by a crash
+    if(state.thread == NULL || mode == 'E') {
+        log_flush(true);
+        return;
+    }
+
+    // Wake up the writer before the queue fills up
+    unsigned int queued = pos + 1 - atomic_load_explicit(&state.tail, memory_order_relaxed);
+    if(queued >= LOG_QUEUE_SIZE / 2) {
+        SDL_SemPost(state.wake);
+    }
 }
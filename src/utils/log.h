@@ -16,9 +16,62 @@
 #define LOGTICK(x) _log_tick = x;
 extern unsigned int _log_tick;
 
+typedef enum
+{
+    LOG_FORMAT_TEXT,
+    LOG_FORMAT_TRACE
+} log_format;
+
+/*
+ * Binary trace format (LOG_FORMAT_TRACE). All integers are little endian.
+ *
+ * File header: LOG_TRACE_MAGIC (8 bytes), u32 LOG_TRACE_VERSION.
+ * Each record starts with a u8 record type:
+ *   LOG_TRACE_CALLSITE: u32 callsite id, u16 function name length, function name,
+ *                       u16 format string length, format string.
+ *                       Written once, before the first event referring to the callsite.
+ *   LOG_TRACE_EVENT:    u32 tick, u8 level, u32 callsite id, u16 argument data length, argument data.
+ *                       Argument data is one entry per printf conversion in the format string:
+ *                       u8 LOG_TRACE_ARG_* type followed by the value (i32, i64, f64, u64 pointer,
+ *                       or u16 length + bytes for strings).
+ *   LOG_TRACE_DROPPED:  u32 number of messages dropped because the log queue was full.
+ */
+#define LOG_TRACE_MAGIC "OMFTRACE"
+#define LOG_TRACE_VERSION 1
+
+enum
+{
+    LOG_TRACE_CALLSITE = 1,
+    LOG_TRACE_EVENT = 2,
+    LOG_TRACE_DROPPED = 3
+};
+
+enum
+{
+    LOG_TRACE_ARG_INT = 'i',
+    LOG_TRACE_ARG_LONG = 'l',
+    LOG_TRACE_ARG_DOUBLE = 'd',
+    LOG_TRACE_ARG_STRING = 's',
+    LOG_TRACE_ARG_POINTER = 'p'
+};
+
 void log_hide(char mode, const char *fn, const char *fmt, ...); // no-op
 void log_print(char mode, const char *fn, const char *fmt, ...);
-int log_init(const char *filename);
+
+/**
+ * Open the log. Messages are queued without blocking and written by a background thread. Errors are
+ * written out before log_print returns, and queued messages are written out if the process exits or
+ * crashes without closing the log.
+ *
+ * @param filename Log file path, or NULL for stdout
+ * @param format Plain text log, or compact binary trace
+ * @return 0 on success, 1 on failure.
+ */
+int log_init(const char *filename, log_format format);
+
+/**
+ * Write out all queued messages and close the log.
+ */
 void log_close();
 
 #endif // LOG_H
@@ -0,0 +1,138 @@
+#include "utils/profiler.h"
+#include "utils/compat.h"
+#include <SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    uint32_t us;
+    uint16_t calls;
+} profile_sample;
+
+static struct {
+    uint64_t start[NUMBER_OF_PROFILE_PHASES];
+    uint64_t ticks[NUMBER_OF_PROFILE_PHASES];
+    unsigned int calls[NUMBER_OF_PROFILE_PHASES];
+    profile_sample history[PROFILER_HISTORY][NUMBER_OF_PROFILE_PHASES];
+    unsigned int frames;
+    uint64_t frame_start;
+} prof;
+
+// Simulations that are not part of the frame, eg. AI lookahead, do not record
+static THREAD_LOCAL bool profiling = true;
+
+static const char *phase_names[] = {
+    "events", "ctrl", "static", "dynamic", "cleanup", "move",
+    "collide", "tick", "render", "tcache", "finish", "frame",
+};
+
+bool profiler_bind(bool enabled) {
+    bool old = profiling;
+    profiling = enabled;
+    return old;
+}
+
+void profiler_begin(profile_phase phase) {
+    if(!profiling) {
+        return;
+    }
+    prof.start[phase] = SDL_GetPerformanceCounter();
+}
+
+void profiler_end(profile_phase phase) {
+    if(!profiling) {
+        return;
+    }
+    profiler_record(phase, SDL_GetPerformanceCounter() - prof.start[phase]);
+}
+
+void profiler_record(profile_phase phase, uint64_t ticks) {
+    if(!profiling) {
+        return;
+    }
+    prof.ticks[phase] += ticks;
+    prof.calls[phase]++;
+}
+
+void profiler_frame_end() {
+    uint64_t now = SDL_GetPerformanceCounter();
+    uint64_t freq = SDL_GetPerformanceFrequency();
+    if(prof.frame_start != 0) {
+        profiler_record(PROFILE_FRAME, now - prof.frame_start);
+    }
+    prof.frame_start = now;
+
+    profile_sample *frame = prof.history[prof.frames % PROFILER_HISTORY];
+    for(int i = 0; i < NUMBER_OF_PROFILE_PHASES; i++) {
+        uint64_t us = prof.ticks[i] * 1000000 / freq;
+        frame[i].us = (us > UINT32_MAX) ? UINT32_MAX : us;
+        frame[i].calls = (prof.calls[i] > UINT16_MAX) ? UINT16_MAX : prof.calls[i];
+        prof.ticks[i] = 0;
+        prof.calls[i] = 0;
+    }
+    prof.frames++;
+}
+
+void profiler_reset() {
+    memset(&prof, 0, sizeof(prof));
+}
+
+unsigned int profiler_frames() {
+    return prof.frames;
+}
+
+const char *profiler_phase_name(profile_phase phase) {
+    return phase_names[phase];
+}
+
+static int compare_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+void profiler_get_stats(profile_phase phase, profile_stats *stats) {
+    uint32_t sorted[PROFILER_HISTORY];
+    unsigned int count = (prof.frames < PROFILER_HISTORY) ? prof.frames : PROFILER_HISTORY;
+
+    memset(stats, 0, sizeof(profile_stats));
+    if(count == 0) {
+        return;
+    }
+    for(unsigned int i = 0; i < count; i++) {
+        sorted[i] = prof.history[i][phase].us;
+        if(prof.history[i][phase].calls > stats->max_calls) {
+            stats->max_calls = prof.history[i][phase].calls;
+        }
+    }
+    qsort(sorted, count, sizeof(uint32_t), compare_u32);
+    stats->p50_us = sorted[(count - 1) * 50 / 100];
+    stats->p99_us = sorted[(count - 1) * 99 / 100];
+    stats->max_us = sorted[count - 1];
+}
+
+int profiler_write_csv(const char *filename) {
+    FILE *fp = fopen(filename, "w");
+    if(fp == NULL) {
+        return 1;
+    }
+    fprintf(fp, "frame");
+    for(int i = 0; i < NUMBER_OF_PROFILE_PHASES; i++) {
+        fprintf(fp, ",%s_us,%s_calls", phase_names[i], phase_names[i]);
+    }
+    fprintf(fp, "\n");
+
+    unsigned int count = (prof.frames < PROFILER_HISTORY) ? prof.frames : PROFILER_HISTORY;
+    for(unsigned int n = prof.frames - count; n < prof.frames; n++) {
+        const profile_sample *frame = prof.history[n % PROFILER_HISTORY];
+        fprintf(fp, "%u", n);
+        for(int i = 0; i < NUMBER_OF_PROFILE_PHASES; i++) {
+            fprintf(fp, ",%u,%u", frame[i].us, frame[i].calls);
+        }
+        fprintf(fp, "\n");
+    }
+    int failed = ferror(fp);
+    fclose(fp);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,75 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Frame phases measured by the profiler. Sub-phases (cleanup, move, collide, tick) are also
+ * included in the time of the phase they are called from.
+ */
+typedef enum
+{
+    PROFILE_EVENTS = 0,
+    PROFILE_CONTROLLERS,
+    PROFILE_STATIC_TICK,
+    PROFILE_DYNAMIC_TICK,
+    PROFILE_CLEANUP,
+    PROFILE_MOVE,
+    PROFILE_COLLIDE,
+    PROFILE_TICK,
+    PROFILE_RENDER,
+    PROFILE_TCACHE_MISS,
+    PROFILE_RENDER_FINISH,
+    PROFILE_FRAME,
+    NUMBER_OF_PROFILE_PHASES
+} profile_phase;
+
+/**
+ * Number of frames kept for the rolling statistics.
+ */
+#define PROFILER_HISTORY 256
+
+typedef struct {
+    unsigned int p50_us;
+    unsigned int p99_us;
+    unsigned int max_us;
+    unsigned int max_calls; // Most calls to the phase in a single frame
+} profile_stats;
+
+/**
+ * Enables or disables recording for the calling thread. Returns the previous setting.
+ */
+bool profiler_bind(bool enabled);
+
+void profiler_begin(profile_phase phase);
+void profiler_end(profile_phase phase);
+
+/**
+ * Adds time to a phase directly. Used by profiler_end(); counter ticks are in
+ * SDL_GetPerformanceFrequency() units.
+ */
+void profiler_record(profile_phase phase, uint64_t ticks);
+
+/**
+ * Closes the current frame: the time accumulated for each phase is moved to the history,
+ * and the whole frame time is recorded to PROFILE_FRAME.
+ */
+void profiler_frame_end();
+
+void profiler_reset();
+unsigned int profiler_frames();
+const char *profiler_phase_name(profile_phase phase);
+
+/**
+ * Computes p50/p99/max over the frames in the history.
+ */
+void profiler_get_stats(profile_phase phase, profile_stats *stats);
+
+/**
+ * Writes the per-frame history to a CSV file, oldest frame first.
+ * Returns 0 on success, 1 on failure.
+ */
+int profiler_write_csv(const char *filename);
+
+#endif // PROFILER_H
@@ -1,9 +1,13 @@
 #include "utils/random.h"
+#include "utils/compat.h"
 #include <limits.h>
 
 // A simple psuedorandom number generator
 
-static struct random_t rand_state = {1};
+static struct random_t rand_default = {1};
+
+// Each simulation binds its own state, see game_state_bind()
+static THREAD_LOCAL struct random_t *rand_state = &rand_default;
 
 void random_seed(struct random_t *r, uint32_t seed) {
     r->seed = seed;
@@ -26,18 +30,24 @@ float random_float(struct random_t *r) {
     return (float)random_intmax(r) / (float)UINT_MAX;
 }
 
+struct random_t *rand_bind(struct random_t *r) {
+    struct random_t *old = rand_state;
+    rand_state = (r != NULL) ? r : &rand_default;
+    return old;
+}
+
 void rand_seed(uint32_t seed) {
-    random_seed(&rand_state, seed);
+    random_seed(rand_state, seed);
 }
 uint32_t rand_get_seed(void) {
-    return random_get_seed(&rand_state);
+    return random_get_seed(rand_state);
 }
 uint32_t rand_int(uint32_t upperbound) {
-    return random_int(&rand_state, upperbound);
+    return random_int(rand_state, upperbound);
 }
 uint32_t rand_intmax(void) {
-    return random_intmax(&rand_state);
+    return random_intmax(rand_state);
 }
 float rand_float(void) {
-    return random_float(&rand_state);
+    return random_float(rand_state);
 }
@@ -30,4 +30,9 @@ uint32_t rand_int(uint32_t upperbound);
 uint32_t rand_intmax(void);
 float rand_float(void);
 
+/* Makes the rand_* functions of the calling thread use the given state.
+ * NULL selects the process-wide default state. Returns the previously used state.
+ */
+struct random_t *rand_bind(struct random_t *r);
+
 #endif // RANDOM_H
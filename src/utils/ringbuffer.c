@@ -0,0 +1,102 @@
+#include "utils/ringbuffer.h"
+#include "utils/allocator.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+void ringbuffer_create(ringbuffer *rb, unsigned int capacity, unsigned int elem_size) {
+    unsigned int size = 1;
+    while(size < capacity) {
+        size <<= 1;
+    }
+    rb->elem_size = elem_size;
+    rb->mask = size - 1;
+    rb->data = omf_calloc(size, elem_size);
+    atomic_init(&rb->head, 0);
+    atomic_init(&rb->tail, 0);
+}
+
+void ringbuffer_free(ringbuffer *rb) {
+    omf_free(rb->data);
+    rb->elem_size = 0;
+    rb->mask = 0;
+}
+
+unsigned int ringbuffer_capacity(const ringbuffer *rb) {
+    return rb->mask + 1;
+}
+
+unsigned int ringbuffer_size(ringbuffer *rb) {
+    unsigned int head = atomic_load_explicit(&rb->head, memory_order_acquire);
+    unsigned int tail = atomic_load_explicit(&rb->tail, memory_order_acquire);
+    return head - tail;
+}
+
+unsigned int ringbuffer_space(ringbuffer *rb) {
+    return ringbuffer_capacity(rb) - ringbuffer_size(rb);
+}
+
+// Copies count elements between the buffer and linear memory, starting from the given index.
+// Handles the wraparound at the end of the buffer.
+static void ringbuffer_copy_in(ringbuffer *rb, unsigned int index, const char *src, unsigned int count) {
+    unsigned int start = index & rb->mask;
+    unsigned int first = ringbuffer_capacity(rb) - start;
+    if(first > count) {
+        first = count;
+    }
+    memcpy(rb->data + start * rb->elem_size, src, first * rb->elem_size);
+    memcpy(rb->data, src + first * rb->elem_size, (count - first) * rb->elem_size);
+}
+
+static void ringbuffer_copy_out(const ringbuffer *rb, unsigned int index, char *dst, unsigned int count) {
+    unsigned int start = index & rb->mask;
+    unsigned int first = ringbuffer_capacity(rb) - start;
+    if(first > count) {
+        first = count;
+    }
+    memcpy(dst, rb->data + start * rb->elem_size, first * rb->elem_size);
+    memcpy(dst + first * rb->elem_size, rb->data, (count - first) * rb->elem_size);
+}
+
+unsigned int ringbuffer_write(ringbuffer *rb, const void *src, unsigned int count) {
+    assert(rb->data != NULL);
+    unsigned int head = atomic_load_explicit(&rb->head, memory_order_relaxed);
+    unsigned int tail = atomic_load_explicit(&rb->tail, memory_order_acquire);
+    unsigned int space = ringbuffer_capacity(rb) - (head - tail);
+    if(count > space) {
+        count = space;
+    }
+    if(count > 0) {
+        ringbuffer_copy_in(rb, head, src, count);
+        atomic_store_explicit(&rb->head, head + count, memory_order_release);
+    }
+    return count;
+}
+
+unsigned int ringbuffer_read(ringbuffer *rb, void *dst, unsigned int count) {
+    assert(rb->data != NULL);
+    unsigned int tail = atomic_load_explicit(&rb->tail, memory_order_relaxed);
+    unsigned int head = atomic_load_explicit(&rb->head, memory_order_acquire);
+    unsigned int avail = head - tail;
+    if(count > avail) {
+        count = avail;
+    }
+    if(count > 0) {
+        ringbuffer_copy_out(rb, tail, dst, count);
+        atomic_store_explicit(&rb->tail, tail + count, memory_order_release);
+    }
+    return count;
+}
+
+bool ringbuffer_push(ringbuffer *rb, const void *elem) {
+    return ringbuffer_write(rb, elem, 1) == 1;
+}
+
+bool ringbuffer_pop(ringbuffer *rb, void *elem) {
+    return ringbuffer_read(rb, elem, 1) == 1;
+}
+
+void ringbuffer_clear(ringbuffer *rb) {
+    unsigned int head = atomic_load_explicit(&rb->head, memory_order_acquire);
+    atomic_store_explicit(&rb->tail, head, memory_order_release);
+}
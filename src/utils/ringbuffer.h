@@ -0,0 +1,68 @@
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+
+/**
+ * Single-producer, single-consumer ring buffer of fixed size elements.
+ *
+ * One thread may write and another thread may read at the same time without locking.
+ * Capacity is always rounded up to a power of two.
+ */
+typedef struct ringbuffer_t {
+    char *data;
+    unsigned int elem_size;
+    unsigned int mask;
+    atomic_uint head; // Written by the producer only
+    atomic_uint tail; // Written by the consumer only
+} ringbuffer;
+
+void ringbuffer_create(ringbuffer *rb, unsigned int capacity, unsigned int elem_size);
+void ringbuffer_free(ringbuffer *rb);
+
+/**
+ * Number of elements the buffer can hold.
+ */
+unsigned int ringbuffer_capacity(const ringbuffer *rb);
+
+/**
+ * Number of elements currently readable. Safe to call from either side.
+ */
+unsigned int ringbuffer_size(ringbuffer *rb);
+
+/**
+ * Number of elements currently writable. Safe to call from either side.
+ */
+unsigned int ringbuffer_space(ringbuffer *rb);
+
+/**
+ * Producer side: Copy up to count elements into the buffer.
+ * @return Number of elements actually written.
+ */
+unsigned int ringbuffer_write(ringbuffer *rb, const void *src, unsigned int count);
+
+/**
+ * Consumer side: Copy up to count elements out of the buffer.
+ * @return Number of elements actually read.
+ */
+unsigned int ringbuffer_read(ringbuffer *rb, void *dst, unsigned int count);
+
+/**
+ * Producer side: Push a single element.
+ * @return True if the element was written, false if the buffer is full.
+ */
+bool ringbuffer_push(ringbuffer *rb, const void *elem);
+
+/**
+ * Consumer side: Pop a single element.
+ * @return True if an element was read, false if the buffer is empty.
+ */
+bool ringbuffer_pop(ringbuffer *rb, void *elem);
+
+/**
+ * Consumer side: Drop all readable elements.
+ */
+void ringbuffer_clear(ringbuffer *rb);
+
+#endif // RINGBUFFER_H
@@ -19,6 +19,12 @@ void vector_clear(vector *vec) {
     vec->blocks = 0;
 }
 
+void vector_truncate(vector *vec, unsigned int size) {
+    if(size < vec->blocks) {
+        vec->blocks = size;
+    }
+}
+
 void vector_free(vector *vec) {
     vec->blocks = 0;
     vec->reserved = 0;
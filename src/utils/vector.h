@@ -16,6 +16,7 @@ typedef int (*vector_compare_func)(const void *, const void *);
 void vector_create(vector *vector, unsigned int block_size);
 void vector_free(vector *vector);
 void vector_clear(vector *vector);
+void vector_truncate(vector *vector, unsigned int size);
 void *vector_get(const vector *vector, unsigned int key);
 int vector_append(vector *vector, const void *value);
 int vector_prepend(vector *vector, const void *value);
@@ -0,0 +1,97 @@
+#include "utils/work_pool.h"
+#include "utils/log.h"
+
+static void run_jobs(work_pool *pool, int worker) {
+    int job;
+    while((job = SDL_AtomicAdd(&pool->next_job, 1)) < pool->jobs) {
+        pool->fn(pool->userdata, worker, job);
+    }
+}
+
+static int work_pool_thread(void *userdata) {
+    work_pool *pool = userdata;
+    int worker = SDL_AtomicAdd(&pool->started, 1);
+    unsigned int seen = 0;
+    SDL_LockMutex(pool->lock);
+    while(1) {
+        while(!pool->quit && pool->generation == seen) {
+            SDL_CondWait(pool->work_cond, pool->lock);
+        }
+        if(pool->quit) {
+            break;
+        }
+        seen = pool->generation;
+        SDL_UnlockMutex(pool->lock);
+        run_jobs(pool, worker);
+        SDL_LockMutex(pool->lock);
+        if(--pool->busy == 0) {
+            SDL_CondSignal(pool->done_cond);
+        }
+    }
+    SDL_UnlockMutex(pool->lock);
+    return 0;
+}
+
+void work_pool_create(work_pool *pool, int threads) {
+    pool->lock = SDL_CreateMutex();
+    pool->work_cond = SDL_CreateCond();
+    pool->done_cond = SDL_CreateCond();
+    pool->generation = 0;
+    pool->busy = 0;
+    pool->quit = 0;
+    pool->thread_count = 0;
+    pool->jobs = 0;
+    SDL_AtomicSet(&pool->started, 0);
+    SDL_AtomicSet(&pool->next_job, 0);
+    if(threads > WORK_POOL_MAX_THREADS) {
+        threads = WORK_POOL_MAX_THREADS;
+    }
+    for(int i = 0; i < threads; i++) {
+        SDL_Thread *thread = SDL_CreateThread(work_pool_thread, "work_pool", pool);
+        if(thread == NULL) {
+            PERROR("Unable to start worker thread: %s", SDL_GetError());
+            break;
+        }
+        pool->threads[pool->thread_count++] = thread;
+    }
+}
+
+void work_pool_free(work_pool *pool) {
+    SDL_LockMutex(pool->lock);
+    pool->quit = 1;
+    SDL_CondBroadcast(pool->work_cond);
+    SDL_UnlockMutex(pool->lock);
+    for(int i = 0; i < pool->thread_count; i++) {
+        SDL_WaitThread(pool->threads[i], NULL);
+    }
+    SDL_DestroyCond(pool->done_cond);
+    SDL_DestroyCond(pool->work_cond);
+    SDL_DestroyMutex(pool->lock);
+    pool->thread_count = 0;
+}
+
+int work_pool_workers(const work_pool *pool) {
+    return pool->thread_count + 1;
+}
+
+void work_pool_run(work_pool *pool, int jobs, work_pool_fn fn, void *userdata) {
+    pool->fn = fn;
+    pool->userdata = userdata;
+    pool->jobs = jobs;
+    SDL_AtomicSet(&pool->next_job, 0);
+
+    SDL_LockMutex(pool->lock);
+    pool->generation++;
+    pool->busy = pool->thread_count;
+    SDL_CondBroadcast(pool->work_cond);
+    SDL_UnlockMutex(pool->lock);
+
+    // The threads number themselves from 0, the calling thread is the last worker
+    run_jobs(pool, pool->thread_count);
+
+    SDL_LockMutex(pool->lock);
+    while(pool->busy > 0) {
+        SDL_CondWait(pool->done_cond, pool->lock);
+    }
+    SDL_UnlockMutex(pool->lock);
+}
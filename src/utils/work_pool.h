@@ -0,0 +1,60 @@
+#ifndef WORK_POOL_H
+#define WORK_POOL_H
+
+#include <SDL.h>
+
+// Most threads in a pool, not counting the thread that runs the jobs
+#define WORK_POOL_MAX_THREADS 7
+
+/**
+ * Runs a job on a worker.
+ *
+ * \param userdata Userdata given to work_pool_run()
+ * \param worker Index of the worker running the job, 0 to work_pool_workers() - 1. Each worker runs one job at a
+ *               time, so data can be kept per worker without locking.
+ * \param job Index of the job
+ */
+typedef void (*work_pool_fn)(void *userdata, int worker, int job);
+
+/**
+ * Fixed set of threads that run batches of numbered jobs. The thread that starts a batch also runs jobs, and
+ * waits until all of them are done.
+ */
+typedef struct work_pool_t {
+    SDL_mutex *lock;
+    SDL_cond *work_cond;
+    SDL_cond *done_cond;
+    unsigned int generation; // Bumped for every batch
+    int busy;                // Threads that have not finished the current batch
+    int quit;
+    SDL_Thread *threads[WORK_POOL_MAX_THREADS];
+    int thread_count;
+    SDL_atomic_t started; // Worker indexes handed out to the threads
+
+    // The current batch
+    work_pool_fn fn;
+    void *userdata;
+    int jobs;
+    SDL_atomic_t next_job;
+} work_pool;
+
+/**
+ * Starts the threads of a pool. If some threads can't be started, the pool runs with fewer.
+ *
+ * \param threads Number of threads, not counting the thread that runs the jobs
+ */
+void work_pool_create(work_pool *pool, int threads);
+void work_pool_free(work_pool *pool);
+
+/**
+ * Number of workers that may run jobs: the threads of the pool and the thread that starts a batch.
+ */
+int work_pool_workers(const work_pool *pool);
+
+/**
+ * Runs jobs 0 to jobs - 1 on the workers, and returns when all of them are done. Which worker runs which job
+ * depends on the timing, so results should not depend on the worker.
+ */
+void work_pool_run(work_pool *pool, int jobs, work_pool_fn fn, void *userdata);
+
+#endif // WORK_POOL_H
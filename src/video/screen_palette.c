@@ -0,0 +1,214 @@
+#include "video/screen_palette.h"
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// The kernels below only use integer math, so that the SSE2 paths give exactly the same colors as the scalar
+// loops. Those handle the entries left over from the 16 entry blocks, and builds without SSE2.
+
+static uint8_t clamp_channel(int v) {
+    return v < 0 ? 0 : (v > 255 ? 255 : v);
+}
+
+// Clips the range to the palette, returns the number of entries left
+static int clip_range(int *start, int count) {
+    if(*start < 0) {
+        count += *start;
+        *start = 0;
+    }
+    if(*start + count > 256) {
+        count = 256 - *start;
+    }
+    return count > 0 ? count : 0;
+}
+
+void screen_palette_commit(screen_palette *pal) {
+    for(int r = 0; r < PALETTE_RANGES; r++) {
+        // Each changed word covers two ranges
+        uint32_t bits = pal->changed[r / 2] >> ((r % 2) * PALETTE_RANGE_SIZE);
+        if((bits & 0xFFFF) == 0) {
+            continue;
+        }
+        int start = r * PALETTE_RANGE_SIZE;
+        if(memcmp(pal->committed[start], pal->data[start], PALETTE_RANGE_SIZE * 3) != 0) {
+            memcpy(pal->committed[start], pal->data[start], PALETTE_RANGE_SIZE * 3);
+            pal->versions[r]++;
+        }
+    }
+    memset(pal->changed, 0, sizeof(pal->changed));
+}
+
+void screen_palette_invalidate(screen_palette *pal) {
+    screen_palette_commit(pal);
+    for(int r = 0; r < PALETTE_RANGES; r++) {
+        pal->versions[r]++;
+    }
+}
+
+unsigned int screen_palette_get_version(const screen_palette *pal, uint16_t ranges) {
+    unsigned int version = 0;
+    for(int r = 0; r < PALETTE_RANGES; r++) {
+        if(ranges & (1 << r)) {
+            version += pal->versions[r];
+        }
+    }
+    return version;
+}
+
+int screen_palette_is_changed(const screen_palette *pal, int index) {
+    return (pal->changed[index / 32] >> (index % 32)) & 1;
+}
+
+int screen_palette_set_range(screen_palette *pal, int start, int count, const uint8_t (*colors)[3]) {
+    int changed = 0;
+    for(int i = 0; i < count; i++) {
+        uint8_t *dst = pal->data[start + i];
+        if(dst[0] != colors[i][0] || dst[1] != colors[i][1] || dst[2] != colors[i][2]) {
+            dst[0] = colors[i][0];
+            dst[1] = colors[i][1];
+            dst[2] = colors[i][2];
+            pal->changed[(start + i) / 32] |= (uint32_t)1 << ((start + i) % 32);
+            changed = 1;
+        }
+    }
+    return changed;
+}
+
+#if defined(__SSE2__)
+// Blends 4 channels, given as 16 bit (entry, ref) pairs. The weights are split into high and low bytes, as 32 bit
+// lanes of (keep, weight) pairs, so that madd can do the multiplies: x = (pairs . hi) * 256 + pairs . lo.
+// x / PAL_WEIGHT_ONE is then (x >> 8) / 255, and y / 255 is (y + 1 + (y >> 8)) >> 8 for y below 65535.
+static __m128i blend4_sse2(__m128i pairs, __m128i hi, __m128i lo) {
+    const __m128i one = _mm_set1_epi32(1);
+    __m128i y = _mm_add_epi32(_mm_madd_epi16(pairs, hi), _mm_srli_epi32(_mm_madd_epi16(pairs, lo), 8));
+    return _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(y, one), _mm_srli_epi32(y, 8)), 8);
+}
+
+// Blends 16 channel bytes towards the ref bytes, with the weights of each channel in hi[] and lo[]
+static __m128i blend16_sse2(__m128i in, __m128i ref, const __m128i hi[4], const __m128i lo[4]) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i pairs_lo = _mm_unpacklo_epi8(in, ref);
+    __m128i pairs_hi = _mm_unpackhi_epi8(in, ref);
+    __m128i q0 = blend4_sse2(_mm_unpacklo_epi8(pairs_lo, zero), hi[0], lo[0]);
+    __m128i q1 = blend4_sse2(_mm_unpackhi_epi8(pairs_lo, zero), hi[1], lo[1]);
+    __m128i q2 = blend4_sse2(_mm_unpacklo_epi8(pairs_hi, zero), hi[2], lo[2]);
+    __m128i q3 = blend4_sse2(_mm_unpackhi_epi8(pairs_hi, zero), hi[3], lo[3]);
+    return _mm_packus_epi16(_mm_packs_epi32(q0, q1), _mm_packs_epi32(q2, q3));
+}
+
+// Loads the ref color repeated over the 48 bytes of a 16 entry block
+static void load_ref_sse2(__m128i refs[3], const uint8_t ref[3]) {
+    uint8_t pattern[48];
+    for(int i = 0; i < 48; i++) {
+        pattern[i] = ref[i % 3];
+    }
+    for(int j = 0; j < 3; j++) {
+        refs[j] = _mm_loadu_si128((const __m128i *)(pattern + j * 16));
+    }
+}
+
+// (keep, weight) pairs of the high and low weight bytes, see blend4_sse2()
+static uint32_t weight_hi(int weight) {
+    return ((uint32_t)(weight >> 8) << 16) | ((PAL_WEIGHT_ONE - weight) >> 8);
+}
+
+static uint32_t weight_lo(int weight) {
+    return ((uint32_t)(weight & 0xFF) << 16) | ((PAL_WEIGHT_ONE - weight) & 0xFF);
+}
+#endif
+
+int screen_palette_blend(screen_palette *pal, int start, int count, const uint8_t ref[3], int weight) {
+    if((count = clip_range(&start, count)) == 0) {
+        return 0;
+    }
+    uint8_t out[256][3];
+    const uint8_t (*in)[3] = pal->data + start;
+    int keep = PAL_WEIGHT_ONE - weight;
+    int i = 0;
+#if defined(__SSE2__)
+    if(weight >= 0 && weight <= PAL_WEIGHT_ONE) {
+        __m128i refs[3], hi[4], lo[4];
+        load_ref_sse2(refs, ref);
+        for(int k = 0; k < 4; k++) {
+            hi[k] = _mm_set1_epi32(weight_hi(weight));
+            lo[k] = _mm_set1_epi32(weight_lo(weight));
+        }
+        for(; i + 16 <= count; i += 16) {
+            for(int j = 0; j < 3; j++) {
+                __m128i v = _mm_loadu_si128((const __m128i *)(in[i] + j * 16));
+                _mm_storeu_si128((__m128i *)(out[i] + j * 16), blend16_sse2(v, refs[j], hi, lo));
+            }
+        }
+    }
+#endif
+    for(; i < count; i++) {
+        for(int k = 0; k < 3; k++) {
+            out[i][k] = clamp_channel((in[i][k] * keep + ref[k] * weight) / PAL_WEIGHT_ONE);
+        }
+    }
+    return screen_palette_set_range(pal, start, count, out);
+}
+
+int screen_palette_tint(screen_palette *pal, int start, int count, const uint8_t ref[3], int weight) {
+    if((count = clip_range(&start, count)) == 0) {
+        return 0;
+    }
+    uint8_t out[256][3];
+    const uint8_t (*in)[3] = pal->data + start;
+    int i = 0;
+#if defined(__SSE2__)
+    if(weight >= 0 && weight <= PAL_WEIGHT_ONE) {
+        __m128i refs[3], hi[4], lo[4];
+        uint32_t block_hi[48], block_lo[48];
+        load_ref_sse2(refs, ref);
+        for(; i + 16 <= count; i += 16) {
+            // The weight of each entry goes to all of its channels
+            for(int e = 0; e < 16; e++) {
+                const uint8_t *c = in[i + e];
+                int m = c[0] > c[1] ? c[0] : c[1];
+                m = m > c[2] ? m : c[2];
+                int w = m * weight / 255;
+                block_hi[e * 3] = block_hi[e * 3 + 1] = block_hi[e * 3 + 2] = weight_hi(w);
+                block_lo[e * 3] = block_lo[e * 3 + 1] = block_lo[e * 3 + 2] = weight_lo(w);
+            }
+            for(int j = 0; j < 3; j++) {
+                for(int k = 0; k < 4; k++) {
+                    hi[k] = _mm_loadu_si128((const __m128i *)(block_hi + j * 16 + k * 4));
+                    lo[k] = _mm_loadu_si128((const __m128i *)(block_lo + j * 16 + k * 4));
+                }
+                __m128i v = _mm_loadu_si128((const __m128i *)(in[i] + j * 16));
+                _mm_storeu_si128((__m128i *)(out[i] + j * 16), blend16_sse2(v, refs[j], hi, lo));
+            }
+        }
+    }
+#endif
+    for(; i < count; i++) {
+        int m = in[i][0] > in[i][1] ? in[i][0] : in[i][1];
+        m = m > in[i][2] ? m : in[i][2];
+        int w = m * weight / 255;
+        int keep = PAL_WEIGHT_ONE - w;
+        for(int k = 0; k < 3; k++) {
+            out[i][k] = clamp_channel((in[i][k] * keep + ref[k] * w) / PAL_WEIGHT_ONE);
+        }
+    }
+    return screen_palette_set_range(pal, start, count, out);
+}
+
+int screen_palette_light(screen_palette *pal, int start, int count, const uint8_t ref[3], int level) {
+    if((count = clip_range(&start, count)) == 0) {
+        return 0;
+    }
+    uint8_t out[256][3];
+    const uint8_t (*in)[3] = pal->data + start;
+    for(int i = 0; i < count; i++) {
+        int m = in[i][0] > in[i][1] ? in[i][0] : in[i][1];
+        m = m > in[i][2] ? m : in[i][2];
+        for(int k = 0; k < 3; k++) {
+            int64_t v = (int64_t)m * level * ref[k] * in[i][k] * in[i][k] / (255 * 255);
+            out[i][k] = v > 255 ? 255 : (v < 0 ? 0 : v);
+        }
+    }
+    return screen_palette_set_range(pal, start, count, out);
+}
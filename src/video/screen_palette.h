@@ -3,9 +3,79 @@
 
 #include <stdint.h>
 
+// Weight of 1.0 for the palette blending functions. Byte weights (x / 255) and weights interpolated between them
+// in 1/256 steps are both exact.
+#define PAL_WEIGHT_ONE (255 * 256)
+
+// Palette versions are kept per range of entries, so that a change only invalidates the textures that use it
+#define PALETTE_RANGE_SIZE 16
+#define PALETTE_RANGES (256 / PALETTE_RANGE_SIZE)
+
 typedef struct {
     uint8_t data[256][3];
-    unsigned int version;
+    uint32_t changed[8];                   // Entries written since the last commit, one bit per entry
+    unsigned int versions[PALETTE_RANGES]; // Bumped by screen_palette_commit() when colors in the range change
+    uint8_t committed[256][3];             // Colors as of the last commit
 } screen_palette;
 
+/**
+ * Bumps the versions of the ranges whose colors differ from the last commit.
+ *
+ * Entries may be changed many times between commits, e.g. reset and then changed back during a frame. Only
+ * the colors at commit time matter, so that does not invalidate anything.
+ */
+void screen_palette_commit(screen_palette *pal);
+
+/**
+ * Bumps the versions of all ranges, whether their colors changed or not.
+ */
+void screen_palette_invalidate(screen_palette *pal);
+
+/**
+ * Gets the combined version of a set of ranges. Versions only grow, so the combined version changes
+ * whenever any of the ranges changes.
+ *
+ * \param pal Palette
+ * \param ranges Bit mask of ranges, bit n is entries n * PALETTE_RANGE_SIZE to (n + 1) * PALETTE_RANGE_SIZE - 1
+ */
+unsigned int screen_palette_get_version(const screen_palette *pal, uint16_t ranges);
+
+/**
+ * Tells whether palette entry has been written with a new color since the last commit.
+ */
+int screen_palette_is_changed(const screen_palette *pal, int index);
+
+/**
+ * Writes palette entries, and marks the ones that get a new color as changed.
+ *
+ * \return 1 if any entry got a new color, 0 otherwise.
+ */
+int screen_palette_set_range(screen_palette *pal, int start, int count, const uint8_t (*colors)[3]);
+
+/**
+ * Blends palette entries towards a color: entry + (ref - entry) * weight.
+ *
+ * \param pal Palette to change
+ * \param start First entry
+ * \param count Number of entries
+ * \param ref Color to blend towards
+ * \param weight Blend weight, PAL_WEIGHT_ONE replaces the entries with ref
+ * \return 1 if any entry got a new color, 0 otherwise.
+ */
+int screen_palette_blend(screen_palette *pal, int start, int count, const uint8_t ref[3], int weight);
+
+/**
+ * Like screen_palette_blend(), but each entry is blended in proportion to its brightest channel, so dark
+ * colors stay dark.
+ */
+int screen_palette_tint(screen_palette *pal, int start, int count, const uint8_t ref[3], int weight);
+
+/**
+ * Lights palette entries up with a color: entry^2 * ref * level * brightest channel / 255^2, per channel.
+ *
+ * \param level Strength of the effect, 0 turns the entries black
+ * \return 1 if any entry got a new color, 0 otherwise.
+ */
+int screen_palette_light(screen_palette *pal, int start, int count, const uint8_t ref[3], int level);
+
 #endif // SCREEN_PALETTE_H
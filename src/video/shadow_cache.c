@@ -0,0 +1,163 @@
+#include "video/shadow_cache.h"
+#include "utils/allocator.h"
+#include "utils/flatmap.h"
+#include "utils/log.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define CACHE_LIFETIME 300
+
+// Opacity of one copy of the sprite, and of two overlapping copies
+#define SHADOW_ALPHA 65
+#define SHADOW_ALPHA_OVERLAP (SHADOW_ALPHA + SHADOW_ALPHA * (255 - SHADOW_ALPHA) / 255)
+
+typedef struct shadow_cache_key_t {
+    surface *c_surface;
+    uint16_t w, h;
+    uint16_t shadow_h;
+    uint8_t flip;
+    uint8_t fade;
+} shadow_cache_key;
+
+typedef struct shadow_cache_value_t {
+    SDL_Texture *tex;
+    unsigned int age;
+} shadow_cache_value;
+
+typedef struct shadow_cache_t {
+    flatmap entries;
+    unsigned int hits;
+    unsigned int misses;
+    SDL_Renderer *renderer;
+} shadow_cache;
+
+static shadow_cache *cache = NULL;
+
+void shadow_cache_init(SDL_Renderer *renderer) {
+    cache = omf_calloc(1, sizeof(shadow_cache));
+    flatmap_create(&cache->entries, 5, sizeof(shadow_cache_key), sizeof(shadow_cache_value));
+    cache->renderer = renderer;
+    DEBUG("Shadow cache initialized.");
+}
+
+void shadow_cache_reinit(SDL_Renderer *renderer) {
+    cache->renderer = renderer;
+    shadow_cache_clear();
+}
+
+void shadow_cache_clear() {
+    iterator it;
+    flatmap_iter_begin(&cache->entries, &it);
+    flatmap_pair *pair;
+    while((pair = iter_next(&it)) != NULL) {
+        shadow_cache_value *entry = pair->val;
+        SDL_DestroyTexture(entry->tex);
+    }
+    flatmap_clear(&cache->entries);
+}
+
+void shadow_cache_tick() {
+    iterator it;
+    flatmap_iter_begin(&cache->entries, &it);
+    flatmap_pair *pair;
+    while((pair = iter_next(&it)) != NULL) {
+        shadow_cache_value *entry = pair->val;
+        entry->age++;
+        if(entry->age > CACHE_LIFETIME) {
+            SDL_DestroyTexture(entry->tex);
+            flatmap_delete(&cache->entries, &it);
+        }
+    }
+}
+
+void shadow_cache_close() {
+    DEBUG("Shadow cache:");
+    DEBUG(" * Misses:    %d", cache->misses);
+    DEBUG(" * Hits:      %d", cache->hits);
+    shadow_cache_clear();
+    flatmap_free(&cache->entries);
+    omf_free(cache);
+}
+
+// Tells whether the squashed and flipped sprite covers the shadow pixel (x, y)
+static int covers(const surface *sur, int shadow_h, SDL_RendererFlip flip, int x, int y) {
+    if(x < 0 || y < 0 || x >= sur->w || y >= shadow_h) {
+        return 0;
+    }
+    // Sample the middle of the source rows that are squashed into this one
+    int src_y = ((2 * y + 1) * sur->h) / (2 * shadow_h);
+    int src_x = (flip & SDL_FLIP_HORIZONTAL) ? sur->w - 1 - x : x;
+    if(flip & SDL_FLIP_VERTICAL) {
+        src_y = sur->h - 1 - src_y;
+    }
+    return surface_stencil_get(sur, src_y * sur->w + src_x);
+}
+
+static SDL_Texture *create_shadow(const surface *sur, int shadow_h, SDL_RendererFlip flip, int fade) {
+    int w = sur->w + 1;
+    int h = shadow_h + 1;
+    uint32_t *pixels = omf_calloc(w * h, sizeof(uint32_t));
+
+    // Two copies of the sprite, the second one offset by a pixel, make the shadow look blobbier.
+    // Only alpha is set, the shadow itself is black.
+    for(int y = 0; y < h; y++) {
+        for(int x = 0; x < w; x++) {
+            int count = covers(sur, shadow_h, flip, x, y) + covers(sur, shadow_h, flip, x - 1, y - 1);
+            int alpha = (count == 2) ? SHADOW_ALPHA_OVERLAP : (count == 1) ? SHADOW_ALPHA : 0;
+            if(fade) {
+                // The top of the shadow is furthest away from the feet
+                alpha = alpha * (y + 1) / h;
+            }
+            pixels[y * w + x] = (uint32_t)alpha << 24;
+        }
+    }
+
+    SDL_Texture *tex =
+        SDL_CreateTexture(cache->renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, w, h);
+    if(tex != NULL) {
+        SDL_UpdateTexture(tex, NULL, pixels, w * sizeof(uint32_t));
+        SDL_SetTextureBlendMode(tex, SDL_BLENDMODE_BLEND);
+    } else {
+        PERROR("Unable to create shadow texture: %s", SDL_GetError());
+    }
+    omf_free(pixels);
+    return tex;
+}
+
+SDL_Texture *shadow_cache_get(surface *sur, int h, SDL_RendererFlip flip, int fade) {
+    if(sur == NULL || sur->type != SURFACE_TYPE_PALETTE || sur->stencil == NULL || sur->w == 0 || h <= 0) {
+        return NULL;
+    }
+
+    shadow_cache_key key;
+    memset(&key, 0, sizeof(shadow_cache_key));
+    key.c_surface = sur;
+    key.w = sur->w;
+    key.h = sur->h;
+    key.shadow_h = h;
+    key.flip = flip;
+    key.fade = fade ? 1 : 0;
+
+    shadow_cache_value *val = NULL;
+    unsigned int tmp_size;
+    flatmap_get(&cache->entries, &key, sizeof(shadow_cache_key), (void **)&val, &tmp_size);
+
+    // The refresh flag is left for the texture cache to reset
+    if(val != NULL && !sur->force_refresh) {
+        val->age = 0;
+        cache->hits++;
+        return val->tex;
+    }
+
+    shadow_cache_value new_entry;
+    new_entry.age = 0;
+    new_entry.tex = create_shadow(sur, h, flip, fade);
+    if(val != NULL) {
+        SDL_DestroyTexture(val->tex);
+        *val = new_entry;
+    } else if(new_entry.tex != NULL) {
+        flatmap_put(&cache->entries, &key, sizeof(shadow_cache_key), &new_entry, sizeof(shadow_cache_value));
+    }
+    cache->misses++;
+    return new_entry.tex;
+}
@@ -0,0 +1,32 @@
+#ifndef SHADOW_CACHE_H
+#define SHADOW_CACHE_H
+
+#include "video/surface.h"
+#include <SDL.h>
+
+/**
+ * Cache of ready made shadow textures.
+ *
+ * A shadow is the stencil of a palette surface, squashed vertically and drawn as translucent black. The cached
+ * texture already contains both offset copies that make up the shadow blob, so a shadow is a single draw.
+ * Shadows only depend on the stencil, so palette changes do not invalidate them.
+ */
+
+void shadow_cache_init(SDL_Renderer *renderer);
+void shadow_cache_reinit(SDL_Renderer *renderer);
+void shadow_cache_close();
+void shadow_cache_clear();
+void shadow_cache_tick();
+
+/**
+ * Gets the shadow texture for a surface.
+ *
+ * \param sur Palette surface that casts the shadow
+ * \param h Height of the squashed shadow, before the blob offset
+ * \param flip SDL flip mode of the surface
+ * \param fade 1 if the shadow should fade out towards its far end
+ * \return Texture of size (sur->w + 1) x (h + 1), or NULL if the surface has no shadow.
+ */
+SDL_Texture *shadow_cache_get(surface *sur, int h, SDL_RendererFlip flip, int fade);
+
+#endif // SHADOW_CACHE_H
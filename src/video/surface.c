@@ -4,18 +4,24 @@
 #include <string.h>
 #include <utils/log.h>
 
+// Bytes needed for a stencil of w * h pixels
+static int stencil_size(int w, int h) {
+    return (w * h + 7) / 8;
+}
+
 void surface_create(surface *sur, int type, int w, int h) {
     if(type == SURFACE_TYPE_RGBA) {
         sur->data = omf_calloc(1, w * h * 4);
         sur->stencil = NULL;
     } else {
         sur->data = omf_calloc(1, w * h);
-        sur->stencil = omf_calloc(1, w * h);
+        sur->stencil = omf_calloc(1, stencil_size(w, h));
     }
     sur->w = w;
     sur->h = h;
     sur->type = type;
     sur->force_refresh = 0;
+    memset(sur->pal_used, 0, sizeof(sur->pal_used));
 }
 
 void surface_force_refresh(surface *sur) {
@@ -27,7 +33,23 @@ void surface_create_from_data(surface *sur, int type, int w, int h, const char *
     int size = w * h * ((type == SURFACE_TYPE_PALETTE) ? 1 : 4);
     memcpy(sur->data, src, size);
     if(type == SURFACE_TYPE_PALETTE) {
-        memset(sur->stencil, 1, w * h);
+        memset(sur->stencil, 0xFF, stencil_size(w, h));
+        for(int i = 0; i < size; i++) {
+            surface_mark_index(sur, sur->data[i]);
+        }
+    }
+}
+
+// Sets the stencil from a byte per pixel array, where non-zero means visible
+void surface_set_stencil(surface *sur, const char *src) {
+    int len = sur->w * sur->h;
+    memset(sur->stencil, 0, stencil_size(sur->w, sur->h));
+    memset(sur->pal_used, 0, sizeof(sur->pal_used));
+    for(int i = 0; i < len; i++) {
+        if(src[i]) {
+            sur->stencil[i >> 3] |= 1 << (i & 7);
+            surface_mark_index(sur, sur->data[i]);
+        }
     }
 }
 
@@ -59,6 +81,7 @@ void surface_clear(surface *sur) {
         memset(sur->data, 0, sur->w * sur->h * 4);
     } else {
         memset(sur->data, 0, sur->w * sur->h);
+        surface_mark_index(sur, 0);
     }
 }
 
@@ -85,7 +108,8 @@ void surface_copy_ex(surface *dst, surface *src) {
     int size = src->w * src->h * ((src->type == SURFACE_TYPE_PALETTE) ? 1 : 4);
     memcpy(dst->data, src->data, size);
     if(src->stencil != NULL)
-        memcpy(dst->stencil, src->stencil, src->w * src->h);
+        memcpy(dst->stencil, src->stencil, stencil_size(src->w, src->h));
+    memcpy(dst->pal_used, src->pal_used, sizeof(dst->pal_used));
 }
 
 // Copies a surface to a new surface
@@ -97,10 +121,11 @@ void surface_copy(surface *dst, surface *src) {
     memcpy(dst->data, src->data, size);
 
     if(src->stencil != NULL && dst->stencil != NULL) {
-        memcpy(dst->stencil, src->stencil, src->w * src->h);
+        memcpy(dst->stencil, src->stencil, stencil_size(src->w, src->h));
     } else {
         dst->stencil = NULL;
     }
+    memcpy(dst->pal_used, src->pal_used, sizeof(dst->pal_used));
 }
 
 // Copies a an area of old surface to an entirely new surface
@@ -129,7 +154,7 @@ void surface_sub(surface *dst, surface *src, int dst_x, int dst_y, int src_x, in
                 dst->data[dst_offset + m] = src->data[src_offset + m];
             }
             if(bytes == 1) {
-                dst->stencil[dst_offset] = src->stencil[src_offset];
+                surface_stencil_set(dst, dst_offset, surface_stencil_get(src, src_offset));
             }
         }
     }
@@ -143,27 +168,31 @@ void surface_additive_blit(surface *dst, surface *src, int dst_x, int dst_y, pal
         return;
     }
 
+    // Clip to the destination surface, so that the inner loop has no bounds checks
+    int x_start = (dst_x < 0) ? -dst_x : 0;
+    int y_start = (dst_y < 0) ? -dst_y : 0;
+    int x_end = (dst->w - dst_x < src->w) ? dst->w - dst_x : src->w;
+    int y_end = (dst->h - dst_y < src->h) ? dst->h - dst_y : src->h;
+
     int src_offset, dst_offset;
     uint8_t src_index, dst_index;
-    for(int y = 0; y < src->h; y++) {
-        for(int x = 0; x < src->w; x++) {
-            // If pixel offscreen, skip
-            if(dst_x + x >= dst->w || dst_y + y >= dst->h || dst_x + x < 0 || dst_y + y < 0)
-                continue;
-
+    for(int y = y_start; y < y_end; y++) {
+        int src_row = ((flip & SDL_FLIP_VERTICAL) ? src->h - y : y) * src->w;
+        int dst_row = (dst_y + y) * dst->w + dst_x;
+        for(int x = x_start; x < x_end; x++) {
             // Calculate pixel offsets
-            src_offset = ((flip & SDL_FLIP_HORIZONTAL) ? src->w - x : x) +
-                         ((flip & SDL_FLIP_VERTICAL) ? src->h - y : y) * src->w;
-            dst_offset = dst_x + x + (dst_y + y) * dst->w;
+            src_offset = ((flip & SDL_FLIP_HORIZONTAL) ? src->w - x : x) + src_row;
+            dst_offset = dst_row + x;
 
             // Do blit, if pixel is visible on stencil
-            if(dst->stencil[dst_offset] == 1) {
+            if(surface_stencil_get(dst, dst_offset)) {
                 if(src->data[src_offset] == 0)
                     continue;
 
                 src_index = src->data[src_offset] + 3;
                 dst_index = dst->data[dst_offset];
                 dst->data[dst_offset] = remap_pal->remaps[src_index][dst_index];
+                surface_mark_index(dst, dst->data[dst_offset]);
             }
         }
     }
@@ -202,22 +231,31 @@ void surface_alpha_blit(surface *dst, surface *src, int dst_x, int dst_y, SDL_Re
         return;
     }
 
+    // Clip to the destination surface, so that the inner loop has no bounds checks
+    int x_start = (dst_x < 0) ? -dst_x : 0;
+    int y_start = (dst_y < 0) ? -dst_y : 0;
+    int x_end = (dst->w - dst_x < src->w) ? dst->w - dst_x : src->w;
+    int y_end = (dst->h - dst_y < src->h) ? dst->h - dst_y : src->h;
+
     int src_offset, dst_offset;
-    for(int y = 0; y < src->h; y++) {
-        for(int x = 0; x < src->w; x++) {
-            // If pixel offscreen, skip
-            if(dst_x + x >= dst->w || dst_y + y >= dst->h || dst_x + x < 0 || dst_y + y < 0)
+    for(int y = y_start; y < y_end; y++) {
+        int src_row = ((flip & SDL_FLIP_VERTICAL) ? src->h - 1 - y : y) * src->w;
+        int dst_row = (dst_y + y) * dst->w + dst_x;
+        for(int x = x_start; x < x_end; x++) {
+            src_offset = ((flip & SDL_FLIP_HORIZONTAL) ? src->w - 1 - x : x) + src_row;
+
+            // Skip a whole stencil byte at a time when it is empty
+            if(src->stencil[src_offset >> 3] == 0 && !(flip & SDL_FLIP_HORIZONTAL)) {
+                int skip = 8 - (src_offset & 7);
+                x += skip - 1;
                 continue;
-
-            // Calculate offsets
-            src_offset = ((flip & SDL_FLIP_HORIZONTAL) ? src->w - 1 - x : x) +
-                         ((flip & SDL_FLIP_VERTICAL) ? src->h - 1 - y : y) * src->w;
-            dst_offset = dst_x + x + (dst_y + y) * dst->w;
+            }
 
             // If pixel is visible on stencil, do blit
-            if(src->stencil[src_offset] == 1) {
+            if(surface_stencil_get(src, src_offset)) {
+                dst_offset = dst_row + x;
                 dst->data[dst_offset] = src->data[src_offset];
-                dst->stencil[dst_offset] = 1;
+                surface_stencil_set(dst, dst_offset, 1);
             }
         }
     }
@@ -246,15 +284,10 @@ void surface_to_rgba(surface *sur, char *dst, screen_palette *pal, char *remap_t
     if(sur->type == SURFACE_TYPE_RGBA) {
         memcpy(dst, sur->data, sur->w * sur->h * 4);
     } else {
-        int n = 0;
-        uint8_t idx = 0;
-        for(int i = 0; i < sur->w * sur->h; i++) {
-            n = i * 4;
-            if(remap_table != NULL) {
-                idx = (uint8_t)remap_table[(uint8_t)sur->data[i]];
-            } else {
-                idx = (uint8_t)sur->data[i];
-            }
+        // Resolve the remapping and palette offset once per color instead of once per pixel
+        uint8_t colors[256];
+        for(int c = 0; c < 256; c++) {
+            uint8_t idx = (remap_table != NULL) ? (uint8_t)remap_table[c] : (uint8_t)c;
             // TODO: This is kind of a hack. Since the pal_offset
             // is only ever used for player 2 har, we can safely
             // make some assumptions. therefore, only apply offset,
@@ -262,12 +295,51 @@ void surface_to_rgba(surface *sur, char *dst, screen_palette *pal, char *remap_t
             if(idx < 48) {
                 idx += pal_offset;
             }
-            *(dst + n + 0) = pal->data[idx][0];
-            *(dst + n + 1) = pal->data[idx][1];
-            *(dst + n + 2) = pal->data[idx][2];
-            *(dst + n + 3) = (sur->stencil[i] == 1) ? 0xFF : 0;
+            colors[c] = idx;
+        }
+
+        // Each stencil byte covers 8 pixels
+        int len = sur->w * sur->h;
+        for(int base = 0; base < len; base += 8) {
+            uint8_t bits = sur->stencil[base >> 3];
+            int end = (base + 8 < len) ? base + 8 : len;
+            for(int i = base; i < end; i++, bits >>= 1) {
+                uint8_t idx = colors[(uint8_t)sur->data[i]];
+                char *out = dst + i * 4;
+                // Hidden pixels are left black, so that they do not depend on the palette
+                uint8_t mask = (bits & 1) ? 0xFF : 0;
+                out[0] = pal->data[idx][0] & mask;
+                out[1] = pal->data[idx][1] & mask;
+                out[2] = pal->data[idx][2] & mask;
+                out[3] = mask;
+            }
+        }
+    }
+}
+
+uint16_t surface_palette_ranges(const surface *sur, const char *remap_table, uint8_t pal_offset) {
+    uint16_t ranges = 0;
+    if(remap_table == NULL && pal_offset == 0) {
+        for(int r = 0; r < PALETTE_RANGES; r++) {
+            if((sur->pal_used[r / 2] >> ((r % 2) * PALETTE_RANGE_SIZE)) & 0xFFFF) {
+                ranges |= 1 << r;
+            }
+        }
+        return ranges;
+    }
+
+    // Same index resolution as in surface_to_rgba()
+    for(int c = 0; c < 256; c++) {
+        if(!((sur->pal_used[c / 32] >> (c % 32)) & 1)) {
+            continue;
+        }
+        uint8_t idx = (remap_table != NULL) ? (uint8_t)remap_table[c] : (uint8_t)c;
+        if(idx < 48) {
+            idx += pal_offset;
         }
+        ranges |= 1 << (idx / PALETTE_RANGE_SIZE);
     }
+    return ranges;
 }
 
 // Copies surface to an existing texture.
@@ -11,10 +11,34 @@ typedef struct {
     int h;
     int type;
     char *data;
-    char *stencil;
+    uint8_t *stencil;     // Palette surfaces only; 1 bit per pixel, row-major, least significant bit first
+    uint32_t pal_used[8]; // Palette surfaces only; palette indices of the visible pixels, 1 bit per index
     uint8_t force_refresh;
 } surface;
 
+/**
+ * Adds a palette index to the ones used by the surface. Needed when visible pixels are written directly.
+ */
+static inline void surface_mark_index(surface *sur, uint8_t index) {
+    sur->pal_used[index / 32] |= (uint32_t)1 << (index % 32);
+}
+
+/**
+ * Tells whether the pixel at the given offset (y * w + x) is visible.
+ */
+static inline int surface_stencil_get(const surface *sur, int offset) {
+    return (sur->stencil[offset >> 3] >> (offset & 7)) & 1;
+}
+
+static inline void surface_stencil_set(surface *sur, int offset, int visible) {
+    if(visible) {
+        sur->stencil[offset >> 3] |= 1 << (offset & 7);
+        surface_mark_index(sur, sur->data[offset]);
+    } else {
+        sur->stencil[offset >> 3] &= ~(1 << (offset & 7));
+    }
+}
+
 enum
 {
     SURFACE_TYPE_RGBA,
@@ -31,6 +55,7 @@ void surface_create(surface *sur, int type, int w, int h);
 void surface_force_refresh(surface *sur);
 void surface_create_from_image(surface *sur, image *img);
 void surface_create_from_data(surface *sur, int type, int w, int h, const char *src);
+void surface_set_stencil(surface *sur, const char *src);
 int surface_to_image(surface *sur, image *img);
 void surface_copy(surface *dst, surface *src);
 void surface_copy_ex(surface *dst, surface *src);
@@ -41,6 +66,16 @@ void surface_sub(surface *dst, surface *src, int dst_x, int dst_y, int src_x, in
 void surface_convert_to_rgba(surface *sur, screen_palette *pal, int pal_offset);
 int surface_get_type(surface *sur);
 void surface_to_rgba(surface *sur, char *dst, screen_palette *pal, char *remap_table, uint8_t pal_offset);
+
+/**
+ * Gets the palette ranges that the surface takes colors from, for screen_palette_get_version().
+ *
+ * \param sur Palette surface
+ * \param remap_table Remapping table the surface is drawn with, or NULL
+ * \param pal_offset Palette offset the surface is drawn with
+ * \return Bit mask of palette ranges
+ */
+uint16_t surface_palette_ranges(const surface *sur, const char *remap_table, uint8_t pal_offset);
 void surface_additive_blit(surface *dst, surface *src, int dst_x, int dst_y, palette *remap_pal, SDL_RendererFlip flip);
 void surface_rgba_blit(surface *dst, const surface *src, int dst_x, int dst_y);
 void surface_alpha_blit(surface *dst, surface *src, int dst_x, int dst_y, SDL_RendererFlip flip);
@@ -1,7 +1,8 @@
 #include "video/tcache.h"
 #include "utils/allocator.h"
-#include "utils/hashmap.h"
+#include "utils/flatmap.h"
 #include "utils/log.h"
+#include "utils/profiler.h"
 #include <stdlib.h>
 
 #define CACHE_LIFETIME 300
@@ -16,11 +17,12 @@ typedef struct tcache_entry_key_t {
 typedef struct tcache_entry_value_t {
     SDL_Texture *tex;
     unsigned int age;
-    unsigned int pal_version;
+    const screen_palette *pal;
+    unsigned int pal_version; // Combined version of the palette ranges the surface uses
 } tcache_entry_value;
 
 typedef struct tcache_t {
-    hashmap entries;
+    flatmap entries;
     unsigned int hits;
     unsigned int misses;
     unsigned int old_frees;
@@ -33,20 +35,20 @@ static tcache *cache = NULL;
 
 // Helper method for getting cache entry
 tcache_entry_value *tcache_add_entry(tcache_entry_key *key, tcache_entry_value *val) {
-    return hashmap_put(&cache->entries, (void *)key, sizeof(tcache_entry_key), (void *)val, sizeof(tcache_entry_value));
+    return flatmap_put(&cache->entries, (void *)key, sizeof(tcache_entry_key), (void *)val, sizeof(tcache_entry_value));
 }
 
 // Helper method for setting cache entry
 tcache_entry_value *tcache_get_entry(tcache_entry_key *key) {
     tcache_entry_value *val = NULL;
     unsigned int tmp_size;
-    hashmap_get(&cache->entries, (void *)key, sizeof(tcache_entry_key), (void **)&val, &tmp_size);
+    flatmap_get(&cache->entries, (void *)key, sizeof(tcache_entry_key), (void **)&val, &tmp_size);
     return val;
 }
 
 void tcache_init(SDL_Renderer *renderer, int scale_factor, scaler_plugin *scaler) {
     cache = omf_calloc(1, sizeof(tcache));
-    hashmap_create(&cache->entries, 6);
+    flatmap_create(&cache->entries, 6, sizeof(tcache_entry_key), sizeof(tcache_entry_value));
     cache->renderer = renderer;
     cache->scaler = scaler;
     cache->scale_factor = scale_factor;
@@ -65,25 +67,25 @@ void tcache_reinit(SDL_Renderer *renderer, int scale_factor, scaler_plugin *scal
 
 void tcache_clear() {
     iterator it;
-    hashmap_iter_begin(&cache->entries, &it);
-    hashmap_pair *pair;
+    flatmap_iter_begin(&cache->entries, &it);
+    flatmap_pair *pair;
     while((pair = iter_next(&it)) != NULL) {
         tcache_entry_value *entry = pair->val;
         SDL_DestroyTexture(entry->tex);
     }
-    hashmap_clear(&cache->entries);
+    flatmap_clear(&cache->entries);
 }
 
 void tcache_tick() {
     iterator it;
-    hashmap_iter_begin(&cache->entries, &it);
-    hashmap_pair *pair;
+    flatmap_iter_begin(&cache->entries, &it);
+    flatmap_pair *pair;
     while((pair = iter_next(&it)) != NULL) {
         tcache_entry_value *entry = pair->val;
         entry->age++;
         if(entry->age > CACHE_LIFETIME) {
             SDL_DestroyTexture(entry->tex);
-            hashmap_delete(&cache->entries, &it);
+            flatmap_delete(&cache->entries, &it);
             cache->old_frees++;
         }
     }
@@ -95,7 +97,7 @@ void tcache_close() {
     DEBUG(" * Hits:      %d", cache->hits);
     DEBUG(" * Old frees: %d", cache->old_frees);
     tcache_clear();
-    hashmap_free(&cache->entries);
+    flatmap_free(&cache->entries);
     omf_free(cache);
 }
 
@@ -119,10 +121,19 @@ SDL_Texture *tcache_get(surface *sur, screen_palette *pal, char *remap_table, ui
     key.w = sur->w;
     key.h = sur->h;
 
+    // Only palette changes in the ranges the surface actually uses make it stale
+    unsigned int pal_version = 0;
+    if(sur->type == SURFACE_TYPE_PALETTE) {
+        screen_palette_commit(pal);
+        pal_version = screen_palette_get_version(pal, surface_palette_ranges(sur, remap_table, pal_offset));
+    }
+
     // Attempt to find appropriate surface
     // If surface is cacheable and hasn't changed, just return here.
     tcache_entry_value *val = tcache_get_entry(&key);
-    if(val != NULL && (val->pal_version == pal->version || sur->type == SURFACE_TYPE_RGBA) && !sur->force_refresh) {
+    if(val != NULL &&
+       ((val->pal == pal && val->pal_version == pal_version) || sur->type == SURFACE_TYPE_RGBA) &&
+       !sur->force_refresh) {
         val->age = 0;
         cache->hits++;
         return val->tex;
@@ -130,13 +141,15 @@ SDL_Texture *tcache_get(surface *sur, screen_palette *pal, char *remap_table, ui
 
     // Reset refresh flag here
     sur->force_refresh = 0;
+    profiler_begin(PROFILE_TCACHE_MISS);
 
     // If there was no fitting surface tex in the cache at all,
     // then we need to create one
     if(val == NULL) {
         tcache_entry_value new_entry;
         new_entry.age = 0;
-        new_entry.pal_version = pal->version;
+        new_entry.pal = pal;
+        new_entry.pal_version = pal_version;
         new_entry.tex = SDL_CreateTexture(cache->renderer, SDL_PIXELFORMAT_ABGR8888, SDL_TEXTUREACCESS_STREAMING,
                                           sur->w * cache->scale_factor, sur->h * cache->scale_factor);
         SDL_SetTextureBlendMode(new_entry.tex, SDL_BLENDMODE_BLEND);
@@ -162,9 +175,11 @@ SDL_Texture *tcache_get(surface *sur, screen_palette *pal, char *remap_table, ui
 
     // Set correct age and palette version
     val->age = 0;
-    val->pal_version = pal->version;
+    val->pal = pal;
+    val->pal_version = pal_version;
 
     // Do some statistics stuff
     cache->misses++;
+    profiler_end(PROFILE_TCACHE_MISS);
     return val->tex;
 }
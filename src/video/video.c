@@ -6,14 +6,17 @@
 #include "formats/palette.h"
 #include "plugins/plugins.h"
 #include "utils/allocator.h"
+#include "utils/compat.h"
 #include "utils/list.h"
 #include "utils/log.h"
 #include "video/image.h"
+#include "video/shadow_cache.h"
 #include "video/tcache.h"
 #include "video/video.h"
 #include "video/video_state.h"
 
 static video_state state;
+static THREAD_LOCAL bool video_output = true;
 
 void reset_targets() {
     if(state.fg_target != NULL) {
@@ -71,8 +74,6 @@ int video_init(int window_w, int window_h, int fullscreen, int vsync, const char
     state.base_palette = omf_calloc(1, sizeof(palette));
     state.extra_palette = omf_calloc(1, sizeof(screen_palette));
     state.screen_palette = omf_calloc(1, sizeof(screen_palette));
-    state.extra_palette->version = 0;
-    state.screen_palette->version = 1;
 
     // Form title string
     char title[32];
@@ -121,6 +122,7 @@ int video_init(int window_w, int window_h, int fullscreen, int vsync, const char
 
     // Init texture cache
     tcache_init(state.renderer, state.scale_factor, &state.scaler);
+    shadow_cache_init(state.renderer);
 
     // Get renderer data
     SDL_RendererInfo rinfo;
@@ -139,6 +141,7 @@ int video_init(int window_w, int window_h, int fullscreen, int vsync, const char
 void video_reinit_renderer() {
     // Clear old texture cache entries
     tcache_clear();
+    shadow_cache_clear();
 
     // Kill old renderer
     SDL_DestroyRenderer(state.renderer);
@@ -151,6 +154,7 @@ void video_reinit_renderer() {
     state.renderer = SDL_CreateRenderer(state.window, -1, renderer_flags);
     SDL_RenderSetLogicalSize(state.renderer, NATIVE_W * state.scale_factor, NATIVE_H * state.scale_factor);
     tcache_reinit(state.renderer, state.scale_factor, &state.scaler);
+    shadow_cache_reinit(state.renderer);
 
     // Reset rendertarget
     reset_targets();
@@ -221,7 +225,20 @@ int video_reinit(int window_w, int window_h, int fullscreen, int vsync, const ch
     return 0;
 }
 
+bool video_bind_output(bool enabled) {
+    bool old = video_output;
+    video_output = enabled;
+    return old;
+}
+
+bool video_output_enabled(void) {
+    return video_output;
+}
+
 void video_move_target(int x, int y) {
+    if(!video_output) {
+        return;
+    }
     state.target_move_x = x * state.scale_factor;
     state.target_move_y = y * state.scale_factor;
 }
@@ -242,6 +259,9 @@ void video_get_state(int *w, int *h, int *fs, int *vsync) {
 }
 
 void video_set_fade(float fade) {
+    if(!video_output) {
+        return;
+    }
     state.fade = fade;
 }
 
@@ -256,6 +276,9 @@ int video_screenshot(image *img) {
 }
 
 int video_area_capture(surface *sur, int x, int y, int w, int h) {
+    if(!video_output) {
+        return 1;
+    }
     float scale_x = (float)state.w / NATIVE_W;
     float scale_y = (float)state.h / NATIVE_H;
 
@@ -281,13 +304,19 @@ int video_area_capture(surface *sur, int x, int y, int w, int h) {
 }
 
 void video_force_pal_refresh() {
-    memcpy(state.screen_palette->data, state.base_palette->data, 768);
-    memcpy(state.extra_palette->data, state.base_palette->data, 768);
-    state.extra_palette->version = state.screen_palette->version + 1;
-    state.screen_palette->version = state.extra_palette->version + 1;
+    if(!video_output) {
+        return;
+    }
+    screen_palette_set_range(state.screen_palette, 0, 256, state.base_palette->data);
+    screen_palette_set_range(state.extra_palette, 0, 256, state.base_palette->data);
+    screen_palette_invalidate(state.screen_palette);
+    screen_palette_invalidate(state.extra_palette);
 }
 
 void video_set_base_palette(const palette *src) {
+    if(!video_output) {
+        return;
+    }
     memcpy(state.base_palette, src, sizeof(palette));
     video_force_pal_refresh();
 }
@@ -297,11 +326,16 @@ palette *video_get_base_palette() {
 }
 
 void video_copy_pal_range(const palette *src, int src_start, int dst_start, int amount) {
-    memcpy(state.screen_palette->data + dst_start * 3, src->data + src_start * 3, amount * 3);
-    state.screen_palette->version++;
+    if(!video_output) {
+        return;
+    }
+    screen_palette_set_range(state.screen_palette, dst_start, amount, src->data + src_start);
 }
 
 void video_copy_base_pal_range(const palette *src, int src_start, int dst_start, int amount) {
+    if(!video_output) {
+        return;
+    }
     memcpy(state.base_palette->data + dst_start, src->data + src_start, amount * 3);
     video_force_pal_refresh();
 }
@@ -317,8 +351,8 @@ static void clear_render_target(SDL_Texture *target) {
 }
 
 void video_render_prepare() {
-    // Reset palette
-    memcpy(state.screen_palette->data, state.base_palette->data, 768);
+    // Reset palette. Textures are only invalidated if the colors at draw time end up different.
+    screen_palette_set_range(state.screen_palette, 0, 256, state.base_palette->data);
     clear_render_target(state.fg_target);
 }
 
@@ -443,9 +477,35 @@ void video_render_sprite_flip_scale_opacity_tint(surface *sur, int sx, int sy, u
     render_sprite_fsot(&state, sur, &dst, blend_mode, pal_offset, flip, opacity, tint);
 }
 
+void video_render_shadow(surface *sur, int sx, int sy, unsigned int flip_mode, float y_percent, int fade) {
+    int shadow_h = sur->h * y_percent;
+
+    SDL_RendererFlip flip = 0;
+    if(flip_mode & FLIP_HORIZONTAL)
+        flip |= SDL_FLIP_HORIZONTAL;
+    if(flip_mode & FLIP_VERTICAL)
+        flip |= SDL_FLIP_VERTICAL;
+
+    SDL_Texture *tex = shadow_cache_get(sur, shadow_h, flip, fade);
+    if(tex == NULL)
+        return;
+
+    // The texture has room for the offset copy that makes up the shadow
+    SDL_Rect dst;
+    dst.w = sur->w + 1;
+    dst.h = shadow_h + 1;
+    dst.x = sx;
+    dst.y = sy + (sur->h - shadow_h) / 2;
+    scale_rect(&state, &dst);
+
+    SDL_SetRenderTarget(state.renderer, state.fg_target);
+    SDL_RenderCopy(state.renderer, tex, NULL, &dst);
+}
+
 // Called on every game tick
 void video_tick() {
     tcache_tick();
+    shadow_cache_tick();
 }
 
 // Called after frame has been rendered
@@ -485,6 +545,7 @@ void video_render_finish() {
 
 void video_close() {
     tcache_close();
+    shadow_cache_close();
     SDL_DestroyTexture(state.fg_target);
     SDL_DestroyTexture(state.bg_target);
     SDL_DestroyRenderer(state.renderer);
@@ -31,6 +31,13 @@ void video_reinit_renderer();
 void video_get_state(int *w, int *h, int *fs, int *vsync);
 void video_move_target(int x, int y);
 
+// Disables screen effects (shake, fades, palette changes, captures) made by the calling thread.
+// Used by simulations that are not shown on screen. Returns the previous setting.
+bool video_bind_output(bool enabled);
+
+// Tells whether screen effects made by the calling thread are shown, see video_bind_output().
+bool video_output_enabled(void);
+
 void video_render_sprite(surface *sur, int x, int y, unsigned int render_mode, int pal_offset);
 
 void video_render_sprite_size(surface *sur, int sx, int sy, int sw, int sh);
@@ -47,6 +54,9 @@ void video_render_sprite_flip_scale_opacity_tint(surface *sur, int x, int y, uns
                                                  unsigned int flip_mode, float x_percent, float y_percent,
                                                  uint8_t opacity, color tint);
 
+// Renders the shadow of a palette surface, squashed to y_percent of its height. Fade makes the far end fainter.
+void video_render_shadow(surface *sur, int x, int y, unsigned int flip_mode, float y_percent, int fade);
+
 void video_tick();
 void video_render_background(surface *sur);
 void video_render_prepare();
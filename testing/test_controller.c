@@ -0,0 +1,40 @@
+#include <CUnit/Basic.h>
+#include <CUnit/CUnit.h>
+#include <controller/controller.h>
+#include <utils/allocator.h>
+
+void test_controller_queue_full_keeps_sync(void) {
+    controller ctrl;
+    ctrl_event_queue q;
+    serial ser;
+    controller_init(&ctrl);
+    ctrl_event_queue_init(&q);
+    serial_create(&ser);
+    serial_write_int32(&ser, 1234);
+
+    // A full queue drops new actions, and keeps the sync event in front of them
+    controller_sync(&ctrl, &ser, &q);
+    for(int i = 0; i < CTRL_EVENT_QUEUE_SIZE * 2; i++) {
+        controller_cmd(&ctrl, i, &q);
+    }
+    CU_ASSERT(q.count == CTRL_EVENT_QUEUE_SIZE);
+    CU_ASSERT(ctrl_event_queue_get(&q, 0)->type == EVENT_TYPE_SYNC);
+    CU_ASSERT(ctrl_event_queue_get(&q, 1)->event_data.action == 0);
+    CU_ASSERT(ctrl_event_queue_get(&q, CTRL_EVENT_QUEUE_SIZE - 1)->event_data.action == CTRL_EVENT_QUEUE_SIZE - 2);
+
+    // Close events always get in
+    controller_close(&ctrl, &q);
+    CU_ASSERT(q.count == 1);
+    CU_ASSERT(ctrl_event_queue_get(&q, 0)->type == EVENT_TYPE_CLOSE);
+
+    serial_free(&ser);
+    ctrl_event_queue_free(&q);
+    controller_free(&ctrl);
+}
+
+void controller_test_suite(CU_pSuite suite) {
+    if(CU_add_test(suite, "Test for controller event queue overflow", test_controller_queue_full_keeps_sync) ==
+       NULL) {
+        return;
+    }
+}
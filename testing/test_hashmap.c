@@ -1,6 +1,9 @@
 #include <CUnit/Basic.h>
 #include <CUnit/CUnit.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <string.h>
+#include <utils/flatmap.h>
 #include <utils/hashmap.h>
 #include <utils/iterator.h>
 
@@ -183,6 +186,166 @@ void hashmap_test_autoresize(void) {
     hashmap_free(&test_map);
 }
 
+static flatmap test_flatmap;
+
+void test_flatmap_create(void) {
+    flatmap_create(&test_flatmap, 4, sizeof(int), sizeof(int));
+    CU_ASSERT_PTR_NOT_NULL(test_flatmap.slots);
+    CU_ASSERT(flatmap_reserved(&test_flatmap) == 0);
+    CU_ASSERT(flatmap_size(&test_flatmap) == 16);
+}
+
+void test_flatmap_insert(void) {
+    unsigned int i, k;
+    int *v;
+    for(i = 0; i < TEST_VAL_COUNT; i++) {
+        k = TEST_VAL_COUNT - i;
+        v = flatmap_put(&test_flatmap, &i, sizeof(int), &k, sizeof(int));
+        CU_ASSERT_PTR_NOT_NULL(v);
+        CU_ASSERT(*v == k);
+        test_values[i] = k;
+    }
+    CU_ASSERT(flatmap_reserved(&test_flatmap) == TEST_VAL_COUNT);
+    CU_ASSERT(flatmap_size(&test_flatmap) >= TEST_VAL_COUNT);
+
+    // Re-adding an existing key replaces the value, size shouldn't change
+    i = TEST_VAL_COUNT / 2;
+    k = TEST_VAL_COUNT - i;
+    v = flatmap_iput(&test_flatmap, i, &k, sizeof(int));
+    CU_ASSERT(*v == test_values[i]);
+    CU_ASSERT(flatmap_reserved(&test_flatmap) == TEST_VAL_COUNT);
+
+    // Too large keys or values are refused
+    uint64_t big = 0;
+    CU_ASSERT_PTR_NULL(flatmap_put(&test_flatmap, &big, sizeof(big), &k, sizeof(int)));
+    CU_ASSERT_PTR_NULL(flatmap_iput(&test_flatmap, 0, &big, sizeof(big)));
+}
+
+void test_flatmap_get(void) {
+    unsigned int *val;
+    unsigned int vlen;
+    for(unsigned int i = 0; i < TEST_VAL_COUNT; i++) {
+        CU_ASSERT_FATAL(flatmap_get(&test_flatmap, &i, sizeof(int), (void **)&val, &vlen) == 0);
+        CU_ASSERT(*val == test_values[i]);
+        CU_ASSERT(vlen == sizeof(int));
+
+        // Integer specialization must find the same entries
+        CU_ASSERT_FATAL(flatmap_iget(&test_flatmap, i, (void **)&val, &vlen) == 0);
+        CU_ASSERT(*val == test_values[i]);
+    }
+    unsigned int missing = TEST_VAL_COUNT;
+    CU_ASSERT(flatmap_iget(&test_flatmap, missing, (void **)&val, &vlen) == 1);
+    CU_ASSERT_PTR_NULL(val);
+    CU_ASSERT(vlen == 0);
+}
+
+void test_flatmap_delete(void) {
+    unsigned int *val;
+    unsigned int vlen;
+    int removed = 0;
+    for(unsigned int i = 0; i < TEST_VAL_COUNT; i += 10) {
+        CU_ASSERT((i % 20 ? flatmap_idel(&test_flatmap, i) : flatmap_del(&test_flatmap, &i, sizeof(int))) == 0);
+        test_values[i] = 0;
+        CU_ASSERT(flatmap_iget(&test_flatmap, i, (void **)&val, &vlen) == 1);
+        removed++;
+    }
+    CU_ASSERT(flatmap_idel(&test_flatmap, 0) == 1);
+    CU_ASSERT(flatmap_reserved(&test_flatmap) == TEST_VAL_COUNT - removed);
+
+    // Everything that was not deleted must still be reachable after the backward shifts
+    for(unsigned int i = 0; i < TEST_VAL_COUNT; i++) {
+        if(test_values[i] == 0) {
+            continue;
+        }
+        CU_ASSERT_FATAL(flatmap_iget(&test_flatmap, i, (void **)&val, &vlen) == 0);
+        CU_ASSERT(*val == test_values[i]);
+    }
+}
+
+void test_flatmap_iterator(void) {
+    iterator it;
+    flatmap_iter_begin(&test_flatmap, &it);
+    flatmap_pair *pair;
+    unsigned int *val;
+    unsigned int *key;
+    unsigned int seen = 0;
+
+    while((pair = iter_next(&it)) != NULL) {
+        key = pair->key;
+        val = pair->val;
+        CU_ASSERT(pair->keylen == sizeof(int));
+        CU_ASSERT(pair->vallen == sizeof(int));
+        CU_ASSERT(*key == (TEST_VAL_COUNT - *val));
+        CU_ASSERT(test_values[*key] > 0);
+        test_values[*key] = 0;
+        seen++;
+    }
+    CU_ASSERT(seen == flatmap_reserved(&test_flatmap));
+    for(unsigned int i = 0; i < TEST_VAL_COUNT; i++) {
+        CU_ASSERT(test_values[i] == 0);
+    }
+}
+
+void test_flatmap_iter_del(void) {
+    iterator it;
+    flatmap_pair *pair;
+    unsigned int seen = 0;
+    unsigned int count = flatmap_reserved(&test_flatmap);
+
+    // Delete every other entry while iterating; each entry must still be visited exactly once
+    flatmap_iter_begin(&test_flatmap, &it);
+    while((pair = iter_next(&it)) != NULL) {
+        if(seen++ % 2 == 0) {
+            CU_ASSERT(flatmap_delete(&test_flatmap, &it) == 0);
+        }
+    }
+    CU_ASSERT(seen == count);
+    CU_ASSERT(flatmap_reserved(&test_flatmap) == count / 2);
+
+    flatmap_iter_begin(&test_flatmap, &it);
+    while((pair = iter_next(&it)) != NULL) {
+        CU_ASSERT(flatmap_delete(&test_flatmap, &it) == 0);
+    }
+    CU_ASSERT(flatmap_reserved(&test_flatmap) == 0);
+}
+
+void test_flatmap_clear(void) {
+    for(unsigned int i = 0; i < TEST_VAL_COUNT; i++) {
+        flatmap_iput(&test_flatmap, i, &i, sizeof(int));
+    }
+    flatmap_clear(&test_flatmap);
+    CU_ASSERT(flatmap_reserved(&test_flatmap) == 0);
+
+    unsigned int *val;
+    unsigned int vlen;
+    CU_ASSERT(flatmap_iget(&test_flatmap, 1, (void **)&val, &vlen) == 1);
+}
+
+void test_flatmap_free(void) {
+    flatmap_free(&test_flatmap);
+    CU_ASSERT_PTR_NULL(test_flatmap.slots);
+    CU_ASSERT(flatmap_reserved(&test_flatmap) == 0);
+}
+
+void test_flatmap_string_keys(void) {
+    flatmap map;
+    char key[16];
+    unsigned int *val;
+    unsigned int vlen;
+    flatmap_create(&map, 2, sizeof(key), sizeof(int));
+    for(unsigned int i = 0; i < 200; i++) {
+        snprintf(key, sizeof(key), "key%u", i);
+        flatmap_put(&map, key, strlen(key) + 1, &i, sizeof(int));
+    }
+    for(unsigned int i = 0; i < 200; i++) {
+        snprintf(key, sizeof(key), "key%u", i);
+        CU_ASSERT_FATAL(flatmap_get(&map, key, strlen(key) + 1, (void **)&val, &vlen) == 0);
+        CU_ASSERT(*val == i);
+    }
+    CU_ASSERT(flatmap_get(&map, "key", 4, (void **)&val, &vlen) == 1);
+    flatmap_free(&map);
+}
+
 void hashmap_test_suite(CU_pSuite suite) {
     // Add tests
     if(CU_add_test(suite, "Test for hashmap create", test_hashmap_create) == NULL) {
@@ -218,4 +381,31 @@ void hashmap_test_suite(CU_pSuite suite) {
     if(CU_add_test(suite, "Test for hashmap auto resize", hashmap_test_autoresize) == NULL) {
         return;
     }
+    if(CU_add_test(suite, "Test for flatmap create", test_flatmap_create) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for flatmap insert operation", test_flatmap_insert) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for flatmap get operation", test_flatmap_get) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for flatmap delete operation", test_flatmap_delete) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for flatmap iterator", test_flatmap_iterator) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for flatmap iterator delete operation", test_flatmap_iter_del) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for flatmap clear operation", test_flatmap_clear) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for flatmap free operation", test_flatmap_free) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for flatmap string keys", test_flatmap_string_keys) == NULL) {
+        return;
+    }
 }
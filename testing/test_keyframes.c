@@ -0,0 +1,144 @@
+#include <CUnit/Basic.h>
+#include <CUnit/CUnit.h>
+#include <game/utils/keyframes.h>
+#include <stdio.h>
+#include <string.h>
+
+#define KF_TEST_FILE "test.kf"
+#define KF_TEST_HASH 0x12345678
+#define KF_TEST_MOVES 100
+
+// Makes keyframes at ticks 0, 250 and 500, with the tick as the state
+static void make_keyframes(keyframes *kf) {
+    keyframes_create(kf, KEYFRAME_INTERVAL, KF_TEST_HASH, KF_TEST_MOVES);
+    for(int i = 0; i < 3; i++) {
+        serial state;
+        serial_create(&state);
+        serial_write_int32(&state, i * KEYFRAME_INTERVAL);
+        keyframes_add(kf, i * KEYFRAME_INTERVAL, &state);
+    }
+}
+
+void test_keyframes_roundtrip(void) {
+    keyframes kf, loaded;
+    make_keyframes(&kf);
+    CU_ASSERT(keyframes_is_dirty(&kf));
+    CU_ASSERT(keyframes_save(&kf, KF_TEST_FILE) == 0);
+    CU_ASSERT(!keyframes_is_dirty(&kf));
+
+    keyframes_create(&loaded, 1, KF_TEST_HASH, KF_TEST_MOVES);
+    CU_ASSERT(keyframes_load(&loaded, KF_TEST_FILE) == 0);
+    CU_ASSERT(!keyframes_is_dirty(&loaded));
+    CU_ASSERT(loaded.interval == KEYFRAME_INTERVAL);
+    CU_ASSERT_FATAL(vector_size(&loaded.frames) == 3);
+    for(int i = 0; i < 3; i++) {
+        keyframe *a = vector_get(&kf.frames, i);
+        keyframe *b = vector_get(&loaded.frames, i);
+        CU_ASSERT(a->tick == b->tick);
+        CU_ASSERT(serial_len(&a->state) == serial_len(&b->state));
+        CU_ASSERT(memcmp(a->state.data, b->state.data, serial_len(&a->state)) == 0);
+    }
+
+    keyframes_free(&loaded);
+    keyframes_free(&kf);
+    remove(KF_TEST_FILE);
+}
+
+void test_keyframes_foreign_file(void) {
+    keyframes kf, other;
+    make_keyframes(&kf);
+    CU_ASSERT(keyframes_save(&kf, KF_TEST_FILE) == 0);
+
+    // Files made for another recording are ignored, and keep the keyframes as they were
+    keyframes_create(&other, KEYFRAME_INTERVAL, KF_TEST_HASH + 1, KF_TEST_MOVES);
+    CU_ASSERT(keyframes_load(&other, KF_TEST_FILE) == 1);
+    CU_ASSERT(vector_size(&other.frames) == 0);
+    keyframes_free(&other);
+
+    keyframes_create(&other, KEYFRAME_INTERVAL, KF_TEST_HASH, KF_TEST_MOVES + 1);
+    CU_ASSERT(keyframes_load(&other, KF_TEST_FILE) == 1);
+    CU_ASSERT(vector_size(&other.frames) == 0);
+    keyframes_free(&other);
+
+    // So are files made by another version of the game. The engine version follows the magic and file version.
+    FILE *fp = fopen(KF_TEST_FILE, "r+b");
+    CU_ASSERT_PTR_NOT_NULL_FATAL(fp);
+    fseek(fp, 7 + 4, SEEK_SET);
+    fputc(0xFF, fp);
+    fclose(fp);
+    keyframes_create(&other, KEYFRAME_INTERVAL, KF_TEST_HASH, KF_TEST_MOVES);
+    CU_ASSERT(keyframes_load(&other, KF_TEST_FILE) == 1);
+    CU_ASSERT(vector_size(&other.frames) == 0);
+    keyframes_free(&other);
+
+    keyframes_free(&kf);
+    remove(KF_TEST_FILE);
+}
+
+void test_keyframes_corrupt_length(void) {
+    keyframes kf, loaded;
+    make_keyframes(&kf);
+    CU_ASSERT(keyframes_save(&kf, KF_TEST_FILE) == 0);
+
+    // The header is the magic and 7 words. Each keyframe is its tick, its length and the state.
+    long second_len = 7 + 7 * 4 + 4 + 4 + serial_len(&((keyframe *)vector_get(&kf.frames, 0))->state) + 4;
+    FILE *fp = fopen(KF_TEST_FILE, "r+b");
+    CU_ASSERT_PTR_NOT_NULL_FATAL(fp);
+    fseek(fp, second_len, SEEK_SET);
+    fputc(0xFF, fp);
+    fputc(0xFF, fp);
+    fputc(0xFF, fp);
+    fputc(0x7F, fp);
+    fclose(fp);
+
+    // Keyframes up to the bad length are kept
+    keyframes_create(&loaded, KEYFRAME_INTERVAL, KF_TEST_HASH, KF_TEST_MOVES);
+    CU_ASSERT(keyframes_load(&loaded, KF_TEST_FILE) == 0);
+    CU_ASSERT(vector_size(&loaded.frames) == 1);
+    keyframes_free(&loaded);
+
+    keyframes_free(&kf);
+    remove(KF_TEST_FILE);
+}
+
+void test_keyframes_find(void) {
+    keyframes kf;
+    make_keyframes(&kf);
+
+    // Seeking starts from the last keyframe at or before the target tick
+    CU_ASSERT(keyframes_find(&kf, 0)->tick == 0);
+    CU_ASSERT(keyframes_find(&kf, 249)->tick == 0);
+    CU_ASSERT(keyframes_find(&kf, 250)->tick == 250);
+    CU_ASSERT(keyframes_find(&kf, 100000)->tick == 500);
+    keyframes_free(&kf);
+
+    keyframes_create(&kf, KEYFRAME_INTERVAL, KF_TEST_HASH, KF_TEST_MOVES);
+    CU_ASSERT_PTR_NULL(keyframes_find(&kf, 100));
+    keyframes_free(&kf);
+}
+
+void test_keyframes_hash_file(void) {
+    const char *rec_file = TESTS_ROOT_DIR "/recs/crystal-shirro.rec";
+    uint32_t hash = keyframes_hash_file(rec_file);
+    CU_ASSERT(hash != 0);
+    CU_ASSERT(keyframes_hash_file(rec_file) == hash);
+    CU_ASSERT(keyframes_hash_file(TESTS_ROOT_DIR "/recs/missing.rec") == 0);
+}
+
+void keyframes_test_suite(CU_pSuite suite) {
+    if(CU_add_test(suite, "Test for keyframe file roundtrip", test_keyframes_roundtrip) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for ignoring foreign keyframe files", test_keyframes_foreign_file) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for corrupt keyframe lengths", test_keyframes_corrupt_length) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for finding the keyframe to seek from", test_keyframes_find) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for hashing recordings", test_keyframes_hash_file) == NULL) {
+        return;
+    }
+}
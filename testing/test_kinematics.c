@@ -0,0 +1,71 @@
+#include <CUnit/Basic.h>
+#include <CUnit/CUnit.h>
+#include <game/objects/arena_constraints.h>
+#include <game/utils/kinematics.h>
+#include <utils/allocator.h>
+
+#define PARTICLES 6
+
+// kinematics_add() needs real objects, so the store is filled directly
+static void set_particle(kinematics *k, int i, int x, int y, float vx, float vy, float gravity, int resting) {
+    k->pos_x[i] = x;
+    k->pos_y[i] = y;
+    k->vel_x[i] = vx;
+    k->vel_y[i] = vy;
+    k->gravity[i] = gravity;
+    k->resting[i] = resting;
+    k->settled[i] = 0;
+}
+
+static void check_particle(const kinematics *k, int i, int x, int y, float vx, float vy) {
+    CU_ASSERT(k->pos_x[i] == x);
+    CU_ASSERT(k->pos_y[i] == y);
+    CU_ASSERT_DOUBLE_EQUAL(k->vel_x[i], vx, 0.0001);
+    CU_ASSERT_DOUBLE_EQUAL(k->vel_y[i], vy, 0.0001);
+}
+
+void test_kinematics_integrate(void) {
+    kinematics k;
+    kinematics_create(&k);
+    k.capacity = PARTICLES;
+    k.count = PARTICLES;
+    k.pos_x = omf_calloc(PARTICLES, sizeof(int32_t));
+    k.pos_y = omf_calloc(PARTICLES, sizeof(int32_t));
+    k.vel_x = omf_calloc(PARTICLES, sizeof(float));
+    k.vel_y = omf_calloc(PARTICLES, sizeof(float));
+    k.gravity = omf_calloc(PARTICLES, sizeof(float));
+    k.resting = omf_calloc(PARTICLES, sizeof(uint8_t));
+    k.settled = omf_calloc(PARTICLES, sizeof(uint8_t));
+
+    set_particle(&k, 0, 100, 50, 3, -2, 1, 0);                    // In the air
+    set_particle(&k, 1, ARENA_LEFT_WALL + 2, 100, -5, 0, 0.5, 0);  // Hits the left wall
+    set_particle(&k, 2, ARENA_RIGHT_WALL - 1, 100, 4, 0, 0, 0);    // Hits the right wall
+    set_particle(&k, 3, 150, ARENA_FLOOR - 3, 1, 4, 1, 0);         // Bounces off the floor
+    set_particle(&k, 4, 60, ARENA_FLOOR, 0.05, 0, 1, 0);           // Comes to rest
+    set_particle(&k, 5, 200, ARENA_FLOOR, 5, 5, 1, 1);             // Already at rest
+
+    // Positions move by the old x velocity and the new y velocity, and are truncated to integers
+    kinematics_integrate(&k);
+    check_particle(&k, 0, 103, 49, 3, -1);
+    check_particle(&k, 1, ARENA_LEFT_WALL, 100, 2, 0.5);
+    check_particle(&k, 2, ARENA_RIGHT_WALL, 100, -1.6, 0);
+    check_particle(&k, 3, 151, ARENA_FLOOR, 0.4, -2);
+    check_particle(&k, 4, 60, ARENA_FLOOR, 0, -0.4);
+    check_particle(&k, 5, 200, ARENA_FLOOR, 5, 5);
+    for(int i = 0; i < PARTICLES; i++) {
+        CU_ASSERT(k.settled[i] == (i == 4));
+    }
+
+    kinematics_integrate(&k);
+    kinematics_integrate(&k);
+    check_particle(&k, 0, 109, 50, 3, 1);
+    check_particle(&k, 5, 200, ARENA_FLOOR, 5, 5);
+
+    kinematics_free(&k);
+}
+
+void kinematics_test_suite(CU_pSuite suite) {
+    if(CU_add_test(suite, "Test for batched particle integration", test_kinematics_integrate) == NULL) {
+        return;
+    }
+}
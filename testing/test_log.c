@@ -0,0 +1,43 @@
+#include <CUnit/Basic.h>
+#include <CUnit/CUnit.h>
+#include <stdio.h>
+#include <string.h>
+#include <utils/log.h>
+
+static int file_contains(const char *filename, const char *text) {
+    char line[1024];
+    int found = 0;
+    FILE *fp = fopen(filename, "r");
+    if(fp == NULL) {
+        return 0;
+    }
+    while(fgets(line, sizeof(line), fp) != NULL) {
+        if(strstr(line, text) != NULL) {
+            found = 1;
+        }
+    }
+    fclose(fp);
+    return found;
+}
+
+void test_log_error_flush(void) {
+    const char *filename = "test_log.txt";
+    CU_ASSERT_FATAL(log_init(filename, LOG_FORMAT_TEXT) == 0);
+
+    // Errors, and everything queued before them, are in the file as soon as log_print returns
+    log_print('I', NULL, "info %d", 1);
+    log_print('E', NULL, "error %d", 2);
+    CU_ASSERT(file_contains(filename, "info 1"));
+    CU_ASSERT(file_contains(filename, "error 2"));
+
+    log_print('I', NULL, "info %d", 3);
+    log_close();
+    CU_ASSERT(file_contains(filename, "info 3"));
+    remove(filename);
+}
+
+void log_test_suite(CU_pSuite suite) {
+    if(CU_add_test(suite, "Test for flushing errors to the log right away", test_log_error_flush) == NULL) {
+        return;
+    }
+}
@@ -12,7 +12,19 @@ void hashmap_test_suite(CU_pSuite suite);
 void vector_test_suite(CU_pSuite suite);
 void list_test_suite(CU_pSuite suite);
 void array_test_suite(CU_pSuite suite);
+void ringbuffer_test_suite(CU_pSuite suite);
+void profiler_test_suite(CU_pSuite suite);
 void text_render_test_suite(CU_pSuite suite);
+void kinematics_test_suite(CU_pSuite suite);
+void rec_controller_test_suite(CU_pSuite suite);
+void surface_test_suite(CU_pSuite suite);
+void screen_palette_test_suite(CU_pSuite suite);
+void mixer_test_suite(CU_pSuite suite);
+void log_test_suite(CU_pSuite suite);
+void controller_test_suite(CU_pSuite suite);
+void random_test_suite(CU_pSuite suite);
+void keyframes_test_suite(CU_pSuite suite);
+void work_pool_test_suite(CU_pSuite suite);
 
 int main(int argc, char **argv) {
     CU_pSuite suite = NULL;
@@ -78,11 +90,71 @@ int main(int argc, char **argv) {
         goto end;
     array_test_suite(array_suite);
 
+    CU_pSuite ringbuffer_suite = CU_add_suite("Ringbuffer", NULL, NULL);
+    if(ringbuffer_suite == NULL)
+        goto end;
+    ringbuffer_test_suite(ringbuffer_suite);
+
+    CU_pSuite profiler_suite = CU_add_suite("Profiler", NULL, NULL);
+    if(profiler_suite == NULL)
+        goto end;
+    profiler_test_suite(profiler_suite);
+
     CU_pSuite text_render_suite = CU_add_suite("Text Renderer", NULL, NULL);
     if(text_render_suite == NULL)
         goto end;
     text_render_test_suite(text_render_suite);
 
+    CU_pSuite kinematics_suite = CU_add_suite("Kinematics", NULL, NULL);
+    if(kinematics_suite == NULL)
+        goto end;
+    kinematics_test_suite(kinematics_suite);
+
+    CU_pSuite rec_controller_suite = CU_add_suite("REC Controller", NULL, NULL);
+    if(rec_controller_suite == NULL)
+        goto end;
+    rec_controller_test_suite(rec_controller_suite);
+
+    CU_pSuite surface_suite = CU_add_suite("Surface", NULL, NULL);
+    if(surface_suite == NULL)
+        goto end;
+    surface_test_suite(surface_suite);
+
+    CU_pSuite screen_palette_suite = CU_add_suite("Screen palette", NULL, NULL);
+    if(screen_palette_suite == NULL)
+        goto end;
+    screen_palette_test_suite(screen_palette_suite);
+
+    CU_pSuite mixer_suite = CU_add_suite("Mixer", NULL, NULL);
+    if(mixer_suite == NULL)
+        goto end;
+    mixer_test_suite(mixer_suite);
+
+    CU_pSuite log_suite = CU_add_suite("Log", NULL, NULL);
+    if(log_suite == NULL)
+        goto end;
+    log_test_suite(log_suite);
+
+    CU_pSuite controller_suite = CU_add_suite("Controller", NULL, NULL);
+    if(controller_suite == NULL)
+        goto end;
+    controller_test_suite(controller_suite);
+
+    CU_pSuite random_suite = CU_add_suite("Random", NULL, NULL);
+    if(random_suite == NULL)
+        goto end;
+    random_test_suite(random_suite);
+
+    CU_pSuite keyframes_suite = CU_add_suite("Keyframes", NULL, NULL);
+    if(keyframes_suite == NULL)
+        goto end;
+    keyframes_test_suite(keyframes_suite);
+
+    CU_pSuite work_pool_suite = CU_add_suite("Work pool", NULL, NULL);
+    if(work_pool_suite == NULL)
+        goto end;
+    work_pool_test_suite(work_pool_suite);
+
     // Run tests
     CU_basic_set_mode(CU_BRM_VERBOSE);
     CU_basic_run_tests();
@@ -0,0 +1,137 @@
+#include <CUnit/Basic.h>
+#include <CUnit/CUnit.h>
+#include <audio/mixer.h>
+#include <utils/allocator.h>
+
+#define LONG_SAMPLE_LEN 100000
+
+void test_mixer_long_sample(void) {
+    // Samples longer than 65535 frames must play to the end
+    mixer_sample sample;
+    sample.len = LONG_SAMPLE_LEN;
+    sample.freq = 8000;
+    sample.data = omf_calloc(LONG_SAMPLE_LEN + 1, sizeof(int16_t));
+    for(int i = 0; i < LONG_SAMPLE_LEN; i++) {
+        sample.data[i] = 1000;
+    }
+
+    mixer m;
+    int16_t out[1000];
+    mixer_create(&m, 8000, 1, 1000);
+    CU_ASSERT(mixer_play(&m, &sample, 1.0f, 0.0f, 1.0f));
+    int frames = 0;
+    for(int chunk = 0; chunk < LONG_SAMPLE_LEN / 1000 + 1; chunk++) {
+        mixer_render(&m, out, NULL, 1000);
+        for(int i = 0; i < 1000; i++) {
+            frames += out[i] != 0;
+        }
+    }
+    CU_ASSERT(frames == LONG_SAMPLE_LEN);
+    CU_ASSERT(m.voices[0].sample == NULL);
+
+    mixer_free(&m);
+    omf_free(sample.data);
+}
+
+void test_mixer_volume_change(void) {
+    // Changing the sound volume must also change sounds that are already playing
+    mixer_sample sample;
+    sample.len = 1000;
+    sample.freq = 8000;
+    sample.data = omf_calloc(1000 + 1, sizeof(int16_t));
+    for(int i = 0; i < 1000; i++) {
+        sample.data[i] = 1000;
+    }
+
+    mixer m;
+    int16_t out[100];
+    mixer_create(&m, 8000, 1, 100);
+    CU_ASSERT(mixer_play(&m, &sample, 1.0f, 0.0f, 1.0f));
+    mixer_render(&m, out, NULL, 100);
+    CU_ASSERT(out[0] == 1000);
+    CU_ASSERT(out[99] == 1000);
+
+    mixer_set_volume(&m, 0.5f);
+    mixer_render(&m, out, NULL, 100);
+    CU_ASSERT(out[0] == 500);
+    CU_ASSERT(out[99] == 500);
+
+    mixer_free(&m);
+    omf_free(sample.data);
+}
+
+void test_mixer_volume_coalesce(void) {
+    // Volume changes are never dropped, however many there are between two renders
+    mixer_sample sample;
+    sample.len = 100;
+    sample.freq = 8000;
+    sample.data = omf_calloc(100 + 1, sizeof(int16_t));
+    for(int i = 0; i < 100; i++) {
+        sample.data[i] = 1000;
+    }
+
+    mixer m;
+    int16_t out[10];
+    mixer_create(&m, 8000, 1, 10);
+    for(int i = 0; i < 1000; i++) {
+        mixer_set_volume(&m, (i % 2) ? 1.0f : 0.75f);
+    }
+    mixer_set_volume(&m, 0.25f);
+    CU_ASSERT(mixer_play(&m, &sample, 1.0f, 0.0f, 1.0f));
+    mixer_render(&m, out, NULL, 10);
+    CU_ASSERT(out[0] == 250);
+    CU_ASSERT(out[9] == 250);
+
+    mixer_free(&m);
+    omf_free(sample.data);
+}
+
+void test_mixer_interpolation(void) {
+    // A ramp of 0, 1000, ..., 8000 played at half speed gives 0, 500, ..., 8000, then halfway to the trailing zero
+    static const int16_t expected[20] = {0,    500,  1000, 1500, 2000, 2500, 3000, 3500, 4000, 4500,
+                                         5000, 5500, 6000, 6500, 7000, 7500, 8000, 4000, 0,    0};
+    mixer_sample sample;
+    sample.len = 9;
+    sample.freq = 4000;
+    sample.data = omf_calloc(9 + 1, sizeof(int16_t));
+    for(int i = 0; i < 9; i++) {
+        sample.data[i] = i * 1000;
+    }
+
+    mixer m;
+    int16_t out[40];
+    mixer_create(&m, 8000, 1, 20);
+    CU_ASSERT(mixer_play(&m, &sample, 1.0f, 0.0f, 1.0f));
+    mixer_render(&m, out, NULL, 20);
+    for(int i = 0; i < 20; i++) {
+        CU_ASSERT(out[i] == expected[i]);
+    }
+    mixer_free(&m);
+
+    // Panned halfway right, the left channel is at half volume
+    mixer_create(&m, 8000, 2, 20);
+    CU_ASSERT(mixer_play(&m, &sample, 1.0f, 0.5f, 1.0f));
+    mixer_render(&m, out, NULL, 20);
+    for(int i = 0; i < 20; i++) {
+        CU_ASSERT(out[i * 2 + 0] == expected[i] / 2);
+        CU_ASSERT(out[i * 2 + 1] == expected[i]);
+    }
+    mixer_free(&m);
+
+    omf_free(sample.data);
+}
+
+void mixer_test_suite(CU_pSuite suite) {
+    if(CU_add_test(suite, "Test for mixer playing long samples", test_mixer_long_sample) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for mixer volume changes on playing sounds", test_mixer_volume_change) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for mixer coalescing volume changes", test_mixer_volume_coalesce) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for mixer sample interpolation", test_mixer_interpolation) == NULL) {
+        return;
+    }
+}
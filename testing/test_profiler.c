@@ -0,0 +1,113 @@
+#include <CUnit/Basic.h>
+#include <CUnit/CUnit.h>
+#include <SDL.h>
+#include <stdio.h>
+#include <string.h>
+#include <utils/profiler.h>
+
+static void record_us(profile_phase phase, unsigned int us) {
+    profiler_record(phase, (uint64_t)us * SDL_GetPerformanceFrequency() / 1000000);
+}
+
+void test_profiler_empty(void) {
+    profile_stats stats;
+    profiler_reset();
+    CU_ASSERT(profiler_frames() == 0);
+    profiler_get_stats(PROFILE_RENDER, &stats);
+    CU_ASSERT(stats.p50_us == 0);
+    CU_ASSERT(stats.p99_us == 0);
+    CU_ASSERT(stats.max_us == 0);
+    CU_ASSERT(stats.max_calls == 0);
+}
+
+void test_profiler_stats(void) {
+    profile_stats stats;
+    profiler_reset();
+    for(int i = 1; i <= 100; i++) {
+        record_us(PROFILE_RENDER, i * 100);
+        record_us(PROFILE_MOVE, 10);
+        record_us(PROFILE_MOVE, 10);
+        profiler_frame_end();
+    }
+    CU_ASSERT(profiler_frames() == 100);
+
+    profiler_get_stats(PROFILE_RENDER, &stats);
+    CU_ASSERT(stats.p50_us >= 4990 && stats.p50_us <= 5010);
+    CU_ASSERT(stats.p99_us >= 9890 && stats.p99_us <= 9910);
+    CU_ASSERT(stats.max_us >= 9990 && stats.max_us <= 10010);
+    CU_ASSERT(stats.max_calls == 1);
+
+    profiler_get_stats(PROFILE_MOVE, &stats);
+    CU_ASSERT(stats.max_us >= 19 && stats.max_us <= 21);
+    CU_ASSERT(stats.max_calls == 2);
+}
+
+void test_profiler_rolling(void) {
+    profile_stats stats;
+    profiler_reset();
+    for(int i = 0; i < PROFILER_HISTORY; i++) {
+        record_us(PROFILE_TICK, 5000);
+        profiler_frame_end();
+    }
+    for(int i = 0; i < PROFILER_HISTORY; i++) {
+        record_us(PROFILE_TICK, 100);
+        profiler_frame_end();
+    }
+    profiler_get_stats(PROFILE_TICK, &stats);
+    CU_ASSERT(stats.max_us >= 99 && stats.max_us <= 101);
+}
+
+void test_profiler_bind(void) {
+    profile_stats stats;
+    profiler_reset();
+    CU_ASSERT(profiler_bind(false) == true);
+    record_us(PROFILE_COLLIDE, 1000);
+    CU_ASSERT(profiler_bind(true) == false);
+    record_us(PROFILE_COLLIDE, 100);
+    profiler_frame_end();
+    profiler_get_stats(PROFILE_COLLIDE, &stats);
+    CU_ASSERT(stats.max_us >= 99 && stats.max_us <= 101);
+    CU_ASSERT(stats.max_calls == 1);
+}
+
+void test_profiler_csv(void) {
+    char line[1024];
+    const char *filename = "test_profiler.csv";
+    profiler_reset();
+    for(int i = 0; i < 3; i++) {
+        record_us(PROFILE_EVENTS, 100);
+        profiler_frame_end();
+    }
+    CU_ASSERT(profiler_write_csv(filename) == 0);
+
+    FILE *fp = fopen(filename, "r");
+    CU_ASSERT_PTR_NOT_NULL_FATAL(fp);
+    int lines = 0;
+    while(fgets(line, sizeof(line), fp) != NULL) {
+        if(lines == 0) {
+            CU_ASSERT(strncmp(line, "frame,events_us,events_calls,", 29) == 0);
+        }
+        lines++;
+    }
+    fclose(fp);
+    remove(filename);
+    CU_ASSERT(lines == 4);
+}
+
+void profiler_test_suite(CU_pSuite suite) {
+    if(CU_add_test(suite, "Test for profiler without frames", test_profiler_empty) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for profiler percentiles", test_profiler_stats) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for profiler rolling history", test_profiler_rolling) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for profiler per-thread disabling", test_profiler_bind) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for profiler CSV export", test_profiler_csv) == NULL) {
+        return;
+    }
+}
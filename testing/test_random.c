@@ -0,0 +1,58 @@
+#include <CUnit/Basic.h>
+#include <CUnit/CUnit.h>
+#include <SDL.h>
+#include <utils/random.h>
+
+#define RANDOM_THREAD_DRAWS 100000
+
+typedef struct {
+    uint32_t seed;
+    uint32_t values[RANDOM_THREAD_DRAWS];
+} random_thread_data;
+
+static int random_thread(void *userdata) {
+    random_thread_data *data = userdata;
+    struct random_t state;
+    random_seed(&state, data->seed);
+    rand_bind(&state);
+    for(int i = 0; i < RANDOM_THREAD_DRAWS; i++) {
+        data->values[i] = rand_intmax();
+    }
+    rand_bind(NULL);
+    return 0;
+}
+
+void test_random_bind_threads(void) {
+    static random_thread_data data[2];
+    data[0].seed = 1234;
+    data[1].seed = 1234;
+    rand_seed(42);
+
+    // Both threads draw from their own state at the same time, so they must get the same sequence
+    SDL_Thread *threads[2];
+    for(int i = 0; i < 2; i++) {
+        threads[i] = SDL_CreateThread(random_thread, "random_test", &data[i]);
+        CU_ASSERT_PTR_NOT_NULL_FATAL(threads[i]);
+    }
+    for(int i = 0; i < 2; i++) {
+        SDL_WaitThread(threads[i], NULL);
+    }
+
+    struct random_t expected;
+    random_seed(&expected, 1234);
+    int same = 1;
+    for(int i = 0; i < RANDOM_THREAD_DRAWS; i++) {
+        uint32_t v = random_intmax(&expected);
+        same &= data[0].values[i] == v && data[1].values[i] == v;
+    }
+    CU_ASSERT(same);
+
+    // The default state of this thread was not touched
+    CU_ASSERT(rand_get_seed() == 42);
+}
+
+void random_test_suite(CU_pSuite suite) {
+    if(CU_add_test(suite, "Test for thread bound random states", test_random_bind_threads) == NULL) {
+        return;
+    }
+}
@@ -1,9 +1,11 @@
 #include "formats/error.h"
 #include "formats/rec.h"
+#include "game/utils/rec_writer.h"
 #include <CUnit/Basic.h>
 #include <CUnit/CUnit.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 sd_rec_file rec;
 
@@ -70,6 +72,114 @@ void test_crystal_shirro_load(void) {
     sd_rec_free(&rec);
 }
 
+static char extra[7] = {1, 2, 3, 4, 5, 6, 7};
+
+// The third move has a raw action and extra data in the file
+static sd_rec_move stream_moves[] = {
+    {0, 2, 0, SD_ACT_KICK | SD_ACT_RIGHT, 0, NULL},
+    {3, 2, 1, SD_ACT_PUNCH | SD_ACT_UP, 0, NULL},
+    {3, 10, 0, SD_ACT_PUNCH | SD_ACT_DOWN | SD_ACT_LEFT, 0, extra},
+    {8, 2, 1, SD_ACT_NONE, 0, NULL},
+    {12, 2, 0, SD_ACT_KICK | SD_ACT_UP | SD_ACT_LEFT, 0, NULL},
+};
+
+static void check_move(const sd_rec_move *move, unsigned int tick, int lookup_id, int player_id, int action) {
+    CU_ASSERT(move->tick == tick);
+    CU_ASSERT(move->lookup_id == lookup_id);
+    CU_ASSERT(move->player_id == player_id);
+    CU_ASSERT(move->action == action);
+}
+
+void test_rec_stream(void) {
+    sd_rec_file header, loaded;
+    CU_ASSERT(sd_rec_create(&header) == SD_SUCCESS);
+    sd_rec_stream *stream = sd_rec_stream_open(&header, "test_stream.rec");
+    CU_ASSERT_PTR_NOT_NULL_FATAL(stream);
+
+    // The file is complete after every write, before the stream is closed
+    CU_ASSERT(sd_rec_stream_write(stream, stream_moves, 2) == SD_SUCCESS);
+    CU_ASSERT(sd_rec_create(&loaded) == SD_SUCCESS);
+    CU_ASSERT(sd_rec_load(&loaded, "test_stream.rec") == SD_SUCCESS);
+    CU_ASSERT_FATAL(loaded.move_count == 2);
+    check_move(&loaded.moves[0], 0, 2, 0, SD_ACT_KICK | SD_ACT_RIGHT);
+    check_move(&loaded.moves[1], 3, 2, 1, SD_ACT_PUNCH | SD_ACT_UP);
+    sd_rec_free(&loaded);
+
+    CU_ASSERT(sd_rec_stream_write(stream, stream_moves + 2, 0) == SD_SUCCESS);
+    CU_ASSERT(sd_rec_stream_write(stream, stream_moves + 2, 3) == SD_SUCCESS);
+    sd_rec_stream_close(stream);
+
+    CU_ASSERT(sd_rec_create(&loaded) == SD_SUCCESS);
+    CU_ASSERT(sd_rec_load(&loaded, "test_stream.rec") == SD_SUCCESS);
+    CU_ASSERT_FATAL(loaded.move_count == 5);
+    check_move(&loaded.moves[0], 0, 2, 0, SD_ACT_KICK | SD_ACT_RIGHT);
+    check_move(&loaded.moves[1], 3, 2, 1, SD_ACT_PUNCH | SD_ACT_UP);
+    check_move(&loaded.moves[2], 3, 10, 0, SD_ACT_PUNCH | SD_ACT_DOWN | SD_ACT_LEFT);
+    CU_ASSERT(loaded.moves[2].raw_action == 97);
+    CU_ASSERT_NSTRING_EQUAL(loaded.moves[2].extra_data, "\x01\x02\x03\x04\x05\x06\x07", 7);
+    check_move(&loaded.moves[3], 8, 2, 1, SD_ACT_NONE);
+    check_move(&loaded.moves[4], 12, 2, 0, SD_ACT_KICK | SD_ACT_UP | SD_ACT_LEFT);
+    sd_rec_free(&loaded);
+
+    sd_rec_free(&header);
+}
+
+// Every 100 moves the tick jumps by 250, so the writer hands over partial chunks as well as full ones
+static unsigned int writer_tick(int i) {
+    return i * 2 + (i / 100) * 250;
+}
+
+void test_rec_writer(void) {
+    sd_rec_file header, loaded;
+    CU_ASSERT(sd_rec_create(&header) == SD_SUCCESS);
+    rec_writer *writer = rec_writer_open(&header, "test_writer.rec");
+    CU_ASSERT_PTR_NOT_NULL_FATAL(writer);
+    unsigned int tick = 0;
+    for(int i = 0; i < 600; i++) {
+        sd_rec_move mv = {writer_tick(i), 2, i % 2, (i % 2) ? SD_ACT_PUNCH : SD_ACT_KICK, 0, NULL};
+        if(i % 50 == 0) {
+            mv.lookup_id = 10;
+            mv.extra_data = extra;
+        }
+        for(; tick < mv.tick; tick++) {
+            rec_writer_tick(writer, tick);
+        }
+        rec_writer_append(writer, &mv);
+    }
+    rec_writer_close(writer);
+
+    // Full chunks, chunks handed over by ticks and the rest at close all end up in order
+    CU_ASSERT(sd_rec_create(&loaded) == SD_SUCCESS);
+    CU_ASSERT(sd_rec_load(&loaded, "test_writer.rec") == SD_SUCCESS);
+    CU_ASSERT_FATAL(loaded.move_count == 600);
+    int same = 1;
+    for(int i = 0; i < 600; i++) {
+        const sd_rec_move *mv = &loaded.moves[i];
+        same &= mv->tick == writer_tick(i) && mv->player_id == i % 2;
+        same &= mv->action == ((i % 2) ? SD_ACT_PUNCH : SD_ACT_KICK);
+        same &= mv->lookup_id == ((i % 50 == 0) ? 10 : 2);
+        same &= (i % 50 != 0) || memcmp(mv->extra_data, extra, 7) == 0;
+    }
+    CU_ASSERT(same);
+    sd_rec_free(&loaded);
+
+    // Moves that only ever sit in the current chunk are written at close
+    writer = rec_writer_open(&header, "test_writer.rec");
+    CU_ASSERT_PTR_NOT_NULL_FATAL(writer);
+    for(int i = 0; i < 5; i++) {
+        rec_writer_append(writer, &stream_moves[i]);
+    }
+    rec_writer_close(writer);
+    CU_ASSERT(sd_rec_create(&loaded) == SD_SUCCESS);
+    CU_ASSERT(sd_rec_load(&loaded, "test_writer.rec") == SD_SUCCESS);
+    CU_ASSERT_FATAL(loaded.move_count == 5);
+    check_move(&loaded.moves[2], 3, 10, 0, SD_ACT_PUNCH | SD_ACT_DOWN | SD_ACT_LEFT);
+    check_move(&loaded.moves[4], 12, 2, 0, SD_ACT_KICK | SD_ACT_UP | SD_ACT_LEFT);
+    sd_rec_free(&loaded);
+
+    sd_rec_free(&header);
+}
+
 void rec_test_suite(CU_pSuite suite) {
     if(CU_add_test(suite, "test of sd_rec_create", test_sd_rec_create) == NULL) {
         return;
@@ -83,4 +193,10 @@ void rec_test_suite(CU_pSuite suite) {
     if(CU_add_test(suite, "test loading crystal-shirro.rec", test_crystal_shirro_load) == NULL) {
         return;
     }
+    if(CU_add_test(suite, "test of REC streaming", test_rec_stream) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of rec_writer", test_rec_writer) == NULL) {
+        return;
+    }
 }
\ No newline at end of file
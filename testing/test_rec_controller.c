@@ -0,0 +1,130 @@
+#include <CUnit/Basic.h>
+#include <CUnit/CUnit.h>
+#include <controller/controller.h>
+#include <controller/rec_controller.h>
+#include <string.h>
+
+#define TICKS 11
+#define CLOSE -1
+
+// Inputs in file order. The tick 6 input comes after the tick 7 ones, and the tick 5 one has another lookup id.
+static const sd_rec_move moves[] = {
+    {.tick = 2, .lookup_id = 2, .player_id = 0, .action = SD_ACT_RIGHT},
+    {.tick = 4, .lookup_id = 2, .player_id = 0, .action = SD_ACT_PUNCH | SD_ACT_UP},
+    {.tick = 4, .lookup_id = 2, .player_id = 1, .action = SD_ACT_LEFT},
+    {.tick = 5, .lookup_id = 3, .player_id = 0, .action = SD_ACT_KICK},
+    {.tick = 7, .lookup_id = 2, .player_id = 0, .action = SD_ACT_DOWN},
+    {.tick = 7, .lookup_id = 2, .player_id = 0, .action = SD_ACT_KICK},
+    {.tick = 6, .lookup_id = 2, .player_id = 0, .action = SD_ACT_NONE},
+    {.tick = 9, .lookup_id = 2, .player_id = 0, .action = SD_ACT_LEFT},
+    {.tick = 10, .lookup_id = 2, .player_id = 1, .action = SD_ACT_NONE},
+};
+
+// Events of each tick from 1 on. Ticks without input repeat the held direction, the last input of a tick wins,
+// and the controller closes after the last tick of the recording.
+static const int expected[2][TICKS][3] = {
+    {{ACT_STOP},
+     {ACT_RIGHT},
+     {ACT_RIGHT},
+     {ACT_PUNCH, ACT_UP},
+     {ACT_UP},
+     {ACT_STOP},
+     {ACT_KICK},
+     {ACT_STOP},
+     {ACT_LEFT},
+     {ACT_LEFT},
+     {CLOSE}},
+    {{ACT_STOP},
+     {ACT_STOP},
+     {ACT_STOP},
+     {ACT_LEFT},
+     {ACT_LEFT},
+     {ACT_LEFT},
+     {ACT_LEFT},
+     {ACT_LEFT},
+     {ACT_LEFT},
+     {ACT_STOP},
+     {CLOSE}},
+};
+
+static void make_rec(sd_rec_file *rec) {
+    sd_rec_create(rec);
+    for(unsigned int i = 0; i < sizeof(moves) / sizeof(moves[0]); i++) {
+        sd_rec_insert_action(rec, i, &moves[i]);
+    }
+}
+
+// Runs one tick and checks its events against the expected list
+static int tick_matches(controller *ctrl, int tick, const int *events, ctrl_event_queue *q) {
+    int ok = 1;
+    unsigned int count = 0;
+    controller_dyntick(ctrl, tick, q);
+    for(; count < 3 && events[count] != 0; count++) {
+        ctrl_event *e = ctrl_event_queue_get(q, count);
+        if(e == NULL) {
+            ok = 0;
+        } else if(events[count] == CLOSE) {
+            ok &= e->type == EVENT_TYPE_CLOSE;
+        } else {
+            ok &= e->type == EVENT_TYPE_ACTION && e->event_data.action == events[count];
+        }
+    }
+    ok &= q->count == count;
+    ctrl_event_queue_clear(q);
+    return ok;
+}
+
+void test_rec_controller_playback(void) {
+    sd_rec_file rec;
+    ctrl_event_queue q;
+    make_rec(&rec);
+    ctrl_event_queue_init(&q);
+
+    for(int player = 0; player < 2; player++) {
+        controller ctrl;
+        controller_init(&ctrl);
+        rec_controller_create(&ctrl, player, &rec);
+        for(int tick = 1; tick <= TICKS; tick++) {
+            CU_ASSERT(tick_matches(&ctrl, tick, expected[player][tick - 1], &q));
+        }
+        controller_free(&ctrl);
+    }
+
+    ctrl_event_queue_free(&q);
+    sd_rec_free(&rec);
+}
+
+void test_rec_controller_seek(void) {
+    sd_rec_file rec;
+    ctrl_event_queue q;
+    controller ctrl;
+    make_rec(&rec);
+    ctrl_event_queue_init(&q);
+    controller_init(&ctrl);
+    rec_controller_create(&ctrl, 0, &rec);
+
+    // Seeking restores the direction held by the last input before the target tick
+    CU_ASSERT(rec_controller_seek(&ctrl, 5) == 0);
+    for(int tick = 5; tick <= TICKS; tick++) {
+        CU_ASSERT(tick_matches(&ctrl, tick, expected[0][tick - 1], &q));
+    }
+
+    // If the game tick goes back, the inputs are found again. The held direction is kept until the next input.
+    static const int held[3] = {ACT_LEFT};
+    CU_ASSERT(tick_matches(&ctrl, 3, held, &q));
+    CU_ASSERT(tick_matches(&ctrl, 4, expected[0][3], &q));
+    CU_ASSERT(tick_matches(&ctrl, 5, expected[0][4], &q));
+
+    controller_free(&ctrl);
+    ctrl_event_queue_free(&q);
+    sd_rec_free(&rec);
+}
+
+void rec_controller_test_suite(CU_pSuite suite) {
+    if(CU_add_test(suite, "Test for REC controller playback", test_rec_controller_playback) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for REC controller seeking", test_rec_controller_seek) == NULL) {
+        return;
+    }
+}
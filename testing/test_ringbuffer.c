@@ -0,0 +1,93 @@
+#include <CUnit/Basic.h>
+#include <CUnit/CUnit.h>
+#include <utils/ringbuffer.h>
+
+#define TEST_CAPACITY 100
+
+ringbuffer test_ringbuffer;
+
+void test_ringbuffer_create(void) {
+    ringbuffer_create(&test_ringbuffer, TEST_CAPACITY, sizeof(int));
+    CU_ASSERT_PTR_NOT_NULL(test_ringbuffer.data);
+    CU_ASSERT(ringbuffer_capacity(&test_ringbuffer) == 128);
+    CU_ASSERT(ringbuffer_size(&test_ringbuffer) == 0);
+    CU_ASSERT(ringbuffer_space(&test_ringbuffer) == 128);
+}
+
+void test_ringbuffer_free(void) {
+    ringbuffer_free(&test_ringbuffer);
+    CU_ASSERT_PTR_NULL(test_ringbuffer.data);
+}
+
+void test_ringbuffer_push_pop(void) {
+    int value;
+    CU_ASSERT(ringbuffer_pop(&test_ringbuffer, &value) == false);
+    for(int i = 0; i < 128; i++) {
+        CU_ASSERT(ringbuffer_push(&test_ringbuffer, &i) == true);
+    }
+    value = 1000;
+    CU_ASSERT(ringbuffer_push(&test_ringbuffer, &value) == false);
+    CU_ASSERT(ringbuffer_size(&test_ringbuffer) == 128);
+    for(int i = 0; i < 128; i++) {
+        CU_ASSERT(ringbuffer_pop(&test_ringbuffer, &value) == true);
+        CU_ASSERT(value == i);
+    }
+    CU_ASSERT(ringbuffer_size(&test_ringbuffer) == 0);
+}
+
+void test_ringbuffer_wraparound(void) {
+    int in[50], out[50];
+    int next_in = 0, next_out = 0;
+
+    // Move the indexes around the buffer several times with bulk reads and writes.
+    for(int round = 0; round < 20; round++) {
+        for(int i = 0; i < 50; i++) {
+            in[i] = next_in++;
+        }
+        CU_ASSERT(ringbuffer_write(&test_ringbuffer, in, 50) == 50);
+        CU_ASSERT(ringbuffer_read(&test_ringbuffer, out, 50) == 50);
+        for(int i = 0; i < 50; i++) {
+            CU_ASSERT(out[i] == next_out++);
+        }
+    }
+    CU_ASSERT(ringbuffer_size(&test_ringbuffer) == 0);
+}
+
+void test_ringbuffer_partial(void) {
+    int in[100] = {0}, out[100];
+    CU_ASSERT(ringbuffer_write(&test_ringbuffer, in, 100) == 100);
+    CU_ASSERT(ringbuffer_write(&test_ringbuffer, in, 100) == 28);
+    CU_ASSERT(ringbuffer_space(&test_ringbuffer) == 0);
+    CU_ASSERT(ringbuffer_read(&test_ringbuffer, out, 100) == 100);
+    CU_ASSERT(ringbuffer_read(&test_ringbuffer, out, 100) == 28);
+    CU_ASSERT(ringbuffer_read(&test_ringbuffer, out, 100) == 0);
+}
+
+void test_ringbuffer_clear(void) {
+    int in[10] = {0};
+    ringbuffer_write(&test_ringbuffer, in, 10);
+    ringbuffer_clear(&test_ringbuffer);
+    CU_ASSERT(ringbuffer_size(&test_ringbuffer) == 0);
+    CU_ASSERT(ringbuffer_space(&test_ringbuffer) == 128);
+}
+
+void ringbuffer_test_suite(CU_pSuite suite) {
+    if(CU_add_test(suite, "Test for ringbuffer create", test_ringbuffer_create) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for ringbuffer push and pop", test_ringbuffer_push_pop) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for ringbuffer wraparound", test_ringbuffer_wraparound) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for ringbuffer partial read and write", test_ringbuffer_partial) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for ringbuffer clear", test_ringbuffer_clear) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for ringbuffer free", test_ringbuffer_free) == NULL) {
+        return;
+    }
+}
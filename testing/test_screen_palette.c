@@ -0,0 +1,139 @@
+#include <CUnit/Basic.h>
+#include <CUnit/CUnit.h>
+#include <string.h>
+#include <video/screen_palette.h>
+
+static void fill(screen_palette *pal) {
+    memset(pal, 0, sizeof(screen_palette));
+    for(int i = 0; i < 256; i++) {
+        pal->data[i][0] = i;
+        pal->data[i][1] = 255 - i;
+        pal->data[i][2] = (i * 7) & 0xFF;
+    }
+}
+
+void test_screen_palette_blend(void) {
+    screen_palette pal;
+    const uint8_t ref[3] = {255, 0, 128};
+
+    // Zero weight keeps the colors, and nothing is reported as changed
+    fill(&pal);
+    CU_ASSERT(screen_palette_blend(&pal, 0, 48, ref, 0) == 0);
+    CU_ASSERT(pal.data[10][0] == 10);
+    CU_ASSERT(screen_palette_is_changed(&pal, 10) == 0);
+
+    // Full weight replaces the colors
+    CU_ASSERT(screen_palette_blend(&pal, 0, 48, ref, PAL_WEIGHT_ONE) == 1);
+    CU_ASSERT(memcmp(pal.data[20], ref, 3) == 0);
+    CU_ASSERT(pal.data[48][0] == 48);
+
+    // Byte weights match (c * ref + (255 - c) * entry) / 255
+    fill(&pal);
+    screen_palette_blend(&pal, 0, 256, ref, 100 * 256);
+    for(int i = 0; i < 256; i++) {
+        CU_ASSERT(pal.data[i][0] == (100 * 255 + 155 * i) / 255);
+        CU_ASSERT(pal.data[i][1] == (155 * (255 - i)) / 255);
+    }
+}
+
+// The SSE2 paths work on 16 entry blocks, so an odd start and count goes through both them and the scalar tail.
+// Both have to match the plain formulas for every weight.
+void test_screen_palette_kernels(void) {
+    static const uint8_t refs[3][3] = {
+        {0, 0, 0},
+        {255, 255, 255},
+        {200, 40, 91},
+    };
+    screen_palette pal, orig;
+    fill(&orig);
+    for(int r = 0; r < 3; r++) {
+        const uint8_t *ref = refs[r];
+        for(int weight = 0; weight <= PAL_WEIGHT_ONE; weight += 251) {
+            int blend_ok = 1;
+            int tint_ok = 1;
+            pal = orig;
+            screen_palette_blend(&pal, 3, 250, ref, weight);
+            for(int i = 3; i < 253; i++) {
+                for(int k = 0; k < 3; k++) {
+                    int in = orig.data[i][k];
+                    blend_ok &= pal.data[i][k] == (in * (PAL_WEIGHT_ONE - weight) + ref[k] * weight) / PAL_WEIGHT_ONE;
+                }
+            }
+            pal = orig;
+            screen_palette_tint(&pal, 3, 250, ref, weight);
+            for(int i = 3; i < 253; i++) {
+                int m = orig.data[i][0] > orig.data[i][1] ? orig.data[i][0] : orig.data[i][1];
+                m = m > orig.data[i][2] ? m : orig.data[i][2];
+                int w = m * weight / 255;
+                for(int k = 0; k < 3; k++) {
+                    int in = orig.data[i][k];
+                    tint_ok &= pal.data[i][k] == (in * (PAL_WEIGHT_ONE - w) + ref[k] * w) / PAL_WEIGHT_ONE;
+                }
+            }
+            CU_ASSERT(blend_ok);
+            CU_ASSERT(tint_ok);
+            CU_ASSERT(memcmp(pal.data[0], orig.data[0], 9) == 0);
+            CU_ASSERT(memcmp(pal.data[253], orig.data[253], 9) == 0);
+        }
+    }
+}
+
+void test_screen_palette_changes(void) {
+    screen_palette pal;
+    const uint8_t ref[3] = {0, 0, 0};
+
+    // Only the entries that get a new color are marked
+    fill(&pal);
+    CU_ASSERT(screen_palette_tint(&pal, 40, 20, ref, PAL_WEIGHT_ONE) == 1);
+    CU_ASSERT(screen_palette_is_changed(&pal, 39) == 0);
+    CU_ASSERT(screen_palette_is_changed(&pal, 45) == 1);
+    CU_ASSERT(screen_palette_is_changed(&pal, 60) == 0);
+
+    // Ranges past the end of the palette are clipped
+    CU_ASSERT(screen_palette_light(&pal, 250, 20, ref, 0) == 1);
+    CU_ASSERT(screen_palette_is_changed(&pal, 255) == 1);
+    CU_ASSERT(pal.data[255][0] == 0);
+
+    screen_palette_commit(&pal);
+    CU_ASSERT(screen_palette_is_changed(&pal, 45) == 0);
+}
+
+void test_screen_palette_versions(void) {
+    screen_palette pal;
+    const uint8_t ref[3] = {255, 255, 255};
+    uint8_t old[20][3];
+    fill(&pal);
+    screen_palette_invalidate(&pal);
+    unsigned int low = screen_palette_get_version(&pal, 0x0001);
+    unsigned int high = screen_palette_get_version(&pal, 0x8000);
+
+    // Only the ranges with new colors get a new version
+    memcpy(old, pal.data[40], sizeof(old));
+    screen_palette_blend(&pal, 40, 20, ref, PAL_WEIGHT_ONE);
+    screen_palette_commit(&pal);
+    CU_ASSERT(screen_palette_get_version(&pal, 0x0001) == low);
+    CU_ASSERT(screen_palette_get_version(&pal, 0x0004) != screen_palette_get_version(&pal, 0x0001));
+    CU_ASSERT(screen_palette_get_version(&pal, 0x8000) == high);
+
+    // Changing colors and changing them back before a commit keeps the version
+    unsigned int mid = screen_palette_get_version(&pal, 0x000C);
+    screen_palette_set_range(&pal, 40, 20, old);
+    screen_palette_blend(&pal, 40, 20, ref, PAL_WEIGHT_ONE);
+    screen_palette_commit(&pal);
+    CU_ASSERT(screen_palette_get_version(&pal, 0x000C) == mid);
+}
+
+void screen_palette_test_suite(CU_pSuite suite) {
+    if(CU_add_test(suite, "Test for screen palette blending", test_screen_palette_blend) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for screen palette kernels", test_screen_palette_kernels) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for screen palette change tracking", test_screen_palette_changes) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for screen palette range versions", test_screen_palette_versions) == NULL) {
+        return;
+    }
+}
@@ -0,0 +1,187 @@
+#include <CUnit/Basic.h>
+#include <CUnit/CUnit.h>
+#include <string.h>
+#include <video/surface.h>
+
+// Stencils are given as strings, '#' for a visible pixel and '.' for a hidden one. Rows past h are allocated and
+// filled, but not part of the surface.
+static void create_surface(surface *sur, int w, int h, int extra_rows, const uint8_t *data, const char *stencil) {
+    surface_create(sur, SURFACE_TYPE_PALETTE, w, h + extra_rows);
+    memcpy(sur->data, data, w * (h + extra_rows));
+    char visible[64];
+    for(int i = 0; i < w * (h + extra_rows); i++) {
+        visible[i] = (stencil[i] == '#');
+    }
+    surface_set_stencil(sur, visible);
+    sur->h = h;
+}
+
+static int surface_equals(const surface *sur, const uint8_t *data, const char *stencil) {
+    for(int i = 0; i < sur->w * sur->h; i++) {
+        if((uint8_t)sur->data[i] != data[i] || surface_stencil_get(sur, i) != (stencil[i] == '#')) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+void test_surface_stencil(void) {
+    surface sur;
+    char stencil[19];
+    surface_create(&sur, SURFACE_TYPE_PALETTE, 19, 1);
+    for(int i = 0; i < 19; i++) {
+        stencil[i] = (i % 3 == 0) ? 1 : 0;
+    }
+    surface_set_stencil(&sur, stencil);
+    for(int i = 0; i < 19; i++) {
+        CU_ASSERT(surface_stencil_get(&sur, i) == stencil[i]);
+    }
+    surface_stencil_set(&sur, 1, 1);
+    surface_stencil_set(&sur, 18, 0);
+    CU_ASSERT(surface_stencil_get(&sur, 1) == 1);
+    CU_ASSERT(surface_stencil_get(&sur, 18) == 0);
+    CU_ASSERT(surface_stencil_get(&sur, 0) == 1);
+    surface_free(&sur);
+}
+
+void test_surface_alpha_blit(void) {
+    // The second row starts in an empty stencil byte, so the unflipped blit skips to the next byte from its middle
+    static const uint8_t src_data[] = {9, 9, 1, 9, 9, 9, 9, 9, 9, 9, //
+                                       9, 9, 9, 9, 9, 9, 2, 3, 9, 4};
+    static const char src_stencil[] = "..#......."
+                                      "......##.#";
+    static const uint8_t dst_data[33] = {0};
+    static const char dst_stencil[] = "..........."
+                                      "..........."
+                                      "...........";
+    surface dst, src;
+    create_surface(&src, 10, 2, 0, src_data, src_stencil);
+    create_surface(&dst, 11, 3, 0, dst_data, dst_stencil);
+
+    surface_alpha_blit(&dst, &src, 2, 1, SDL_FLIP_NONE);
+    static const uint8_t plain_data[] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, //
+                                         0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, //
+                                         0, 0, 0, 0, 0, 0, 0, 0, 2, 3, 0};
+    static const char plain_stencil[] = "..........."
+                                        "....#......"
+                                        "........##.";
+    CU_ASSERT(surface_equals(&dst, plain_data, plain_stencil));
+
+    // Clipped on the right, at the top and on the left
+    surface_alpha_blit(&dst, &src, 4, 0, SDL_FLIP_HORIZONTAL);
+    surface_alpha_blit(&dst, &src, -2, -1, SDL_FLIP_HORIZONTAL | SDL_FLIP_VERTICAL);
+    surface_alpha_blit(&dst, &src, -7, 2, SDL_FLIP_VERTICAL);
+    static const uint8_t flipped_data[] = {0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, //
+                                           0, 0, 0, 0, 4, 0, 3, 2, 0, 0, 0, //
+                                           3, 0, 4, 0, 0, 0, 0, 0, 2, 3, 0};
+    static const char flipped_stencil[] = ".....#....."
+                                          "....#.##..."
+                                          "#.#.....##.";
+    CU_ASSERT(surface_equals(&dst, flipped_data, flipped_stencil));
+
+    surface_free(&dst);
+    surface_free(&src);
+}
+
+void test_surface_additive_blit(void) {
+    // Source color s on destination color d gives (s + 3) * 10 + d % 10
+    palette remap_pal;
+    for(int i = 0; i < 19; i++) {
+        for(int k = 0; k < 256; k++) {
+            remap_pal.remaps[i][k] = i * 10 + k % 10;
+        }
+    }
+
+    // The horizontally flipped blit reads one pixel to the right, and one past the end of the source on the last row
+    static const uint8_t src_data[] = {1, 2, 0, 3, //
+                                       4, 0, 5, 6, //
+                                       7, 7, 7, 7};
+    static const char src_stencil[] = "############";
+    static const uint8_t dst_data[] = {1, 2, 8, 3, 4, 5, 8, 6, 7, //
+                                       9, 9, 1, 2, 3, 4, 5, 6, 9};
+    static const char dst_stencil[] = "##.###.##"
+                                      ".#######.";
+    surface dst, src;
+    create_surface(&src, 4, 2, 1, src_data, src_stencil);
+    create_surface(&dst, 9, 2, 0, dst_data, dst_stencil);
+
+    // Only visible destination pixels change, and source color 0 is skipped
+    surface_additive_blit(&dst, &src, 6, 0, &remap_pal, SDL_FLIP_NONE);
+    static const uint8_t plain_data[] = {1, 2, 8, 3, 4, 5, 8, 56, 7, //
+                                         9, 9, 1, 2, 3, 4, 75, 6, 9};
+    CU_ASSERT(surface_equals(&dst, plain_data, dst_stencil));
+
+    surface_additive_blit(&dst, &src, -1, 0, &remap_pal, SDL_FLIP_HORIZONTAL);
+    surface_additive_blit(&dst, &src, 2, 0, &remap_pal, SDL_FLIP_HORIZONTAL);
+    static const uint8_t flipped_data[] = {61, 2, 8, 63, 4, 55, 8, 56, 7, //
+                                           9, 89, 101, 92, 83, 4, 75, 6, 9};
+    CU_ASSERT(surface_equals(&dst, flipped_data, dst_stencil));
+
+    surface_free(&dst);
+    surface_free(&src);
+}
+
+static void check_rgba(const char *rgba, const uint8_t *indexes, const char *stencil, int len) {
+    int ok = 1;
+    for(int i = 0; i < len; i++) {
+        const uint8_t *out = (const uint8_t *)rgba + i * 4;
+        if(stencil[i] == '#') {
+            ok &= out[0] == indexes[i] && out[1] == 255 - indexes[i] && out[2] == (uint8_t)(indexes[i] * 3);
+            ok &= out[3] == 0xFF;
+        } else {
+            // Hidden pixels are transparent black, whatever color is under them
+            ok &= out[0] == 0 && out[1] == 0 && out[2] == 0 && out[3] == 0;
+        }
+    }
+    CU_ASSERT(ok);
+}
+
+void test_surface_to_rgba(void) {
+    screen_palette pal;
+    char remap[256];
+    memset(&pal, 0, sizeof(pal));
+    for(int i = 0; i < 256; i++) {
+        pal.data[i][0] = i;
+        pal.data[i][1] = 255 - i;
+        pal.data[i][2] = i * 3;
+        remap[i] = 255 - i;
+    }
+    static const uint8_t data[] = {0, 10, 47, 48, 200, 255, 1, 2, 3, //
+                                   4, 5, 6, 7, 8, 9, 10, 11, 12};
+    static const char stencil[] = "####.####"
+                                  "#..######";
+    surface sur;
+    char rgba[18 * 4];
+    create_surface(&sur, 9, 2, 0, data, stencil);
+
+    surface_to_rgba(&sur, rgba, &pal, NULL, 0);
+    check_rgba(rgba, data, stencil, 18);
+
+    // The palette offset only applies to the first 48 colors, after remapping
+    static const uint8_t offset_indexes[] = {48, 58, 95, 48, 200, 255, 49, 50, 51, //
+                                             52, 53, 54, 55, 56, 57, 58, 59, 60};
+    surface_to_rgba(&sur, rgba, &pal, NULL, 48);
+    check_rgba(rgba, offset_indexes, stencil, 18);
+
+    static const uint8_t remap_indexes[] = {255, 245, 208, 207, 55, 48, 254, 253, 252, //
+                                            251, 250, 249, 248, 247, 246, 245, 244, 243};
+    surface_to_rgba(&sur, rgba, &pal, remap, 48);
+    check_rgba(rgba, remap_indexes, stencil, 18);
+
+    surface_free(&sur);
+}
+
+void surface_test_suite(CU_pSuite suite) {
+    if(CU_add_test(suite, "Test for surface stencil access", test_surface_stencil) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for surface alpha blit", test_surface_alpha_blit) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for surface additive blit", test_surface_additive_blit) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for surface to rgba", test_surface_to_rgba) == NULL) {
+        return;
+    }
+}
@@ -63,6 +63,15 @@ void test_vector_iterator(void) {
     }
 }
 
+void test_vector_truncate(void) {
+    vector_truncate(&test_vector, TEST_VAL_COUNT * 2);
+    CU_ASSERT(vector_size(&test_vector) == TEST_VAL_COUNT);
+    vector_truncate(&test_vector, 10);
+    CU_ASSERT(vector_size(&test_vector) == 10);
+    CU_ASSERT_PTR_NOT_NULL(vector_get(&test_vector, 9));
+    CU_ASSERT_PTR_NULL(vector_get(&test_vector, 10));
+}
+
 void test_vector_delete(void) {
     iterator it;
     vector_iter_begin(&test_vector, &it);
@@ -96,6 +105,9 @@ void vector_test_suite(CU_pSuite suite) {
     if(CU_add_test(suite, "Test for vector iterator", test_vector_iterator) == NULL) {
         return;
     }
+    if(CU_add_test(suite, "Test for vector truncate", test_vector_truncate) == NULL) {
+        return;
+    }
     if(CU_add_test(suite, "Test for vector delete", test_vector_delete) == NULL) {
         return;
     }
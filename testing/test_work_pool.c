@@ -0,0 +1,81 @@
+#include <CUnit/Basic.h>
+#include <CUnit/CUnit.h>
+#include <SDL.h>
+#include <string.h>
+#include <utils/work_pool.h>
+
+#define TEST_JOBS 80
+
+typedef struct {
+    int scratch[WORK_POOL_MAX_THREADS + 1]; // Per worker state, reset before each job like a lookahead fork
+    int scores[TEST_JOBS];
+    SDL_atomic_t runs[TEST_JOBS];
+    int bad_worker;
+    int workers;
+} test_batch;
+
+static void test_job(void *userdata, int worker, int job) {
+    test_batch *b = userdata;
+    if(worker < 0 || worker >= b->workers) {
+        b->bad_worker = 1;
+        return;
+    }
+    SDL_AtomicAdd(&b->runs[job], 1);
+
+    // Uneven job lengths shuffle which worker gets which job
+    if(job % 7 == 0) {
+        SDL_Delay(1);
+    }
+    b->scratch[worker] = 0;
+    for(int i = 0; i <= job; i++) {
+        b->scratch[worker] = (b->scratch[worker] * 31 + i) % 1009;
+    }
+    b->scores[job] = b->scratch[worker];
+}
+
+// Picks the best job the same way the lookahead AI picks its plan
+static int best_job(const test_batch *b) {
+    int best = 0;
+    for(int i = 1; i < TEST_JOBS; i++) {
+        if(b->scores[i] > b->scores[best]) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+void test_work_pool_deterministic(void) {
+    static test_batch b;
+    int expected = -1;
+    int thread_counts[] = {0, 1, 3, WORK_POOL_MAX_THREADS};
+    for(int t = 0; t < 4; t++) {
+        work_pool pool;
+        work_pool_create(&pool, thread_counts[t]);
+        for(int run = 0; run < 3; run++) {
+            memset(&b, 0, sizeof(b));
+            b.workers = work_pool_workers(&pool);
+            work_pool_run(&pool, TEST_JOBS, test_job, &b);
+
+            int once = 1;
+            for(int i = 0; i < TEST_JOBS; i++) {
+                once &= SDL_AtomicGet(&b.runs[i]) == 1;
+            }
+            CU_ASSERT(once);
+            CU_ASSERT(!b.bad_worker);
+
+            // The same jobs give the same choice, whatever the number of threads and their timing
+            if(expected < 0) {
+                expected = best_job(&b);
+            }
+            CU_ASSERT(best_job(&b) == expected);
+        }
+        work_pool_free(&pool);
+    }
+}
+
+void work_pool_test_suite(CU_pSuite suite) {
+    if(CU_add_test(suite, "Test for work pool results not depending on timing", test_work_pool_deterministic) ==
+       NULL) {
+        return;
+    }
+}
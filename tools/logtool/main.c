@@ -0,0 +1,354 @@
+/** @file main.c
+ * @brief Binary log trace decoder
+ * @license MIT
+ */
+
+#include <argtable2.h>
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils/allocator.h"
+#include "utils/log.h"
+
+typedef struct callsite {
+    char *fn;
+    char *fmt;
+} callsite;
+
+typedef struct trace_reader {
+    FILE *fp;
+    callsite *callsites;
+    unsigned int callsite_count;
+    unsigned int callsite_capacity;
+} trace_reader;
+
+static int read_le(FILE *fp, uint64_t *value, unsigned int bytes) {
+    *value = 0;
+    for(unsigned int i = 0; i < bytes; i++) {
+        int c = fgetc(fp);
+        if(c == EOF)
+            return 1;
+        *value |= (uint64_t)c << (i * 8);
+    }
+    return 0;
+}
+
+static char *read_string(FILE *fp) {
+    uint64_t len;
+    if(read_le(fp, &len, 2))
+        return NULL;
+    char *str = omf_calloc(len + 1, 1);
+    if(fread(str, 1, len, fp) != len) {
+        omf_free(str);
+        return NULL;
+    }
+    return str;
+}
+
+static uint64_t get_le(const unsigned char *buf, unsigned int *pos, unsigned int len, unsigned int bytes) {
+    uint64_t value = 0;
+    for(unsigned int i = 0; i < bytes && *pos < len; i++) {
+        value |= (uint64_t)buf[(*pos)++] << (i * 8);
+    }
+    return value;
+}
+
+// Reads the next argument from the encoded data. Returns the argument type, or 0 if there are no more.
+static char next_arg(const unsigned char *buf, unsigned int *pos, unsigned int len, uint64_t *value,
+                     const char **str, unsigned int *str_len) {
+    if(*pos >= len)
+        return 0;
+    char type = buf[(*pos)++];
+    switch(type) {
+        case LOG_TRACE_ARG_INT:
+            *value = get_le(buf, pos, len, 4);
+            break;
+        case LOG_TRACE_ARG_LONG:
+        case LOG_TRACE_ARG_DOUBLE:
+        case LOG_TRACE_ARG_POINTER:
+            *value = get_le(buf, pos, len, 8);
+            break;
+        case LOG_TRACE_ARG_STRING:
+            *str_len = get_le(buf, pos, len, 2);
+            if(*str_len > len - *pos)
+                *str_len = len - *pos;
+            *str = (const char *)buf + *pos;
+            *pos += *str_len;
+            break;
+        default:
+            return 0;
+    }
+    return type;
+}
+
+// Appends a field width or precision to a conversion spec. Values come from the trace, so they are clamped
+// to something printf can handle without producing huge output.
+static int append_number(char *spec, int n, int size, long value, long min) {
+    if(value > 999)
+        value = 999;
+    if(value < min)
+        value = min;
+    return n + snprintf(spec + n, size - n, "%ld", value);
+}
+
+// Reads a run of digits from the format string. Returns 1 if there are too many of them.
+static int parse_digits(const char **p, long *value) {
+    int digits = 0;
+    *value = 0;
+    while(**p >= '0' && **p <= '9') {
+        if(++digits > 3)
+            return 1;
+        *value = *value * 10 + (**p - '0');
+        (*p)++;
+    }
+    return 0;
+}
+
+// Applies the original printf format string to the decoded arguments.
+static void print_message(const char *fmt, const unsigned char *buf, unsigned int len) {
+    unsigned int pos = 0;
+    uint64_t value;
+    const char *str;
+    unsigned int str_len;
+    long number;
+
+    // Flags, width, precision and the conversion, each bounded: "%" 5 flags "-999" ".-999" "ll" conversion
+    char spec[24];
+
+    for(const char *p = fmt; *p != '\0'; p++) {
+        if(*p != '%') {
+            putchar(*p);
+            continue;
+        }
+        if(p[1] == '%') {
+            putchar('%');
+            p++;
+            continue;
+        }
+
+        // Copy the conversion spec, without length modifiers. Star fields are replaced by their values.
+        int n = 0;
+        spec[n++] = *p++;
+        for(int flags = 0; *p != '\0' && strchr("-+ #0'", *p); flags++, p++) {
+            if(flags >= 5) {
+                printf("<bad format>");
+                return;
+            }
+            spec[n++] = *p;
+        }
+        if(*p == '*') {
+            next_arg(buf, &pos, len, &value, &str, &str_len);
+            n = append_number(spec, n, sizeof(spec), (int32_t)value, -999);
+            p++;
+        } else if(parse_digits(&p, &number)) {
+            printf("<bad format>");
+            return;
+        } else if(number > 0) {
+            n = append_number(spec, n, sizeof(spec), number, 0);
+        }
+        if(*p == '.') {
+            spec[n++] = *p++;
+            if(*p == '*') {
+                next_arg(buf, &pos, len, &value, &str, &str_len);
+                n = append_number(spec, n, sizeof(spec), (int32_t)value, 0);
+                p++;
+            } else if(parse_digits(&p, &number)) {
+                printf("<bad format>");
+                return;
+            } else {
+                n = append_number(spec, n, sizeof(spec), number, 0);
+            }
+        }
+        while(*p != '\0' && strchr("hlLqjzt", *p))
+            p++;
+        if(*p == '\0')
+            break;
+        if(*p == 'n')
+            continue;
+
+        // The argument type comes from the trace, so check that it fits the conversion before using it
+        char type = next_arg(buf, &pos, len, &value, &str, &str_len);
+        switch(type) {
+            case LOG_TRACE_ARG_INT:
+                if(strchr("diouxXc", *p) == NULL)
+                    goto bad_argument;
+                spec[n++] = *p;
+                spec[n] = '\0';
+                printf(spec, (int)(int32_t)value);
+                break;
+            case LOG_TRACE_ARG_LONG:
+                if(strchr("diouxX", *p) == NULL)
+                    goto bad_argument;
+                spec[n++] = 'l';
+                spec[n++] = 'l';
+                spec[n++] = *p;
+                spec[n] = '\0';
+                printf(spec, (long long)value);
+                break;
+            case LOG_TRACE_ARG_DOUBLE: {
+                if(strchr("fFeEgGaA", *p) == NULL)
+                    goto bad_argument;
+                double d;
+                memcpy(&d, &value, sizeof(d));
+                spec[n++] = *p;
+                spec[n] = '\0';
+                printf(spec, d);
+            } break;
+            case LOG_TRACE_ARG_POINTER:
+                printf("0x%llx", (unsigned long long)value);
+                break;
+            case LOG_TRACE_ARG_STRING:
+                printf("%.*s", (int)str_len, str);
+                break;
+            default:
+                printf("<missing>");
+                break;
+        }
+        continue;
+
+    bad_argument:
+        printf("<bad argument>");
+    }
+}
+
+static int read_trace(trace_reader *r) {
+    uint64_t type, id, tick, level, len;
+    unsigned char buf[65536];
+    unsigned int events = 0;
+
+    for(;;) {
+        int c = fgetc(r->fp);
+        if(c == EOF)
+            break;
+        type = c;
+        switch(type) {
+            case LOG_TRACE_CALLSITE: {
+                // Callsites are numbered in the order they are written, so the next one must follow the last
+                if(read_le(r->fp, &id, 4) || id != r->callsite_count)
+                    return 1;
+                if(r->callsite_count == r->callsite_capacity) {
+                    r->callsite_capacity = (r->callsite_capacity > 0) ? r->callsite_capacity * 2 : 64;
+                    r->callsites = omf_realloc(r->callsites, r->callsite_capacity * sizeof(callsite));
+                }
+                r->callsites[id].fn = read_string(r->fp);
+                r->callsites[id].fmt = read_string(r->fp);
+                r->callsite_count++;
+                if(r->callsites[id].fn == NULL || r->callsites[id].fmt == NULL)
+                    return 1;
+            } break;
+            case LOG_TRACE_EVENT: {
+                if(read_le(r->fp, &tick, 4) || read_le(r->fp, &level, 1) || read_le(r->fp, &id, 4) ||
+                   read_le(r->fp, &len, 2))
+                    return 1;
+                if(fread(buf, 1, len, r->fp) != len)
+                    return 1;
+                if(id >= r->callsite_count || r->callsites[id].fmt == NULL) {
+                    printf("[%7u][%c] <unknown callsite %u>\n", (unsigned)tick, (char)level, (unsigned)id);
+                    break;
+                }
+                if(strlen(r->callsites[id].fn) > 0) {
+                    printf("[%7u][%c] %s(): ", (unsigned)tick, (char)level, r->callsites[id].fn);
+                } else {
+                    printf("[%7u][%c] ", (unsigned)tick, (char)level);
+                }
+                print_message(r->callsites[id].fmt, buf, len);
+                printf("\n");
+                events++;
+            } break;
+            case LOG_TRACE_DROPPED:
+                if(read_le(r->fp, &len, 4))
+                    return 1;
+                printf("<%u messages dropped>\n", (unsigned)len);
+                break;
+            default:
+                fprintf(stderr, "Unknown record type %u\n", (unsigned)type);
+                return 1;
+        }
+    }
+    fprintf(stderr, "Decoded %u events from %u callsites.\n", events, r->callsite_count);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    struct arg_lit *help = arg_lit0("h", "help", "print this help and exit");
+    struct arg_lit *vers = arg_lit0("v", "version", "print version information and exit");
+    struct arg_file *file = arg_file1("f", "file", "<file>", "Binary log trace file");
+    struct arg_end *end = arg_end(20);
+    void *argtable[] = {help, vers, file, end};
+    const char *progname = "logtool";
+    int ret = 1;
+    trace_reader reader;
+    memset(&reader, 0, sizeof(reader));
+
+    // Make sure everything got allocated
+    if(arg_nullcheck(argtable) != 0) {
+        printf("%s: insufficient memory\n", progname);
+        goto exit_0;
+    }
+
+    // Parse arguments
+    int nerrors = arg_parse(argc, argv, argtable);
+
+    // Handle help
+    if(help->count > 0) {
+        printf("Usage: %s", progname);
+        arg_print_syntax(stdout, argtable, "\n");
+        printf("\nArguments:\n");
+        arg_print_glossary(stdout, argtable, "%-25s %s\n");
+        ret = 0;
+        goto exit_0;
+    }
+
+    // Handle version
+    if(vers->count > 0) {
+        printf("%s v0.1\n", progname);
+        printf("Command line OpenOMF binary log trace decoder.\n");
+        printf("Source code is available at https://github.com/omf2097 under MIT license.\n");
+        ret = 0;
+        goto exit_0;
+    }
+
+    // Handle errors
+    if(nerrors > 0) {
+        arg_print_errors(stdout, end, progname);
+        printf("Try '%s --help' for more information.\n", progname);
+        goto exit_0;
+    }
+
+    if((reader.fp = fopen(file->filename[0], "rb")) == NULL) {
+        printf("Unable to open file %s.\n", file->filename[0]);
+        goto exit_0;
+    }
+
+    // Check header
+    char magic[8];
+    uint64_t version;
+    if(fread(magic, 1, 8, reader.fp) != 8 || memcmp(magic, LOG_TRACE_MAGIC, 8) != 0 ||
+       read_le(reader.fp, &version, 4)) {
+        printf("File %s is not a log trace.\n", file->filename[0]);
+        goto exit_1;
+    }
+    if(version != LOG_TRACE_VERSION) {
+        printf("Unsupported log trace version %u.\n", (unsigned)version);
+        goto exit_1;
+    }
+
+    ret = read_trace(&reader);
+    if(ret) {
+        printf("Trace file is truncated or corrupt.\n");
+    }
+
+exit_1:
+    for(unsigned int i = 0; i < reader.callsite_count; i++) {
+        omf_free(reader.callsites[i].fn);
+        omf_free(reader.callsites[i].fmt);
+    }
+    omf_free(reader.callsites);
+    fclose(reader.fp);
+exit_0:
+    arg_freetable(argtable, sizeof(argtable) / sizeof(argtable[0]));
+    return ret;
+}
@@ -0,0 +1,351 @@
+/** @file main.c
+ * @brief Batch .REC playback validator
+ * @license MIT
+ */
+
+#include "engine.h"
+#include "game/game_player.h"
+#include "game/game_state.h"
+#include "game/objects/har.h"
+#include "game/protos/object.h"
+#include "game/utils/serial.h"
+#include "game/utils/settings.h"
+#include "resources/ids.h"
+#include "resources/pathmanager.h"
+#include "utils/allocator.h"
+#include "utils/log.h"
+#include "utils/str.h"
+#include "utils/vector.h"
+#include "utils/work_pool.h"
+#include <SDL.h>
+#include <argtable2.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#define NULL_DEVICE "NUL"
+#else
+#define NULL_DEVICE "/dev/null"
+#endif
+
+// Upper bound for a single playback, in dynamic ticks. Recordings end long before this.
+#define MAX_PLAYBACK_TICKS 1000000
+#define RESULT_LINE_MAX 65536
+
+typedef struct {
+    const char *file;
+    char *result;   // Result line of the playback, NULL if it failed
+    char *baseline; // Matching baseline line, NULL if there is none
+} job;
+
+typedef struct {
+    job *jobs;
+    int interval;
+} job_batch;
+
+static uint32_t fnv1a(const char *data, size_t len) {
+    uint32_t hash = 2166136261u;
+    for(size_t i = 0; i < len; i++) {
+        hash ^= (uint8_t)data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static int player_health(game_state *gs, int player_id) {
+    object *obj = game_player_get_har(game_state_get_player(gs, player_id));
+    if(obj == NULL) {
+        return -1;
+    }
+    har *h = object_get_userdata(obj);
+    return h->health;
+}
+
+// Plays one recording on the calling thread. Each playback has its own game state, which binds the RNG,
+// settings and output switches to this thread. Returns the result line, or NULL if the recording can't be played.
+static char *run_recording(const char *file, int interval) {
+    engine_init_flags init_flags;
+    memset(&init_flags, 0, sizeof(init_flags));
+    init_flags.net_mode = NET_MODE_NONE;
+    init_flags.headless = 1;
+    strncpy(init_flags.rec_file, file, sizeof(init_flags.rec_file) - 1);
+
+    game_state *gs = omf_calloc(1, sizeof(game_state));
+    if(game_state_create(gs, &init_flags)) {
+        game_state_free(&gs);
+        return NULL;
+    }
+
+    vector hashes;
+    vector_create(&hashes, sizeof(uint32_t));
+    unsigned int last_tick = gs->tick;
+    for(int i = 0; i < MAX_PLAYBACK_TICKS && game_state_is_running(gs); i++) {
+        game_state_dynamic_tick(gs);
+        if(gs->tick == last_tick || !is_arena(gs->this_id)) {
+            continue;
+        }
+        last_tick = gs->tick;
+        if(gs->tick % interval == 0) {
+            serial ser;
+            serial_create(&ser);
+            game_state_serialize(gs, &ser);
+            uint32_t hash = fnv1a(ser.data, serial_len(&ser));
+            vector_append(&hashes, &hash);
+            serial_free(&ser);
+        }
+    }
+
+    int health[2] = {player_health(gs, 0), player_health(gs, 1)};
+    int winner = -1;
+    if(health[0] != health[1]) {
+        winner = (health[0] > health[1]) ? 0 : 1;
+    }
+    str line;
+    str_from_format(&line, "%s\t%u\t%d\t%d\t%d\t%d\t", file, gs->tick, health[0], health[1], winner, interval);
+    iterator it;
+    uint32_t *hash;
+    vector_iter_begin(&hashes, &it);
+    while((hash = iter_next(&it)) != NULL) {
+        char buf[16];
+        snprintf(buf, sizeof(buf), "%08x,", *hash);
+        str_append_c(&line, buf);
+    }
+    char *result = strdup(str_c(&line));
+
+    str_free(&line);
+    vector_free(&hashes);
+    game_state_free(&gs);
+    return result;
+}
+
+static void run_job(void *userdata, int worker, int n) {
+    job_batch *batch = userdata;
+    job *j = &batch->jobs[n];
+    if((j->result = run_recording(j->file, batch->interval)) == NULL) {
+        fprintf(stderr, "%s: playback failed\n", j->file);
+    }
+}
+
+// Column 5 holds the hash interval. Returns 0 if the line has none.
+static int result_interval(const char *line, const char *file) {
+    int interval;
+    if(sscanf(line + strlen(file), "\t%*u\t%*d\t%*d\t%*d\t%d", &interval) != 1) {
+        return 0;
+    }
+    return interval;
+}
+
+// Column 6 holds the state hashes. Both lines must use the same hash interval. Returns the tick of the first hash
+// that differs, or -1.
+static int first_hash_mismatch(const char *a, const char *b, int interval) {
+    for(int i = 0; i < 6; i++) {
+        a = strchr(a, '\t');
+        b = strchr(b, '\t');
+        if(a == NULL || b == NULL) {
+            return 0;
+        }
+        a++;
+        b++;
+    }
+    for(int n = 1; *a || *b; n++) {
+        size_t la = strcspn(a, ",");
+        size_t lb = strcspn(b, ",");
+        if(la != lb || strncmp(a, b, la) != 0) {
+            return n * interval;
+        }
+        a += la + (a[la] == ',');
+        b += lb + (b[lb] == ',');
+    }
+    return -1;
+}
+
+static void load_baseline(const char *filename, job *jobs, int count) {
+    char line[RESULT_LINE_MAX];
+    FILE *fp = fopen(filename, "r");
+    if(fp == NULL) {
+        printf("Unable to open baseline file %s\n", filename);
+        return;
+    }
+    while(fgets(line, sizeof(line), fp) != NULL) {
+        line[strcspn(line, "\r\n")] = 0;
+        size_t name_len = strcspn(line, "\t");
+        for(int i = 0; i < count; i++) {
+            if(jobs[i].baseline == NULL && strlen(jobs[i].file) == name_len &&
+               strncmp(jobs[i].file, line, name_len) == 0) {
+                jobs[i].baseline = strdup(line);
+                break;
+            }
+        }
+    }
+    fclose(fp);
+}
+
+int main(int argc, char *argv[]) {
+    // commandline argument parser options
+    struct arg_lit *help = arg_lit0("h", "help", "print this help and exit");
+    struct arg_lit *vers = arg_lit0("v", "version", "print version information and exit");
+    struct arg_file *files = arg_filen(NULL, NULL, "<file>", 1, 100000, "Input .REC files");
+    struct arg_int *jobs_arg = arg_int0("j", "jobs", "<int>", "Number of recordings to play at once (default 4)");
+    struct arg_int *interval = arg_int0("i", "interval", "<int>", "Ticks between state hashes (default 100)");
+    struct arg_file *baseline = arg_file0("b", "baseline", "<file>", "Compare results against a baseline file");
+    struct arg_file *output = arg_file0("o", "output", "<file>", "Write results as a new baseline file");
+    struct arg_end *end = arg_end(20);
+    void *argtable[] = {help, vers, files, jobs_arg, interval, baseline, output, end};
+    const char *progname = "recverify";
+    int ret = 0;
+
+    // Make sure everything got allocated
+    if(arg_nullcheck(argtable) != 0) {
+        printf("%s: insufficient memory\n", progname);
+        goto exit_0;
+    }
+
+    // Parse arguments
+    int nerrors = arg_parse(argc, argv, argtable);
+
+    // Handle help
+    if(help->count > 0) {
+        printf("Usage: %s", progname);
+        arg_print_syntax(stdout, argtable, "\n");
+        printf("\nArguments:\n");
+        arg_print_glossary(stdout, argtable, "%-25s %s\n");
+        goto exit_0;
+    }
+
+    // Handle version
+    if(vers->count > 0) {
+        printf("%s v0.1\n", progname);
+        printf("Command line One Must Fall 2097 .REC playback validator.\n");
+        printf("Source code is available at https://github.com/omf2097 under MIT license.\n");
+        printf("(C) 2097 Tuomas Virtanen, Andrew Thompson, Hunter and others\n");
+        goto exit_0;
+    }
+
+    // Handle errors
+    if(nerrors > 0) {
+        arg_print_errors(stdout, end, progname);
+        printf("Try '%s --help' for more information.\n", progname);
+        ret = 1;
+        goto exit_0;
+    }
+
+    int hash_interval = (interval->count > 0 && interval->ival[0] > 0) ? interval->ival[0] : 100;
+
+    // The game logs to stdout by default, which is where the report goes.
+    if(pm_init() != 0) {
+        fprintf(stderr, "Error: %s.\n", pm_get_errormsg());
+        ret = 1;
+        goto exit_0;
+    }
+    if(log_init(NULL_DEVICE, LOG_FORMAT_TEXT)) {
+        ret = 1;
+        goto exit_1;
+    }
+    if(settings_init(pm_get_local_path(CONFIG_PATH))) {
+        ret = 1;
+        goto exit_2;
+    }
+    settings_load();
+    settings_get()->video.crossfade_on = 0; // Otherwise the end of the match waits for static ticks
+
+    // No window and no sound device
+    SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");
+    SDL_SetHint(SDL_HINT_AUDIODRIVER, "dummy");
+    SDL_SetHint(SDL_HINT_RENDER_DRIVER, "software");
+    if(SDL_Init(SDL_INIT_TIMER | SDL_INIT_VIDEO)) {
+        fprintf(stderr, "SDL2 Initialization failed: %s\n", SDL_GetError());
+        ret = 1;
+        goto exit_3;
+    }
+    if(engine_init()) {
+        fprintf(stderr, "Engine initialization failed\n");
+        ret = 1;
+        goto exit_4;
+    }
+
+    // Recordings are played on the threads of a work pool, each with its own headless game state
+    job_batch batch;
+    int count = files->count;
+    batch.jobs = omf_calloc(count, sizeof(job));
+    batch.interval = hash_interval;
+    for(int i = 0; i < count; i++) {
+        batch.jobs[i].file = files->filename[i];
+    }
+    if(baseline->count > 0) {
+        load_baseline(baseline->filename[0], batch.jobs, count);
+    }
+
+    int workers = (jobs_arg->count > 0) ? jobs_arg->ival[0] : 4;
+    workers = (workers < 1) ? 1 : ((workers > WORK_POOL_MAX_THREADS + 1) ? WORK_POOL_MAX_THREADS + 1 : workers);
+    work_pool pool;
+    work_pool_create(&pool, workers - 1);
+    work_pool_run(&pool, count, run_job, &batch);
+    work_pool_free(&pool);
+
+    // Report
+    int failed = 0, regressions = 0;
+    FILE *out = NULL;
+    if(output->count > 0 && (out = fopen(output->filename[0], "w")) == NULL) {
+        printf("Unable to open %s for writing\n", output->filename[0]);
+    }
+    printf("%-40s %8s %7s %7s %6s  %s\n", "File", "Ticks", "Health1", "Health2", "Winner", "Status");
+    for(int i = 0; i < count; i++) {
+        job *j = &batch.jobs[i];
+        unsigned int ticks;
+        int health1, health2, winner;
+        if(j->result == NULL || sscanf(j->result + strlen(j->file), "\t%u\t%d\t%d\t%d", &ticks, &health1, &health2,
+                                       &winner) != 4) {
+            printf("%-40s %8s %7s %7s %6s  %s\n", j->file, "-", "-", "-", "-", "FAILED");
+            failed++;
+            continue;
+        }
+        if(out != NULL) {
+            fprintf(out, "%s\n", j->result);
+        }
+
+        char status[64] = "OK";
+        int baseline_interval = (j->baseline != NULL) ? result_interval(j->baseline, j->file) : 0;
+        if(j->baseline == NULL) {
+            snprintf(status, sizeof(status), "%s", baseline->count > 0 ? "NEW" : "-");
+        } else if(baseline_interval != hash_interval) {
+            // Hashes taken at other ticks can't be compared
+            snprintf(status, sizeof(status), "FAILED (baseline hash interval is %d)", baseline_interval);
+            failed++;
+        } else if(strcmp(j->result, j->baseline) != 0) {
+            int tick = first_hash_mismatch(j->result, j->baseline, hash_interval);
+            if(tick >= 0) {
+                snprintf(status, sizeof(status), "REGRESSION (state differs at tick %d)", tick);
+            } else {
+                snprintf(status, sizeof(status), "REGRESSION (result differs)");
+            }
+            regressions++;
+        }
+        printf("%-40s %8u %7d %7d %6d  %s\n", j->file, ticks, health1, health2, winner, status);
+    }
+    printf("\n%d recordings, %d failed, %d regressions\n", count, failed, regressions);
+    if(out != NULL) {
+        fclose(out);
+    }
+    ret = (failed > 0 || regressions > 0) ? 1 : 0;
+
+    for(int i = 0; i < count; i++) {
+        omf_free(batch.jobs[i].result);
+        omf_free(batch.jobs[i].baseline);
+    }
+    omf_free(batch.jobs);
+
+    engine_close();
+exit_4:
+    SDL_Quit();
+exit_3:
+    settings_free();
+exit_2:
+    log_close();
+exit_1:
+    pm_free();
+exit_0:
+    arg_freetable(argtable, sizeof(argtable) / sizeof(argtable[0]));
+    return ret;
+}